@@ -7,8 +7,7 @@
 #include <editor/assetmanager.h>
 #include <editor/codebuilder.h>
 
-#include <quazip.h>
-#include <quazipfile.h>
+#include <utils/assetpack.h>
 
 #include <QCoreApplication>
 #include <QDirIterator>
@@ -52,12 +51,7 @@ void Builder::package(const QString &target) {
     dir += "/base.pak";
 
     aInfo() << "Packaging Assets to:" << qPrintable(dir);
-    QuaZip zip(dir);
-    if(!zip.open(QuaZip::mdCreate)) {
-        aError() << "Can't open package.";
-        return;
-    }
-    QuaZipFile outZipFile(&zip);
+    AssetPackWriter pack;
 
     QDirIterator it(ProjectSettings::instance()->importPath(), QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
     while(it.hasNext()) {
@@ -70,23 +64,20 @@ void Builder::package(const QString &target) {
             aInfo() << "\tCoping:" << origin.c_str();
 
             if(!inFile.open(QIODevice::ReadOnly)) {
-                zip.close();
                 aError() << "Can't open input file.";
                 return;
             }
 
-            if(!outZipFile.open(QIODevice::WriteOnly, QuaZipNewInfo(info.fileName(), info.absoluteFilePath()))) {
-                inFile.close();
-                zip.close();
-                aError() << "Can't open output file.";
-                return;
-            }
-            outZipFile.write(inFile.readAll());
+            QByteArray data = inFile.readAll();
+            pack.addFile(info.fileName().toStdString(), ByteArray(data.begin(), data.end()));
 
-            outZipFile.close();
             inFile.close();
         }
     }
+
+    if(!pack.save(dir.toStdString())) {
+        aError() << "Can't write package.";
+    }
 }
 
 bool copyRecursively(QString sourceFolder, QString destFolder) {
@@ -10,6 +10,7 @@
 #define UNIFORM_BIND    4
 
 class ComputeInstance;
+class CommandList;
 class RenderTarget;
 class Texture;
 class Mesh;
@@ -58,6 +59,8 @@ public:
 
     virtual void setRenderTarget(RenderTarget *target, uint32_t level = 0);
 
+    virtual void copyRenderTarget(RenderTarget *source, int32_t x, int32_t y, int32_t width, int32_t height);
+
     virtual void setViewProjection(const Matrix4 &view, const Matrix4 &projection);
 
     virtual void setGlobalValue(const char *name, const Variant &value);
@@ -79,6 +82,8 @@ public:
     virtual void beginDebugMarker(const char *name);
     virtual void endDebugMarker();
 
+    void execute(const CommandList &list);
+
     Vector2 viewport() const;
 
     static Vector4 idToColor(uint32_t id);
@@ -87,6 +92,10 @@ public:
 
     static void setInited();
 
+    static bool isComputeSupported();
+
+    static void setComputeSupported(bool supported);
+
 protected:
     bool m_screenProjection;
 
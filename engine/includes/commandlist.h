@@ -0,0 +1,176 @@
+#ifndef COMMANDLIST_H
+#define COMMANDLIST_H
+
+#include "engine.h"
+
+class CommandBuffer;
+class ComputeInstance;
+class MaterialInstance;
+class RenderTarget;
+class Texture;
+class Mesh;
+
+class ENGINE_EXPORT CommandList {
+public:
+    enum CommandType {
+        ClearRenderTarget = 1,
+        DispatchCompute,
+        DrawMesh,
+        SetRenderTarget,
+        SetViewProjection,
+        SetGlobalValue,
+        SetGlobalTexture,
+        SetViewport,
+        EnableScissor,
+        DisableScissor,
+        BeginDebugMarker,
+        EndDebugMarker
+    };
+
+    struct Header {
+        uint32_t size;
+
+        uint16_t type;
+
+        uint16_t name;
+    };
+
+    struct ClearPacket {
+        float color[4];
+
+        float depth;
+
+        uint8_t clearColor;
+
+        uint8_t clearDepth;
+    };
+
+    struct DispatchPacket {
+        ComputeInstance *shader;
+
+        int32_t groupsX;
+
+        int32_t groupsY;
+
+        int32_t groupsZ;
+    };
+
+    struct DrawPacket {
+        Mesh *mesh;
+
+        MaterialInstance *instance;
+
+        uint32_t sub;
+
+        uint32_t layer;
+
+        uint32_t batches;
+    };
+
+    struct TargetPacket {
+        RenderTarget *target;
+
+        uint32_t level;
+    };
+
+    struct ViewProjectionPacket {
+        float view[16];
+
+        float projection[16];
+    };
+
+    struct ValuePacket {
+        uint8_t data[64];
+
+        uint32_t type;
+    };
+
+    struct TexturePacket {
+        Texture *texture;
+    };
+
+    struct RectPacket {
+        int32_t x;
+
+        int32_t y;
+
+        int32_t width;
+
+        int32_t height;
+    };
+
+    class ENGINE_EXPORT Iterator {
+    public:
+        explicit Iterator(const uint8_t *data);
+
+        const Header &header() const;
+
+        template<typename T>
+        const T &packet() const {
+            return *reinterpret_cast<const T *>(m_data + sizeof(Header));
+        }
+
+        const char *name() const;
+
+        Iterator &operator++();
+
+        bool operator!=(const Iterator &other) const;
+
+    private:
+        const uint8_t *m_data;
+
+    };
+
+public:
+    CommandList();
+
+    void clearRenderTarget(bool clearColor = true, const Vector4 &color = Vector4(0.0f), bool clearDepth = true, float depth = 1.0f);
+
+    void dispatchCompute(ComputeInstance *shader, int32_t groupsX, int32_t groupsY, int32_t groupsZ);
+
+    void drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance &instance);
+    void drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance &instance, const std::vector<MaterialInstance *> &batches);
+
+    void setRenderTarget(RenderTarget *target, uint32_t level = 0);
+
+    void setViewProjection(const Matrix4 &view, const Matrix4 &projection);
+
+    void setGlobalValue(const char *name, const Variant &value);
+
+    void setGlobalTexture(const char *name, Texture *texture);
+
+    void setViewport(int32_t x, int32_t y, int32_t width, int32_t height);
+
+    void enableScissor(int32_t x, int32_t y, int32_t width, int32_t height);
+
+    void disableScissor();
+
+    void beginDebugMarker(const char *name);
+    void endDebugMarker();
+
+    void append(const CommandList &list);
+
+    void replay(CommandBuffer &buffer) const;
+
+    void clear();
+
+    bool isEmpty() const;
+
+    uint32_t count() const;
+
+    uint32_t size() const;
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    uint8_t *allocate(uint16_t type, uint32_t size, const char *name = nullptr);
+
+private:
+    ByteArray m_data;
+
+    uint32_t m_count;
+
+};
+
+#endif // COMMANDLIST_H
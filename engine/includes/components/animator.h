@@ -72,9 +72,15 @@ private:
 
     void setClips(AnimationClip *start, AnimationClip *end, float duration = 0.0f, float time = 0.0f);
 
+    void evaluate();
+
+    void evaluateChannels(bool transforms);
+
     static void stateMachineUpdated(int state, void *ptr);
 
 private:
+    friend class AnimationBatch;
+
     std::unordered_map<uint32_t, BaseAnimationBlender *> m_properties;
 
     VariableMap m_currentVariables;
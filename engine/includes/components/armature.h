@@ -31,9 +31,13 @@ private:
 
     void cleanDirty();
 
+    void updatePalette();
+
     static void bindPoseUpdated(int state, void *ptr);
 
 private:
+    friend class AnimationBatch;
+
     std::vector<Matrix4> m_invertTransform;
     std::vector<Transform *> m_bones;
 
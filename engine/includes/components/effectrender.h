@@ -5,6 +5,10 @@
 
 #include "resources/visualeffect.h"
 
+class ComputeInstance;
+class ComputeBuffer;
+class CommandBuffer;
+
 class ENGINE_EXPORT EffectRender : public Renderable {
     A_REGISTER(EffectRender, Renderable, Components/Effects)
 
@@ -29,6 +33,17 @@ private:
 
     void update() override;
 
+    bool prepare(float dt);
+
+    void simulate();
+
+    void upload();
+
+    void dispatch(CommandBuffer &buffer);
+
+    void createCompute();
+    void releaseCompute();
+
     static void effectUpdated(int state, void *ptr);
 
 private:
@@ -41,6 +56,17 @@ private:
     std::vector<int32_t> m_offsets;
 
     VisualEffect *m_effect;
+
+    ComputeInstance *m_computeInstance;
+
+    ComputeBuffer *m_particlesBuffer;
+
+    ComputeBuffer *m_renderBuffer;
+
+    ComputeBuffer *m_stateBuffer;
+
+    friend class EffectBatch;
+
 };
 
 #endif // EFFECTRENDER_H
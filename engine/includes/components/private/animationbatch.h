@@ -0,0 +1,31 @@
+#ifndef ANIMATIONBATCH_H
+#define ANIMATIONBATCH_H
+
+#include <cstdint>
+#include <vector>
+
+class Animator;
+class Armature;
+class ThreadPool;
+
+class AnimationBatch {
+public:
+    static void addAnimator(Animator *animator);
+    static void removeAnimator(Animator *animator);
+
+    static void addArmature(Armature *armature);
+    static void removeArmature(Armature *armature);
+
+    static void process(ThreadPool *pool);
+
+private:
+    static void dispatch(ThreadPool *pool, bool armatures, uint32_t count);
+
+private:
+    static std::vector<Animator *> m_animators;
+
+    static std::vector<Armature *> m_armatures;
+
+};
+
+#endif // ANIMATIONBATCH_H
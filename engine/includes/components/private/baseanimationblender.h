@@ -4,11 +4,22 @@
 #include <propertyanimation.h>
 
 class AnimationTrack;
+class Transform;
 
 class BaseAnimationBlender : public PropertyAnimation {
+public:
+    enum Channel {
+        NoChannel = 0,
+        PositionChannel,
+        QuaternionChannel,
+        ScaleChannel
+    };
+
 public:
     BaseAnimationBlender();
 
+    void setTarget(Object *object, const char *property);
+
     void setOffset(float offset);
 
     void setTransitionTime(float time);
@@ -21,8 +32,25 @@ public:
 
     void setPreviousDuration(int32_t duration);
 
+    bool isTransformChannel() const;
+
+private:
+    void applyTransform(float time);
+
 private:
-    AnimationTrack *m_previousTrack;
+    AnimationCurve m_previousCurve;
+
+    Vector3 m_defaultVector;
+
+    Quaternion m_defaultQuaternion;
+
+    Transform *m_transform;
+
+    Channel m_channel;
+
+    int32_t m_previousCursor;
+
+    bool m_previous;
 
     float m_factor;
     float m_offset;
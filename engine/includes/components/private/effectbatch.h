@@ -0,0 +1,23 @@
+#ifndef EFFECTBATCH_H
+#define EFFECTBATCH_H
+
+#include <cstdint>
+#include <vector>
+
+class EffectRender;
+class ThreadPool;
+class CommandBuffer;
+
+class EffectBatch {
+public:
+    static void addEmitter(EffectRender *emitter);
+    static void removeEmitter(EffectRender *emitter);
+
+    static void process(ThreadPool *pool, CommandBuffer *buffer);
+
+private:
+    static std::vector<EffectRender *> m_emitters;
+
+};
+
+#endif // EFFECTBATCH_H
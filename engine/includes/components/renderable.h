@@ -50,6 +50,8 @@ protected:
 
     uint32_t m_surfaceType;
 
+    uint32_t m_lod;
+
 private:
     mutable AABBox m_localBox;
     mutable AABBox m_worldBox;
@@ -5,7 +5,10 @@
 #include "system.h"
 #include "scene.h"
 
+class QueryBatch;
+
 typedef bool (*RayCastCallback)(System *system, World *graph, const Ray &ray, float maxDistance, Ray::Hit *hit);
+typedef void (*QueryCallback)(System *system, World *graph, QueryBatch &batch);
 
 class ENGINE_EXPORT World : public Object {
     A_REGISTER(World, Object, General)
@@ -48,6 +51,14 @@ public:
 
     void setRayCastHandler(RayCastCallback callback, System *system);
 
+    void query(QueryBatch &batch);
+    void queryDeferred(QueryBatch &batch);
+    void cancelQuery(QueryBatch &batch);
+
+    void processDeferredQueries();
+
+    void setQueryHandler(QueryCallback callback, System *system);
+
 public: // signals
     void sceneLoaded();
     void sceneUnloaded();
@@ -63,6 +74,11 @@ private:
     RayCastCallback m_rayCastCallback;
     System *m_rayCastSystem;
 
+    QueryCallback m_queryCallback;
+    System *m_querySystem;
+
+    std::vector<QueryBatch *> m_deferredQueries;
+
     Scene *m_activeScene;
     Object *m_gameController;
 
@@ -55,6 +55,8 @@ public:
     QString hash() const;
     void setHash(const QString &hash);
 
+    QString cacheKey() const;
+
     uint32_t version() const;
     void setVersion(uint32_t version);
 
@@ -83,6 +85,9 @@ public:
 signals:
     void updated();
 
+protected:
+    QJsonObject properties() const;
+
 protected:
     bool m_valid;
     bool m_modified;
@@ -116,6 +121,11 @@ public:
     virtual void init();
     virtual QStringList suffixes() const = 0;
 
+    virtual bool isThreadSafe() const;
+
+    virtual bool hasPrepareStep() const;
+    virtual ReturnCode prepareFile(AssetConverterSettings *settings);
+
     virtual ReturnCode convertFile(AssetConverterSettings *settings) = 0;
     virtual AssetConverterSettings *createSettings() = 0;
 
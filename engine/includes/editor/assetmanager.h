@@ -7,6 +7,7 @@
 #include <QTimer>
 #include <QImage>
 #include <QSet>
+#include <QMutex>
 
 #include <engine.h>
 #include <module.h>
@@ -17,9 +18,12 @@
 
 class QFileSystemWatcher;
 class QAbstractItemModel;
+class QThreadPool;
 
 class ProjectSettings;
 
+class ImportCache;
+
 class CodeBuilder;
 
 class ENGINE_EXPORT AssetManager : public QObject {
@@ -90,6 +94,7 @@ signals:
 
     void imported(const QString &path, const QString &type);
     void importStarted(int count, const QString &stage);
+    void importProgress(int processed, int total);
     void importFinished();
 
     void iconUpdated(QString guid);
@@ -124,6 +129,19 @@ protected:
 
     QList<AssetConverterSettings *> m_importQueue;
 
+    QSet<AssetConverterSettings *> m_inFlight;
+
+    QSet<AssetConverterSettings *> m_forcedImport;
+
+    QList<QPair<AssetConverterSettings *, uint8_t>> m_converted;
+    QList<QPair<AssetConverterSettings *, uint8_t>> m_prepared;
+
+    QMutex m_convertedMutex;
+
+    QThreadPool *m_importPool;
+
+    ImportCache *m_importCache;
+
     ProjectSettings *m_projectManager;
 
     QTimer *m_timer;
@@ -134,6 +152,12 @@ protected:
 
     QHash<QString, QImage> m_defaultIcons;
 
+    uint32_t m_importStage;
+
+    int m_importTotal;
+
+    int m_importProcessed;
+
     bool m_noIcons;
 
 protected:
@@ -141,6 +165,11 @@ protected:
     void dumpBundle();
 
     void convert(AssetConverterSettings *settings);
+    void convertFinished(AssetConverterSettings *settings, uint8_t result);
+
+    void collectConverted();
+
+    void checkOutdated(const QList<QFileInfo> &files, bool force);
 
     QString pathToLocal(const QFileInfo &source) const;
 
@@ -23,6 +23,9 @@ class AssimpImportSettings : public AssetConverterSettings {
     Q_PROPERTY(float Custom_Scale READ customScale WRITE setCustomScale DESIGNABLE true USER true)
     Q_PROPERTY(bool Import_Color READ colors WRITE setColors DESIGNABLE true USER true)
     Q_PROPERTY(bool Import_Normals READ normals WRITE setNormals DESIGNABLE true USER true)
+    Q_PROPERTY(bool Optimize_Mesh READ optimize WRITE setOptimize DESIGNABLE true USER true)
+    Q_PROPERTY(bool Quantize_Vertices READ quantize WRITE setQuantize DESIGNABLE true USER true)
+    Q_PROPERTY(int Generate_LODs READ lods WRITE setLods DESIGNABLE true USER true)
 
     Q_PROPERTY(bool Import_Animation READ animation WRITE setAnimation DESIGNABLE true USER true)
     Q_PROPERTY(Compression Compress_Animation READ filter WRITE setFilter DESIGNABLE true USER true)
@@ -34,7 +37,8 @@ public:
 
     enum Compression {
         Off = 0,
-        Keyframe_Reduction
+        Keyframe_Reduction,
+        Keyframe_Quantization
     };
     Q_ENUM(Compression)
 
@@ -46,6 +50,15 @@ public:
     bool normals() const;
     void setNormals(bool value);
 
+    bool optimize() const;
+    void setOptimize(bool value);
+
+    bool quantize() const;
+    void setQuantize(bool value);
+
+    int lods() const;
+    void setLods(int value);
+
     bool animation() const;
     void setAnimation(bool value);
 
@@ -80,6 +93,8 @@ public:
     Actor *m_rootActor;
     Actor *m_rootBone;
 
+    aiScene *m_scene;
+
     bool m_flip;
 
 private:
@@ -94,6 +109,11 @@ protected:
     bool m_colors;
     bool m_normals;
 
+    bool m_optimize;
+    bool m_quantize;
+
+    int m_lods;
+
     bool m_animation;
     Compression m_filter;
 
@@ -108,6 +128,9 @@ public:
     AssimpConverter();
 
     QStringList suffixes() const Q_DECL_OVERRIDE { return {"fbx", "obj", "gltf", "glb"}; }
+
+    bool hasPrepareStep() const override { return true; }
+    ReturnCode prepareFile(AssetConverterSettings *settings) override;
     ReturnCode convertFile(AssetConverterSettings *) override;
 
     AssetConverterSettings *createSettings() override;
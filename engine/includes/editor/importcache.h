@@ -0,0 +1,29 @@
+#ifndef IMPORTCACHE_H
+#define IMPORTCACHE_H
+
+#include <QString>
+
+#include <engine.h>
+
+class AssetConverterSettings;
+
+class ENGINE_EXPORT ImportCache {
+public:
+    explicit ImportCache(const QString &path);
+
+    QString path() const;
+
+    bool restore(AssetConverterSettings *settings) const;
+    bool store(AssetConverterSettings *settings, bool replace = false) const;
+
+    void clear() const;
+
+private:
+    QString entryPath(const QString &key) const;
+
+private:
+    QString m_path;
+
+};
+
+#endif // IMPORTCACHE_H
@@ -18,6 +18,7 @@ class RenderSystem;
 class Resource;
 class World;
 class PlatformAdaptor;
+class ThreadPool;
 class NativeBehaviour;
 
 #if defined(SHARED_DEFINE) && defined(_WIN32)
@@ -58,6 +59,8 @@ public:
 */
     static Object *loadResource(const std::string &path);
 
+    static Object *loadResourceAsync(const std::string &path, int32_t priority = 0);
+
     static void unloadResource(const std::string &path);
     static void unloadResource(Resource *resource);
 
@@ -68,6 +71,11 @@ public:
         return dynamic_cast<T *>(loadResource(path));
     }
 
+    template<typename T>
+    static T *loadResourceAsync(const std::string &path, int32_t priority = 0) {
+        return dynamic_cast<T *>(loadResourceAsync(path, priority));
+    }
+
     static bool isResourceExist(const std::string &path);
 
     static std::string reference(Object *object);
@@ -78,6 +86,8 @@ public:
 
     static RenderSystem *renderSystem();
 
+    static ThreadPool *threadPool();
+
 /*
     Scene management
 */
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <string>
 #include <list>
+#include <mutex>
+#include <unordered_set>
 
 #include <engine.h>
 
@@ -11,8 +13,13 @@ typedef void _FILE;
 typedef	uint64_t _size_t;
 typedef std::list<std::string> StringList;
 
+class AssetPack;
+
 class ENGINE_EXPORT File {
 public:
+    File();
+    virtual ~File();
+
     void finit(const char *argv0);
     void fsearchPathAdd(const char *path, bool isFirst = false);
 
@@ -39,6 +46,17 @@ public:
     virtual _size_t fsize(_FILE *stream);
 
     virtual _size_t ftell(_FILE *stream);
+
+private:
+    bool isPackStream(_FILE *stream);
+
+private:
+    std::list<AssetPack *> m_packs;
+
+    std::unordered_set<_FILE *> m_packStreams;
+
+    std::mutex m_mutex;
+
 };
 
 #endif // FILE_H
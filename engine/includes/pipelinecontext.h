@@ -2,11 +2,13 @@
 #define PIPELINECONTEXT
 
 #include <cstdint>
+#include <functional>
 #include <unordered_map>
 
 #include <amath.h>
 
 #include "resource.h"
+#include "commandlist.h"
 
 class CommandBuffer;
 
@@ -23,10 +25,31 @@ class BaseLight;
 class Renderable;
 class PostProcessSettings;
 class InstancingBatch;
+class RenderListJob;
 
 class ENGINE_EXPORT PipelineContext : public Object {
     A_REGISTER(PipelineContext, Object, System)
 
+public:
+    struct DrawItem {
+        Renderable *renderable;
+
+        uint32_t sub;
+
+        uint32_t hash;
+
+        int32_t priority;
+
+        float depth;
+    };
+    typedef std::vector<DrawItem> DrawItems;
+
+    enum RenderListContent {
+        AllItems,
+        StaticItems,
+        DynamicItems
+    };
+
 public:
     PipelineContext();
     ~PipelineContext();
@@ -39,6 +62,19 @@ public:
 
     void drawRenderers(const std::list<Renderable *> &list, uint32_t layer, uint32_t flags = 0);
 
+    int32_t requestRenderList(uint32_t layer, uint32_t flags = 0);
+    int32_t requestRenderList(const std::array<Vector3, 8> &frustum, uint32_t layer, uint32_t flags = 0, bool split = false);
+
+    void drawRenderList(int32_t id, RenderListContent content = AllItems);
+
+    void requestJob(const std::function<void()> &job);
+
+    AABBox renderListBound(int32_t id, RenderListContent content = AllItems) const;
+
+    uint32_t renderListHash(int32_t id, RenderListContent content = AllItems) const;
+
+    bool isRenderListStatic(int32_t id) const;
+
     void setMaxTexture(uint32_t size);
 
     World *world();
@@ -70,13 +106,28 @@ public:
 
     void resize(int32_t width, int32_t height);
 
+    float lodBias() const;
+    void setLodBias(float bias);
+
     static Mesh *defaultPlane();
     static Mesh *defaultCube();
 
 private:
     void analizeGraph();
 
+    void buildRenderLists();
+
+    void selectLods(Camera *camera);
+
+    void requestTextures(Camera *camera);
+
+    static void recordItems(const DrawItems &items, uint32_t layer, CommandList &list);
+
+    static void filterRenderers(const std::list<Renderable *> &list, uint32_t layer, uint32_t flags, DrawItems &items);
+
 protected:
+    friend class RenderListJob;
+
     typedef std::map<std::string, Texture *> BuffersMap;
     typedef std::map<std::string, RenderTarget *> TargetsMap;
 
@@ -93,6 +144,14 @@ protected:
 
     std::list<PipelineTask *> m_renderTasks;
 
+    std::vector<RenderListJob *> m_renderLists;
+
+    std::vector<std::function<void()>> m_jobs;
+
+    DrawItems m_drawItems;
+
+    CommandList m_commandList;
+
     World *m_world;
 
     Pipeline *m_pipeline;
@@ -112,6 +171,10 @@ protected:
     int32_t m_width;
     int32_t m_height;
 
+    uint32_t m_renderListsCount;
+
+    float m_lodBias;
+
     bool m_frustumCulling;
 
 };
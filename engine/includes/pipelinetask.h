@@ -17,6 +17,7 @@ public:
     ~PipelineTask();
 
     virtual void analyze(World *world);
+    virtual void prepare(PipelineContext &context);
     virtual void exec(PipelineContext &context);
 
     virtual void resize(int width, int height);
@@ -3,22 +3,68 @@
 
 #include "pipelinetask.h"
 
+#include "utils/lightclusters.h"
+
 class RenderTarget;
+class MaterialInstance;
+class BaseLight;
 
 class DeferredLighting : public PipelineTask {
     A_REGISTER(DeferredLighting, PipelineTask, Pipeline)
 
 public:
     DeferredLighting();
+    ~DeferredLighting();
 
 private:
+    struct LightVolume {
+        Matrix4 transform;
+
+        Vector3 position;
+        Vector3 direction;
+        Vector3 right;
+        Vector3 up;
+    };
+
+    void prepare(PipelineContext &context) override;
+
     void exec(PipelineContext &context) override;
 
     void setInput(int index, Texture *texture) override;
 
+    bool isClusterable(BaseLight *light) const;
+
+    void lightVolumesUpdate();
+
+    void clusteredLightBuild();
+
+    void clusteredLightUpdate();
+
+    void resizeTexture(Texture *texture, uint32_t texels);
+
 private:
+    LightClusters m_clusters;
+
+    std::vector<BaseLight *> m_clusteredLights;
+
+    std::vector<BaseLight *> m_volumeLights;
+
+    std::vector<LightVolume> m_volumes;
+
+    std::vector<Vector4> m_spheres;
+
+    Matrix4 m_view;
+
     RenderTarget *m_lightPass;
 
+    Texture *m_clustersTexture;
+    Texture *m_indicesTexture;
+    Texture *m_lightsTexture;
+
+    MaterialInstance *m_clustered;
+
+    bool m_clusteredMode;
+
 };
 
 #endif // DEFERREDLIGHTING_H
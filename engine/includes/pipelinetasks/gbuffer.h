@@ -12,11 +12,14 @@ public:
     GBuffer();
 
 private:
+    void prepare(PipelineContext &context) override;
     void exec(PipelineContext &context) override;
 
 private:
     RenderTarget *m_gbuffer;
 
+    int32_t m_renderList;
+
 };
 
 #endif // GBUFFER_H
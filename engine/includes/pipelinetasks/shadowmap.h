@@ -14,7 +14,7 @@ class AreaLight;
 class DirectLight;
 class SpotLight;
 class PointLight;
-class Renderable;
+class BaseLight;
 
 class ShadowMap : public PipelineTask {
     A_REGISTER(ShadowMap, PipelineTask, Pipeline)
@@ -23,29 +23,104 @@ public:
     ShadowMap();
 
 private:
+    struct ShadowRequest {
+        int32_t x[6];
+        int32_t y[6];
+        int32_t w[6];
+        int32_t h[6];
+
+        Matrix4 view[6];
+        Matrix4 crop[6];
+
+        AABBox box[4];
+
+        Vector4 planeDistance;
+
+        BaseLight *light = nullptr;
+
+        RenderTarget *target = nullptr;
+
+        int32_t renderList = -1;
+
+        uint32_t count = 0;
+    };
+
+    struct TileContent {
+        AABBox staticBound;
+
+        uint32_t lightHash = 0;
+
+        uint32_t staticHash = 0;
+
+        uint32_t dynamicHash = 0;
+    };
+
+    struct TileState {
+        Matrix4 matrix;
+
+        TileContent content;
+
+        bool staticCached = false;
+
+        bool valid = false;
+    };
+
+    enum TileUpdate {
+        Skip,
+        Dynamic,
+        Full
+    };
+
+private:
+    void prepare(PipelineContext &context) override;
     void exec(PipelineContext &context) override;
 
-    void areaLightUpdate(PipelineContext &context, AreaLight *light, std::list<Renderable *> &components);
-    void directLightUpdate(PipelineContext &context, DirectLight *light, std::list<Renderable *> &components, const Camera &camera);
-    void pointLightUpdate(PipelineContext &context, PointLight *light, std::list<Renderable *> &components);
-    void spotLightUpdate(PipelineContext &context, SpotLight *light, std::list<Renderable *> &components);
+    void setProperty(const std::string &name, const Variant &value) override;
+
+    void areaLightUpdate(PipelineContext &context, AreaLight *light);
+    void directLightUpdate(PipelineContext &context, DirectLight *light, const Camera &camera);
+    void pointLightUpdate(PipelineContext &context, PointLight *light);
+    void spotLightUpdate(PipelineContext &context, SpotLight *light);
+    void omniLightUpdate(PipelineContext &context, BaseLight *light, float zFar);
+
+    void directLightMatrices(PipelineContext &context, ShadowRequest &request);
+
+    void lightUniforms(const ShadowRequest &request, const std::vector<TileState> &cache);
 
     void cleanShadowCache();
 
+    RenderTarget *cachePage(RenderTarget *page);
+
+    static TileUpdate tileUpdate(const TileState &tile, const TileContent &content, bool cached);
+
+    static RenderTarget *createPage(const std::string &name);
+
     RenderTarget *requestShadowTiles(PipelineContext &context, uint32_t id, uint32_t lod, int32_t *x, int32_t *y, int32_t *w, int32_t *h, uint32_t count);
 
 private:
+    friend class ShadowMapTest;
+
     std::unordered_map<uint32_t, std::pair<RenderTarget *, std::vector<AtlasNode *>>> m_tiles;
     std::unordered_map<RenderTarget *, AtlasNode *> m_shadowPages;
+    std::unordered_map<RenderTarget *, RenderTarget *> m_cachePages;
+    std::unordered_map<uint32_t, std::vector<TileState>> m_tileStates;
 
     std::vector<Quaternion> m_directions;
 
+    std::vector<ShadowRequest> m_requests;
+
     Matrix4 m_scale;
 
     float m_bias;
 
     uint32_t m_shadowResolution;
 
+    uint32_t m_tilesPerFrame;
+
+    uint32_t m_nextRequest;
+
+    bool m_cached;
+
 };
 
 #endif // SHADOWMAP_H
@@ -12,6 +12,7 @@ public:
     Translucent();
 
 private:
+    void prepare(PipelineContext &context) override;
     void exec(PipelineContext &context) override;
 
     void setInput(int index, Texture *texture) override;
@@ -19,6 +20,8 @@ private:
 private:
     RenderTarget *m_translucentPass;
 
+    int32_t m_renderList;
+
 };
 
 #endif // TRANSLUCENT_H
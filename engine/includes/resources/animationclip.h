@@ -33,6 +33,7 @@ public:
     void fixCurves();
 
     AnimationCurve &curve();
+    const AnimationCurve &curve() const;
 
 private:
     std::string m_path;
@@ -46,7 +47,7 @@ private:
     AnimationCurve m_curve;
 
 };
-typedef std::list<AnimationTrack> AnimationTrackList;
+typedef std::vector<AnimationTrack> AnimationTrackList;
 
 class ENGINE_EXPORT AnimationClip : public Resource {
     A_REGISTER(AnimationClip, Resource, Resources)
@@ -57,14 +58,22 @@ class ENGINE_EXPORT AnimationClip : public Resource {
     )
 
 public:
+    AnimationClip();
+
     int duration() const;
 
+    bool isCompressed() const;
+    void setCompressed(bool compressed);
+
 public:
     AnimationTrackList m_tracks;
 
     void loadUserData(const VariantMap &data) override;
     VariantMap saveUserData() const override;
 
+private:
+    bool m_compressed;
+
 };
 
 #endif // ANIMATIONCLIP_H
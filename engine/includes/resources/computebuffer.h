@@ -18,6 +18,9 @@ public:
     virtual ByteArray data() const;
     void setData(const ByteArray &data);
 
+protected:
+    void switchState(Resource::State state) override;
+
 protected:
     ByteArray m_buffer;
 
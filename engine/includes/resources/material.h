@@ -5,6 +5,7 @@
 #include "texture.h"
 
 class Transform;
+class ComputeBuffer;
 class MaterialInstance;
 
 class ENGINE_EXPORT Material : public Resource {
@@ -196,6 +197,8 @@ public:
 
     void setTexture(const std::string &name, Texture *texture);
 
+    const Textures &textures() const;
+
     bool wireframe() const;
     void setWireframe(bool wireframe);
 
@@ -302,9 +305,19 @@ public:
 
     ByteArray &rawUniformBuffer();
 
+    ComputeBuffer *instanceBuffer() const;
+    void setInstanceBuffer(ComputeBuffer *buffer);
+
+    ComputeBuffer *indirectBuffer() const;
+    uint32_t indirectOffset() const;
+    void setIndirectBuffer(ComputeBuffer *buffer, uint32_t offset);
+
     void batch(MaterialInstance &instance);
     void resetBatches();
 
+    uint32_t batchedSize();
+    void copyBatched(uint8_t *data, uint32_t offset, uint32_t size);
+
     int hash() const;
 
 protected:
@@ -317,12 +330,19 @@ protected:
     std::map<std::string, Variant> m_paramOverride;
 
     ByteArray m_uniformBuffer;
-    ByteArray m_batchBuffer;
+
+    std::vector<MaterialInstance *> m_batches;
 
     Material *m_material;
 
     Transform *m_transform;
 
+    ComputeBuffer *m_gpuInstances;
+
+    ComputeBuffer *m_indirectBuffer;
+
+    uint32_t m_indirectOffset;
+
     uint32_t m_instanceCount;
     uint32_t m_batchesCount;
 
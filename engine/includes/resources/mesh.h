@@ -27,6 +27,9 @@ public:
     bool isDynamic() const;
     void makeDynamic();
 
+    bool isQuantized() const;
+    void setQuantized(bool quantized);
+
     bool isEmpty() const;
     void clear();
 
@@ -62,8 +65,15 @@ public:
 
     int subMeshCount() const;
     void setSubMesh(int offset, int sub);
-    int indexStart(int sub) const;
-    int indexCount(int sub) const;
+    int indexStart(int sub, int lod = 0) const;
+    int indexCount(int sub, int lod = 0) const;
+
+    int lodCount() const;
+    float lodScreenSize(int lod) const;
+    void addLod(const IndexVector &indices, const IndexVector &offsets, float screenSize);
+    void clearLods();
+
+    float uvDensity() const;
 
     Material *defaultMaterial(int sub = 0) const;
     void setDefaultMaterial(Material *material, int sub = 0);
@@ -105,10 +115,16 @@ private:
 
     IndexVector m_offsets;
 
+    std::vector<float> m_lodSizes;
+
     std::vector<Material *> m_defaultMaterials;
 
     bool m_dynamic;
 
+    bool m_quantized;
+
+    mutable float m_uvDensity;
+
 };
 
 #endif // MESH_H
@@ -15,7 +15,9 @@ class ENGINE_EXPORT Texture : public Resource {
         A_PROPERTY(int, height, Texture::height, Texture::setHeight),
         A_PROPERTY(int, format, Texture::format, Texture::setFormat),
         A_PROPERTY(int, wrap, Texture::wrap, Texture::setWrap),
-        A_PROPERTY(int, filtering, Texture::filtering, Texture::setFiltering)
+        A_PROPERTY(int, filtering, Texture::filtering, Texture::setFiltering),
+        A_PROPERTY(int, compress, Texture::compress, Texture::setCompress),
+        A_PROPERTY(bool, streaming, Texture::isStreaming, Texture::setStreaming)
     )
 
     A_METHODS(
@@ -36,6 +38,16 @@ class ENGINE_EXPORT Texture : public Resource {
                A_VALUE(Depth),
                A_VALUE(RGBA32Float)),
 
+        A_ENUM(CompressionType,
+               A_VALUE(Uncompressed),
+               A_VALUE(DXT1),
+               A_VALUE(DXT5),
+               A_VALUE(ETC2),
+               A_VALUE(BC4),
+               A_VALUE(BC5),
+               A_VALUE(BC7),
+               A_VALUE(ETC2A)),
+
         A_ENUM(FilteringType,
                A_VALUE(None),
                A_VALUE(Bilinear),
@@ -62,7 +74,11 @@ public:
         Uncompressed,
         DXT1,
         DXT5,
-        ETC2
+        ETC2,
+        BC4,
+        BC5,
+        BC7,
+        ETC2A
     };
 
     enum FilteringType {
@@ -120,6 +136,15 @@ public:
     int filtering() const;
     void setFiltering(int type);
 
+    int compress() const;
+    void setCompress(int type);
+
+    bool isStreaming() const;
+    void setStreaming(bool streaming);
+
+    int residentMip() const;
+    void setResidentMip(int mip);
+
     int depthBits() const;
     void setDepthBits(int depth);
 
@@ -148,12 +173,17 @@ protected:
     int32_t sizeDXTc(int32_t width, int32_t height) const;
     int32_t sizeRGB(int32_t width, int32_t height) const;
 
+    void releaseLevels(int32_t mip);
+    bool restoreLevels(int32_t mip);
+
     bool isDwordAligned();
     int32_t dwordAlignedLineSize(int32_t width, int32_t bpp);
 
     uint8_t components() const;
 
 protected:
+    friend class TextureStreamer;
+
     Texture::Sides m_sides;
 
     int32_t m_format;
@@ -168,6 +198,13 @@ protected:
 
     int32_t m_flags;
 
+    int32_t m_residentMip;
+    int32_t m_requiredMip;
+
+    uint32_t m_lastUse;
+
+    bool m_streaming;
+
     static uint32_t s_maxTextureSize;
     static uint32_t s_maxCubemapSize;
 
@@ -6,6 +6,11 @@
 #include <material.h>
 #include <mesh.h>
 
+#include "utils/particleprogram.h"
+
+class ComputeShader;
+class ComputeBuffer;
+
 class ENGINE_EXPORT VisualEffect : public Resource {
     A_REGISTER(VisualEffect, Resource, Resources)
 
@@ -14,28 +19,6 @@ class ENGINE_EXPORT VisualEffect : public Resource {
     A_NOENUMS()
 
 public:
-    struct Argument {
-        int32_t space;
-
-        int32_t size;
-
-        int32_t offset;
-    };
-
-    struct Operator {
-        int32_t op;
-
-        int32_t resultSpace;
-
-        int32_t resultOffset;
-
-        int32_t resultSize;
-
-        std::vector<Argument> arguments;
-
-        std::vector<float> constData;
-    };
-
     enum EmitterAttributes {
         EmitterAge = 0,
         DeltaTime,
@@ -76,12 +59,17 @@ public:
 
     AABBox bound() const;
 
+    ComputeShader *computeShader() const;
+    ComputeBuffer *constantBuffer() const;
+
     void loadUserData(const VariantMap &data) override;
 
+    static void simulate(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render, const ParticleProgram::Context &context);
+
 protected:
-    std::vector<Operator> m_spawnOperations;
-    std::vector<Operator> m_updateOperations;
-    std::vector<Operator> m_renderOperations;
+    ParticleProgram m_spawnProgram;
+    ParticleProgram m_updateProgram;
+    ParticleProgram m_renderProgram;
 
     AABBox m_aabb;
 
@@ -89,6 +77,10 @@ protected:
 
     Material *m_material;
 
+    ComputeShader *m_computeShader;
+
+    ComputeBuffer *m_constantBuffer;
+
     float m_spawnRate;
 
     int m_capacity;
@@ -104,9 +96,9 @@ protected:
     bool m_continous;
 
 private:
-    void apply(std::vector<Operator> &operations, std::vector<float> &emitter, std::vector<float> &particle, std::vector<float> &render, int stage) const;
+    void loadOperations(const VariantList &list, ParticleProgram &program);
 
-    void loadOperations(const VariantList &list, std::vector<Operator> &operations);
+    void buildComputeShader();
 
 };
 
@@ -4,12 +4,16 @@
 #include "system.h"
 #include "resource.h"
 
+class LoadRequest;
+class ThreadPool;
+
 class ENGINE_EXPORT ResourceSystem : public System {
 public:
     typedef std::unordered_map<std::string, std::pair<std::string, std::string>> DictionaryMap;
 
 public:
     ResourceSystem();
+    ~ResourceSystem();
 
     void setResource(Resource *object, const std::string &uuid);
 
@@ -17,6 +21,17 @@ public:
 
     Resource *loadResource(const std::string &path);
 
+    Resource *loadResourceAsync(const std::string &path, int32_t priority = 0);
+
+    bool isLoading(Resource *resource) const;
+
+    void setLoadingPriority(Resource *resource, int32_t priority);
+
+    void cancelLoading(Resource *resource);
+
+    float finalizationBudget() const;
+    void setFinalizationBudget(float milliseconds);
+
     void unloadResource(Resource *resource, bool force = false);
 
     void reloadResource(Resource *resource, bool force = false);
@@ -25,6 +40,8 @@ public:
 
     std::string reference(Resource *resource);
 
+    VariantMap readUserData(Resource *resource);
+
     Resource *resource(std::string &path) const;
 
     DictionaryMap &indices() const;
@@ -32,6 +49,8 @@ public:
     void deleteFromCahe(Resource *resource);
 
 private:
+    friend class LoadRequest;
+
     bool init() override;
 
     void update(World *) override;
@@ -42,6 +61,17 @@ private:
 
     void processState(Resource *resource);
 
+    void dispatchRequests();
+    void finalizeRequests();
+
+    void finishRequest(LoadRequest *request);
+
+    void restoreData(Resource *resource, const Variant &data);
+
+    void applyData(Resource *resource, const std::string &uuid, const Variant &data);
+
+    static Variant readData(const std::string &uuid);
+
 private:
     mutable ResourceSystem::DictionaryMap  m_indexMap;
     std::unordered_map<std::string, Resource *> m_resourceCache;
@@ -49,6 +79,14 @@ private:
 
     ObjectList m_deleteList;
 
+    std::unordered_map<Resource *, LoadRequest *> m_requests;
+
+    ThreadPool *m_loaderPool;
+
+    uint32_t m_requestsOrder;
+
+    float m_finalizationBudget;
+
 };
 
 #endif // RESOURCESYSTEM_H
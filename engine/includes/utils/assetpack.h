@@ -0,0 +1,124 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include "engine.h"
+
+class ENGINE_EXPORT AssetPack {
+public:
+    enum Compression {
+        Stored = 0,
+        Deflate
+    };
+
+    struct Header {
+        char magic[4];
+
+        uint32_t version;
+
+        uint32_t count;
+
+        uint32_t bucketBits;
+
+        uint64_t tableOffset;
+
+        uint64_t namesOffset;
+
+        uint64_t namesSize;
+    };
+
+    struct Entry {
+        uint64_t hash;
+
+        uint64_t offset;
+
+        uint64_t size;
+
+        uint64_t originalSize;
+
+        uint32_t name;
+
+        uint16_t nameLength;
+
+        uint8_t compression;
+
+        uint8_t reserved;
+    };
+
+public:
+    AssetPack();
+    ~AssetPack();
+
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const;
+
+    uint32_t count() const;
+
+    const Entry *entry(uint32_t index) const;
+
+    const Entry *find(const std::string &name) const;
+
+    std::string name(const Entry &entry) const;
+
+    const uint8_t *data(const Entry &entry) const;
+
+    bool extract(const Entry &entry, uint8_t *buffer) const;
+
+    static uint64_t hash(const std::string &name);
+
+    static uint32_t bucket(uint64_t hash, uint32_t bits);
+
+private:
+    static uint64_t entriesOffset(const Header &header);
+
+    bool validate(const Header &header) const;
+
+private:
+    const Header *m_header;
+
+    const uint32_t *m_buckets;
+
+    const Entry *m_entries;
+
+    const char *m_names;
+
+    uint8_t *m_data;
+
+    uint64_t m_size;
+
+    void *m_handle;
+
+};
+
+class ENGINE_EXPORT AssetPackWriter {
+public:
+    enum Mode {
+        Auto = -1
+    };
+
+public:
+    void addFile(const std::string &name, const ByteArray &data, int32_t compression = Auto);
+
+    bool save(const std::string &path) const;
+
+    uint32_t count() const;
+
+private:
+    struct Item {
+        std::string name;
+
+        ByteArray data;
+
+        uint64_t originalSize;
+
+        uint8_t compression;
+    };
+
+    std::vector<Item> m_items;
+
+    std::unordered_map<std::string, size_t> m_indices;
+
+};
+
+#endif // ASSETPACK_H
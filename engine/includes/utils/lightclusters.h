@@ -0,0 +1,71 @@
+#ifndef LIGHTCLUSTERS_H
+#define LIGHTCLUSTERS_H
+
+#include "engine.h"
+
+class ENGINE_EXPORT LightClusters {
+public:
+    struct Cluster {
+        uint32_t offset;
+
+        uint32_t count;
+    };
+
+public:
+    LightClusters();
+
+    void setGridSize(uint32_t x, uint32_t y, uint32_t z);
+
+    uint32_t sizeX() const;
+    uint32_t sizeY() const;
+    uint32_t sizeZ() const;
+
+    void setPerspective(float fov, float ratio, float nearPlane, float farPlane);
+    void setOrthographic(float size, float ratio, float nearPlane, float farPlane);
+
+    float nearPlane() const;
+    float farPlane() const;
+
+    void build(const Matrix4 &view, const std::vector<Vector4> &lights);
+
+    int32_t slice(float depth) const;
+
+    uint32_t clusterIndex(uint32_t x, uint32_t y, uint32_t z) const;
+
+    AABBox clusterBound(uint32_t x, uint32_t y, uint32_t z) const;
+
+    const std::vector<Cluster> &clusters() const;
+
+    const std::vector<uint32_t> &indices() const;
+
+private:
+    void updateBounds();
+
+    float sliceDepth(uint32_t z) const;
+
+private:
+    std::vector<Cluster> m_clusters;
+
+    std::vector<uint32_t> m_indices;
+
+    std::vector<Vector3> m_bounds;
+
+    std::vector<std::pair<uint32_t, uint32_t>> m_pairs;
+
+    uint32_t m_sizeX;
+    uint32_t m_sizeY;
+    uint32_t m_sizeZ;
+
+    float m_tanX;
+    float m_tanY;
+
+    float m_near;
+    float m_far;
+
+    float m_logScale;
+
+    bool m_ortho;
+
+};
+
+#endif // LIGHTCLUSTERS_H
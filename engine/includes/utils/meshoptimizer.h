@@ -0,0 +1,34 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include "engine.h"
+
+#include "resources/mesh.h"
+
+class ENGINE_EXPORT MeshOptimizer {
+public:
+    static void optimize(Mesh &mesh);
+
+    static void optimizeVertexCache(uint32_t *indices, uint32_t count, uint32_t vertexCount);
+
+    static void optimizeOverdraw(uint32_t *indices, uint32_t count, const Vector3 *vertices, uint32_t vertexCount);
+
+    static void optimizeVertexFetch(Mesh &mesh);
+
+    static void generateLods(Mesh &mesh, uint32_t count, float ratio = 0.5f, float error = 0.01f);
+
+    static IndexVector simplify(const uint32_t *indices, uint32_t count, const Vector3 *vertices, uint32_t vertexCount, uint32_t targetCount, float targetError);
+
+    static float cacheMissRatio(const uint32_t *indices, uint32_t count, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+    static bool isQuantizable(Mesh &mesh);
+
+    static uint32_t packSnorm(const Vector3 &vector);
+    static Vector3 unpackSnorm(uint32_t value);
+
+    static uint16_t packHalf(float value);
+    static float unpackHalf(uint16_t value);
+
+};
+
+#endif // MESHOPTIMIZER_H
@@ -0,0 +1,16 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include "engine.h"
+
+#include <functional>
+
+class ENGINE_EXPORT ParallelFor {
+public:
+    typedef std::function<void(uint32_t index)> Function;
+
+    static void run(ThreadPool *pool, uint32_t count, const Function &function);
+
+};
+
+#endif // PARALLELFOR_H
@@ -0,0 +1,51 @@
+#ifndef PARTICLECOMPUTE_H
+#define PARTICLECOMPUTE_H
+
+#include "utils/particleprogram.h"
+
+#include "resources/visualeffect.h"
+
+class ENGINE_EXPORT ParticleCompute {
+public:
+    enum Bindings {
+        ParticlesBinding = 0,
+        RenderBinding,
+        StateBinding,
+        ConstantsBinding
+    };
+
+    enum DrawArguments {
+        IndexCount = 0,
+        InstanceCount,
+        FirstIndex,
+        BaseVertex,
+        BaseInstance,
+        LastArgument
+    };
+
+    enum {
+        GroupSize = 64
+    };
+
+    struct State {
+        float emitter[VisualEffect::LastAttribute];
+
+        uint32_t spawnRequest;
+
+        uint32_t spawned;
+
+        uint32_t arguments[LastArgument];
+    };
+
+public:
+    static std::string source(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render, const ParticleProgram::Context &layout);
+
+    static std::vector<float> constants(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render);
+
+    static void dispatch(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render, const ParticleProgram::Context &context, State &state);
+
+    static uint32_t argumentsOffset();
+
+};
+
+#endif // PARTICLECOMPUTE_H
@@ -0,0 +1,92 @@
+#ifndef PARTICLEPROGRAM_H
+#define PARTICLEPROGRAM_H
+
+#include "engine.h"
+
+class ENGINE_EXPORT ParticleProgram {
+public:
+    enum Operation {
+        Mov = 0,
+        Add,
+        Sub,
+        Mul,
+        Div
+    };
+
+    enum Space {
+        System,
+        Emitter,
+        Particle,
+        Renderable,
+        Local,
+        Constant,
+        Random
+    };
+
+    enum {
+        LocalRegisters = 4
+    };
+
+    struct Register {
+        int32_t space = System;
+
+        int32_t offset = 0;
+
+        int32_t size = 0;
+    };
+
+    struct Instruction {
+        int32_t op = Mov;
+
+        int32_t size = 0;
+
+        Register result;
+
+        Register arguments[2];
+    };
+
+    struct Context {
+        float *emitter = nullptr;
+
+        float *particles = nullptr;
+
+        float *render = nullptr;
+
+        int32_t capacity = 0;
+
+        int32_t stride = 0;
+
+        int32_t renderStride = 0;
+    };
+
+public:
+    void clear();
+
+    bool isEmpty() const;
+
+    const std::vector<Instruction> &instructions() const;
+
+    const std::vector<float> &constants() const;
+
+    int32_t addConstant(const Vector4 &value);
+    int32_t addRandom(const Vector4 &min, const Vector4 &max, int32_t size, int32_t capacity);
+
+    void addInstruction(const Instruction &instruction);
+
+    void execute(const Context &context, int32_t first, int32_t count) const;
+
+    static int32_t compact(const Context &context, int32_t count);
+
+    static int32_t bufferSize(int32_t stride, int32_t capacity);
+
+private:
+    float *address(const Context &context, const Register &reg, int32_t component, int32_t first, int32_t &step) const;
+
+private:
+    std::vector<Instruction> m_instructions;
+
+    std::vector<float> m_constants;
+
+};
+
+#endif // PARTICLEPROGRAM_H
@@ -0,0 +1,76 @@
+#ifndef QUERYBATCH_H
+#define QUERYBATCH_H
+
+#include "engine.h"
+
+class ENGINE_EXPORT QueryBatch {
+public:
+    enum Type {
+        RayCast = 0,
+        RayCastAll,
+        SphereCast,
+        Overlap
+    };
+
+    enum State {
+        Idle = 0,
+        Pending,
+        Ready
+    };
+
+    struct Query {
+        Ray ray;
+
+        float distance = 0.0f;
+
+        float radius = 0.0f;
+
+        int32_t type = RayCast;
+
+        uint32_t first = 0;
+
+        uint32_t capacity = 1;
+
+        uint32_t count = 0;
+    };
+
+public:
+    QueryBatch();
+
+    void clear();
+
+    uint32_t size() const;
+
+    int32_t state() const;
+    void setState(int32_t state);
+
+    bool isReady() const;
+
+    uint32_t addRayCast(const Ray &ray, float distance);
+    uint32_t addRayCastAll(const Ray &ray, float distance, uint32_t maxHits);
+    uint32_t addSphereCast(const Ray &ray, float radius, float distance);
+    uint32_t addOverlap(const Vector3 &center, float radius, uint32_t maxHits);
+
+    const Query &query(uint32_t index) const;
+
+    uint32_t hitCount(uint32_t index) const;
+    const Ray::Hit &hit(uint32_t index, uint32_t number = 0) const;
+
+    Ray::Hit *hits(uint32_t index);
+    void setHitCount(uint32_t index, uint32_t count);
+
+    void resetHits();
+
+private:
+    uint32_t addQuery(int32_t type, const Ray &ray, float radius, float distance, uint32_t capacity);
+
+private:
+    std::vector<Query> m_queries;
+
+    std::vector<Ray::Hit> m_hits;
+
+    int32_t m_state;
+
+};
+
+#endif // QUERYBATCH_H
@@ -0,0 +1,35 @@
+#ifndef TEXTUREENCODER_H
+#define TEXTUREENCODER_H
+
+#include "engine.h"
+
+class ENGINE_EXPORT TextureEncoder {
+public:
+    enum Quality {
+        Fast = 0,
+        Normal,
+        Best
+    };
+
+    enum MipFilter {
+        Box = 0,
+        Triangle,
+        Kaiser
+    };
+
+public:
+    static ByteArray encode(const uint8_t *rgba, int32_t width, int32_t height, int32_t compression, int32_t quality = Normal);
+
+    static ByteArray decode(const uint8_t *data, int32_t width, int32_t height, int32_t compression);
+
+    static ByteArray downsample(const uint8_t *rgba, int32_t width, int32_t height, int32_t filter = Box, bool srgb = true);
+
+    static uint32_t blockSize(int32_t compression);
+
+    static void encodeBlock(const uint8_t *rgba, uint8_t *block, int32_t compression, int32_t quality = Normal);
+
+    static void decodeBlock(const uint8_t *block, uint8_t *rgba, int32_t compression);
+
+};
+
+#endif // TEXTUREENCODER_H
@@ -0,0 +1,71 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+
+#include "engine.h"
+
+class Texture;
+
+class ENGINE_EXPORT TextureStreamer {
+public:
+    struct Statistics {
+        uint64_t budget = 0;
+
+        uint64_t residentMemory = 0;
+
+        uint64_t requestedMemory = 0;
+
+        uint32_t textures = 0;
+
+        uint32_t visible = 0;
+
+        uint32_t partial = 0;
+
+        uint32_t upgrades = 0;
+
+        uint32_t evictions = 0;
+    };
+
+    struct Residency {
+        std::vector<uint64_t> sizes;
+
+        int32_t resident = 0;
+
+        int32_t required = INT32_MAX;
+
+        int32_t tail = 0;
+
+        int32_t target = 0;
+
+        uint32_t lastUse = 0;
+    };
+    typedef std::vector<Residency> ResidencyList;
+
+public:
+    static void addTexture(Texture *texture);
+    static void removeTexture(Texture *texture);
+
+    static void requestMip(Texture *texture, int32_t mip);
+
+    static void update();
+
+    static uint64_t budget();
+    static void setBudget(uint64_t bytes);
+
+    static const Statistics &statistics();
+
+    static int32_t tailMip(int32_t width, int32_t height, int32_t mipCount);
+
+    static Statistics plan(ResidencyList &list, uint64_t budget);
+
+private:
+    static std::list<Texture *> m_textures;
+
+    static Statistics m_statistics;
+
+    static uint64_t m_budget;
+
+    static uint32_t m_frame;
+
+};
+
+#endif // TEXTURESTREAMER_H
@@ -0,0 +1,109 @@
+#ifndef VOICEMIXER_H
+#define VOICEMIXER_H
+
+#include "engine.h"
+
+#include <cfloat>
+
+class ENGINE_EXPORT VoiceMixer {
+public:
+    struct Clip {
+        const int16_t *data = nullptr;
+
+        uint32_t frames = 0;
+
+        uint32_t channels = 1;
+
+        uint32_t frequency = 0;
+
+        float loudness = 1.0f;
+    };
+
+    struct Emitter {
+        Clip clip;
+
+        Vector3 position;
+
+        float volume = 1.0f;
+
+        float minDistance = 1.0f;
+
+        float maxDistance = FLT_MAX;
+
+        int32_t priority = 0;
+
+        bool loop = false;
+    };
+
+public:
+    VoiceMixer(uint32_t frequency, uint32_t realVoices);
+
+    uint32_t frequency() const;
+
+    uint32_t realVoices() const;
+
+    uint32_t play(const Emitter &emitter);
+    void stop(uint32_t voice);
+
+    bool isPlaying(uint32_t voice) const;
+    bool isReal(uint32_t voice) const;
+
+    uint32_t position(uint32_t voice) const;
+
+    void setPosition(uint32_t voice, const Vector3 &position);
+    void setVolume(uint32_t voice, float volume);
+    void setLoop(uint32_t voice, bool loop);
+
+    void setListener(const Vector3 &position, const Vector3 &right);
+
+    void mix(float *output, uint32_t frames);
+
+    static float loudness(const int16_t *data, uint32_t samples);
+
+    static void convert(const float *input, int16_t *output, uint32_t samples);
+
+private:
+    struct Voice {
+        Emitter emitter;
+
+        uint64_t position = 0;
+
+        float score = 0.0f;
+
+        float gains[2] = {0.0f, 0.0f};
+
+        uint32_t id = 0;
+
+        bool real = false;
+
+        bool finished = false;
+    };
+
+    void prioritize();
+
+    void render(Voice &voice, float *output, uint32_t frames);
+
+    void advance(Voice &voice, uint32_t frames);
+
+    uint64_t step(const Voice &voice) const;
+
+private:
+    std::map<uint32_t, Voice> m_voices;
+
+    std::vector<Voice *> m_order;
+
+    std::vector<float> m_scratch;
+
+    Vector3 m_listener;
+
+    Vector3 m_right;
+
+    uint32_t m_frequency;
+
+    uint32_t m_realVoices;
+
+    uint32_t m_nextVoice;
+
+};
+
+#endif // VOICEMIXER_H
@@ -1,8 +1,11 @@
 #include "commandbuffer.h"
 
+#include "commandlist.h"
+
 #include <cstring>
 
 static bool s_Inited = false;
+static bool s_ComputeSupported = false;
 
 /*!
     \class CommandBuffer
@@ -61,6 +64,18 @@ void CommandBuffer::setRenderTarget(RenderTarget *target, uint32_t level) {
     A_UNUSED(target);
     A_UNUSED(level);
 }
+/*!
+    Copies the depth of the region from the \a source render target to the same region of the current render target.
+    Parameters \a x and \a y represents the region coordinates, \a width and \a height the region dimensions.
+    Both render targets must have the depth attachments of the same format.
+*/
+void CommandBuffer::copyRenderTarget(RenderTarget *source, int32_t x, int32_t y, int32_t width, int32_t height) {
+    A_UNUSED(source);
+    A_UNUSED(x);
+    A_UNUSED(y);
+    A_UNUSED(width);
+    A_UNUSED(height);
+}
 /*!
     Converts a 32-bit \a id to a Vector4 color.
 */
@@ -85,6 +100,19 @@ bool CommandBuffer::isInited() {
 void CommandBuffer::setInited() {
     s_Inited = true;
 }
+/*!
+    Returns true if the compute shaders and the indirect draws are supported by the render backend; otherwise, false.
+*/
+bool CommandBuffer::isComputeSupported() {
+    return s_ComputeSupported;
+}
+/*!
+    \internal
+    Sets the compute shaders and the indirect draws \a supported by the render backend.
+*/
+void CommandBuffer::setComputeSupported(bool supported) {
+    s_ComputeSupported = supported;
+}
 /*!
      Sets the \a view and \a projection matrices.
 */
@@ -169,6 +197,13 @@ void CommandBuffer::beginDebugMarker(const char *name) {
 */
 void CommandBuffer::endDebugMarker() {
 
+}
+/*!
+    Replays all commands recorded into the command \a list.
+    Must be called from the render thread.
+*/
+void CommandBuffer::execute(const CommandList &list) {
+    list.replay(*this);
 }
 /*!
     Returns Vector2 representing the viewport dimensions.
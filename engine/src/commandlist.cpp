@@ -0,0 +1,370 @@
+#include "commandlist.h"
+
+#include "commandbuffer.h"
+
+#include "resources/material.h"
+
+#include <cstring>
+
+namespace {
+    const uint32_t gPacketAlignment = 8;
+    const uint32_t gMaxNameLength = 255;
+};
+
+/*!
+    \class CommandList
+    \brief Records rendering commands to be replayed on a CommandBuffer later.
+    \inmodule Engine
+
+    The CommandList class mirrors the recording part of the CommandBuffer interface, but instead of issuing the commands it stores them as compact POD packets in a linear memory block.
+    The memory is retained between frames, clear() only resets the write position.
+
+    CommandList does not touch any graphics API, so it's safe to record different lists from different threads.
+    The lists can be merged with append() and must be replayed on the render thread with replay() or CommandBuffer::execute().
+
+    All recorded pointers (meshes, material instances, render targets and textures) must stay valid until the list is replayed.
+    The material instances are not touched during the recording, so the uniform data is taken at the moment of the replay.
+*/
+
+CommandList::CommandList() :
+        m_count(0) {
+
+}
+/*!
+    Records a command to clear the render target with the specified \a color and \a depth values.
+    Flag \a clearColor indicating whether to clear the color buffer.
+    Flag \a clearDepth indicating whether to clear the depth buffer.
+*/
+void CommandList::clearRenderTarget(bool clearColor, const Vector4 &color, bool clearDepth, float depth) {
+    ClearPacket *packet = reinterpret_cast<ClearPacket *>(allocate(ClearRenderTarget, sizeof(ClearPacket)));
+    packet->color[0] = color.x;
+    packet->color[1] = color.y;
+    packet->color[2] = color.z;
+    packet->color[3] = color.w;
+    packet->depth = depth;
+    packet->clearColor = clearColor;
+    packet->clearDepth = clearDepth;
+}
+/*!
+    Records a compute \a shader dispatch with the specified workgroup dimensions \a groupsX, \a groupsY and \a groupsZ.
+*/
+void CommandList::dispatchCompute(ComputeInstance *shader, int32_t groupsX, int32_t groupsY, int32_t groupsZ) {
+    DispatchPacket *packet = reinterpret_cast<DispatchPacket *>(allocate(DispatchCompute, sizeof(DispatchPacket)));
+    packet->shader = shader;
+    packet->groupsX = groupsX;
+    packet->groupsY = groupsY;
+    packet->groupsZ = groupsZ;
+}
+/*!
+    Records a draw of the \a mesh with the specified \a sub mesh index with assigned material \a instance, and rendering \a layer.
+*/
+void CommandList::drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance &instance) {
+    DrawPacket *packet = reinterpret_cast<DrawPacket *>(allocate(DrawMesh, sizeof(DrawPacket)));
+    packet->mesh = mesh;
+    packet->instance = &instance;
+    packet->sub = sub;
+    packet->layer = layer;
+    packet->batches = 0;
+}
+/*!
+    Records a draw of the \a mesh with the specified \a sub mesh index with assigned material \a instance, and rendering \a layer.
+    The \a batches instances are drawn together with the \a instance using GPU instancing, they are stored right after the packet.
+*/
+void CommandList::drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance &instance, const std::vector<MaterialInstance *> &batches) {
+    uint32_t size = batches.size() * sizeof(MaterialInstance *);
+
+    DrawPacket *packet = reinterpret_cast<DrawPacket *>(allocate(DrawMesh, sizeof(DrawPacket) + size));
+    packet->mesh = mesh;
+    packet->instance = &instance;
+    packet->sub = sub;
+    packet->layer = layer;
+    packet->batches = batches.size();
+    if(size > 0) {
+        memcpy(packet + 1, batches.data(), size);
+    }
+}
+/*!
+    Records a change of the render \a target with Mipmap \a level.
+*/
+void CommandList::setRenderTarget(RenderTarget *target, uint32_t level) {
+    TargetPacket *packet = reinterpret_cast<TargetPacket *>(allocate(SetRenderTarget, sizeof(TargetPacket)));
+    packet->target = target;
+    packet->level = level;
+}
+/*!
+    Records a change of the \a view and \a projection matrices.
+*/
+void CommandList::setViewProjection(const Matrix4 &view, const Matrix4 &projection) {
+    ViewProjectionPacket *packet = reinterpret_cast<ViewProjectionPacket *>(allocate(SetViewProjection, sizeof(ViewProjectionPacket)));
+    memcpy(packet->view, view.mat, sizeof(packet->view));
+    memcpy(packet->projection, projection.mat, sizeof(packet->projection));
+}
+/*!
+    Records a change of the global \a value with a given \a name.
+    Only plain value types (numbers, vectors and matrices) can be recorded, other values are ignored.
+*/
+void CommandList::setGlobalValue(const char *name, const Variant &value) {
+    uint32_t type = value.type();
+    if(type == MetaType::INVALID || (type >= MetaType::STRING && type < MetaType::VECTOR2) || type > MetaType::MATRIX4) {
+        return;
+    }
+
+    int size = MetaType::size(type);
+    if(size <= 0 || size > static_cast<int>(sizeof(ValuePacket::data))) {
+        return;
+    }
+
+    ValuePacket *packet = reinterpret_cast<ValuePacket *>(allocate(SetGlobalValue, sizeof(ValuePacket), name));
+    memcpy(packet->data, value.data(), size);
+    packet->type = type;
+}
+/*!
+    Records a change of the global \a texture with a given \a name.
+*/
+void CommandList::setGlobalTexture(const char *name, Texture *texture) {
+    TexturePacket *packet = reinterpret_cast<TexturePacket *>(allocate(SetGlobalTexture, sizeof(TexturePacket), name));
+    packet->texture = texture;
+}
+/*!
+    Records a change of the viewport dimensions.
+    Parameters \a x and \a y represents viewport coordinates.
+    \a width and \a height viewport dimensions.
+*/
+void CommandList::setViewport(int32_t x, int32_t y, int32_t width, int32_t height) {
+    RectPacket *packet = reinterpret_cast<RectPacket *>(allocate(SetViewport, sizeof(RectPacket)));
+    packet->x = x;
+    packet->y = y;
+    packet->width = width;
+    packet->height = height;
+}
+/*!
+    Records enabling of the scissor test.
+    Parameters \a x and \a y represents scissor coordinates.
+    \a width and \a height scissor dimensions.
+*/
+void CommandList::enableScissor(int32_t x, int32_t y, int32_t width, int32_t height) {
+    RectPacket *packet = reinterpret_cast<RectPacket *>(allocate(EnableScissor, sizeof(RectPacket)));
+    packet->x = x;
+    packet->y = y;
+    packet->width = width;
+    packet->height = height;
+}
+/*!
+    Records disabling of the scissor test.
+*/
+void CommandList::disableScissor() {
+    allocate(DisableScissor, 0);
+}
+/*!
+    Records the beginning of a debug marker with the specified \a name.
+*/
+void CommandList::beginDebugMarker(const char *name) {
+    allocate(BeginDebugMarker, 0, name);
+}
+/*!
+    Records the end of the current debug marker.
+*/
+void CommandList::endDebugMarker() {
+    allocate(EndDebugMarker, 0);
+}
+/*!
+    Appends all commands from the \a list to the end of this list.
+*/
+void CommandList::append(const CommandList &list) {
+    if(list.m_data.empty()) {
+        return;
+    }
+
+    size_t offset = m_data.size();
+    m_data.resize(offset + list.m_data.size());
+    memcpy(&m_data[offset], list.m_data.data(), list.m_data.size());
+
+    m_count += list.m_count;
+}
+/*!
+    Issues all recorded commands to the command \a buffer in the recording order.
+    Must be called from the render thread.
+*/
+void CommandList::replay(CommandBuffer &buffer) const {
+    PROFILE_FUNCTION();
+
+    for(auto it = begin(); it != end(); ++it) {
+        switch(it.header().type) {
+            case ClearRenderTarget: {
+                const ClearPacket &packet = it.packet<ClearPacket>();
+                buffer.clearRenderTarget(packet.clearColor, Vector4(packet.color[0], packet.color[1], packet.color[2], packet.color[3]),
+                                         packet.clearDepth, packet.depth);
+            } break;
+            case DispatchCompute: {
+                const DispatchPacket &packet = it.packet<DispatchPacket>();
+                buffer.dispatchCompute(packet.shader, packet.groupsX, packet.groupsY, packet.groupsZ);
+            } break;
+            case DrawMesh: {
+                const DrawPacket &packet = it.packet<DrawPacket>();
+                MaterialInstance *const *batches = reinterpret_cast<MaterialInstance *const *>(&packet + 1);
+                for(uint32_t i = 0; i < packet.batches; i++) {
+                    packet.instance->batch(*batches[i]);
+                }
+                buffer.drawMesh(packet.mesh, packet.sub, packet.layer, *packet.instance);
+                if(packet.batches > 0) {
+                    packet.instance->resetBatches();
+                }
+            } break;
+            case SetRenderTarget: {
+                const TargetPacket &packet = it.packet<TargetPacket>();
+                buffer.setRenderTarget(packet.target, packet.level);
+            } break;
+            case SetViewProjection: {
+                const ViewProjectionPacket &packet = it.packet<ViewProjectionPacket>();
+                Matrix4 view;
+                memcpy(view.mat, packet.view, sizeof(packet.view));
+                Matrix4 projection;
+                memcpy(projection.mat, packet.projection, sizeof(packet.projection));
+                buffer.setViewProjection(view, projection);
+            } break;
+            case SetGlobalValue: {
+                const ValuePacket &packet = it.packet<ValuePacket>();
+                buffer.setGlobalValue(it.name(), Variant(packet.type, const_cast<uint8_t *>(packet.data)));
+            } break;
+            case SetGlobalTexture: {
+                buffer.setGlobalTexture(it.name(), it.packet<TexturePacket>().texture);
+            } break;
+            case SetViewport: {
+                const RectPacket &packet = it.packet<RectPacket>();
+                buffer.setViewport(packet.x, packet.y, packet.width, packet.height);
+            } break;
+            case EnableScissor: {
+                const RectPacket &packet = it.packet<RectPacket>();
+                buffer.enableScissor(packet.x, packet.y, packet.width, packet.height);
+            } break;
+            case DisableScissor: {
+                buffer.disableScissor();
+            } break;
+            case BeginDebugMarker: {
+                buffer.beginDebugMarker(it.name());
+            } break;
+            case EndDebugMarker: {
+                buffer.endDebugMarker();
+            } break;
+            default: break;
+        }
+    }
+}
+/*!
+    Removes all recorded commands.
+    The allocated memory is retained to be reused by the next recording.
+*/
+void CommandList::clear() {
+    m_data.clear();
+    m_count = 0;
+}
+/*!
+    Returns true if the list contains no commands; otherwise returns false.
+*/
+bool CommandList::isEmpty() const {
+    return m_count == 0;
+}
+/*!
+    Returns the number of recorded commands.
+*/
+uint32_t CommandList::count() const {
+    return m_count;
+}
+/*!
+    Returns the size of recorded data in bytes.
+*/
+uint32_t CommandList::size() const {
+    return m_data.size();
+}
+/*!
+    Returns an iterator pointing to the first recorded command.
+*/
+CommandList::Iterator CommandList::begin() const {
+    return Iterator(m_data.data());
+}
+/*!
+    Returns an iterator pointing past the last recorded command.
+*/
+CommandList::Iterator CommandList::end() const {
+    return Iterator(m_data.data() + m_data.size());
+}
+/*!
+    \internal
+    Reserves space for a new packet with a given \a type, payload \a size and an optional \a name.
+    Returns a pointer to the payload.
+*/
+uint8_t *CommandList::allocate(uint16_t type, uint32_t size, const char *name) {
+    uint32_t nameLength = 0;
+    if(name) {
+        nameLength = MIN(static_cast<uint32_t>(strlen(name)), gMaxNameLength);
+    }
+
+    uint32_t total = sizeof(Header) + size;
+    uint32_t nameOffset = 0;
+    if(name) {
+        nameOffset = total;
+        total += nameLength + 1;
+    }
+    total = (total + gPacketAlignment - 1) & ~(gPacketAlignment - 1);
+
+    size_t offset = m_data.size();
+    m_data.resize(offset + total);
+
+    uint8_t *data = &m_data[offset];
+
+    Header *header = reinterpret_cast<Header *>(data);
+    header->size = total;
+    header->type = type;
+    header->name = nameOffset;
+
+    if(name) {
+        memcpy(data + nameOffset, name, nameLength);
+        data[nameOffset + nameLength] = 0;
+    }
+
+    m_count++;
+
+    return data + sizeof(Header);
+}
+
+/*!
+    \class CommandList::Iterator
+    \brief Iterates over packets recorded into the CommandList.
+    \inmodule Engine
+
+    The iterator allows to inspect recorded commands without replaying them.
+*/
+
+CommandList::Iterator::Iterator(const uint8_t *data) :
+        m_data(data) {
+
+}
+/*!
+    Returns the header of the current packet.
+*/
+const CommandList::Header &CommandList::Iterator::header() const {
+    return *reinterpret_cast<const Header *>(m_data);
+}
+/*!
+    Returns the name attached to the current packet or empty string if the packet has no name.
+*/
+const char *CommandList::Iterator::name() const {
+    const Header &h = header();
+    if(h.name == 0) {
+        return "";
+    }
+    return reinterpret_cast<const char *>(m_data + h.name);
+}
+/*!
+    Moves the iterator to the next packet.
+*/
+CommandList::Iterator &CommandList::Iterator::operator++() {
+    m_data += header().size;
+    return *this;
+}
+/*!
+    \internal
+*/
+bool CommandList::Iterator::operator!=(const Iterator &other) const {
+    return m_data != other.m_data;
+}
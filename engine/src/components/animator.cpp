@@ -3,6 +3,7 @@
 #include "components/actor.h"
 
 #include "private/baseanimationblender.h"
+#include "private/animationbatch.h"
 
 #include "resources/animationclip.h"
 #include "resources/animationstatemachine.h"
@@ -31,6 +32,8 @@ Animator::Animator() :
 }
 
 Animator::~Animator() {
+    AnimationBatch::removeAnimator(this);
+
     if(m_stateMachine) {
         m_stateMachine->unsubscribe(this);
     }
@@ -86,7 +89,9 @@ void Animator::update() {
             auto next = m_currentState->m_transitions.begin();
             setStateHash(next->m_targetState->m_hash);
         } else {
-            setPosition(m_time + static_cast<uint32_t>(1000.0f * Timer::deltaTime()));
+            // The clips are evaluated later with the rest of the animators
+            m_time += static_cast<uint32_t>(1000.0f * Timer::deltaTime());
+            AnimationBatch::addAnimator(this);
         }
     }
 }
@@ -146,9 +151,7 @@ void Animator::setPosition(uint32_t position) {
 
     m_time = position;
 
-    for(auto it : m_properties) {
-        it.second->setCurrentTime(m_time);
-    }
+    evaluate();
 }
 /*!
     Changes the current \a state of state machine immediately.
@@ -390,6 +393,30 @@ void Animator::setClips(AnimationClip *start, AnimationClip *end, float duration
         property->start();
     }
 }
+/*!
+    \internal
+    Applies the animation of all bound properties at the current position.
+*/
+void Animator::evaluate() {
+    PROFILE_FUNCTION();
+
+    for(auto &it : m_properties) {
+        it.second->setCurrentTime(m_time);
+    }
+}
+/*!
+    \internal
+    Applies the animation at the current position only to the Transform channels if \a transforms is true; otherwise only to the rest of the properties.
+*/
+void Animator::evaluateChannels(bool transforms) {
+    PROFILE_FUNCTION();
+
+    for(auto &it : m_properties) {
+        if(it.second->isTransformChannel() == transforms) {
+            it.second->setCurrentTime(m_time);
+        }
+    }
+}
 /*!
     \internal
 */
@@ -9,12 +9,19 @@
 
 #include "systems/resourcesystem.h"
 
+#include "private/animationbatch.h"
+
 #include "commandbuffer.h"
 #include "gizmos.h"
 
 #include <cstring>
 #include <cfloat>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define ARMATURE_SSE
+#endif
+
 #define M4X3_SIZE 48
 #define MAX_BONES 170
 
@@ -22,6 +29,29 @@ namespace {
     const char *gPose = "Pose";
 }
 
+// Multiplies the column major matrices, the result must not overlap the arguments
+static inline void multiply(const float *left, const float *right, float *result) {
+#ifdef ARMATURE_SSE
+    __m128 c0 = _mm_loadu_ps(&left[0]);
+    __m128 c1 = _mm_loadu_ps(&left[4]);
+    __m128 c2 = _mm_loadu_ps(&left[8]);
+    __m128 c3 = _mm_loadu_ps(&left[12]);
+    for(int i = 0; i < 16; i += 4) {
+        __m128 r = _mm_mul_ps(c0, _mm_set1_ps(right[i]));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(right[i + 1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(right[i + 2])));
+        r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(right[i + 3])));
+        _mm_storeu_ps(&result[i], r);
+    }
+#else
+    for(int i = 0; i < 16; i += 4) {
+        for(int j = 0; j < 4; j++) {
+            result[i + j] = left[j] * right[i] + left[4 + j] * right[i + 1] + left[8 + j] * right[i + 2] + left[12 + j] * right[i + 3];
+        }
+    }
+#endif
+}
+
 /*!
     \class Armature
     \brief A bone management component.
@@ -51,39 +81,62 @@ Armature::Armature() :
 }
 
 Armature::~Armature() {
+    AnimationBatch::removeArmature(this);
+
     if(m_bindPose) {
         m_bindPose->unsubscribe(this);
     }
 }
 /*!
     \internal
+    In game mode the palette is calculated later together with the rest of the armatures.
 */
 void Armature::update() {
+    if(Engine::isGameMode()) {
+        AnimationBatch::addArmature(this);
+    } else {
+        updatePalette();
+        m_cache->setDirty();
+    }
+}
+/*!
+    \internal
+    Calculates the skinning matrices of the bones relative to the Armature and packs them to the cache texture as 3x4 matrices.
+*/
+void Armature::updatePalette() {
+    PROFILE_FUNCTION();
+
     if(m_bindDirty) {
         cleanDirty();
     }
 
     Texture::Surface &surface = m_cache->surface(0);
     ByteArray &array = surface.front();
-    uint8_t *data = array.data();
+    float *data = reinterpret_cast<float *>(array.data());
 
     Transform *t = transform();
     if(t) {
         Matrix4 localInv(t->worldTransform().inverse());
 
-        for(uint32_t i = 0; i < m_bones.size(); i++) {
-            if(i < m_invertTransform.size() && m_bones[i]) {
-                Matrix4 t(localInv * m_bones[i]->worldTransform() * m_invertTransform[i]);
-
-                // Compress data
-                t[3]  = t[12];
-                t[7]  = t[13];
-                t[11] = t[14];
-
-                memcpy(&data[i * M4X3_SIZE], t.mat, M4X3_SIZE);
+        uint32_t count = MIN(m_bones.size(), m_invertTransform.size());
+        count = MIN(count, static_cast<uint32_t>(MAX_BONES));
+        for(uint32_t i = 0; i < count; i++) {
+            if(m_bones[i]) {
+                float world[16];
+                float palette[16];
+                multiply(localInv.mat, m_bones[i]->worldTransform().mat, world);
+                multiply(world, m_invertTransform[i].mat, palette);
+
+                // Compress data, the translation is stored in the last row
+                float *bone = &data[i * 12];
+                memcpy(bone, palette, sizeof(float) * 3);
+                bone[3] = palette[12];
+                memcpy(&bone[4], &palette[4], sizeof(float) * 3);
+                bone[7] = palette[13];
+                memcpy(&bone[8], &palette[8], sizeof(float) * 3);
+                bone[11] = palette[14];
             }
         }
-        m_cache->setDirty();
     }
 }
 /*!
@@ -10,10 +10,30 @@
 
 #include "visualeffect.h"
 #include "material.h"
+#include "computeshader.h"
+#include "computebuffer.h"
 
 #include "commandbuffer.h"
 #include "timer.h"
 
+#include "private/effectbatch.h"
+
+#include "utils/particlecompute.h"
+
+namespace {
+    const char *gParticles("Particles");
+    const char *gRenderables("Renderables");
+    const char *gEmitter("Emitter");
+    const char *gConstants("Constants");
+};
+
+static ComputeBuffer *createBuffer(const uint8_t *data, size_t size) {
+    ComputeBuffer *result = Engine::objectCreate<ComputeBuffer>();
+    result->incRef();
+    result->setData(data ? ByteArray(data, data + size) : ByteArray(size, 0));
+    return result;
+}
+
 /*!
     \class EffectRender
     \brief Draws a particle effect on the scene.
@@ -23,29 +43,51 @@
 */
 
 EffectRender::EffectRender() :
-        m_effect(nullptr) {
+        m_effect(nullptr),
+        m_computeInstance(nullptr),
+        m_particlesBuffer(nullptr),
+        m_renderBuffer(nullptr),
+        m_stateBuffer(nullptr) {
 
 }
 
 EffectRender::~EffectRender() {
+    EffectBatch::removeEmitter(this);
+
+    releaseCompute();
+
     if(m_effect) {
         m_effect->unsubscribe(this);
     }
 }
 /*!
     \internal
+    The particles are simulated later in parallel with the other emitters.
 */
 void EffectRender::update() {
-    deltaUpdate(Timer::deltaTime() * Timer::scale());
+    if(prepare(Timer::deltaTime() * Timer::scale())) {
+        EffectBatch::addEmitter(this);
+    }
 }
 /*!
-    \internal
+    Simulates the particles of the effect immediately with the given \a dt time step.
 */
 void EffectRender::deltaUpdate(float dt) {
+    if(prepare(dt)) {
+        simulate();
+        upload();
+    }
+}
+/*!
+    \internal
+    Updates the emitter state with the \a dt time step.
+    Returns false if the effect must not be simulated.
+*/
+bool EffectRender::prepare(float dt) {
     if(m_effect && isEnabled()) {
         Camera *camera = Camera::current();
         if(camera == nullptr || m_materials.empty()) {
-            return;
+            return false;
         }
 
         float &emitterAge = m_emitterData[VisualEffect::EmitterAge];
@@ -63,28 +105,116 @@ void EffectRender::deltaUpdate(float dt) {
             }
         }
 
-        m_effect->update(m_emitterData, m_particleData, m_renderData);
+        return true;
+    }
+    return false;
+}
+/*!
+    \internal
+    Simulates the particles, it touches only the own buffers of the component.
+*/
+void EffectRender::simulate() {
+    m_effect->update(m_emitterData, m_particleData, m_renderData);
 
-        if(m_effect->local()) {
-            Matrix4 world(transform()->worldTransform());
+    if(m_effect->local()) {
+        Matrix4 world(transform()->worldTransform());
 
-            int32_t count = static_cast<int32_t>(m_emitterData[VisualEffect::AliveParticles]);
-            int32_t stride = m_effect->renderableStride();
+        int32_t count = static_cast<int32_t>(m_emitterData[VisualEffect::AliveParticles]);
+        int32_t stride = m_effect->renderableStride();
 
-            for(int32_t i = 0; i < count; i++) {
-                int index = i * stride;
-                Vector3 p(world * Vector3(m_renderData[index + 12], m_renderData[index + 13], m_renderData[index + 14]));
-                m_renderData[index + 12] = p.x;
-                m_renderData[index + 13] = p.y;
-                m_renderData[index + 14] = p.z;
-            }
+        for(int32_t i = 0; i < count; i++) {
+            int index = i * stride;
+            Vector3 p(world * Vector3(m_renderData[index + 12], m_renderData[index + 13], m_renderData[index + 14]));
+            m_renderData[index + 12] = p.x;
+            m_renderData[index + 13] = p.y;
+            m_renderData[index + 14] = p.z;
         }
+    }
+}
+/*!
+    \internal
+    Passes the simulated particles to the material instance.
+*/
+void EffectRender::upload() {
+    MaterialInstance *instance = m_materials.front();
+    instance->setInstanceBuffer(nullptr);
+    instance->setIndirectBuffer(nullptr, 0);
+    instance->setInstanceCount(static_cast<int32_t>(m_emitterData[VisualEffect::AliveParticles]));
+
+    memcpy(instance->rawUniformBuffer().data(), m_renderData.data(), m_renderData.size());
+}
+/*!
+    \internal
+    Records the GPU simulation of the particles to the command \a buffer.
+    The particles stay resident on GPU and are drawn with the arguments produced by the simulation.
+*/
+void EffectRender::dispatch(CommandBuffer &buffer) {
+    ParticleCompute::State state;
+    memcpy(state.emitter, m_emitterData.data(), sizeof(state.emitter));
+
+    float &spawnCounter = m_emitterData[VisualEffect::SpawnCounter];
+    state.spawnRequest = static_cast<uint32_t>(MAX(spawnCounter, 0.0f));
+    state.spawned = 0;
+    spawnCounter -= state.spawnRequest;
+
+    Mesh *mesh = m_effect->mesh();
+    bool indexed = mesh && !mesh->indices().empty();
+    state.arguments[ParticleCompute::IndexCount] = mesh ? (indexed ? mesh->indexCount(0) : mesh->vertices().size()) : 0;
+    state.arguments[ParticleCompute::InstanceCount] = 0;
+    state.arguments[ParticleCompute::FirstIndex] = indexed ? mesh->indexStart(0) : 0;
+    state.arguments[ParticleCompute::BaseVertex] = 0;
+    state.arguments[ParticleCompute::BaseInstance] = 0;
+
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(&state);
+    m_stateBuffer->setData(ByteArray(data, data + sizeof(state)));
+
+    int32_t groups = (m_effect->capacity() + ParticleCompute::GroupSize - 1) / ParticleCompute::GroupSize;
+    buffer.dispatchCompute(m_computeInstance, groups, 1, 1);
+
+    MaterialInstance *instance = m_materials.front();
+    instance->setInstanceBuffer(m_renderBuffer);
+    instance->setIndirectBuffer(m_stateBuffer, ParticleCompute::argumentsOffset());
+}
+/*!
+    \internal
+    Creates the compute buffers for the GPU simulation of the effect.
+    The effects in local space are simulated on CPU.
+*/
+void EffectRender::createCompute() {
+    releaseCompute();
+
+    ComputeShader *shader = m_effect->computeShader();
+    if(shader == nullptr || m_effect->local() || m_materials.empty()) {
+        return;
+    }
 
-        MaterialInstance *instance = m_materials.front();
-        instance->setInstanceCount(static_cast<int32_t>(m_emitterData[VisualEffect::AliveParticles]));
+    int32_t size = ParticleProgram::bufferSize(m_effect->particleStride(), m_effect->capacity()) * sizeof(float);
 
-        memcpy(instance->rawUniformBuffer().data(), m_renderData.data(), m_renderData.size());
+    m_particlesBuffer = createBuffer(nullptr, size);
+    m_renderBuffer = createBuffer(reinterpret_cast<const uint8_t *>(m_renderData.data()), m_renderData.size() * sizeof(float));
+    m_stateBuffer = createBuffer(nullptr, sizeof(ParticleCompute::State));
+
+    m_computeInstance = shader->createInstance();
+    m_computeInstance->setBuffer(gParticles, m_particlesBuffer);
+    m_computeInstance->setBuffer(gRenderables, m_renderBuffer);
+    m_computeInstance->setBuffer(gEmitter, m_stateBuffer);
+    m_computeInstance->setBuffer(gConstants, m_effect->constantBuffer());
+}
+/*!
+    \internal
+*/
+void EffectRender::releaseCompute() {
+    delete m_computeInstance;
+    m_computeInstance = nullptr;
+
+    for(auto it : {m_particlesBuffer, m_renderBuffer, m_stateBuffer}) {
+        if(it) {
+            it->decRef();
+        }
     }
+    m_particlesBuffer = nullptr;
+    m_renderBuffer = nullptr;
+    m_stateBuffer = nullptr;
 }
 /*!
     \internal
@@ -107,6 +237,7 @@ void EffectRender::setEffect(VisualEffect *effect) {
     if(m_effect) {
         m_effect->unsubscribe(this);
     }
+    releaseCompute();
 
     m_effect = effect;
     if(m_effect) {
@@ -149,7 +280,8 @@ void EffectRender::effectUpdated(int state, void *ptr) {
         // Update emitter buffer
         p->m_emitterData.resize(VisualEffect::LastAttribute);
         // Update particles buffer
-        p->m_particleData.resize(capacity * p->m_effect->particleStride());
+        p->m_particleData.assign(ParticleProgram::bufferSize(p->m_effect->particleStride(), capacity), 0.0f);
+        p->m_emitterData[VisualEffect::AliveParticles] = 0.0f;
 
         int renderableStride = p->m_effect->renderableStride();
         p->m_renderData.resize(capacity * renderableStride);
@@ -164,5 +296,7 @@ void EffectRender::effectUpdated(int state, void *ptr) {
             p->m_renderData[r + 11] = colorID.z;
             p->m_renderData[r + 15] = colorID.w;
         }
+
+        p->createCompute();
     }
 }
@@ -0,0 +1,102 @@
+#include "private/animationbatch.h"
+
+#include "components/animator.h"
+#include "components/armature.h"
+
+#include "resources/texture.h"
+
+#include "utils/parallelfor.h"
+
+#include <algorithm>
+
+namespace {
+    const uint32_t gParallelThreshold = 16;
+};
+
+std::vector<Animator *> AnimationBatch::m_animators;
+std::vector<Armature *> AnimationBatch::m_armatures;
+
+template<typename T>
+static void removeDuplicates(std::vector<T *> &list) {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+}
+
+/*!
+    \class AnimationBatch
+    \brief Evaluates the animation of all active Animators and Armatures in one pass.
+    \internal
+
+    The Animator and Armature components only register themselves for the evaluation during their update in game mode.
+    The batch is processed once per frame after all of the game logic: the Transform channels of all Animators are evaluated in parallel jobs first,
+    then the rest of the animated properties are written on the calling thread, because the generic property writes may have any side effects.
+    After that the skinning palettes of all Armatures are calculated in parallel.
+    The Transforms of different characters don't share any state, so they are distributed over the pool workers one by one.
+*/
+
+/*!
+    Registers the \a animator for the evaluation in the current frame.
+*/
+void AnimationBatch::addAnimator(Animator *animator) {
+    m_animators.push_back(animator);
+}
+/*!
+    Removes the destroyed \a animator from the current frame.
+*/
+void AnimationBatch::removeAnimator(Animator *animator) {
+    m_animators.erase(std::remove(m_animators.begin(), m_animators.end(), animator), m_animators.end());
+}
+/*!
+    Registers the \a armature for the palette update in the current frame.
+*/
+void AnimationBatch::addArmature(Armature *armature) {
+    m_armatures.push_back(armature);
+}
+/*!
+    Removes the destroyed \a armature from the current frame.
+*/
+void AnimationBatch::removeArmature(Armature *armature) {
+    m_armatures.erase(std::remove(m_armatures.begin(), m_armatures.end(), armature), m_armatures.end());
+}
+/*!
+    Evaluates all registered components using the thread \a pool and clears the registration.
+    The components are processed on the calling thread in case of the \a pool is nullptr.
+*/
+void AnimationBatch::process(ThreadPool *pool) {
+    PROFILE_FUNCTION();
+
+    removeDuplicates(m_animators);
+    removeDuplicates(m_armatures);
+
+    // The palettes depend on the bone transforms written by the animators
+    dispatch(pool, false, m_animators.size());
+    for(auto it : m_animators) {
+        it->evaluateChannels(false);
+    }
+    dispatch(pool, true, m_armatures.size());
+
+    for(auto it : m_armatures) {
+        it->m_cache->setDirty();
+    }
+
+    m_animators.clear();
+    m_armatures.clear();
+}
+/*!
+    \internal
+*/
+void AnimationBatch::dispatch(ThreadPool *pool, bool armatures, uint32_t count) {
+    if(count < gParallelThreshold) {
+        pool = nullptr;
+    }
+
+    if(armatures) {
+        ParallelFor::run(pool, count, [](uint32_t index) {
+            m_armatures[index]->updatePalette();
+        });
+    } else {
+        ParallelFor::run(pool, count, [](uint32_t index) {
+            m_animators[index]->evaluateChannels(true);
+        });
+    }
+}
@@ -2,8 +2,22 @@
 
 #include "animationclip.h"
 
+#include "components/transform.h"
+
+#include <cstring>
+
+namespace {
+    const char *gTransform = "Transform";
+    const char *gPosition = "position";
+    const char *gQuaternion = "quaternion";
+    const char *gScale = "scale";
+};
+
 BaseAnimationBlender::BaseAnimationBlender() :
-        m_previousTrack(nullptr),
+        m_transform(nullptr),
+        m_channel(NoChannel),
+        m_previousCursor(-1),
+        m_previous(false),
         m_factor(0.0f),
         m_offset(0.0f),
         m_transitionTime(0.0f),
@@ -12,6 +26,32 @@ BaseAnimationBlender::BaseAnimationBlender() :
 
 }
 
+void BaseAnimationBlender::setTarget(Object *object, const char *property) {
+    PropertyAnimation::setTarget(object, property);
+
+    // The Transform channels are written directly, without the property lookup and the Variant conversion
+    m_transform = nullptr;
+    m_channel = NoChannel;
+    if(object && target() == object && object->metaObject()->canCastTo(gTransform)) {
+        if(strcmp(property, gPosition) == 0) {
+            m_channel = PositionChannel;
+        } else if(strcmp(property, gQuaternion) == 0) {
+            m_channel = QuaternionChannel;
+        } else if(strcmp(property, gScale) == 0) {
+            m_channel = ScaleChannel;
+        }
+
+        if(m_channel != NoChannel) {
+            m_transform = static_cast<Transform *>(object);
+            if(m_channel == QuaternionChannel) {
+                m_defaultQuaternion = defaultValue().toQuaternion();
+            } else {
+                m_defaultVector = defaultValue().toVector3();
+            }
+        }
+    }
+}
+
 void BaseAnimationBlender::setOffset(float offset) {
     m_offset = offset;
 }
@@ -57,13 +97,19 @@ void BaseAnimationBlender::setCurrentTime(uint32_t position) {
             }
         }
 
+        if(isTransformChannel()) {
+            applyTransform(time);
+            m_previousTime = position;
+            return;
+        }
+
         Variant data = defaultValue();
 
-        if(m_previousTrack) {
-            data = m_previousTrack->curve().value(time);
+        if(m_previous) {
+            data = m_previousCurve.value(time, m_previousCursor);
         }
 
-        Variant target = curve().value(MAX(time - m_offset, 0.0f));
+        Variant target = curveValue(MAX(time - m_offset, 0.0f));
 
         switch(data.type()) {
             case MetaType::BOOLEAN: {
@@ -99,6 +145,11 @@ void BaseAnimationBlender::setCurrentTime(uint32_t position) {
                 }
                 data = v;
             } break;
+            case MetaType::QUATERNION: {
+                Quaternion q;
+                q.mix(target.toQuaternion(), data.toQuaternion(), m_factor);
+                data = q;
+            } break;
             default: data = target; break;
         }
         setCurrentValue(data);
@@ -110,5 +161,51 @@ void BaseAnimationBlender::setCurrentTime(uint32_t position) {
 void BaseAnimationBlender::setPreviousTrack(AnimationTrack &track) {
     PROFILE_FUNCTION();
 
-    m_previousTrack = &track;
+    m_previousCurve = track.curve();
+    m_previousCurve.bake();
+    m_previousCursor = -1;
+    m_previous = true;
+}
+
+bool BaseAnimationBlender::isTransformChannel() const {
+    // Such channels don't touch the generic properties, so different transforms can be animated in parallel
+    if(m_transform == nullptr) {
+        return false;
+    }
+
+    int32_t components = (m_channel == QuaternionChannel) ? 4 : 3;
+    return curve().components() == components && (!m_previous || m_previousCurve.components() == components);
+}
+
+void BaseAnimationBlender::applyTransform(float time) {
+    float target[4];
+    curveSample(MAX(time - m_offset, 0.0f), target);
+
+    if(m_channel == QuaternionChannel) {
+        float data[4] = { m_defaultQuaternion.x, m_defaultQuaternion.y, m_defaultQuaternion.z, m_defaultQuaternion.w };
+        if(m_previous) {
+            m_previousCurve.sample(time, data, m_previousCursor);
+        }
+
+        // The rotations are cross-faded along the shortest arc
+        Quaternion q;
+        q.mix(Quaternion(target[0], target[1], target[2], target[3]), Quaternion(data[0], data[1], data[2], data[3]), m_factor);
+        m_transform->setQuaternion(q);
+        return;
+    }
+
+    float data[4] = { m_defaultVector.x, m_defaultVector.y, m_defaultVector.z, 0.0f };
+    if(m_previous) {
+        m_previousCurve.sample(time, data, m_previousCursor);
+    }
+
+    Vector3 v(MIX(target[0], data[0], m_factor),
+              MIX(target[1], data[1], m_factor),
+              MIX(target[2], data[2], m_factor));
+
+    if(m_channel == PositionChannel) {
+        m_transform->setPosition(v);
+    } else {
+        m_transform->setScale(v);
+    }
 }
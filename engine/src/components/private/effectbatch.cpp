@@ -0,0 +1,66 @@
+#include "private/effectbatch.h"
+
+#include "components/effectrender.h"
+
+#include "commandbuffer.h"
+
+#include "utils/parallelfor.h"
+
+#include <algorithm>
+
+std::vector<EffectRender *> EffectBatch::m_emitters;
+
+/*!
+    \class EffectBatch
+    \brief Simulates the particles of all active EffectRenders in one pass.
+    \internal
+
+    The EffectRender components only prepare the emitter state and register themselves during their update.
+    The batch is processed once per frame after all of the renderables are updated: the particles of different emitters are simulated in parallel jobs
+    and then the results are passed to the material instances on the calling thread.
+    The emitters with GPU simulation only record the compute dispatch to the command buffer.
+*/
+
+/*!
+    Registers the \a emitter for the simulation in the current frame.
+*/
+void EffectBatch::addEmitter(EffectRender *emitter) {
+    m_emitters.push_back(emitter);
+}
+/*!
+    Removes the destroyed \a emitter from the current frame.
+*/
+void EffectBatch::removeEmitter(EffectRender *emitter) {
+    m_emitters.erase(std::remove(m_emitters.begin(), m_emitters.end(), emitter), m_emitters.end());
+}
+/*!
+    Simulates all registered emitters using the thread \a pool and clears the registration.
+    The emitters are processed on the calling thread in case of the \a pool is nullptr.
+    The GPU simulations are recorded to the command \a buffer, they fall back to CPU if the \a buffer is nullptr
+    or the render backend doesn't support the compute shaders and the indirect draws.
+*/
+void EffectBatch::process(ThreadPool *pool, CommandBuffer *buffer) {
+    PROFILE_FUNCTION();
+
+    std::sort(m_emitters.begin(), m_emitters.end());
+    m_emitters.erase(std::unique(m_emitters.begin(), m_emitters.end()), m_emitters.end());
+
+    bool compute = buffer && CommandBuffer::isComputeSupported();
+    auto gpu = std::stable_partition(m_emitters.begin(), m_emitters.end(), [compute](EffectRender *it) {
+        return !compute || it->m_computeInstance == nullptr;
+    });
+    for(auto it = gpu; it != m_emitters.end(); ++it) {
+        (*it)->dispatch(*buffer);
+    }
+    m_emitters.erase(gpu, m_emitters.end());
+
+    ParallelFor::run(pool, m_emitters.size(), [](uint32_t index) {
+        m_emitters[index]->simulate();
+    });
+
+    for(auto it : m_emitters) {
+        it->upload();
+    }
+
+    m_emitters.clear();
+}
@@ -19,7 +19,8 @@
 
 Renderable::Renderable() :
         m_transformHash(0),
-        m_surfaceType(Material::Static) {
+        m_surfaceType(Material::Static),
+        m_lod(0) {
 
 }
 
@@ -66,6 +67,7 @@ uint32_t Renderable::instanceHash(int index) const {
     Mesh *mesh = meshToDraw();
     if(mesh) {
         Mathf::hashCombine(result, mesh->uuid());
+        Mathf::hashCombine(result, m_lod);
     }
 
     return result;
@@ -6,6 +6,10 @@
 
 #include "components/private/postprocessorsettings.h"
 
+#include "utils/querybatch.h"
+
+#include <algorithm>
+
 /*!
     \class World
     \brief A root object in the scene graph hierarchy.
@@ -20,6 +24,8 @@
 World::World() :
         m_rayCastCallback(nullptr),
         m_rayCastSystem(nullptr),
+        m_queryCallback(nullptr),
+        m_querySystem(nullptr),
         m_activeScene(nullptr),
         m_gameController(nullptr),
         m_dirty(true),
@@ -161,6 +167,61 @@ void World::setRayCastHandler(RayCastCallback callback, System *system) {
     m_rayCastCallback = callback;
     m_rayCastSystem = system;
 }
+/*!
+    Executes all queries of the \a batch against the colliders in the World.
+    The results are available immediately after the call.
+*/
+void World::query(QueryBatch &batch) {
+    batch.resetHits();
+    if(m_queryCallback) {
+        m_queryCallback(m_querySystem, this, batch);
+    }
+    batch.setState(QueryBatch::Ready);
+}
+/*!
+    Schedules the \a batch to be executed after the next update of the physics system.
+    The results are ready in the next frame, this allows the physics system to process the queries in parallel with the other systems.
+    \note The \a batch must not be modified or destroyed until it's ready or cancelled with cancelQuery().
+    The queries must be scheduled from the game logic, not from the systems running in parallel with the physics.
+*/
+void World::queryDeferred(QueryBatch &batch) {
+    if(batch.state() != QueryBatch::Pending) {
+        batch.setState(QueryBatch::Pending);
+        m_deferredQueries.push_back(&batch);
+    }
+}
+/*!
+    Removes the pending \a batch from the deferred queries.
+*/
+void World::cancelQuery(QueryBatch &batch) {
+    auto it = std::find(m_deferredQueries.begin(), m_deferredQueries.end(), &batch);
+    if(it != m_deferredQueries.end()) {
+        m_deferredQueries.erase(it);
+        batch.setState(QueryBatch::Idle);
+    }
+}
+/*!
+    \internal
+    Executes all deferred queries.
+    This method is called by the physics system after the simulation step.
+*/
+void World::processDeferredQueries() {
+    std::vector<QueryBatch *> queries;
+    queries.swap(m_deferredQueries);
+
+    for(auto it : queries) {
+        query(*it);
+    }
+}
+/*!
+    Sets the batched queries \a callback function.
+
+    This callback is added by any physical \a system by the default.
+*/
+void World::setQueryHandler(QueryCallback callback, System *system) {
+    m_queryCallback = callback;
+    m_querySystem = system;
+}
 /*!
     \internal
 */
@@ -51,16 +51,22 @@ bool AssetConverterSettings::isReadOnly() const {
 }
 
 bool AssetConverterSettings::isOutdated() const {
-    if(version() > currentVersion()) {
-        return true;
-    }
     bool result = true;
 
     QFile file(source());
     if(file.open(QIODevice::ReadOnly)) {
-        QByteArray md5 = QCryptographicHash::hash(file.readAll(), QCryptographicHash::Md5).toHex();
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        uchar *data = (file.size() > 0) ? file.map(0, file.size()) : nullptr;
+        if(data) {
+            hash.addData(reinterpret_cast<const char *>(data), file.size());
+            file.unmap(data);
+        } else {
+            hash.addData(&file);
+        }
         file.close();
 
+        QByteArray md5 = hash.result().toHex();
+
         md5 = md5.insert(20, '-');
         md5 = md5.insert(16, '-');
         md5 = md5.insert(12, '-');
@@ -68,11 +74,12 @@ bool AssetConverterSettings::isOutdated() const {
         md5.push_front('{');
         md5.push_back('}');
 
-        if(hash() == md5) {
+        if(hash() == md5 && version() <= currentVersion()) {
             if(isCode() || QFileInfo::exists(absoluteDestination())) {
                 result = false;
             }
         }
+        // Always keep the actual hash, it's a part of the import cache key
         m_md5 = md5;
     }
     return result;
@@ -102,6 +109,18 @@ QString AssetConverterSettings::defaultIcon(QString type) const {
 QString AssetConverterSettings::hash() const {
     return m_md5;
 }
+
+QString AssetConverterSettings::cacheKey() const {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(m_md5.toUtf8());
+    hash.addData(m_destination.toUtf8());
+    hash.addData(metaObject()->className());
+    hash.addData(QByteArray::number(m_version));
+    hash.addData(ProjectSettings::instance()->currentPlatformName().toUtf8());
+    hash.addData(QJsonDocument(properties()).toJson(QJsonDocument::Compact));
+
+    return hash.result().toHex();
+}
 void AssetConverterSettings::setHash(const QString &hash) {
     m_md5 = hash;
 }
@@ -246,24 +265,24 @@ bool AssetConverterSettings::loadSettings() {
     return false;
 }
 
-void AssetConverterSettings::saveSettings() {
-    QJsonObject set;
-    QObject *object = dynamic_cast<QObject *>(this);
-    if(object) {
-        const QMetaObject *meta = object->metaObject();
-        for(int i = 0; i < meta->propertyCount(); i++) {
-            QMetaProperty property = meta->property(i);
-            if(QString(property.name()) != "objectName") {
-                set.insert(property.name(), QJsonValue::fromVariant(property.read(object)));
-            }
+QJsonObject AssetConverterSettings::properties() const {
+    QJsonObject result;
+    const QMetaObject *meta = metaObject();
+    for(int i = 0; i < meta->propertyCount(); i++) {
+        QMetaProperty property = meta->property(i);
+        if(QString(property.name()) != "objectName") {
+            result.insert(property.name(), QJsonValue::fromVariant(property.read(this)));
         }
     }
+    return result;
+}
 
+void AssetConverterSettings::saveSettings() {
     QJsonObject obj;
     obj.insert(gVersion, int(currentVersion()));
     obj.insert(gMd5, hash());
     obj.insert(gGUID, destination());
-    obj.insert(gSettings, set);
+    obj.insert(gSettings, properties());
     obj.insert(gType, static_cast<int>(type()));
 
     QJsonObject sub;
@@ -307,6 +326,23 @@ void AssetConverter::init() {
 
 }
 
+bool AssetConverter::isThreadSafe() const {
+    // Thread safe converters are executed on the import pool and must not create engine objects.
+    // This includes temporary Resources: their destruction updates the ResourceSystem cache which isn't synchronised.
+    return false;
+}
+
+bool AssetConverter::hasPrepareStep() const {
+    // Converters which aren't thread safe may still move the heavy part of work to prepareFile().
+    // It's executed on the import pool and followed by convertFile() on the main thread with the prepared data.
+    return false;
+}
+
+AssetConverter::ReturnCode AssetConverter::prepareFile(AssetConverterSettings *settings) {
+    Q_UNUSED(settings)
+    return Success;
+}
+
 AssetConverterSettings *AssetConverter::createSettings() {
     return new AssetConverterSettings();
 }
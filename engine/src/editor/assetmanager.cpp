@@ -6,6 +6,8 @@
 #include <QUuid>
 #include <QDebug>
 #include <QMessageBox>
+#include <QThreadPool>
+#include <QElapsedTimer>
 
 #include <QPainter>
 #include <QDomDocument>
@@ -13,6 +15,7 @@
 #include <QtSvg/QSvgRenderer>
 
 #include <cstring>
+#include <functional>
 
 #include "config.h"
 
@@ -20,6 +23,7 @@
 #include <bson.h>
 
 #include "editor/assetconverter.h"
+#include "editor/importcache.h"
 #include "editor/codebuilder.h"
 
 #include "components/world.h"
@@ -55,6 +59,27 @@ namespace {
     const char *gProject(".project");
 
     const char *gPersistent("Persistent");
+
+    const char *gArtifacts("artifacts");
+    const char *gImportCacheEnv("THUNDER_IMPORT_CACHE");
+
+    const int gImportBudget = 30; // milliseconds
+};
+
+class ImportTask : public QRunnable {
+public:
+    explicit ImportTask(const std::function<void()> &function) :
+            m_function(function) {
+
+    }
+
+    void run() override {
+        m_function();
+    }
+
+private:
+    std::function<void()> m_function;
+
 };
 
 AssetManager *AssetManager::m_instance = nullptr;
@@ -71,12 +96,21 @@ AssetManager::AssetManager() :
         m_fileWatcher(new QFileSystemWatcher(this)),
         m_projectManager(ProjectSettings::instance()),
         m_timer(new QTimer(this)),
+        m_importPool(new QThreadPool(this)),
+        m_importCache(nullptr),
+        m_importStage(0),
+        m_importTotal(0),
+        m_importProcessed(0),
         m_noIcons(false) {
 
     connect(m_timer, SIGNAL(timeout()), this, SLOT(onPerform()));
 }
 
 AssetManager::~AssetManager() {
+    m_importPool->waitForDone();
+
+    delete m_importCache;
+
     delete m_dirWatcher;
     delete m_fileWatcher;
 
@@ -159,6 +193,10 @@ void AssetManager::rescan(bool force) {
 
     force |= !target.isEmpty() || !info.exists();
 
+    QString cache = qEnvironmentVariable(gImportCacheEnv, m_projectManager->cachePath() + "/" + gArtifacts);
+    delete m_importCache;
+    m_importCache = new ImportCache(cache);
+
     if(target.isEmpty()) {
         connect(m_dirWatcher, SIGNAL(directoryChanged(QString)), this, SIGNAL(directoryChanged(QString)));
         connect(m_dirWatcher, SIGNAL(directoryChanged(QString)), this, SLOT(onDirectoryChanged(QString)));
@@ -215,8 +253,11 @@ bool AssetManager::pushToImport(AssetConverterSettings *settings) {
 }
 
 void AssetManager::reimport() {
-    std::sort(m_importQueue.begin(), m_importQueue.end(), typeLessThan);
-    emit importStarted(m_importQueue.size(), tr("Importing resources"));
+    std::stable_sort(m_importQueue.begin(), m_importQueue.end(), typeLessThan);
+
+    m_importTotal = m_importQueue.size() + m_inFlight.size();
+    m_importProcessed = 0;
+    emit importStarted(m_importTotal, tr("Importing resources"));
     m_timer->start(10);
 }
 
@@ -693,8 +734,24 @@ void AssetManager::dumpBundle() {
 }
 
 void AssetManager::onPerform() {
-    if(!m_importQueue.isEmpty()) {
-        convert(m_importQueue.takeFirst());
+    collectConverted();
+
+    if(!m_importQueue.isEmpty() || !m_inFlight.isEmpty()) {
+        QElapsedTimer timer;
+        timer.start();
+
+        while(!m_importQueue.isEmpty() && timer.elapsed() < gImportBudget) {
+            // The queue is sorted by type, assets of the next type may depend on the previous ones
+            AssetConverterSettings *settings = m_importQueue.first();
+            if(!m_inFlight.isEmpty() && settings->type() != m_importStage) {
+                break;
+            }
+            m_importStage = settings->type();
+
+            convert(m_importQueue.takeFirst());
+        }
+
+        emit importProgress(m_importProcessed, m_importTotal);
     } else {
         bool result = false;
 
@@ -733,29 +790,12 @@ void AssetManager::onPerform() {
 }
 
 void AssetManager::onFileChanged(const QString &path, bool force) {
-    QFileInfo info(path);
-    if(info.exists() && (QString(".") + info.suffix()) != gMetaExt) {
-        AssetConverterSettings *settings = fetchSettings(info);
-
-        if(settings) {
-            if(force || settings->isOutdated()) {
-                pushToImport(settings);
-            } else {
-                if(!settings->isCode()) {
-                    QString guid = settings->destination();
-                    registerAsset(info, guid, settings->typeName());
-                    for(const QString &it : settings->subKeys()) {
-                        QString value = settings->subItem(it);
-                        QString path = info.absoluteFilePath() + "/" + it;
-                        registerAsset(path, value, settings->subTypeName(it));
-                    }
-                }
-            }
-        }
-    }
+    checkOutdated({QFileInfo(path)}, force);
 }
 
 void AssetManager::onDirectoryChanged(const QString &path, bool force) {
+    QList<QFileInfo> files;
+
     QDirIterator it(path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
     while(it.hasNext()) {
         QString item = it.next();
@@ -768,7 +808,56 @@ void AssetManager::onDirectoryChanged(const QString &path, bool force) {
         }
         m_fileWatcher->addPath(info.absoluteFilePath());
 
-        onFileChanged(item, force);
+        files.push_back(info);
+    }
+
+    checkOutdated(files, force);
+}
+
+void AssetManager::checkOutdated(const QList<QFileInfo> &files, bool force) {
+    QList<QFileInfo> infos;
+    QList<AssetConverterSettings *> settings;
+    for(auto &info : files) {
+        if(info.exists() && (QString(".") + info.suffix()) != gMetaExt) {
+            AssetConverterSettings *s = fetchSettings(info);
+            if(s) {
+                infos.push_back(info);
+                settings.push_back(s);
+            }
+        }
+    }
+
+    // Sources are hashed even for the forced import, the hash is a part of the import cache key
+    std::vector<uint8_t> outdated(settings.size(), 0);
+    if(settings.size() > 1) {
+        // Hashing of the sources takes the most time of the scan
+        for(int i = 0; i < settings.size(); i++) {
+            AssetConverterSettings *s = settings[i];
+            uint8_t *result = &outdated[i];
+            m_importPool->start(new ImportTask([s, result]() { *result = s->isOutdated(); }));
+        }
+        m_importPool->waitForDone();
+    } else if(!settings.isEmpty()) {
+        outdated[0] = settings[0]->isOutdated();
+    }
+
+    for(int i = 0; i < settings.size(); i++) {
+        AssetConverterSettings *s = settings[i];
+        if(force || outdated[i]) {
+            if(force) {
+                // The forced import always runs the converter instead of restoring the cached result
+                m_forcedImport.insert(s);
+            }
+            pushToImport(s);
+        } else if(!s->isCode()) {
+            const QFileInfo &info = infos[i];
+            registerAsset(info, s->destination(), s->typeName());
+            for(const QString &it : s->subKeys()) {
+                QString value = s->subItem(it);
+                QString path = info.absoluteFilePath() + "/" + it;
+                registerAsset(path, value, s->subTypeName(it));
+            }
+        }
     }
 }
 
@@ -840,46 +929,27 @@ void AssetManager::convert(AssetConverterSettings *settings) {
     AssetConverter *converter = getConverter(settings->source());
     if(converter) {
         settings->setSubItemsDirty();
-        uint8_t result = converter->convertFile(settings);
-        switch(result) {
-            case AssetConverter::Success: {
-                aInfo() << "Converting:" << qPrintable(settings->source());
-
-                settings->setCurrentVersion(settings->version());
-
-                QString guid = settings->destination();
-                QString type = settings->typeName();
-                QString source = settings->source();
-                registerAsset(source, guid, type);
-
-                for(const QString &it : settings->subKeys()) {
-                    QString value = settings->subItem(it);
-                    QString type = settings->subTypeName(it);
-                    QString path = source + "/" + it;
-
-                    registerAsset(path, value, type);
-
-                    if(QFileInfo::exists(m_projectManager->importPath() + "/" + value)) {
-                        Engine::reloadResource(value.toStdString());
-                        emit imported(path, type);
-                    }
-                }
-
-                Engine::reloadResource(guid.toStdString());
-
-                emit imported(source, type);
-
-                settings->saveSettings();
-            } break;
-            case AssetConverter::CopyAsIs: {
-                QDir dir(m_projectManager->contentPath());
-
-                QString dst = m_projectManager->importPath() + "/" + settings->destination();
-                QFileInfo info(dst);
-                dir.mkpath(info.absoluteDir().absolutePath());
-                QFile::copy(settings->source(), dst);
-            } break;
-            default: break;
+        bool forced = m_forcedImport.contains(settings);
+        if(m_importCache && !forced && m_importCache->restore(settings)) {
+            convertFinished(settings, AssetConverter::Success);
+        } else if(converter->isThreadSafe()) {
+            m_inFlight.insert(settings);
+            m_importPool->start(new ImportTask([this, converter, settings]() {
+                uint8_t result = converter->convertFile(settings);
+
+                QMutexLocker locker(&m_convertedMutex);
+                m_converted.push_back(qMakePair(settings, result));
+            }));
+        } else if(converter->hasPrepareStep()) {
+            m_inFlight.insert(settings);
+            m_importPool->start(new ImportTask([this, converter, settings]() {
+                uint8_t result = converter->prepareFile(settings);
+
+                QMutexLocker locker(&m_convertedMutex);
+                m_prepared.push_back(qMakePair(settings, result));
+            }));
+        } else {
+            convertFinished(settings, converter->convertFile(settings));
         }
     } else {
         BuilderSettings *builderSettings = dynamic_cast<BuilderSettings *>(settings);
@@ -891,6 +961,87 @@ void AssetManager::convert(AssetConverterSettings *settings) {
         } else {
             aDebug() << "No Converterter for" << settings->source().toStdString();
         }
+        m_forcedImport.remove(settings);
+        m_importProcessed++;
+    }
+}
+
+void AssetManager::convertFinished(AssetConverterSettings *settings, uint8_t result) {
+    m_importProcessed++;
+
+    bool forced = m_forcedImport.remove(settings);
+
+    switch(result) {
+        case AssetConverter::Success: {
+            aInfo() << "Converting:" << qPrintable(settings->source());
+
+            settings->setCurrentVersion(settings->version());
+
+            if(m_importCache) {
+                // The forced import replaces the cached artifacts which may be outdated
+                m_importCache->store(settings, forced);
+            }
+
+            QString guid = settings->destination();
+            QString type = settings->typeName();
+            QString source = settings->source();
+            registerAsset(source, guid, type);
+
+            for(const QString &it : settings->subKeys()) {
+                QString value = settings->subItem(it);
+                QString type = settings->subTypeName(it);
+                QString path = source + "/" + it;
+
+                registerAsset(path, value, type);
+
+                if(QFileInfo::exists(m_projectManager->importPath() + "/" + value)) {
+                    Engine::reloadResource(value.toStdString());
+                    emit imported(path, type);
+                }
+            }
+
+            Engine::reloadResource(guid.toStdString());
+
+            emit imported(source, type);
+
+            settings->saveSettings();
+        } break;
+        case AssetConverter::CopyAsIs: {
+            QDir dir(m_projectManager->contentPath());
+
+            QString dst = m_projectManager->importPath() + "/" + settings->destination();
+            QFileInfo info(dst);
+            dir.mkpath(info.absoluteDir().absolutePath());
+            QFile::copy(settings->source(), dst);
+        } break;
+        default: break;
+    }
+}
+
+void AssetManager::collectConverted() {
+    QList<QPair<AssetConverterSettings *, uint8_t>> converted;
+    QList<QPair<AssetConverterSettings *, uint8_t>> prepared;
+    {
+        QMutexLocker locker(&m_convertedMutex);
+        converted.swap(m_converted);
+        prepared.swap(m_prepared);
+    }
+
+    for(auto &it : converted) {
+        m_inFlight.remove(it.first);
+        convertFinished(it.first, it.second);
+    }
+
+    // The prepared data is turned into the engine objects on the main thread
+    for(auto &it : prepared) {
+        m_inFlight.remove(it.first);
+
+        uint8_t result = it.second;
+        if(result == AssetConverter::Success) {
+            AssetConverter *converter = getConverter(it.first->source());
+            result = converter ? converter->convertFile(it.first) : AssetConverter::InternalError;
+        }
+        convertFinished(it.first, result);
     }
 }
 
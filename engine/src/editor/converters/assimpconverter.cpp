@@ -3,8 +3,10 @@
 #include <QFile>
 
 #include <float.h>
+#include <algorithm>
 
 #include <assimp/cimport.h>
+#include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
@@ -24,12 +26,14 @@
 
 #include "systems/resourcesystem.h"
 
+#include "utils/meshoptimizer.h"
+
 #include "converters/animconverter.h"
 
 #define HEADER  "Header"
 #define DATA    "Data"
 
-#define FORMAT_VERSION 8
+#define FORMAT_VERSION 11
 
 int32_t indexOf(const aiBone *item, const BonesList &list) {
     int i = 0;
@@ -66,10 +70,14 @@ void stabilizeUUID(Object *object) {
 AssimpImportSettings::AssimpImportSettings() :
         m_rootActor(nullptr),
         m_rootBone(nullptr),
+        m_scene(nullptr),
         m_useScale(false),
         m_scale(1.0f),
         m_colors(true),
         m_normals(true),
+        m_optimize(true),
+        m_quantize(false),
+        m_lods(3),
         m_animation(true),
         m_filter(Keyframe_Reduction),
         m_positionError(0.5f),
@@ -115,6 +123,36 @@ void AssimpImportSettings::setNormals(bool value) {
     }
 }
 
+bool AssimpImportSettings::optimize() const {
+    return m_optimize;
+}
+void AssimpImportSettings::setOptimize(bool value) {
+    if(m_optimize != value) {
+        m_optimize = value;
+        emit updated();
+    }
+}
+
+bool AssimpImportSettings::quantize() const {
+    return m_quantize;
+}
+void AssimpImportSettings::setQuantize(bool value) {
+    if(m_quantize != value) {
+        m_quantize = value;
+        emit updated();
+    }
+}
+
+int AssimpImportSettings::lods() const {
+    return m_lods;
+}
+void AssimpImportSettings::setLods(int value) {
+    if(m_lods != value) {
+        m_lods = value;
+        emit updated();
+    }
+}
+
 bool AssimpImportSettings::animation() const {
     return m_animation;
 }
@@ -208,6 +246,19 @@ Actor *AssimpConverter::createActor(const AssetConverterSettings *settings, cons
     return AssetConverter::createActor(settings, guid);
 }
 
+AssetConverter::ReturnCode AssimpConverter::prepareFile(AssetConverterSettings *settings) {
+    AssimpImportSettings *fbxSettings = static_cast<AssimpImportSettings *>(settings);
+
+    // Parsing and post processing of the scene don't touch the engine objects and can be done out of the main thread
+    delete fbxSettings->m_scene;
+
+    Assimp::Importer importer;
+    importer.ReadFile(qPrintable(fbxSettings->source()), aiProcessPreset_TargetRealtime_MaxQuality);
+    fbxSettings->m_scene = importer.GetOrphanedScene();
+
+    return (fbxSettings->m_scene) ? Success : InternalError;
+}
+
 AssetConverter::ReturnCode AssimpConverter::convertFile(AssetConverterSettings *settings) {
     AssimpImportSettings *fbxSettings = static_cast<AssimpImportSettings *>(settings);
 
@@ -220,7 +271,11 @@ AssetConverter::ReturnCode AssimpConverter::convertFile(AssetConverterSettings *
     fbxSettings->m_rootBone = nullptr;
     fbxSettings->m_flip = false;
 
-    const aiScene *scene = aiImportFile(qPrintable(fbxSettings->source()), aiProcessPreset_TargetRealtime_MaxQuality);
+    // The scene which was read by prepareFile() is owned by the settings
+    aiScene *prepared = fbxSettings->m_scene;
+    fbxSettings->m_scene = nullptr;
+
+    const aiScene *scene = prepared ? prepared : aiImportFile(qPrintable(fbxSettings->source()), aiProcessPreset_TargetRealtime_MaxQuality);
     if(scene) {
         aiMetadata *meta = scene->mMetaData;
         for(uint32_t m = 0; m < meta->mNumProperties; m++) {
@@ -266,7 +321,11 @@ AssetConverter::ReturnCode AssimpConverter::convertFile(AssetConverterSettings *
             importAnimation(scene, fbxSettings);
         }
 
-        aiReleaseImport(scene);
+        if(prepared) {
+            delete prepared;
+        } else {
+            aiReleaseImport(scene);
+        }
 
         stabilizeUUID(root);
 
@@ -518,6 +577,14 @@ Mesh *AssimpConverter::importMesh(const aiScene *scene, const aiNode *element, A
             total_i += indexCount;
         }
 
+        if(fbxSettings->optimize()) {
+            MeshOptimizer::optimize(*mesh);
+        }
+        if(fbxSettings->lods() > 0) {
+            MeshOptimizer::generateLods(*mesh, fbxSettings->lods());
+        }
+        mesh->setQuantized(fbxSettings->quantize() && MeshOptimizer::isQuantizable(*mesh));
+
         QString uuid = actor->name().c_str();
 
         uuid = fbxSettings->saveSubData(Bson::save(Engine::toVariant(mesh)), uuid, MetaType::type<Mesh *>());
@@ -740,7 +807,8 @@ void AssimpConverter::importAnimation(const aiScene *scene, AssimpImportSettings
             }
         }
 
-        clip.m_tracks.sort(compare);
+        std::sort(clip.m_tracks.begin(), clip.m_tracks.end(), compare);
+        clip.setCompressed(fbxSettings->filter() == AssimpImportSettings::Keyframe_Quantization);
 
         fbxSettings->saveSubData(Bson::save(ObjectSystem::toVariant(&clip)), animation->mName.C_Str(), MetaType::type<AnimationClip *>());
     }
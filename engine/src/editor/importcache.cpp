@@ -0,0 +1,148 @@
+#include "editor/importcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QUuid>
+
+#include "editor/assetconverter.h"
+
+namespace {
+    const char *gData("data");
+    const char *gManifest("manifest.json");
+};
+
+static bool replaceFile(const QString &source, const QString &destination) {
+    QFile::remove(destination);
+    return QFile::copy(source, destination);
+}
+
+ImportCache::ImportCache(const QString &path) :
+        m_path(path) {
+
+    QDir().mkpath(m_path);
+}
+
+QString ImportCache::path() const {
+    return m_path;
+}
+
+bool ImportCache::restore(AssetConverterSettings *settings) const {
+    if(settings->isCode() || settings->hash().isEmpty()) {
+        return false;
+    }
+
+    QString entry = entryPath(settings->cacheKey());
+
+    QFile file(entry + "/" + gManifest);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonObject manifest = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    QFileInfo dst(settings->absoluteDestination());
+    QDir().mkpath(dst.absolutePath());
+
+    if(!replaceFile(entry + "/" + gData, dst.absoluteFilePath())) {
+        return false;
+    }
+
+    for(auto it = manifest.constBegin(); it != manifest.constEnd(); ++it) {
+        QJsonArray array = it.value().toArray();
+        QString uuid = array.at(0).toString();
+        if(!replaceFile(entry + "/" + uuid, dst.absolutePath() + "/" + uuid)) {
+            return false;
+        }
+        settings->setSubItem(it.key(), uuid, array.at(1).toInt());
+
+        QJsonObject data = array.at(2).toObject();
+        if(!data.isEmpty()) {
+            settings->setSubItemData(it.key(), data);
+        }
+    }
+
+    return true;
+}
+
+bool ImportCache::store(AssetConverterSettings *settings, bool replace) const {
+    if(settings->isCode() || settings->hash().isEmpty()) {
+        return false;
+    }
+
+    QString entry = entryPath(settings->cacheKey());
+    bool exists = QFileInfo::exists(entry);
+    if(exists && !replace) {
+        return true;
+    }
+
+    // Entry is assembled aside and moved in place to never expose a partial one
+    QString temp = m_path + "/tmp-" + QUuid::createUuid().toString(QUuid::Id128);
+    QDir dir;
+    dir.mkpath(temp);
+
+    QFileInfo dst(settings->absoluteDestination());
+
+    bool result = QFile::copy(dst.absoluteFilePath(), temp + "/" + gData);
+
+    QJsonObject manifest;
+    for(const QString &it : settings->subKeys()) {
+        if(!result) {
+            break;
+        }
+        QString uuid = settings->subItem(it);
+        result = QFile::copy(dst.absolutePath() + "/" + uuid, temp + "/" + uuid);
+
+        manifest.insert(it, QJsonArray({uuid, settings->subType(it), settings->subItemData(it)}));
+    }
+
+    if(result) {
+        QFile file(temp + "/" + gManifest);
+        result = file.open(QIODevice::WriteOnly);
+        if(result) {
+            file.write(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+            file.close();
+        }
+    }
+
+    if(result) {
+        dir.mkpath(QFileInfo(entry).absolutePath());
+
+        // The replaced entry is moved away first, so the readers see either the old or the new one
+        QString old;
+        if(exists) {
+            old = m_path + "/old-" + QUuid::createUuid().toString(QUuid::Id128);
+            result = dir.rename(entry, old);
+        }
+
+        if(result) {
+            result = dir.rename(temp, entry);
+            if(!old.isEmpty()) {
+                if(result) {
+                    QDir(old).removeRecursively();
+                } else {
+                    dir.rename(old, entry);
+                }
+            }
+        }
+    }
+
+    if(!result) {
+        QDir(temp).removeRecursively();
+    }
+
+    return result;
+}
+
+void ImportCache::clear() const {
+    QDir dir(m_path);
+    dir.removeRecursively();
+    dir.mkpath(m_path);
+}
+
+QString ImportCache::entryPath(const QString &key) const {
+    return m_path + "/" + key.left(2) + "/" + key;
+}
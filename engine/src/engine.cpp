@@ -28,6 +28,7 @@
 
 #include "components/animator.h"
 #include "components/playerinput.h"
+#include "components/private/animationbatch.h"
 
 #ifdef THUNDER_MOBILE
     #include "adapters/mobileadaptor.h"
@@ -117,6 +118,13 @@ static Engine *m_instance = nullptr;
 
     \sa unloadResource()
 */
+/*!
+    \fn template<typename T> T *loadResourceAsync(const std::string &path, int32_t priority)
+
+    Returns an instance of type T for the resource located along the \a path which will be loaded in the background with a given \a priority.
+
+    \sa loadResource()
+*/
 /*!
     Constructs Engine.
     Using \a file and \a path parameters creates necessary platform adapters, register basic component types and resource types.
@@ -293,6 +301,9 @@ void Engine::update() {
                     }
                 }
             }
+
+            // The animation of all characters is evaluated in parallel after the game logic
+            AnimationBatch::process(m_threadPool);
         }
 
         m_world->setToBeUpdated(true);
@@ -379,6 +390,19 @@ Object *Engine::loadResource(const std::string &path) {
 
     return m_resourceSystem->loadResource(path);
 }
+/*!
+    Returns an instance for the resource located along the \a path and starts loading of it in the background.
+    Resources with a higher \a priority are loaded first.
+    The instance stays in Resource::Loading state until the data is loaded.
+    \note In case of resource was loaded previously this function will return the same instance.
+
+    \sa loadResource(), ResourceSystem::loadResourceAsync()
+*/
+Object *Engine::loadResourceAsync(const std::string &path, int32_t priority) {
+    PROFILE_FUNCTION();
+
+    return m_resourceSystem->loadResourceAsync(path, priority);
+}
 /*!
     Forcely unloads the resource located along the \a path from memory.
     \warning After this call, the reference on the resource may become an invalid at any time and must not be used anymore.
@@ -514,6 +538,13 @@ ResourceSystem *Engine::resourceSystem() {
 RenderSystem *Engine::renderSystem() {
     return m_renderSystem;
 }
+/*!
+    Returns the thread pool shared by all engine systems and batch jobs.
+    Returns nullptr in case of the pool is disabled; the work must be done on the calling thread in that case.
+*/
+ThreadPool *Engine::threadPool() {
+    return m_threadPool;
+}
 /*!
     Returns true if game started; otherwise returns false.
 */
@@ -2,8 +2,25 @@
 
 #include "log.h"
 
+#include "utils/assetpack.h"
+
 #include <physfs.h>
 
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    struct PackStream {
+        const uint8_t *data;
+
+        ByteArray buffer;
+
+        uint64_t size;
+
+        uint64_t position;
+    };
+};
+
 /*!
     \class File
     \brief Basic file system I/O module.
@@ -28,8 +45,23 @@
         file->fclose(fp);
     }
     \endcode
+
+    Besides of directories and archives supported by PhysFS, the File module can mount AssetPack archives.
+    Such packs are memory-mapped and checked before other search paths.
 */
 
+File::File() {
+
+}
+
+File::~File() {
+    for(auto it : m_packStreams) {
+        delete static_cast<PackStream *>(it);
+    }
+    for(auto it : m_packs) {
+        delete it;
+    }
+}
 /*!
     Initialize the file system module at \a argv0 application file path.
     This method must be called before any operations with filesytem.
@@ -49,6 +81,15 @@ void File::finit(const char *argv0) {
     \note Usually, this method calls internally and must not be called manually.
 */
 void File::fsearchPathAdd(const char *path, bool isFirst) {
+    if(!isFirst) {
+        AssetPack *pack = new AssetPack;
+        if(pack->open(path)) {
+            m_packs.push_back(pack);
+            return;
+        }
+        delete pack;
+    }
+
     if(PHYSFS_addToSearchPath(path, isFirst ? 0 : 1) == 0) {
         aError() << "[ FileIO ] Filed to add search path." << path << PHYSFS_getLastError();
     }
@@ -68,10 +109,27 @@ void File::fsearchPathAdd(const char *path, bool isFirst) {
     \endcode
 */
 StringList File::flist(const char *path) {
+    StringList result;
+
+    std::string prefix(path);
+    if(!prefix.empty() && prefix.back() != '/') {
+        prefix += '/';
+    }
+    for(auto pack : m_packs) {
+        for(uint32_t i = 0; i < pack->count(); i++) {
+            std::string name = pack->name(*pack->entry(i));
+            if(name.compare(0, prefix.size(), prefix) == 0) {
+                name = name.substr(prefix.size(), name.find('/', prefix.size()) - prefix.size());
+                if(std::find(result.begin(), result.end(), name) == result.end()) {
+                    result.push_back(name);
+                }
+            }
+        }
+    }
+
     char **rc = PHYSFS_enumerateFiles(path);
     char **i;
 
-    StringList result;
     for(i = rc; *i != nullptr; i++) {
         result.push_back(*i);
     }
@@ -102,6 +160,11 @@ bool File::fdelete(const char *path) {
     Checks if a file by \a path exists. Returns true if operation succeeded; otherwise returns false.
 */
 bool File::exists(const char *path) {
+    for(auto pack : m_packs) {
+        if(pack->find(path)) {
+            return true;
+        }
+    }
     return PHYSFS_exists(path);
 }
 /*!
@@ -110,12 +173,28 @@ bool File::exists(const char *path) {
     Returns true if operation succeeded; otherwise returns false.
 */
 bool File::isdir(const char *path) {
+    std::string prefix = std::string(path) + '/';
+    for(auto pack : m_packs) {
+        for(uint32_t i = 0; i < pack->count(); i++) {
+            if(pack->name(*pack->entry(i)).compare(0, prefix.size(), prefix) == 0) {
+                return true;
+            }
+        }
+    }
     return PHYSFS_isDirectory(path);
 }
 /*!
     Closes file \a stream. Returns 0 if succeeded; otherwise returns non-zero value.
 */
 int File::fclose(_FILE *stream) {
+    if(isPackStream(stream)) {
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            m_packStreams.erase(stream);
+        }
+        delete static_cast<PackStream *>(stream);
+        return 0;
+    }
     return PHYSFS_close(static_cast<PHYSFS_file *>(stream));
 }
 /*!
@@ -127,7 +206,14 @@ int File::fclose(_FILE *stream) {
     \sa ftell()
 */
 _size_t File::fseek(_FILE *stream, uint64_t origin) {
-    A_UNUSED(origin);
+    if(isPackStream(stream)) {
+        PackStream *pack = static_cast<PackStream *>(stream);
+        if(origin > pack->size) {
+            return 0;
+        }
+        pack->position = origin;
+        return 1;
+    }
     return static_cast<_size_t>(PHYSFS_seek(static_cast<PHYSFS_file *>(stream), origin));
 }
 /*!
@@ -143,6 +229,33 @@ _size_t File::fseek(_FILE *stream, uint64_t origin) {
     Returns _FILE pointer to file stream if succeeded; otherwise returns nullptr value.
 */
 _FILE *File::fopen(const char *path, const char *mode) {
+    if(mode[0] == 'r') {
+        for(auto pack : m_packs) {
+            const AssetPack::Entry *entry = pack->find(path);
+            if(entry) {
+                PackStream *stream = new PackStream;
+                stream->size = entry->originalSize;
+                stream->position = 0;
+                if(entry->compression == AssetPack::Stored) {
+                    stream->data = pack->data(*entry);
+                } else {
+                    stream->buffer.resize(entry->originalSize);
+                    stream->data = pack->extract(*entry, stream->buffer.data()) ? stream->buffer.data() : nullptr;
+                }
+
+                if(stream->data == nullptr) {
+                    aWarning() << "[ FileIO ] Can't unpack file" << path;
+                    delete stream;
+                    return nullptr;
+                }
+
+                std::unique_lock<std::mutex> locker(m_mutex);
+                m_packStreams.insert(stream);
+                return stream;
+            }
+        }
+    }
+
     _FILE *result = nullptr;
     switch (mode[0]) {
         case 'r': result = static_cast<void *>(PHYSFS_openRead(path)); break;
@@ -162,6 +275,16 @@ _FILE *File::fopen(const char *path, const char *mode) {
     Returns number of objects read.
 */
 _size_t File::fread(void *ptr, _size_t size, _size_t count, _FILE *stream) {
+    if(isPackStream(stream)) {
+        PackStream *pack = static_cast<PackStream *>(stream);
+        if(size == 0) {
+            return 0;
+        }
+        count = MIN(count, (pack->size - pack->position) / size);
+        memcpy(ptr, pack->data + pack->position, size * count);
+        pack->position += size * count;
+        return count;
+    }
     return static_cast<_size_t>(PHYSFS_read(static_cast<PHYSFS_file *>(stream), ptr, size, count));
 }
 /*!
@@ -171,12 +294,18 @@ _size_t File::fread(void *ptr, _size_t size, _size_t count, _FILE *stream) {
     Returns number of objects written.
 */
 _size_t File::fwrite(const void *ptr, _size_t size, _size_t count, _FILE *stream) {
+    if(isPackStream(stream)) {
+        return 0;
+    }
     return static_cast<_size_t>(PHYSFS_write(static_cast<PHYSFS_file *>(stream), ptr, size, count));
 }
 /*!
     Get total length of a file \a stream in bytes.
 */
 _size_t File::fsize(_FILE *stream) {
+    if(isPackStream(stream)) {
+        return static_cast<PackStream *>(stream)->size;
+    }
     return static_cast<_size_t>(PHYSFS_fileLength(static_cast<PHYSFS_file *>(stream)));
 }
 /*!
@@ -185,5 +314,19 @@ _size_t File::fsize(_FILE *stream) {
     Returns offset in bytes from start of file.
 */
 _size_t File::ftell(_FILE *stream) {
+    if(isPackStream(stream)) {
+        return static_cast<PackStream *>(stream)->position;
+    }
     return static_cast<_size_t>(PHYSFS_tell(static_cast<PHYSFS_file *>(stream)));
 }
+/*!
+    \internal
+    Returns true if the \a stream was opened from a mounted AssetPack; otherwise returns false.
+*/
+bool File::isPackStream(_FILE *stream) {
+    if(m_packs.empty()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> locker(m_mutex);
+    return m_packStreams.find(stream) != m_packStreams.end();
+}
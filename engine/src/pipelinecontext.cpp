@@ -12,12 +12,16 @@
 #include "components/postprocessvolume.h"
 
 #include "components/private/postprocessorsettings.h"
+#include "components/private/effectbatch.h"
 
 #include "resources/mesh.h"
 #include "resources/material.h"
 #include "resources/rendertarget.h"
 #include "resources/pipeline.h"
 
+#include "utils/texturestreamer.h"
+#include "utils/parallelfor.h"
+
 #include "pipelinetask.h"
 #include "commandbuffer.h"
 #include "log.h"
@@ -29,6 +33,161 @@
 namespace {
     const char *gTexture("mainTexture");
     const char *gRadianceMap("radianceMap");
+
+    const char *gLodBias(".lodBias");
+
+    const float gLodHysteresis = 0.1f;
+
+    const float gDepthRange = 8.0f;
+};
+
+static int32_t depthRange(float depth) {
+    // Each range is twice as deep as the previous one
+    return (depth > gDepthRange) ? static_cast<int32_t>(log2f(depth / gDepthRange)) + 1 : 0;
+}
+
+class RenderListJob {
+public:
+    explicit RenderListJob(PipelineContext *context) :
+            m_context(context),
+            m_layer(0),
+            m_flags(0),
+            m_static(true),
+            m_cull(false),
+            m_split(false) {
+
+        m_hash[PipelineContext::AllItems] = 0;
+        m_hash[PipelineContext::StaticItems] = 0;
+        m_hash[PipelineContext::DynamicItems] = 0;
+    }
+
+    void process() {
+        PROFILE_FUNCTION();
+
+        m_items.clear();
+        m_bound = AABBox();
+        if(m_cull) {
+            RenderList list = m_context->frustumCulling(m_frustum, m_context->sceneComponents(), m_bound);
+            PipelineContext::filterRenderers(list, m_layer, m_flags, m_items);
+        } else {
+            PipelineContext::filterRenderers(m_context->culledComponents(), m_layer, m_flags, m_items);
+        }
+
+        if(!(m_layer & CommandBuffer::TRANSLUCENT)) {
+            // The culled lists are sorted from the near plane of the frustum, the rest from the camera
+            Vector3 origin;
+            if(m_cull) {
+                origin = (m_frustum[0] + m_frustum[1] + m_frustum[2] + m_frustum[3]) * 0.25f;
+            } else if(m_context->currentCamera()) {
+                origin = m_context->currentCamera()->transform()->worldPosition();
+            }
+
+            for(auto &it : m_items) {
+                it.depth = (it.renderable->transform()->worldPosition() - origin).length();
+            }
+
+            // Translucent objects keep the distance order, the rest are drawn front to back by the depth ranges for the early depth test,
+            // the items are grouped within a range to produce bigger instancing batches
+            std::sort(m_items.begin(), m_items.end(), [](const PipelineContext::DrawItem &left, const PipelineContext::DrawItem &right) {
+                if(left.priority != right.priority) {
+                    return left.priority < right.priority;
+                }
+                int32_t leftRange = depthRange(left.depth);
+                int32_t rightRange = depthRange(right.depth);
+                if(leftRange != rightRange) {
+                    return leftRange < rightRange;
+                }
+                if(left.hash != right.hash) {
+                    return left.hash < right.hash;
+                }
+                return left.depth < right.depth;
+            });
+        }
+
+        // The static and the dynamic parts are hashed separately, the hash of an empty part is zero
+        m_hash[PipelineContext::AllItems] = m_items.size();
+        m_hash[PipelineContext::StaticItems] = 0;
+        m_hash[PipelineContext::DynamicItems] = 0;
+
+        m_static = true;
+        m_parts[0].clear();
+        m_parts[1].clear();
+
+        uint32_t counts[2] = {0, 0};
+        for(auto &it : m_items) {
+            uint32_t hash = it.hash;
+            Mathf::hashCombine(hash, it.renderable->transform()->hash());
+
+            Mathf::hashCombine(m_hash[PipelineContext::AllItems], hash);
+
+            bool isStatic = it.renderable->actor()->isStatic();
+            m_static &= isStatic;
+
+            PipelineContext::RenderListContent part = isStatic ? PipelineContext::StaticItems : PipelineContext::DynamicItems;
+            uint32_t index = part - PipelineContext::StaticItems;
+
+            AABBox bound = it.renderable->bound();
+            if(counts[index] == 0) {
+                m_partBound[index] = bound;
+            } else {
+                m_partBound[index].encapsulate(bound);
+            }
+            counts[index]++;
+
+            Mathf::hashCombine(m_hash[part], hash);
+
+            if(m_split) {
+                m_parts[index].push_back(it);
+            }
+        }
+
+        for(uint32_t i = 0; i < 2; i++) {
+            if(counts[i] == 0) {
+                m_partBound[i] = AABBox();
+            } else {
+                Mathf::hashCombine(m_hash[PipelineContext::StaticItems + i], counts[i]);
+            }
+        }
+
+        // The draw calls are recorded here and replayed on the render thread by PipelineContext::drawRenderList()
+        for(auto &it : m_commands) {
+            it.clear();
+        }
+        if(m_split) {
+            PipelineContext::recordItems(m_parts[0], m_layer, m_commands[PipelineContext::StaticItems]);
+            PipelineContext::recordItems(m_parts[1], m_layer, m_commands[PipelineContext::DynamicItems]);
+        } else {
+            PipelineContext::recordItems(m_items, m_layer, m_commands[PipelineContext::AllItems]);
+        }
+    }
+
+public:
+    std::array<Vector3, 8> m_frustum;
+
+    PipelineContext::DrawItems m_items;
+
+    PipelineContext::DrawItems m_parts[2];
+
+    CommandList m_commands[3];
+
+    AABBox m_bound;
+
+    AABBox m_partBound[2];
+
+    PipelineContext *m_context;
+
+    uint32_t m_layer;
+
+    uint32_t m_flags;
+
+    uint32_t m_hash[3];
+
+    bool m_static;
+
+    bool m_cull;
+
+    bool m_split;
+
 };
 
 /*!
@@ -50,6 +209,8 @@ PipelineContext::PipelineContext() :
         m_camera(nullptr),
         m_width(64),
         m_height(64),
+        m_renderListsCount(0),
+        m_lodBias(Engine::value(gLodBias, 1.0f).toFloat()),
         m_frustumCulling(true) {
 
     Material *mtl = Engine::loadResource<Material>(".embedded/DefaultPostEffect.shader");
@@ -75,6 +236,11 @@ PipelineContext::PipelineContext() :
 
 PipelineContext::~PipelineContext() {
     m_textureBuffers.clear();
+
+    for(auto it : m_renderLists) {
+        delete it;
+    }
+    m_renderLists.clear();
 }
 /*!
     Retrieves the command buffer associated with the pipeline context.
@@ -91,6 +257,16 @@ void PipelineContext::draw(Camera *camera) {
 
     setCurrentCamera(camera);
 
+    m_renderListsCount = 0;
+    m_jobs.clear();
+    for(auto it : m_renderTasks) {
+        if(it && it->isEnabled()) {
+            it->prepare(*this);
+        }
+    }
+
+    buildRenderLists();
+
     for(auto it : m_renderTasks) {
         if(it) {
             if(it->isEnabled()) {
@@ -180,11 +356,20 @@ void PipelineContext::analizeGraph() {
             }
         }
     }
+    // The particle emitters registered by their update are simulated in parallel
+    if(update) {
+        EffectBatch::process(Engine::threadPool(), m_buffer);
+    }
     // Renderables cull and sort
     if(m_frustumCulling) {
         m_culledComponents = frustumCulling(Camera::frustumCorners(*camera), m_sceneComponents, m_worldBound);
     }
 
+    // All scene components are processed, the shadow passes must use the same levels of detail
+    selectLods(camera);
+
+    requestTextures(camera);
+
     Vector3 origin = cameraTransform->position();
     culledComponents().sort([origin](const Renderable *left, const Renderable *right) {
         int p1 = left->priority();
@@ -234,6 +419,109 @@ void PipelineContext::analizeGraph() {
         it->setSettings(*m_postProcessSettings);
     }
 }
+/*!
+    \internal
+    Selects the level of detail for each scene component according to the projected size of its bounding sphere for the \a camera.
+    The hysteresis prevents flickering when the size is close to the switching threshold.
+*/
+void PipelineContext::selectLods(Camera *camera) {
+    PROFILE_FUNCTION();
+
+    Vector3 origin = camera->transform()->worldPosition();
+    bool ortho = camera->orthographic();
+    float scale = ortho ? 2.0f / camera->orthoSize() : 1.0f / tan(DEG2RAD * camera->fov() * 0.5f);
+    scale *= m_lodBias;
+
+    for(auto it : m_sceneComponents) {
+        Mesh *mesh = it->meshToDraw();
+        int32_t count = (mesh) ? mesh->lodCount() : 1;
+        if(count < 2) {
+            it->m_lod = 0;
+            continue;
+        }
+
+        AABBox bb = it->bound();
+        float radius = bb.extent.length();
+        float size = radius * scale;
+        if(!ortho) {
+            float distance = (bb.center - origin).length();
+            size = (distance > radius) ? size / distance : 1.0f;
+        }
+
+        int32_t lod = MIN(static_cast<int32_t>(it->m_lod), count - 1);
+        while(lod + 1 < count && size < mesh->lodScreenSize(lod + 1) * (1.0f - gLodHysteresis)) {
+            lod++;
+        }
+        while(lod > 0 && size > mesh->lodScreenSize(lod) * (1.0f + gLodHysteresis)) {
+            lod--;
+        }
+        it->m_lod = lod;
+    }
+}
+/*!
+    \internal
+    Requests the MIP levels of the streamed textures for the visible components according to their projected texel density for the \a camera.
+*/
+void PipelineContext::requestTextures(Camera *camera) {
+    PROFILE_FUNCTION();
+
+    if(TextureStreamer::budget() == 0) {
+        return;
+    }
+
+    Vector3 origin = camera->transform()->worldPosition();
+    bool ortho = camera->orthographic();
+    float scale = ortho ? m_height / camera->orthoSize() : m_height * 0.5f / tan(DEG2RAD * camera->fov() * 0.5f);
+
+    for(auto it : culledComponents()) {
+        Mesh *mesh = it->meshToDraw();
+        float density = (mesh) ? mesh->uvDensity() : 0.0f;
+
+        // The number of screen pixels covered by the whole UV space
+        float pixels = 0.0f;
+        if(density > 0.0f) {
+            Vector3 worldScale = it->actor()->transform()->worldScale();
+            pixels = density * MAX(fabs(worldScale.x), MAX(fabs(worldScale.y), fabs(worldScale.z))) * scale;
+            if(!ortho) {
+                AABBox bb = it->bound();
+                float distance = (bb.center - origin).length() - bb.extent.length();
+                pixels /= MAX(distance, camera->nearPlane());
+            }
+        }
+
+        for(auto instance : it->m_materials) {
+            if(instance == nullptr || instance->material() == nullptr) {
+                continue;
+            }
+            for(auto &item : instance->material()->textures()) {
+                Texture *texture = instance->texture(item.name.c_str());
+                if(texture == nullptr) {
+                    texture = item.texture;
+                }
+                if(texture && texture->isStreaming()) {
+                    int32_t mip = 0;
+                    if(pixels > 0.0f) {
+                        mip = MAX(static_cast<int32_t>(floor(log2(MAX(texture->width(), texture->height()) / pixels))), 0);
+                    }
+                    TextureStreamer::requestMip(texture, mip);
+                }
+            }
+        }
+    }
+}
+/*!
+    Returns the global level of detail bias.
+*/
+float PipelineContext::lodBias() const {
+    return m_lodBias;
+}
+/*!
+    Sets the global level of detail \a bias.
+    Values greater than 1.0 keep the detailed meshes for longer distance, lower values switch to the simplified meshes earlier.
+*/
+void PipelineContext::setLodBias(float bias) {
+    m_lodBias = MAX(bias, 0.0f);
+}
 /*!
     Returns the curent world instance to process.
 */
@@ -379,45 +667,205 @@ list<string> PipelineContext::renderTextures() const {
     Draws the specified \a list of Renderable compoenents on the given \a layer and \a flags.
 */
 void PipelineContext::drawRenderers(const list<Renderable *> &list, uint32_t layer, uint32_t flags) {
-    uint32_t lastHash = 0;
-    uint32_t lastSub = 0;
-    Mesh *lastMesh = nullptr;
-    MaterialInstance *lastInstance = nullptr;
+    m_drawItems.clear();
+    filterRenderers(list, layer, flags, m_drawItems);
+
+    for(auto &it : m_drawItems) {
+        MaterialInstance *instance = it.renderable->m_materials[it.sub];
+        if(instance->transform() == nullptr) {
+            instance->setTransform(it.renderable->transform());
+        }
+    }
+
+    m_commandList.clear();
+    recordItems(m_drawItems, layer, m_commandList);
+
+    m_buffer->execute(m_commandList);
+}
+/*!
+    Requests a list of culled components filtered by \a layer and \a flags to be built before the render tasks execution.
+    Must be called from PipelineTask::prepare().
+    Returns an identifier of the list to be used with drawRenderList().
+*/
+int32_t PipelineContext::requestRenderList(uint32_t layer, uint32_t flags) {
+    if(m_renderListsCount >= m_renderLists.size()) {
+        m_renderLists.push_back(new RenderListJob(this));
+    }
+
+    RenderListJob *job = m_renderLists[m_renderListsCount];
+    job->m_layer = layer;
+    job->m_flags = flags;
+    job->m_cull = false;
+    job->m_split = false;
+
+    return m_renderListsCount++;
+}
+/*!
+    Requests a list of scene components visible in the \a frustum and filtered by \a layer and \a flags to be built before the render tasks execution.
+    Must be called from PipelineTask::prepare().
+    The \a split list records the static and the dynamic components separately, so each part can be drawn on its own.
+    Returns an identifier of the list to be used with drawRenderList().
+*/
+int32_t PipelineContext::requestRenderList(const std::array<Vector3, 8> &frustum, uint32_t layer, uint32_t flags, bool split) {
+    int32_t result = requestRenderList(layer, flags);
+
+    RenderListJob *job = m_renderLists[result];
+    job->m_frustum = frustum;
+    job->m_cull = true;
+    job->m_split = split;
+
+    return result;
+}
+/*!
+    Draws the \a content of the render list with a given \a id which was requested by requestRenderList().
+    The static and the dynamic parts can be drawn only for the split lists, the whole list is drawn as the static part followed by the dynamic one.
+    The draw calls of the list are recorded on the worker thread when the list is built, this method only replays them to the command buffer.
+*/
+void PipelineContext::drawRenderList(int32_t id, RenderListContent content) {
+    if(id >= 0 && id < static_cast<int32_t>(m_renderListsCount)) {
+        RenderListJob *job = m_renderLists[id];
+        if(job->m_split && content == AllItems) {
+            m_buffer->execute(job->m_commands[StaticItems]);
+            m_buffer->execute(job->m_commands[DynamicItems]);
+        } else {
+            m_buffer->execute(job->m_commands[content]);
+        }
+    }
+}
+/*!
+    Requests a CPU \a job to be executed together with the render lists before the render tasks execution.
+    Must be called from PipelineTask::prepare(). The job runs on a worker thread, so it must not issue commands to the command buffer.
+*/
+void PipelineContext::requestJob(const std::function<void()> &job) {
+    m_jobs.push_back(job);
+}
+/*!
+    Returns the bounding box of the \a content of the render list with a given \a id.
+    For the whole list that is the bound of all components visible in the frustum, it's valid only for the lists requested with a frustum.
+    For the static or the dynamic part that is the bound of the components of the part.
+    The box is valid only after the render lists were built.
+*/
+AABBox PipelineContext::renderListBound(int32_t id, RenderListContent content) const {
+    if(id >= 0 && id < static_cast<int32_t>(m_renderListsCount)) {
+        RenderListJob *job = m_renderLists[id];
+        return (content == AllItems) ? job->m_bound : job->m_partBound[content - StaticItems];
+    }
+    return AABBox();
+}
+/*!
+    Returns the hash of the \a content of the render list with a given \a id.
+    The hash changes when the components are added, removed, moved or get a different mesh or material, the hash of an empty part is zero.
+    The hash is valid only after the render lists were built.
+*/
+uint32_t PipelineContext::renderListHash(int32_t id, RenderListContent content) const {
+    if(id >= 0 && id < static_cast<int32_t>(m_renderListsCount)) {
+        return m_renderLists[id]->m_hash[content];
+    }
+    return 0;
+}
+/*!
+    Returns true if all components of the render list with a given \a id belong to static actors; otherwise returns false.
+    The content of such lists can be cached while renderListHash() remains the same.
+*/
+bool PipelineContext::isRenderListStatic(int32_t id) const {
+    if(id >= 0 && id < static_cast<int32_t>(m_renderListsCount)) {
+        return m_renderLists[id]->m_static;
+    }
+    return false;
+}
+/*!
+    \internal
+    Executes culling, filtering and sorting for all requested render lists and the requested jobs.
+    Lists are built in parallel, it's safe because the jobs only read the scene data.
+*/
+void PipelineContext::buildRenderLists() {
+    PROFILE_FUNCTION();
+
+    uint32_t count = m_renderListsCount + m_jobs.size();
+    if(count == 0) {
+        return;
+    }
+
+    // Update cached bounds and transforms in advance, so the jobs don't write to the shared data
+    for(auto it : m_sceneComponents) {
+        it->bound();
 
+        for(auto instance : it->m_materials) {
+            if(instance && instance->transform() == nullptr) {
+                instance->setTransform(it->transform());
+            }
+        }
+    }
+
+    ParallelFor::run(Engine::threadPool(), count, [this](uint32_t index) {
+        if(index < m_renderListsCount) {
+            m_renderLists[index]->process();
+        } else {
+            m_jobs[index - m_renderListsCount]();
+        }
+    });
+}
+/*!
+    \internal
+    Fills the \a items with material instances of the \a list components which match the \a layer and \a flags.
+*/
+void PipelineContext::filterRenderers(const list<Renderable *> &list, uint32_t layer, uint32_t flags, DrawItems &items) {
     for(auto it : list) {
         if(it) {
             Actor *actor = it->actor();
 
             if((flags == 0 || actor->hideFlags() & flags) && actor->layers() & layer) {
+                int32_t priority = it->priority();
                 for(int32_t i = 0; i < it->m_materials.size(); i++) {
-                    MaterialInstance *instance = it->m_materials[i];
-                    if(instance->transform() == nullptr) {
-                        instance->setTransform(it->transform());
-                    }
-
-                    uint32_t hash = it->instanceHash(i);
-                    if(lastHash != hash || (lastInstance != nullptr && lastInstance->material() != instance->material())) {
-                        if(lastInstance != nullptr) {
-                            m_buffer->drawMesh(lastMesh, lastSub, layer, *lastInstance);
-                            lastInstance->resetBatches();
-                        }
-
-                        lastHash = hash;
-                        lastMesh = it->meshToDraw();
-                        lastInstance = instance;
-                        lastSub = i;
-                    } else if(lastInstance != nullptr) {
-                        lastInstance->batch(*instance);
+                    if(it->m_materials[i]) {
+                        items.push_back({it, static_cast<uint32_t>(i), it->instanceHash(i), priority, 0.0f});
                     }
                 }
             }
         }
     }
+}
+/*!
+    \internal
+    Records the draw calls of the prepared \a items on the given \a layer into the command \a list.
+    Items with equal hashes which are placed one by one are batched to a single draw call.
+    The material instances are only read, so it's safe to record different lists from different threads.
+*/
+void PipelineContext::recordItems(const DrawItems &items, uint32_t layer, CommandList &list) {
+    uint32_t lastHash = 0;
+    uint32_t lastSub = 0;
+    Mesh *lastMesh = nullptr;
+    MaterialInstance *lastInstance = nullptr;
+
+    std::vector<MaterialInstance *> batches;
+
+    for(auto &it : items) {
+        MaterialInstance *instance = it.renderable->m_materials[it.sub];
+
+        // The instances drawn with the arguments produced on GPU can't be batched
+        bool indirect = instance->indirectBuffer() != nullptr || (lastInstance != nullptr && lastInstance->indirectBuffer() != nullptr);
+        if(indirect || lastHash != it.hash || (lastInstance != nullptr && lastInstance->material() != instance->material())) {
+            if(lastInstance != nullptr) {
+                list.drawMesh(lastMesh, lastSub, layer, *lastInstance, batches);
+                batches.clear();
+            }
+
+            lastHash = it.hash;
+            lastMesh = it.renderable->meshToDraw();
+            lastInstance = instance;
+            lastSub = it.sub;
+            if(lastMesh && it.renderable->m_lod > 0) {
+                // Sub meshes of the levels of detail follow the base ones
+                lastSub += it.renderable->m_lod * lastMesh->subMeshCount();
+            }
+        } else if(lastInstance != nullptr) {
+            batches.push_back(instance);
+        }
+    }
 
     // do the last call
     if(lastInstance != nullptr) {
-        m_buffer->drawMesh(lastMesh, lastSub, layer, *lastInstance);
-        lastInstance->resetBatches();
+        list.drawMesh(lastMesh, lastSub, layer, *lastInstance, batches);
     }
 }
 /*!
@@ -26,6 +26,13 @@ PipelineTask::~PipelineTask() {
 */
 void PipelineTask::analyze(World *world) {
 
+}
+/*!
+    This method is called for the provided \a context before execution of any task.
+    It can be used to request render lists with PipelineContext::requestRenderList(), which will be built in parallel.
+*/
+void PipelineTask::prepare(PipelineContext &context) {
+    A_UNUSED(context);
 }
 /*!
     The task will be executed for the provided \a context.
@@ -8,25 +8,112 @@
 #include "components/spotlight.h"
 
 #include "resources/rendertarget.h"
+#include "resources/material.h"
 #include "resources/mesh.h"
 
 #include "pipelinecontext.h"
 #include "commandbuffer.h"
 
+#include <cstring>
+
+#define ROW_SIZE 1024
+#define LIGHT_TEXELS 4
+
 namespace {
     const char *uniPosition  = "position";
     const char *uniDirection = "direction";
     const char *uniRight     = "right";
     const char *uniUp        = "up";
+
+    const char *uniClusterSize  = "clusterSize";
+    const char *uniClusterDepth = "clusterDepth";
+
+    const char *clustersMap     = "clustersMap";
+    const char *lightIndicesMap = "lightIndicesMap";
+    const char *lightsMap       = "lightsMap";
+
+    // Below this number of lights the light volumes are cheaper than the cluster building
+    const uint32_t gClusteredThreshold = 16;
 }
 
 DeferredLighting::DeferredLighting() :
-    m_lightPass(Engine::objectCreate<RenderTarget>("lightPass")) {
+        m_lightPass(Engine::objectCreate<RenderTarget>("lightPass")),
+        m_clustersTexture(Engine::objectCreate<Texture>(clustersMap)),
+        m_indicesTexture(Engine::objectCreate<Texture>(lightIndicesMap)),
+        m_lightsTexture(Engine::objectCreate<Texture>(lightsMap)),
+        m_clustered(nullptr),
+        m_clusteredMode(false) {
 
     setName("DeferredLighting");
 
     m_inputs.push_back("In");
     m_outputs.push_back(std::make_pair("Result", nullptr));
+
+    for(auto it : {m_clustersTexture, m_indicesTexture, m_lightsTexture}) {
+        it->setFormat(Texture::RGBA32Float);
+        it->setFiltering(Texture::None);
+        it->setWrap(Texture::Clamp);
+    }
+
+    Material *mtl = Engine::loadResource<Material>(".embedded/ClusteredLighting.shader");
+    if(mtl) {
+        m_clustered = mtl->createInstance();
+        m_clustered->setTexture(clustersMap, m_clustersTexture);
+        m_clustered->setTexture(lightIndicesMap, m_indicesTexture);
+        m_clustered->setTexture(lightsMap, m_lightsTexture);
+    }
+}
+
+DeferredLighting::~DeferredLighting() {
+    m_clustersTexture->deleteLater();
+    m_indicesTexture->deleteLater();
+    m_lightsTexture->deleteLater();
+
+    delete m_clustered;
+}
+
+void DeferredLighting::prepare(PipelineContext &context) {
+    // Shadowless point and spot lights can be shaded together in a single clustered pass
+    m_clusteredLights.clear();
+    if(m_clustered) {
+        for(auto it : context.sceneLights()) {
+            BaseLight *light = static_cast<BaseLight *>(it);
+            if(isClusterable(light)) {
+                m_clusteredLights.push_back(light);
+            }
+        }
+    }
+
+    m_clusteredMode = m_clusteredLights.size() >= gClusteredThreshold;
+
+    m_volumeLights.clear();
+    for(auto it : context.sceneLights()) {
+        BaseLight *light = static_cast<BaseLight *>(it);
+        if(!m_clusteredMode || !isClusterable(light)) {
+            m_volumeLights.push_back(light);
+        }
+    }
+    m_volumes.resize(m_volumeLights.size());
+
+    if(m_clusteredMode) {
+        Camera *camera = context.currentCamera();
+        if(camera->orthographic()) {
+            m_clusters.setOrthographic(camera->orthoSize(), camera->ratio(), camera->nearPlane(), camera->farPlane());
+        } else {
+            m_clusters.setPerspective(camera->fov(), camera->ratio(), camera->nearPlane(), camera->farPlane());
+        }
+        m_view = camera->viewMatrix();
+
+        resizeTexture(m_lightsTexture, m_clusteredLights.size() * LIGHT_TEXELS);
+    }
+
+    // The light data only reads the scene, so it's calculated together with the render lists
+    context.requestJob([this]() {
+        if(m_clusteredMode) {
+            clusteredLightBuild();
+        }
+        lightVolumesUpdate();
+    });
 }
 
 void DeferredLighting::exec(PipelineContext &context) {
@@ -34,88 +121,190 @@ void DeferredLighting::exec(PipelineContext &context) {
     buffer->beginDebugMarker("DeferredLighting");
 
     buffer->setRenderTarget(m_lightPass);
+
+    if(m_clusteredMode) {
+        clusteredLightUpdate();
+    }
+
     // Light pass
-    for(auto it : context.sceneLights()) {
-        BaseLight *light = static_cast<BaseLight *>(it);
+    for(uint32_t i = 0; i < m_volumeLights.size(); i++) {
+        BaseLight *light = m_volumeLights[i];
+        const LightVolume &volume = m_volumes[i];
 
-        Mesh *mesh = PipelineContext::defaultCube();
+        auto instance = light->material();
+        if(instance) {
+            if(light->lightType() != BaseLight::DirectLight) {
+                instance->setTransform(volume.transform);
+                instance->setVector3(uniPosition, &volume.position);
+            }
+            instance->setVector3(uniDirection, &volume.direction);
+            if(light->lightType() == BaseLight::AreaLight) {
+                instance->setVector3(uniRight, &volume.right);
+                instance->setVector3(uniUp, &volume.up);
+            }
+        }
 
-        switch(light->lightType()) {
-        case BaseLight::AreaLight: {
-            auto instance = light->material();
-            if(instance) {
-                Matrix4 m(light->transform()->worldTransform());
+        Mesh *mesh = (light->lightType() == BaseLight::DirectLight) ? PipelineContext::defaultPlane() : PipelineContext::defaultCube();
+        buffer->drawMesh(mesh, 0, CommandBuffer::LIGHT, *light->material());
+    }
 
-                Vector3 position(m[12], m[13], m[14]);
+    if(m_clusteredMode) {
+        buffer->drawMesh(PipelineContext::defaultPlane(), 0, CommandBuffer::LIGHT, *m_clustered);
+    }
 
-                float d = static_cast<AreaLight *>(light)->radius() * 2.0f;
+    buffer->endDebugMarker();
+}
 
-                Vector3 direction(m.rotation() * Vector3(0.0f, 0.0f, 1.0f));
-                Vector3 right(m.rotation() * Vector3(1.0f, 0.0f, 0.0f));
-                Vector3 up(m.rotation() * Vector3(0.0f, 1.0f, 0.0f));
+bool DeferredLighting::isClusterable(BaseLight *light) const {
+    if(light->castShadows() || light->material() == nullptr) {
+        return false;
+    }
 
-                instance->setTransform(Matrix4(position, Quaternion(), Vector3(d)));
-                instance->setVector3(uniPosition, &position);
-                instance->setVector3(uniDirection, &direction);
-                instance->setVector3(uniRight, &right);
-                instance->setVector3(uniUp, &up);
-            }
-        } break;
-        case BaseLight::PointLight: {
-            auto instance = light->material();
-            if(instance) {
-                Matrix4 m(light->transform()->worldTransform());
+    switch(light->lightType()) {
+        case BaseLight::PointLight: return static_cast<PointLight *>(light)->sourceLength() <= 0.0f;
+        case BaseLight::SpotLight: return true;
+        default: break;
+    }
+    return false;
+}
 
-                float d = static_cast<PointLight *>(light)->attenuationRadius() * 2.0f;
+void DeferredLighting::lightVolumesUpdate() {
+    PROFILE_FUNCTION();
 
-                Vector3 position(m[12], m[13], m[14]);
-                Vector3 direction(m.rotation() * Vector3(0.0f, 1.0f, 0.0f));
+    for(uint32_t i = 0; i < m_volumeLights.size(); i++) {
+        BaseLight *light = m_volumeLights[i];
+        LightVolume &volume = m_volumes[i];
 
-                instance->setTransform(Matrix4(Vector3(m[12], m[13], m[14]), Quaternion(), Vector3(d)));
-                instance->setVector3(uniPosition, &position);
-                instance->setVector3(uniDirection, &direction);
-            }
+        Transform *t = light->transform();
+        Matrix4 m(t->worldTransform());
+
+        switch(light->lightType()) {
+        case BaseLight::AreaLight: {
+            float d = static_cast<AreaLight *>(light)->radius() * 2.0f;
+
+            volume.position = Vector3(m[12], m[13], m[14]);
+            volume.direction = m.rotation() * Vector3(0.0f, 0.0f, 1.0f);
+            volume.right = m.rotation() * Vector3(1.0f, 0.0f, 0.0f);
+            volume.up = m.rotation() * Vector3(0.0f, 1.0f, 0.0f);
+            volume.transform = Matrix4(volume.position, Quaternion(), Vector3(d));
+        } break;
+        case BaseLight::PointLight: {
+            float d = static_cast<PointLight *>(light)->attenuationRadius() * 2.0f;
+
+            volume.position = Vector3(m[12], m[13], m[14]);
+            volume.direction = m.rotation() * Vector3(0.0f, 1.0f, 0.0f);
+            volume.transform = Matrix4(volume.position, Quaternion(), Vector3(d));
         } break;
         case BaseLight::SpotLight: {
-            auto instance = light->material();
-            if(instance) {
-                Transform *t = light->transform();
-
-                Matrix4 m(t->worldTransform());
-                Quaternion q(t->worldQuaternion());
-
-                Vector3 position(m[12], m[13], m[14]);
-                Vector3 direction(q * Vector3(0.0f, 0.0f, 1.0f));
-
-                float distance = static_cast<SpotLight *>(light)->attenuationDistance();
-                float angle = static_cast<SpotLight *>(light)->outerAngle();
-                float radius = tan(DEG2RAD * angle * 0.5f) * distance;
-                Matrix4 mat(position - direction * distance * 0.5f,
-                            q,
-                            Vector3(radius * 2.0f, radius * 2.0f, distance));
-
-                instance->setTransform(mat);
-                instance->setVector3(uniPosition, &position);
-                instance->setVector3(uniDirection, &direction);
-            }
+            Quaternion q(t->worldQuaternion());
+
+            volume.position = Vector3(m[12], m[13], m[14]);
+            volume.direction = q * Vector3(0.0f, 0.0f, 1.0f);
+
+            float distance = static_cast<SpotLight *>(light)->attenuationDistance();
+            float angle = static_cast<SpotLight *>(light)->outerAngle();
+            float radius = tan(DEG2RAD * angle * 0.5f) * distance;
+            volume.transform = Matrix4(volume.position - volume.direction * distance * 0.5f,
+                                       q,
+                                       Vector3(radius * 2.0f, radius * 2.0f, distance));
         } break;
         case BaseLight::DirectLight: {
-            mesh = PipelineContext::defaultPlane();
+            volume.direction = t->worldQuaternion() * Vector3(0.0f, 0.0f, 1.0f);
+        } break;
+        default: break;
+        }
+    }
+}
+
+void DeferredLighting::clusteredLightBuild() {
+    PROFILE_FUNCTION();
+
+    uint32_t count = m_clusteredLights.size();
 
-            auto instance = light->material();
-            if(instance) {
-                Transform *t = light->transform();
-                Vector3 direction(t->worldQuaternion() * Vector3(0.0f, 0.0f, 1.0f));
+    m_spheres.resize(count);
+    Vector4 *lights = reinterpret_cast<Vector4 *>(m_lightsTexture->surface(0)[0].data());
 
-                instance->setVector3(uniDirection, &direction);
+    for(uint32_t i = 0; i < count; i++) {
+        BaseLight *light = m_clusteredLights[i];
+        Transform *t = light->transform();
+
+        Vector3 position(t->worldPosition());
+        Vector3 direction(t->worldQuaternion() * Vector3(0.0f, 0.0f, 1.0f));
+        Vector4 params(light->brightness(), 0.0f, 0.0f, 0.0f);
+
+        Vector4 *data = &lights[i * LIGHT_TEXELS];
+        if(light->lightType() == BaseLight::SpotLight) {
+            SpotLight *spot = static_cast<SpotLight *>(light);
+            // Bounding sphere of the cone which is directed backward to the light direction
+            float distance = spot->attenuationDistance();
+            float angle = DEG2RAD * spot->outerAngle() * 0.5f;
+            float cosine = cos(angle);
+
+            params.y = distance;
+            params.w = cosine;
+            if(angle > PI * 0.25f) {
+                m_spheres[i] = Vector4(position - direction * (cosine * distance), sin(angle) * distance);
+            } else {
+                float radius = distance / (2.0f * cosine);
+                m_spheres[i] = Vector4(position - direction * radius, radius);
             }
-        } break;
-        default: break;
+
+            data[0] = Vector4(position, 1.0f);
+        } else {
+            PointLight *point = static_cast<PointLight *>(light);
+            params.y = point->sourceRadius();
+            params.w = point->attenuationRadius();
+
+            m_spheres[i] = Vector4(position, params.w);
+
+            data[0] = Vector4(position, 0.0f);
         }
+        data[1] = light->color();
+        data[2] = Vector4(direction, 0.0f);
+        data[3] = params;
+    }
 
-        buffer->drawMesh(mesh, 0, CommandBuffer::LIGHT, *light->material());
+    m_clusters.build(m_view, m_spheres);
+}
+
+void DeferredLighting::clusteredLightUpdate() {
+    PROFILE_FUNCTION();
+
+    auto &clusters = m_clusters.clusters();
+    uint32_t width = m_clusters.sizeX() * m_clusters.sizeY();
+    if(m_clustersTexture->width() != width || m_clustersTexture->height() != m_clusters.sizeZ()) {
+        m_clustersTexture->resize(width, m_clusters.sizeZ());
+    }
+    Vector4 *cells = reinterpret_cast<Vector4 *>(m_clustersTexture->surface(0)[0].data());
+    for(uint32_t i = 0; i < clusters.size(); i++) {
+        cells[i] = Vector4(clusters[i].offset, clusters[i].count, 0.0f, 0.0f);
+    }
+    m_clustersTexture->setDirty();
+
+    auto &indices = m_clusters.indices();
+    resizeTexture(m_indicesTexture, (indices.size() + 3) / 4);
+    float *ptr = reinterpret_cast<float *>(m_indicesTexture->surface(0)[0].data());
+    for(uint32_t i = 0; i < indices.size(); i++) {
+        ptr[i] = indices[i];
+    }
+    m_indicesTexture->setDirty();
+
+    m_lightsTexture->setDirty();
+
+    Vector4 size(m_clusters.sizeX(), m_clusters.sizeY(), m_clusters.sizeZ(), m_clusteredLights.size());
+    Vector4 depth(m_clusters.nearPlane(), m_clusters.farPlane(),
+                  m_clusters.sizeZ() / log(m_clusters.farPlane() / m_clusters.nearPlane()), 0.0f);
+
+    m_clustered->setVector4(uniClusterSize, &size);
+    m_clustered->setVector4(uniClusterDepth, &depth);
+}
+
+void DeferredLighting::resizeTexture(Texture *texture, uint32_t texels) {
+    // Texture grows by rows and never shrinks to avoid reallocations
+    uint32_t rows = MAX((texels + ROW_SIZE - 1) / ROW_SIZE, 1U);
+    if(texture->width() != ROW_SIZE || texture->height() < rows) {
+        texture->resize(ROW_SIZE, rows);
     }
-    buffer->endDebugMarker();
 }
 
 void DeferredLighting::setInput(int index, Texture *texture) {
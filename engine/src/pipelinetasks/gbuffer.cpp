@@ -16,7 +16,8 @@
 #define G_PARAMS    "paramsMap"
 
 GBuffer::GBuffer() :
-        m_gbuffer(Engine::objectCreate<RenderTarget>(GBUFFER)) {
+        m_gbuffer(Engine::objectCreate<RenderTarget>(GBUFFER)),
+        m_renderList(-1) {
 
     setName("GBuffer");
 
@@ -56,6 +57,10 @@ GBuffer::GBuffer() :
     }
 }
 
+void GBuffer::prepare(PipelineContext &context) {
+    m_renderList = context.requestRenderList(CommandBuffer::DEFAULT);
+}
+
 void GBuffer::exec(PipelineContext &context) {
     CommandBuffer *buffer = context.buffer();
     buffer->beginDebugMarker("GBuffer Pass");
@@ -66,7 +71,7 @@ void GBuffer::exec(PipelineContext &context) {
     buffer->setRenderTarget(m_gbuffer);
     buffer->clearRenderTarget(true, context.currentCamera()->color());
 
-    context.drawRenderers(context.culledComponents(), CommandBuffer::DEFAULT);
+    context.drawRenderList(m_renderList);
 
     buffer->endDebugMarker();
 }
@@ -36,11 +36,17 @@ namespace {
     const char *uniBias = "bias";
     const char *uniPlaneDistance = "planeDistance";
     const char *uniShadows = "shadows";
+
+    const char *gTilesPerFrame = "tilesPerFrame";
+    const char *gCached = "cached";
 };
 
 ShadowMap::ShadowMap() :
         m_bias(0.0f),
-        m_shadowResolution(4096) {
+        m_shadowResolution(4096),
+        m_tilesPerFrame(0),
+        m_nextRequest(0),
+        m_cached(true) {
 
     setName("ShadowMap");
 
@@ -62,12 +68,10 @@ ShadowMap::ShadowMap() :
                     Quaternion()};
 }
 
-void ShadowMap::exec(PipelineContext &context) {
-    CommandBuffer *buffer = context.buffer();
-    buffer->beginDebugMarker("ShadowMap");
+void ShadowMap::prepare(PipelineContext &context) {
     cleanShadowCache();
 
-    std::list<Renderable *> &components = context.sceneComponents();
+    m_requests.clear();
     for(auto &it : context.sceneLights()) {
         BaseLight *base = static_cast<BaseLight *>(it);
 
@@ -79,78 +83,152 @@ void ShadowMap::exec(PipelineContext &context) {
 
         if(base->castShadows()) {
             switch(base->lightType()) {
-            case BaseLight::DirectLight: directLightUpdate(context, static_cast<DirectLight *>(base), components, *context.currentCamera()); break;
-            case BaseLight::AreaLight: areaLightUpdate(context, static_cast<AreaLight *>(base), components); break;
-            case BaseLight::PointLight: pointLightUpdate(context, static_cast<PointLight *>(base), components); break;
-            case BaseLight::SpotLight: spotLightUpdate(context, static_cast<SpotLight *>(base), components); break;
+            case BaseLight::DirectLight: directLightUpdate(context, static_cast<DirectLight *>(base), *context.currentCamera()); break;
+            case BaseLight::AreaLight: areaLightUpdate(context, static_cast<AreaLight *>(base)); break;
+            case BaseLight::PointLight: pointLightUpdate(context, static_cast<PointLight *>(base)); break;
+            case BaseLight::SpotLight: spotLightUpdate(context, static_cast<SpotLight *>(base)); break;
             default: break;
             }
         }
     }
-
-    context.cameraReset();
-    buffer->endDebugMarker();
 }
 
-void ShadowMap::areaLightUpdate(PipelineContext &context, AreaLight *light, std::list<Renderable *> &components) {
+void ShadowMap::exec(PipelineContext &context) {
     CommandBuffer *buffer = context.buffer();
-    Transform *t = light->transform();
+    buffer->beginDebugMarker("ShadowMap");
 
-    int32_t x[SIDES], y[SIDES], w[SIDES], h[SIDES];
-    RenderTarget *shadowTarget = requestShadowTiles(context, light->uuid(), 1, x, y, w, h, SIDES);
+    uint32_t updated = 0;
+    uint32_t count = m_requests.size();
+    uint32_t start = (count > 0) ? m_nextRequest % count : 0;
+    uint32_t next = start;
+    for(uint32_t r = 0; r < count; r++) {
+        // Continue from the light which was out of the update budget last time
+        uint32_t index = (start + r) % count;
+        ShadowRequest &request = m_requests[index];
+        if(request.light->lightType() == BaseLight::DirectLight) {
+            directLightMatrices(context, request);
+        }
 
-    float zNear = 0.1f;
-    float zFar = light->radius();
-    Matrix4 crop(Matrix4::perspective(90.0f, 1.0f, zNear, zFar));
+        std::vector<TileState> &cache = m_tileStates[request.light->uuid()];
+        cache.resize(request.count);
 
-    Matrix4 wt(t->worldTransform());
-    Vector3 position(wt[12], wt[13], wt[14]);
+        RenderTarget *current = nullptr;
+        for(uint32_t i = 0; i < request.count; i++) {
+            TileState &tile = cache[i];
 
-    Matrix4 wp;
-    wp.translate(position);
+            int32_t list = request.renderList + i;
 
-    Vector4 tiles[SIDES];
-    Matrix4 matrix[SIDES];
+            TileContent content;
+            for(int32_t m = 0; m < 16; m++) {
+                Mathf::hashCombine(content.lightHash, request.view[i][m]);
+                Mathf::hashCombine(content.lightHash, request.crop[i][m]);
+            }
+            content.staticHash = context.renderListHash(list, PipelineContext::StaticItems);
+            content.dynamicHash = context.renderListHash(list, PipelineContext::DynamicItems);
+            content.staticBound = context.renderListBound(list, PipelineContext::StaticItems);
 
-    uint32_t pageSize = Texture::maxTextureSize();
+            TileUpdate update = tileUpdate(tile, content, m_cached);
+            if(update == Skip) {
+                continue;
+            }
+            if(tile.valid && m_tilesPerFrame > 0 && updated >= m_tilesPerFrame) {
+                // Out of budget, keep the outdated tile until the next frames
+                if(next == start) {
+                    next = index;
+                }
+                continue;
+            }
 
-    buffer->setRenderTarget(shadowTarget);
-    for(int32_t i = 0; i < m_directions.size(); i++) {
-        Matrix4 mat((wp * Matrix4(m_directions[i].toMatrix())).inverse());
-        matrix[i] = m_scale * crop * mat;
+            buffer->setViewProjection(request.view[i], request.crop[i]);
+            buffer->setViewport(request.x[i], request.y[i], request.w[i], request.h[i]);
 
-        tiles[i] = Vector4(static_cast<float>(x[i]) / pageSize,
-                           static_cast<float>(y[i]) / pageSize,
-                           static_cast<float>(w[i]) / pageSize,
-                           static_cast<float>(h[i]) / pageSize);
+            bool split = m_cached && content.dynamicHash != 0;
+            if(update == Full && split) {
+                // Static casters are rendered once to the cache page and copied to the tile while they don't change
+                RenderTarget *page = cachePage(request.target);
+                buffer->setRenderTarget(page);
+                current = page;
 
-        buffer->enableScissor(x[i], y[i], w[i], h[i]);
-        buffer->clearRenderTarget();
-        buffer->disableScissor();
+                buffer->enableScissor(request.x[i], request.y[i], request.w[i], request.h[i]);
+                buffer->clearRenderTarget();
+                buffer->disableScissor();
 
-        buffer->setViewProjection(mat, crop);
-        buffer->setViewport(x[i], y[i], w[i], h[i]);
+                context.drawRenderList(list, PipelineContext::StaticItems);
+            }
 
-        AABBox bb;
-        auto corners = Camera::frustumCorners(false, 90.0f, 1.0f, position, m_directions[i], zNear, zFar);
-        // Draw in the depth buffer from position of the light source
-        context.drawRenderers(context.frustumCulling(corners, components, bb), CommandBuffer::SHADOWCAST);
+            if(current != request.target) {
+                buffer->setRenderTarget(request.target);
+                current = request.target;
+            }
+
+            buffer->enableScissor(request.x[i], request.y[i], request.w[i], request.h[i]);
+            if(split) {
+                buffer->copyRenderTarget(cachePage(request.target), request.x[i], request.y[i], request.w[i], request.h[i]);
+            } else {
+                buffer->clearRenderTarget();
+            }
+            buffer->disableScissor();
+
+            // Draw in the depth buffer from position of the light source
+            if(split) {
+                context.drawRenderList(list, PipelineContext::DynamicItems);
+            } else {
+                context.drawRenderList(list);
+            }
+
+            tile.matrix = m_scale * request.crop[i] * request.view[i];
+            tile.content = content;
+            tile.staticCached = split;
+            tile.valid = true;
+
+            updated++;
+        }
+
+        lightUniforms(request, cache);
+    }
+    m_nextRequest = next;
+
+    context.cameraReset();
+    buffer->endDebugMarker();
+}
+
+void ShadowMap::setProperty(const std::string &name, const Variant &value) {
+    if(name == gTilesPerFrame) {
+        m_tilesPerFrame = MAX(value.toInt(), 0);
+    } else if(name == gCached) {
+        m_cached = value.toBool();
+        m_tileStates.clear();
+    }
+}
+/*!
+    \internal
+    Returns how the \a tile must be updated to match the new \a content.
+    With the \a cached static casters the tile is redrawn completely only when the light or the static casters are changed,
+    otherwise only the dynamic casters are drawn on top of the cached static depth.
+*/
+ShadowMap::TileUpdate ShadowMap::tileUpdate(const TileState &tile, const TileContent &content, bool cached) {
+    if(!tile.valid || !cached) {
+        return Full;
     }
 
-    auto instance = light->material();
-    if(instance) {
-        Vector4 bias(m_bias);
+    if(tile.content.lightHash != content.lightHash ||
+       tile.content.staticHash != content.staticHash ||
+       tile.content.staticBound != content.staticBound) {
+        return Full;
+    }
 
-        instance->setMatrix4(uniMatrix, matrix, SIDES);
-        instance->setVector4(uniTiles, tiles, SIDES);
-        instance->setVector4(uniBias, &bias);
-        instance->setTexture(SHADOW_MAP, shadowTarget->depthAttachment());
+    if(tile.content.dynamicHash == 0 && content.dynamicHash == 0) {
+        return Skip;
     }
+
+    return tile.staticCached ? Dynamic : Full;
 }
 
-void ShadowMap::directLightUpdate(PipelineContext &context, DirectLight *light, std::list<Renderable *> &components, const Camera &camera) {
-    CommandBuffer *buffer = context.buffer();
+void ShadowMap::areaLightUpdate(PipelineContext &context, AreaLight *light) {
+    omniLightUpdate(context, light, light->radius());
+}
 
+void ShadowMap::directLightUpdate(PipelineContext &context, DirectLight *light, const Camera &camera) {
     float nearPlane = camera.nearPlane();
 
     Matrix4 p(camera.projectionMatrix());
@@ -183,13 +261,12 @@ void ShadowMap::directLightUpdate(PipelineContext &context, DirectLight *light,
     float sigma = (orthographic) ? camera.orthoSize() : camera.fov();
     ratio = camera.ratio();
 
-    int32_t x[MAX_LODS], y[MAX_LODS], w[MAX_LODS], h[MAX_LODS];
-    RenderTarget *shadowTarget = requestShadowTiles(context, light->uuid(), 0, x, y, w, h, MAX_LODS);
+    ShadowRequest request;
+    request.light = light;
+    request.count = MAX_LODS;
+    request.target = requestShadowTiles(context, light->uuid(), 0, request.x, request.y, request.w, request.h, MAX_LODS);
+    request.planeDistance = planeDistance;
 
-    Vector4 tiles[MAX_LODS];
-    Matrix4 matrix[MAX_LODS];
-
-    buffer->setRenderTarget(shadowTarget);
     for(int32_t lod = 0; lod < MAX_LODS; lod++) {
         float dist = distance[lod];
         auto points = Camera::frustumCorners(orthographic, sigma, ratio, cameraPos, cameraRot, nearPlane, dist);
@@ -200,65 +277,74 @@ void ShadowMap::directLightUpdate(PipelineContext &context, DirectLight *light,
         box.setBox(points.data(), 8);
         box *= rot.rotation();
 
-        AABBox bb;
+        request.box[lod] = box;
+
         auto corners = Camera::frustumCorners(true, box.extent.y * 2.0f, 1.0f, box.center, lightRot, -FLT_MAX, FLT_MAX);
-        RenderList filter(context.frustumCulling(corners, components, bb));
+        int32_t id = context.requestRenderList(corners, CommandBuffer::SHADOWCAST, 0, true);
+        if(lod == 0) {
+            request.renderList = id;
+        }
+    }
 
-        float radius = MAX(box.radius, bb.radius);
+    m_requests.push_back(request);
+}
+
+void ShadowMap::directLightMatrices(PipelineContext &context, ShadowRequest &request) {
+    Quaternion lightRot(request.light->transform()->worldQuaternion());
+    Matrix4 rot(Matrix4(lightRot.toMatrix()).inverse());
+
+    for(int32_t lod = 0; lod < MAX_LODS; lod++) {
+        // The cascade must enclose all shadow casters found by the render list
+        AABBox &box = request.box[lod];
+        float radius = MAX(box.radius, context.renderListBound(request.renderList + lod).radius);
 
         Matrix4 m;
         m.translate(-box.center - lightRot * Vector3(0.0f, 0.0f, radius));
-        Matrix4 view(rot * m);
-        Matrix4 crop(Matrix4::ortho(-box.extent.x, box.extent.x,
-                                    -box.extent.y, box.extent.y,
-                                     0.0f, radius * 2.0f));
-
-        uint32_t pageSize = Texture::maxTextureSize();
+        request.view[lod] = rot * m;
+        request.crop[lod] = Matrix4::ortho(-box.extent.x, box.extent.x,
+                                           -box.extent.y, box.extent.y,
+                                            0.0f, radius * 2.0f);
+    }
+}
 
-        matrix[lod] = m_scale * crop * view;
-        tiles[lod] = Vector4(static_cast<float>(x[lod]) / pageSize,
-                             static_cast<float>(y[lod]) / pageSize,
-                             static_cast<float>(w[lod]) / pageSize,
-                             static_cast<float>(h[lod]) / pageSize);
+void ShadowMap::pointLightUpdate(PipelineContext &context, PointLight *light) {
+    omniLightUpdate(context, light, light->attenuationRadius());
+}
 
-        buffer->enableScissor(x[lod], y[lod], w[lod], h[lod]);
-        buffer->clearRenderTarget();
+void ShadowMap::spotLightUpdate(PipelineContext &context, SpotLight *light) {
+    Transform *t = light->transform();
 
-        buffer->setViewProjection(view, crop);
-        buffer->setViewport(x[lod], y[lod], w[lod], h[lod]);
+    Quaternion q(t->worldQuaternion());
+    Matrix4 wt(t->worldTransform());
+    Matrix4 rot(wt.inverse());
 
-        // Draw in the depth buffer from position of the light source
-        context.drawRenderers(filter, CommandBuffer::SHADOWCAST);
+    Vector3 position(wt[12], wt[13], wt[14]);
 
-        buffer->disableScissor();
-    }
+    float zNear = 0.1f;
+    float zFar = light->attenuationDistance();
 
-    auto instance = light->material();
-    if(instance) {
-        Vector4 bias(m_bias);
+    ShadowRequest request;
+    request.light = light;
+    request.count = 1;
+    request.target = requestShadowTiles(context, light->uuid(), 1, request.x, request.y, request.w, request.h, 1);
+    request.view[0] = rot;
+    request.crop[0] = Matrix4::perspective(light->outerAngle(), 1.0f, zNear, zFar);
 
-        const float biasModifier = 0.5f;
-        for(int32_t lod = 0; lod < MAX_LODS; lod++) {
-            bias[lod] *= 1.0 / (planeDistance[lod] * biasModifier);
-        }
+    auto corners = Camera::frustumCorners(false, light->outerAngle() * 2.0f, 1.0f, position, q, zNear, zFar);
+    request.renderList = context.requestRenderList(corners, CommandBuffer::SHADOWCAST, 0, true);
 
-        instance->setMatrix4(uniMatrix, matrix, MAX_LODS);
-        instance->setVector4(uniTiles, tiles, MAX_LODS);
-        instance->setVector4(uniBias, &bias);
-        instance->setVector4(uniPlaneDistance, &planeDistance);
-        instance->setTexture(SHADOW_MAP, shadowTarget->depthAttachment());
-    }
+    m_requests.push_back(request);
 }
 
-void ShadowMap::pointLightUpdate(PipelineContext &context, PointLight *light, std::list<Renderable *> &components) {
-    CommandBuffer *buffer = context.buffer();
+void ShadowMap::omniLightUpdate(PipelineContext &context, BaseLight *light, float zFar) {
     Transform *t = light->transform();
 
-    int32_t x[SIDES], y[SIDES], w[SIDES], h[SIDES];
-    RenderTarget *shadowTarget = requestShadowTiles(context, light->uuid(), 1, x, y, w, h, SIDES);
+    ShadowRequest request;
+    request.light = light;
+    request.count = SIDES;
+    request.target = requestShadowTiles(context, light->uuid(), 1, request.x, request.y, request.w, request.h, SIDES);
 
     float zNear = 0.1f;
-    float zFar = light->attenuationRadius();
     Matrix4 crop(Matrix4::perspective(90.0f, 1.0f, zNear, zFar));
 
     Matrix4 wt(t->worldTransform());
@@ -267,96 +353,53 @@ void ShadowMap::pointLightUpdate(PipelineContext &context, PointLight *light, st
     Matrix4 wp;
     wp.translate(position);
 
-    Vector4 tiles[SIDES];
-    Matrix4 matrix[SIDES];
-
-    uint32_t pageSize = Texture::maxTextureSize();
-
-    buffer->setRenderTarget(shadowTarget);
     for(int32_t i = 0; i < m_directions.size(); i++) {
-        Matrix4 mat((wp * Matrix4(m_directions[i].toMatrix())).inverse());
-        matrix[i] = m_scale * crop * mat;
-
-        tiles[i] = Vector4(static_cast<float>(x[i]) / pageSize,
-                           static_cast<float>(y[i]) / pageSize,
-                           static_cast<float>(w[i]) / pageSize,
-                           static_cast<float>(h[i]) / pageSize);
-
-        buffer->enableScissor(x[i], y[i], w[i], h[i]);
-        buffer->clearRenderTarget();
-        buffer->disableScissor();
+        request.view[i] = (wp * Matrix4(m_directions[i].toMatrix())).inverse();
+        request.crop[i] = crop;
 
-        buffer->setViewProjection(mat, crop);
-        buffer->setViewport(x[i], y[i], w[i], h[i]);
-
-        AABBox bb;
         auto corners = Camera::frustumCorners(false, 90.0f, 1.0f, position, m_directions[i], zNear, zFar);
-
-        // Draw in the depth buffer from position of the light source
-        context.drawRenderers(context.frustumCulling(corners, components, bb), CommandBuffer::SHADOWCAST);
+        int32_t id = context.requestRenderList(corners, CommandBuffer::SHADOWCAST, 0, true);
+        if(i == 0) {
+            request.renderList = id;
+        }
     }
 
-    auto instance = light->material();
-    if(instance) {
-        Vector4 bias(m_bias);
-
-        instance->setMatrix4(uniMatrix, matrix, SIDES);
-        instance->setVector4(uniTiles,  tiles, SIDES);
-        instance->setVector4(uniBias, &bias);
-        instance->setTexture(SHADOW_MAP, shadowTarget->depthAttachment());
-    }
+    m_requests.push_back(request);
 }
 
-void ShadowMap::spotLightUpdate(PipelineContext &context, SpotLight *light, std::list<Renderable *> &components) {
-    CommandBuffer *buffer = context.buffer();
-    Transform *t = light->transform();
-
-    Quaternion q(t->worldQuaternion());
-    Matrix4 wt(t->worldTransform());
-    Matrix4 rot(wt.inverse());
-
-    Vector3 position(wt[12], wt[13], wt[14]);
-
-    float zNear = 0.1f;
-    float zFar = light->attenuationDistance();
-    Matrix4 crop(Matrix4::perspective(light->outerAngle(), 1.0f, zNear, zFar));
-
-    int32_t x = 0;
-    int32_t y = 0;
-    int32_t w = 0;
-    int32_t h = 0;
-    RenderTarget *shadowTarget = requestShadowTiles(context, light->uuid(), 1, &x, &y, &w, &h, 1);
-
-    buffer->setRenderTarget(shadowTarget);
-    buffer->enableScissor(x, y, w, h);
-    buffer->clearRenderTarget();
-    buffer->disableScissor();
-
-    buffer->setViewProjection(rot, crop);
-    buffer->setViewport(x, y, w, h);
+void ShadowMap::lightUniforms(const ShadowRequest &request, const std::vector<TileState> &cache) {
+    auto instance = request.light->material();
+    if(instance == nullptr) {
+        return;
+    }
 
-    AABBox bb;
-    auto corners = Camera::frustumCorners(false, light->outerAngle() * 2.0f, 1.0f, position, q, zNear, zFar);
+    uint32_t pageSize = Texture::maxTextureSize();
 
-    // Draw in the depth buffer from position of the light source
-    context.drawRenderers(context.frustumCulling(corners, components, bb), CommandBuffer::SHADOWCAST);
+    // Matrices must match to the tile content which may be rendered during the previous frames
+    Vector4 tiles[SIDES];
+    Matrix4 matrix[SIDES];
+    for(uint32_t i = 0; i < request.count; i++) {
+        matrix[i] = cache[i].matrix;
+        tiles[i] = Vector4(static_cast<float>(request.x[i]) / pageSize,
+                           static_cast<float>(request.y[i]) / pageSize,
+                           static_cast<float>(request.w[i]) / pageSize,
+                           static_cast<float>(request.h[i]) / pageSize);
+    }
 
-    auto instance = light->material();
-    if(instance) {
-        Vector4 bias(m_bias);
+    Vector4 bias(m_bias);
+    if(request.light->lightType() == BaseLight::DirectLight) {
+        const float biasModifier = 0.5f;
+        for(int32_t lod = 0; lod < MAX_LODS; lod++) {
+            bias[lod] *= 1.0 / (request.planeDistance[lod] * biasModifier);
+        }
 
-        uint32_t pageSize = Texture::maxTextureSize();
-        Matrix4 matrix(m_scale * crop * rot);
-        Vector4 tiles(static_cast<float>(x) / pageSize,
-                      static_cast<float>(y) / pageSize,
-                      static_cast<float>(w) / pageSize,
-                      static_cast<float>(h) / pageSize);
-
-        instance->setMatrix4(uniMatrix, &matrix);
-        instance->setVector4(uniTiles,  &tiles);
-        instance->setVector4(uniBias, &bias);
-        instance->setTexture(SHADOW_MAP, shadowTarget->depthAttachment());
+        instance->setVector4(uniPlaneDistance, &request.planeDistance);
     }
+
+    instance->setMatrix4(uniMatrix, matrix, request.count);
+    instance->setVector4(uniTiles, tiles, request.count);
+    instance->setVector4(uniBias, &bias);
+    instance->setTexture(SHADOW_MAP, request.target->depthAttachment());
 }
 
 void ShadowMap::cleanShadowCache() {
@@ -372,6 +415,7 @@ void ShadowMap::cleanShadowCache() {
             for(auto &it : tiles->second.second) {
                 delete it;
             }
+            m_tileStates.erase(tiles->first);
             tiles = m_tiles.erase(tiles);
         } else {
             ++tiles;
@@ -424,17 +468,9 @@ RenderTarget *ShadowMap::requestShadowTiles(PipelineContext &context, uint32_t i
 
     if(sub == nullptr) {
         uint32_t pageSize = Texture::maxTextureSize();
-        Texture *map = Engine::objectCreate<Texture>(std::string("shadowAtlas ") + std::to_string(m_shadowPages.size()));
-        map->setFormat(Texture::Depth);
-        map->setDepthBits(24);
-        map->setFlags(Texture::Render);
-
-        map->resize(pageSize, pageSize);
 
-        context.addTextureBuffer(map);
-
-        target = Engine::objectCreate<RenderTarget>();
-        target->setDepthAttachment(map);
+        target = createPage(std::string("shadowAtlas ") + std::to_string(m_shadowPages.size()));
+        context.addTextureBuffer(target->depthAttachment());
 
         AtlasNode *root = new AtlasNode;
 
@@ -463,3 +499,37 @@ RenderTarget *ShadowMap::requestShadowTiles(PipelineContext &context, uint32_t i
     }
     return target;
 }
+/*!
+    \internal
+    Returns the page which keeps the static casters depth for the tiles of the shadow \a page.
+    The cache page is created on the first request.
+*/
+RenderTarget *ShadowMap::cachePage(RenderTarget *page) {
+    auto it = m_cachePages.find(page);
+    if(it != m_cachePages.end()) {
+        return it->second;
+    }
+
+    RenderTarget *result = createPage(std::string("shadowCache ") + std::to_string(m_cachePages.size()));
+    m_cachePages[page] = result;
+
+    return result;
+}
+/*!
+    \internal
+    Creates a depth render target of the maximum texture size with a given \a name.
+*/
+RenderTarget *ShadowMap::createPage(const std::string &name) {
+    uint32_t pageSize = Texture::maxTextureSize();
+    Texture *map = Engine::objectCreate<Texture>(name);
+    map->setFormat(Texture::Depth);
+    map->setDepthBits(24);
+    map->setFlags(Texture::Render);
+
+    map->resize(pageSize, pageSize);
+
+    RenderTarget *target = Engine::objectCreate<RenderTarget>();
+    target->setDepthAttachment(map);
+
+    return target;
+}
@@ -10,7 +10,8 @@
 #include "commandbuffer.h"
 
 Translucent::Translucent() :
-        m_translucentPass(Engine::objectCreate<RenderTarget>("translucentPass")) {
+        m_translucentPass(Engine::objectCreate<RenderTarget>("translucentPass")),
+        m_renderList(-1) {
 
     setName("Translucent");
 
@@ -21,6 +22,10 @@ Translucent::Translucent() :
 
 }
 
+void Translucent::prepare(PipelineContext &context) {
+    m_renderList = context.requestRenderList(CommandBuffer::TRANSLUCENT);
+}
+
 void Translucent::exec(PipelineContext &context) {
     CommandBuffer *buffer = context.buffer();
     buffer->beginDebugMarker("Translucent Pass");
@@ -28,7 +33,7 @@ void Translucent::exec(PipelineContext &context) {
     buffer->setRenderTarget(m_translucentPass);
 
     // Transparent pass
-    context.drawRenderers(context.culledComponents(), CommandBuffer::TRANSLUCENT);
+    context.drawRenderList(m_renderList);
 
     buffer->endDebugMarker();
 }
@@ -1,7 +1,180 @@
 #include "resources/animationclip.h"
 
+#include <cstring>
+#include <cfloat>
+
 namespace  {
     const char *gTracks = "Tracks";
+
+    const float gQuantizationSteps = 65535.0f;
+}
+
+template<typename T>
+static void writeValue(ByteArray &data, const T &value) {
+    size_t offset = data.size();
+    data.resize(offset + sizeof(T));
+    memcpy(&data[offset], &value, sizeof(T));
+}
+
+template<typename T>
+static T readValue(const ByteArray &data, size_t &offset) {
+    T result = T();
+    if(offset + sizeof(T) <= data.size()) {
+        memcpy(&result, &data[offset], sizeof(T));
+    }
+    offset += sizeof(T);
+    return result;
+}
+
+static int32_t curveComponents(const AnimationCurve &curve) {
+    if(curve.m_keys.empty()) {
+        return 0;
+    }
+
+    int32_t type = curve.m_keys.front().m_value.type();
+    for(auto &it : curve.m_keys) {
+        if(it.m_value.type() != type) {
+            return 0;
+        }
+    }
+
+    switch(type) {
+        case MetaType::FLOAT: return 1;
+        case MetaType::VECTOR2: return 2;
+        case MetaType::VECTOR3: return 3;
+        case MetaType::VECTOR4:
+        case MetaType::QUATERNION: return 4;
+        default: break;
+    }
+    return 0;
+}
+
+static void keyComponents(const Variant &value, float *result) {
+    switch(value.type()) {
+        case MetaType::FLOAT: {
+            result[0] = value.toFloat();
+        } break;
+        case MetaType::VECTOR2: {
+            Vector2 v(value.toVector2());
+            result[0] = v.x; result[1] = v.y;
+        } break;
+        case MetaType::VECTOR3: {
+            Vector3 v(value.toVector3());
+            result[0] = v.x; result[1] = v.y; result[2] = v.z;
+        } break;
+        case MetaType::VECTOR4: {
+            Vector4 v(value.toVector4());
+            result[0] = v.x; result[1] = v.y; result[2] = v.z; result[3] = v.w;
+        } break;
+        case MetaType::QUATERNION: {
+            Quaternion q(value.toQuaternion());
+            result[0] = q.x; result[1] = q.y; result[2] = q.z; result[3] = q.w;
+        } break;
+        default: break;
+    }
+}
+
+static Variant componentsValue(int32_t type, const float *value) {
+    switch(type) {
+        case MetaType::FLOAT: return value[0];
+        case MetaType::VECTOR2: return Vector2(value[0], value[1]);
+        case MetaType::VECTOR3: return Vector3(value[0], value[1], value[2]);
+        case MetaType::VECTOR4: return Vector4(value[0], value[1], value[2], value[3]);
+        case MetaType::QUATERNION: {
+            Quaternion q(value[0], value[1], value[2], value[3]);
+            q.normalize();
+            return q;
+        }
+        default: break;
+    }
+    return Variant();
+}
+// The position and each component of the values are stored as 16-bit integers in the range of the curve
+static ByteArray packCurve(const AnimationCurve &curve) {
+    ByteArray result;
+
+    int32_t components = curveComponents(curve);
+    if(components == 0) {
+        return result;
+    }
+
+    // The first channel is the key position, the rest are the value components
+    int32_t channels = components + 1;
+    std::vector<float> keys(curve.m_keys.size() * channels);
+    std::vector<float> minimum(channels, FLT_MAX);
+    std::vector<float> maximum(channels,-FLT_MAX);
+
+    bool cubic = false;
+    for(size_t i = 0; i < curve.m_keys.size(); i++) {
+        const AnimationCurve::KeyFrame &key = curve.m_keys[i];
+        float *data = &keys[i * channels];
+        data[0] = key.m_position;
+        keyComponents(key.m_value, &data[1]);
+        for(int32_t c = 0; c < channels; c++) {
+            minimum[c] = MIN(minimum[c], data[c]);
+            maximum[c] = MAX(maximum[c], data[c]);
+        }
+        cubic |= (key.m_type == AnimationCurve::KeyFrame::Cubic);
+    }
+
+    writeValue<int32_t>(result, curve.m_keys.front().m_value.type());
+    writeValue<uint32_t>(result, curve.m_keys.size());
+    writeValue<uint8_t>(result, components);
+    writeValue<uint8_t>(result, cubic);
+    for(int32_t c = 0; c < channels; c++) {
+        writeValue<float>(result, minimum[c]);
+        writeValue<float>(result, maximum[c] - minimum[c]);
+    }
+
+    for(size_t i = 0; i < curve.m_keys.size(); i++) {
+        const AnimationCurve::KeyFrame &key = curve.m_keys[i];
+        for(int32_t c = 0; c < channels; c++) {
+            float range = maximum[c] - minimum[c];
+            float value = (range > 0.0f) ? (keys[i * channels + c] - minimum[c]) / range : 0.0f;
+            writeValue<uint16_t>(result, static_cast<uint16_t>(CLAMP(value, 0.0f, 1.0f) * gQuantizationSteps + 0.5f));
+        }
+        writeValue<uint8_t>(result, key.m_type);
+        if(cubic) {
+            writeValue<float>(result, key.m_leftTangent);
+            writeValue<float>(result, key.m_rightTangent);
+        }
+    }
+
+    return result;
+}
+static void unpackCurve(const ByteArray &data, AnimationCurve &curve) {
+    size_t offset = 0;
+    int32_t type = readValue<int32_t>(data, offset);
+    uint32_t count = readValue<uint32_t>(data, offset);
+    int32_t channels = CLAMP(readValue<uint8_t>(data, offset), 1, 4) + 1;
+    bool cubic = readValue<uint8_t>(data, offset);
+
+    float minimum[5];
+    float range[5];
+    for(int32_t c = 0; c < channels; c++) {
+        minimum[c] = readValue<float>(data, offset);
+        range[c] = readValue<float>(data, offset);
+    }
+
+    uint32_t keySize = channels * sizeof(uint16_t) + sizeof(uint8_t) + (cubic ? sizeof(float) * 2 : 0);
+    if(offset + count * keySize > data.size()) {
+        return;
+    }
+
+    curve.m_keys.resize(count);
+    for(auto &key : curve.m_keys) {
+        float values[5];
+        for(int32_t c = 0; c < channels; c++) {
+            values[c] = minimum[c] + range[c] * (readValue<uint16_t>(data, offset) / gQuantizationSteps);
+        }
+        key.m_position = values[0];
+        key.m_value = componentsValue(type, &values[1]);
+        key.m_type = static_cast<AnimationCurve::KeyFrame::Type>(readValue<uint8_t>(data, offset));
+        if(cubic) {
+            key.m_leftTangent = readValue<float>(data, offset);
+            key.m_rightTangent = readValue<float>(data, offset);
+        }
+    }
 }
 
 /*!
@@ -95,6 +268,12 @@ void AnimationTrack::fixCurves() {
 AnimationCurve &AnimationTrack::curve() {
     return m_curve;
 }
+/*!
+    \internal
+*/
+const AnimationCurve &AnimationTrack::curve() const {
+    return m_curve;
+}
 
 /*!
     \class AnimationClip
@@ -107,6 +286,11 @@ AnimationCurve &AnimationTrack::curve() {
     Which allows them to animate elements independently.
 */
 
+AnimationClip::AnimationClip() :
+        m_compressed(false) {
+
+}
+
 /*!
     \internal
 */
@@ -114,10 +298,14 @@ void AnimationClip::loadUserData(const VariantMap &data) {
     PROFILE_FUNCTION();
 
     m_tracks.clear();
+    m_compressed = false;
 
     auto section = data.find(gTracks);
     if(section != data.end()) {
-        for(auto &trackIt : *(reinterpret_cast<VariantList *>((*section).second.data()))) {
+        VariantList &tracks = *(reinterpret_cast<VariantList *>((*section).second.data()));
+        m_tracks.reserve(tracks.size());
+
+        for(auto &trackIt : tracks) {
             VariantList &trackData = *(reinterpret_cast<VariantList *>(trackIt.data()));
             auto i = trackData.begin();
 
@@ -131,22 +319,30 @@ void AnimationClip::loadUserData(const VariantMap &data) {
 
             AnimationCurve &curve = track.curve();
 
-            for(auto &curveIt : *(reinterpret_cast<VariantList *>((*i).data()))) {
-                VariantList &keyList = *(reinterpret_cast<VariantList *>(curveIt.data()));
-                auto k = keyList.begin();
-
-                AnimationCurve::KeyFrame key;
-                key.m_position = (*k).toFloat();
-                k++;
-                key.m_type = static_cast<AnimationCurve::KeyFrame::Type>((*k).toInt());
-                k++;
-                key.m_value = (*k);
-                k++;
-                key.m_leftTangent = (*k).toFloat();
-                k++;
-                key.m_rightTangent = (*k).toFloat();
-
-                curve.m_keys.push_back(key);
+            if((*i).type() == MetaType::BYTEARRAY) {
+                unpackCurve((*i).toByteArray(), curve);
+                m_compressed = true;
+            } else {
+                VariantList &keys = *(reinterpret_cast<VariantList *>((*i).data()));
+                curve.m_keys.reserve(keys.size());
+
+                for(auto &curveIt : keys) {
+                    VariantList &keyList = *(reinterpret_cast<VariantList *>(curveIt.data()));
+                    auto k = keyList.begin();
+
+                    AnimationCurve::KeyFrame key;
+                    key.m_position = (*k).toFloat();
+                    k++;
+                    key.m_type = static_cast<AnimationCurve::KeyFrame::Type>((*k).toInt());
+                    k++;
+                    key.m_value = (*k);
+                    k++;
+                    key.m_leftTangent = (*k).toFloat();
+                    k++;
+                    key.m_rightTangent = (*k).toFloat();
+
+                    curve.m_keys.push_back(key);
+                }
             }
 
             m_tracks.push_back(track);
@@ -160,12 +356,21 @@ VariantMap AnimationClip::saveUserData() const {
     VariantMap result;
 
     VariantList tracks;
-    for(auto t : m_tracks) {
+    for(auto &t : m_tracks) {
         VariantList track;
         track.push_back(t.path());
         track.push_back(t.property());
         track.push_back(t.duration());
 
+        if(m_compressed) {
+            ByteArray packed = packCurve(t.curve());
+            if(!packed.empty()) {
+                track.push_back(packed);
+                tracks.push_back(track);
+                continue;
+            }
+        }
+
         VariantList curve;
 
         for(auto &it : t.curve().m_keys) {
@@ -200,3 +405,17 @@ int AnimationClip::duration() const {
     }
     return result;
 }
+/*!
+    Returns true in case of the animation tracks are stored in the quantized form; otherwise returns false.
+*/
+bool AnimationClip::isCompressed() const {
+    return m_compressed;
+}
+/*!
+    Enables the quantized storage of the animation tracks if \a compressed is true.
+    The positions and the values of the key frames are stored as 16-bit integers in the range of each track which reduces the size of the clip several times.
+    The tracks with non numeric values are always stored as is.
+*/
+void AnimationClip::setCompressed(bool compressed) {
+    m_compressed = compressed;
+}
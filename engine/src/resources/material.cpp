@@ -29,6 +29,9 @@ namespace {
 MaterialInstance::MaterialInstance(Material *material) :
         m_material(material),
         m_transform(nullptr),
+        m_gpuInstances(nullptr),
+        m_indirectBuffer(nullptr),
+        m_indirectOffset(0),
         m_instanceCount(1),
         m_batchesCount(0),
         m_hash(material->uuid()),
@@ -319,29 +322,90 @@ ByteArray &MaterialInstance::rawUniformBuffer() {
 
     return m_uniformBuffer;
 }
+/*!
+    Returns a buffer with the instances data produced on GPU.
+*/
+ComputeBuffer *MaterialInstance::instanceBuffer() const {
+    return m_gpuInstances;
+}
+/*!
+    Sets a \a buffer with the instances data produced on GPU, it's used instead of the uniform buffer.
+    Set nullptr to use the uniform buffer again.
+*/
+void MaterialInstance::setInstanceBuffer(ComputeBuffer *buffer) {
+    m_gpuInstances = buffer;
+}
+/*!
+    Returns a buffer with the indirect draw arguments.
+*/
+ComputeBuffer *MaterialInstance::indirectBuffer() const {
+    return m_indirectBuffer;
+}
+/*!
+    Returns an offset in bytes of the indirect draw arguments in the indirectBuffer().
+*/
+uint32_t MaterialInstance::indirectOffset() const {
+    return m_indirectOffset;
+}
+/*!
+    Sets a \a buffer with the indirect draw arguments at the given \a offset in bytes.
+    The number of instances to draw is taken from the buffer in this case; such instances are never batched.
+*/
+void MaterialInstance::setIndirectBuffer(ComputeBuffer *buffer, uint32_t offset) {
+    m_indirectBuffer = buffer;
+    m_indirectOffset = offset;
+}
 
 /*!
     Batches a material \a instance to draw using GPU instancing.
+    Only the instance is remembered, its uniform data is copied by the render backend with copyBatched() straight to the GPU memory.
+    The \a instance must stay valid until resetBatches() is called.
 */
 void MaterialInstance::batch(MaterialInstance &instance) {
-    if(m_batchBuffer.empty()) {
-        ByteArray &buffer = rawUniformBuffer();
-        m_batchBuffer.insert(m_batchBuffer.begin(), buffer.begin(), buffer.end());
-    }
-
-    ByteArray &buffer = instance.rawUniformBuffer();
-    m_batchBuffer.insert(m_batchBuffer.end(), buffer.begin(), buffer.end());
+    m_batches.push_back(&instance);
 
     m_batchesCount += instance.m_instanceCount;
 }
-
 /*!
-    Rests batch buffer.
+    Rests the list of batched instances.
+    The allocated memory is retained to be reused by the next batch.
 */
 void MaterialInstance::resetBatches() {
-    m_batchBuffer.clear();
+    m_batches.clear();
     m_batchesCount = 0;
 }
+/*!
+    Returns the size in bytes of the uniform data of this instance together with all batched instances.
+*/
+uint32_t MaterialInstance::batchedSize() {
+    uint32_t result = rawUniformBuffer().size();
+    for(auto it : m_batches) {
+        result += it->rawUniformBuffer().size();
+    }
+    return result;
+}
+/*!
+    Copies \a size bytes of the uniform data of this instance followed by all batched instances to the \a data, starting from the \a offset.
+*/
+void MaterialInstance::copyBatched(uint8_t *data, uint32_t offset, uint32_t size) {
+    uint32_t index = 0;
+    MaterialInstance *instance = this;
+    while(instance && size > 0) {
+        ByteArray &buffer = instance->rawUniformBuffer();
+        if(offset < buffer.size()) {
+            uint32_t length = MIN(static_cast<uint32_t>(buffer.size()) - offset, size);
+            memcpy(data, &buffer[offset], length);
+            data += length;
+            size -= length;
+            offset = 0;
+        } else {
+            offset -= buffer.size();
+        }
+
+        instance = (index < m_batches.size()) ? m_batches[index] : nullptr;
+        index++;
+    }
+}
 /*!
     \internal
 */
@@ -424,6 +488,12 @@ void Material::setTexture(const std::string &name, Texture *texture) {
     item.binding = -1;
     m_textures.push_back(item);
 }
+/*!
+    Returns the list of texture slots declared by the material with their default textures.
+*/
+const Material::Textures &Material::textures() const {
+    return m_textures;
+}
 /*!
     Returns true if material must be rendered as wireframe.
 */
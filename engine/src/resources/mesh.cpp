@@ -4,6 +4,8 @@
 
 #include "systems/resourcesystem.h"
 
+#include "utils/meshoptimizer.h"
+
 #include <cstring>
 #include <cfloat>
 
@@ -18,6 +20,8 @@ enum MeshAttributes {
     Normals  = (1<<3),
     Tangents = (1<<4),
     Skinned  = (1<<5),
+    Quantized= (1<<6),
+    Index16  = (1<<7)
 };
 
 /*!
@@ -27,7 +31,9 @@ enum MeshAttributes {
 */
 
 Mesh::Mesh() :
-        m_dynamic(false)  {
+        m_dynamic(false),
+        m_quantized(false),
+        m_uvDensity(-1.0f) {
 
 }
 
@@ -55,6 +61,21 @@ bool Mesh::isDynamic() const {
 void Mesh::makeDynamic() {
     m_dynamic = true;
 }
+/*!
+    Returns true in case of mesh uses compact vertex formats; otherwise returns false.
+*/
+bool Mesh::isQuantized() const {
+    return m_quantized;
+}
+/*!
+    Sets the \a quantized flag.
+    Quantized mesh stores and renders normals and tangents as signed normalized bytes and uv0 texture coordinates as half floats.
+    The mesh data is still accessible as float arrays.
+*/
+void Mesh::setQuantized(bool quantized) {
+    m_quantized = quantized;
+    switchState(ToBeUpdated);
+}
 /*!
     Returns false if mesh structure is empty; otherwise returns true.
 */
@@ -67,6 +88,7 @@ bool Mesh::isEmpty() const {
 void Mesh::clear() {
     m_indices.clear();
     m_offsets.clear();
+    m_lodSizes.clear();
     m_vertices.clear();
     m_uv0.clear();
     m_uv1.clear();
@@ -220,7 +242,7 @@ void Mesh::setBound(const AABBox &box) {
     Returns the number of sub-meshes inside the Mesh.
 */
 int Mesh::subMeshCount() const {
-    return m_offsets.size();
+    return m_offsets.size() / lodCount();
 }
 /*!
     Sets a base vertex \a offset for the \a sub mesh.
@@ -233,18 +255,20 @@ void Mesh::setSubMesh(int offset, int sub) {
     m_offsets.push_back(offset);
 }
 /*!
-    Returns starting point index for the \a sub mesh.
+    Returns starting point index for the \a sub mesh of the level of detail \a lod.
 */
-int Mesh::indexStart(int sub) const {
+int Mesh::indexStart(int sub, int lod) const {
+    sub += lod * subMeshCount();
     if(sub < m_offsets.size()) {
         return m_offsets[sub];
     }
     return 0;
 }
 /*!
-    Returns index count for the \a sub mesh.
+    Returns index count for the \a sub mesh of the level of detail \a lod.
 */
-int Mesh::indexCount(int sub) const {
+int Mesh::indexCount(int sub, int lod) const {
+    sub += lod * subMeshCount();
     if(sub < static_cast<int32_t>(m_offsets.size()) - 1) {
         return m_offsets[sub+1] - m_offsets[sub];
     }
@@ -252,6 +276,89 @@ int Mesh::indexCount(int sub) const {
     size_t offsetId = CLAMP(sub, 0, m_offsets.size() - 1);
     return m_indices.size() - (m_offsets.empty() ? 0 : m_offsets[offsetId]);
 }
+/*!
+    Returns the number of levels of detail including the base one.
+*/
+int Mesh::lodCount() const {
+    return m_lodSizes.size() + 1;
+}
+/*!
+    Returns the projected size of the Mesh bounding sphere relative to the screen height below which the \a lod is used.
+    The base level of detail always returns 1.0.
+*/
+float Mesh::lodScreenSize(int lod) const {
+    if(lod > 0 && lod <= m_lodSizes.size()) {
+        return m_lodSizes[lod - 1];
+    }
+    return 1.0f;
+}
+/*!
+    Appends a new level of detail which reuses the vertices of the Mesh.
+    The \a indices contain triangles of all sub meshes and the \a offsets contain a starting index for each sub mesh in the \a indices.
+    The level of detail will be used when the projected size of the Mesh is smaller than \a screenSize.
+    All sub meshes must be set before the levels of detail are added.
+*/
+void Mesh::addLod(const IndexVector &indices, const IndexVector &offsets, float screenSize) {
+    if(offsets.size() != subMeshCount()) {
+        return;
+    }
+
+    uint32_t start = m_indices.size();
+    m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+    for(auto it : offsets) {
+        m_offsets.push_back(start + it);
+    }
+    m_lodSizes.push_back(screenSize);
+
+    switchState(ToBeUpdated);
+}
+/*!
+    Removes all levels of detail except the base one.
+*/
+void Mesh::clearLods() {
+    if(!m_lodSizes.empty()) {
+        uint32_t subs = subMeshCount();
+        uint32_t end = (subs < m_offsets.size()) ? m_offsets[subs] : m_indices.size();
+
+        m_indices.resize(end);
+        m_offsets.resize(subs);
+        m_lodSizes.clear();
+
+        switchState(ToBeUpdated);
+    }
+}
+/*!
+    Returns the average ratio between the object space size and the first UV channel size of the Mesh triangles.
+    The render pipeline uses this value to estimate the required MIP levels of the streamed textures.
+    Returns 0 in case of the Mesh has no texture coordinates.
+*/
+float Mesh::uvDensity() const {
+    if(m_uvDensity < 0.0f) {
+        double worldArea = 0.0;
+        double uvArea = 0.0;
+
+        if(m_uv0.size() == m_vertices.size()) {
+            uint32_t subs = subMeshCount();
+            uint32_t end = (subs < m_offsets.size()) ? m_offsets[subs] : m_indices.size();
+            for(uint32_t i = 0; i + 2 < end; i += 3) {
+                uint32_t a = m_indices[i];
+                uint32_t b = m_indices[i + 1];
+                uint32_t c = m_indices[i + 2];
+                if(a >= m_vertices.size() || b >= m_vertices.size() || c >= m_vertices.size()) {
+                    continue;
+                }
+                worldArea += (m_vertices[b] - m_vertices[a]).cross(m_vertices[c] - m_vertices[a]).length() * 0.5f;
+
+                Vector2 ab(m_uv0[b] - m_uv0[a]);
+                Vector2 ac(m_uv0[c] - m_uv0[a]);
+                uvArea += fabs(ab.x * ac.y - ab.y * ac.x) * 0.5f;
+            }
+        }
+
+        m_uvDensity = (uvArea > 0.0) ? float(sqrt(worldArea / uvArea)) : 0.0f;
+    }
+    return m_uvDensity;
+}
 /*!
     Recalculates the normals of the Mesh from the triangles and vertices.
 */
@@ -325,6 +432,9 @@ void Mesh::batchMesh(Mesh &mesh, const Matrix4 *transform) {
     // Indices
     size_t size = vertices().size();
     auto indexVector = mesh.indices();
+    if(mesh.lodCount() > 1) {
+        indexVector.resize(mesh.indexStart(0, 1));
+    }
     for(auto &it : indexVector) {
         it += size;
     }
@@ -343,6 +453,9 @@ void Mesh::batchMesh(Mesh &mesh, const Matrix4 *transform) {
     \internal
 */
 void Mesh::switchState(State state) {
+    if(state == ToBeUpdated) {
+        m_uvDensity = -1.0f;
+    }
     setState(state);
 }
 /*!
@@ -361,6 +474,7 @@ void Mesh::loadUserData(const VariantMap &data) {
         auto i = mesh.begin();
 
         int flags = (*i).toInt();
+        m_quantized = (flags & MeshAttributes::Quantized);
 
         i++;
         int sub = 0;
@@ -398,7 +512,14 @@ void Mesh::loadUserData(const VariantMap &data) {
         i++;
         vertexData = (*i).toByteArray();
         m_indices.resize(tCount * 3);
-        memcpy(m_indices.data(), vertexData.data(), sizeof(uint32_t) * tCount * 3);
+        if(flags & MeshAttributes::Index16) {
+            const uint16_t *data = reinterpret_cast<const uint16_t *>(vertexData.data());
+            for(uint32_t i = 0; i < tCount * 3; i++) {
+                m_indices[i] = data[i];
+            }
+        } else {
+            memcpy(m_indices.data(), vertexData.data(), sizeof(uint32_t) * tCount * 3);
+        }
 
         // Load attributes
         if(flags & MeshAttributes::Color) { // Optional field
@@ -411,19 +532,40 @@ void Mesh::loadUserData(const VariantMap &data) {
             i++;
             vertexData = (*i).toByteArray();
             m_uv0.resize(vCount);
-            memcpy(m_uv0.data(), vertexData.data(), sizeof(Vector2) * vCount);
+            if(m_quantized) {
+                const uint16_t *data = reinterpret_cast<const uint16_t *>(vertexData.data());
+                for(uint32_t i = 0; i < vCount; i++) {
+                    m_uv0[i] = Vector2(MeshOptimizer::unpackHalf(data[i * 2]), MeshOptimizer::unpackHalf(data[i * 2 + 1]));
+                }
+            } else {
+                memcpy(m_uv0.data(), vertexData.data(), sizeof(Vector2) * vCount);
+            }
         }
         if(flags & MeshAttributes::Normals) { // Optional field
             i++;
             vertexData = (*i).toByteArray();
             m_normals.resize(vCount);
-            memcpy(m_normals.data(), vertexData.data(), sizeof(Vector3) * vCount);
+            if(m_quantized) {
+                const uint32_t *data = reinterpret_cast<const uint32_t *>(vertexData.data());
+                for(uint32_t i = 0; i < vCount; i++) {
+                    m_normals[i] = MeshOptimizer::unpackSnorm(data[i]);
+                }
+            } else {
+                memcpy(m_normals.data(), vertexData.data(), sizeof(Vector3) * vCount);
+            }
         }
         if(flags & MeshAttributes::Tangents) { // Optional field
             i++;
             vertexData = (*i).toByteArray();
             m_tangents.resize(vCount);
-            memcpy(m_tangents.data(), vertexData.data(), sizeof(Vector3) * vCount);
+            if(m_quantized) {
+                const uint32_t *data = reinterpret_cast<const uint32_t *>(vertexData.data());
+                for(uint32_t i = 0; i < vCount; i++) {
+                    m_tangents[i] = MeshOptimizer::unpackSnorm(data[i]);
+                }
+            } else {
+                memcpy(m_tangents.data(), vertexData.data(), sizeof(Vector3) * vCount);
+            }
         }
         if(flags & MeshAttributes::Skinned) { // Optional field
             i++;
@@ -449,6 +591,17 @@ void Mesh::loadUserData(const VariantMap &data) {
             m_offsets.push_back(0);
         }
 
+        // Load levels of detail
+        m_lodSizes.clear();
+        if(i != mesh.end()) {
+            i++;
+            if(i != mesh.end()) {
+                for(auto &size : (*i).toList()) {
+                    m_lodSizes.push_back(size.toFloat());
+                }
+            }
+        }
+
         m_box.setBox(min, max);
     }
     switchState(ToBeUpdated);
@@ -469,6 +622,12 @@ VariantMap Mesh::saveUserData() const {
 
     flags = m_weights.empty() ? flags : (flags | Skinned);
 
+    flags = m_quantized ? (flags | Quantized) : flags;
+
+    size_t vCount = m_vertices.size();
+    bool index16 = (vCount <= UINT16_MAX);
+    flags = index16 ? (flags | Index16) : flags;
+
     mesh.push_back(flags);
 
     // Push materials
@@ -479,7 +638,6 @@ VariantMap Mesh::saveUserData() const {
     mesh.push_back(materials);
 
     // Push geometry
-    size_t vCount = m_vertices.size();
     mesh.push_back(static_cast<int32_t>(vCount));
     mesh.push_back(static_cast<int32_t>(m_indices.size() / 3));
 
@@ -491,8 +649,16 @@ VariantMap Mesh::saveUserData() const {
     }
     { // Required field
         ByteArray buffer;
-        buffer.resize(sizeof(uint32_t) * m_indices.size());
-        memcpy(buffer.data(), m_indices.data(), sizeof(uint32_t) * m_indices.size());
+        if(index16) {
+            buffer.resize(sizeof(uint16_t) * m_indices.size());
+            uint16_t *data = reinterpret_cast<uint16_t *>(buffer.data());
+            for(size_t i = 0; i < m_indices.size(); i++) {
+                data[i] = m_indices[i];
+            }
+        } else {
+            buffer.resize(sizeof(uint32_t) * m_indices.size());
+            memcpy(buffer.data(), m_indices.data(), sizeof(uint32_t) * m_indices.size());
+        }
         mesh.push_back(buffer);
     }
 
@@ -504,20 +670,45 @@ VariantMap Mesh::saveUserData() const {
     }
     if(!m_uv0.empty()) { // Optional field
         ByteArray buffer;
-        buffer.resize(sizeof(Vector2) * vCount);
-        memcpy(buffer.data(), m_uv0.data(), sizeof(Vector2) * vCount);
+        if(m_quantized) {
+            buffer.resize(sizeof(uint16_t) * 2 * vCount);
+            uint16_t *data = reinterpret_cast<uint16_t *>(buffer.data());
+            for(size_t i = 0; i < vCount; i++) {
+                data[i * 2] = MeshOptimizer::packHalf(m_uv0[i].x);
+                data[i * 2 + 1] = MeshOptimizer::packHalf(m_uv0[i].y);
+            }
+        } else {
+            buffer.resize(sizeof(Vector2) * vCount);
+            memcpy(buffer.data(), m_uv0.data(), sizeof(Vector2) * vCount);
+        }
         mesh.push_back(buffer);
     }
     if(!m_normals.empty()) { // Optional field
         ByteArray buffer;
-        buffer.resize(sizeof(Vector3) * vCount);
-        memcpy(buffer.data(), m_normals.data(), sizeof(Vector3) * vCount);
+        if(m_quantized) {
+            buffer.resize(sizeof(uint32_t) * vCount);
+            uint32_t *data = reinterpret_cast<uint32_t *>(buffer.data());
+            for(size_t i = 0; i < vCount; i++) {
+                data[i] = MeshOptimizer::packSnorm(m_normals[i]);
+            }
+        } else {
+            buffer.resize(sizeof(Vector3) * vCount);
+            memcpy(buffer.data(), m_normals.data(), sizeof(Vector3) * vCount);
+        }
         mesh.push_back(buffer);
     }
     if(!m_tangents.empty()) { // Optional field
         ByteArray buffer;
-        buffer.resize(sizeof(Vector3) * vCount);
-        memcpy(buffer.data(), m_tangents.data(), sizeof(Vector3) * vCount);
+        if(m_quantized) {
+            buffer.resize(sizeof(uint32_t) * vCount);
+            uint32_t *data = reinterpret_cast<uint32_t *>(buffer.data());
+            for(size_t i = 0; i < vCount; i++) {
+                data[i] = MeshOptimizer::packSnorm(m_tangents[i]);
+            }
+        } else {
+            buffer.resize(sizeof(Vector3) * vCount);
+            memcpy(buffer.data(), m_tangents.data(), sizeof(Vector3) * vCount);
+        }
         mesh.push_back(buffer);
     }
     if(!m_weights.empty()) { // Optional field
@@ -542,6 +733,13 @@ VariantMap Mesh::saveUserData() const {
     }
     mesh.push_back(offsets);
 
+    // Save levels of detail
+    VariantList lods;
+    for(auto it : m_lodSizes) {
+        lods.push_back(it);
+    }
+    mesh.push_back(lods);
+
     result[gData] = mesh;
 
     return result;
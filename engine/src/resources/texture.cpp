@@ -1,5 +1,10 @@
 #include "resources/texture.h"
 
+#include "utils/textureencoder.h"
+#include "utils/texturestreamer.h"
+
+#include "systems/resourcesystem.h"
+
 #include <variant.h>
 
 #include <cstring>
@@ -75,12 +80,20 @@ Texture::Texture() :
         m_width(1),
         m_height(1),
         m_depth(0),
-        m_flags(0) {
+        m_flags(0),
+        m_residentMip(0),
+        m_requiredMip(INT32_MAX),
+        m_lastUse(0),
+        m_streaming(false) {
 
 }
 
 Texture::~Texture() {
     clear();
+
+    if(m_streaming) {
+        TextureStreamer::removeTexture(this);
+    }
 }
 /*!
     \internal
@@ -113,6 +126,11 @@ void Texture::loadUserData(const VariantMap &data) {
             }
         }
     }
+
+    // The streamed textures start from the MIP tail and request the rest on demand
+    if(m_streaming && TextureStreamer::budget() > 0) {
+        m_residentMip = TextureStreamer::tailMip(m_width, m_height, mipCount());
+    }
 }
 /*!
     \internal
@@ -178,12 +196,22 @@ void Texture::readPixels(int x, int y, int width, int height) {
 }
 /*!
     Returns pixel color from mip \a level at \a x and \a y position as RGBA integer for example 0x00ff00ff which can be mapped to (0, 255, 0, 255)
+    The compressed textures decode the block which contains the pixel.
 */
 int Texture::getPixel(int x, int y, int level) const {
     uint32_t result = 0;
-    if(!m_sides.empty() && m_sides[0].size() > level) {
-        const uint8_t *ptr = m_sides[0][level].data() + (y * m_width + x) * 4;
-        memcpy(&result, ptr, sizeof(uint32_t));
+    if(!m_sides.empty() && m_sides[0].size() > level && !m_sides[0][level].empty()) {
+        if(isCompressed()) {
+            int32_t columns = (MAX(m_width >> level, 1) + 3) / 4;
+            const uint8_t *block = m_sides[0][level].data() + ((y / 4) * columns + (x / 4)) * TextureEncoder::blockSize(m_compress);
+
+            uint8_t pixels[64];
+            TextureEncoder::decodeBlock(block, pixels, m_compress);
+            memcpy(&result, &pixels[((y % 4) * 4 + (x % 4)) * 4], sizeof(uint32_t));
+        } else {
+            const uint8_t *ptr = m_sides[0][level].data() + (y * m_width + x) * 4;
+            memcpy(&result, ptr, sizeof(uint32_t));
+        }
     }
     return result;
 }
@@ -269,6 +297,138 @@ int Texture::filtering() const {
 void Texture::setFiltering(int type) {
     m_filtering = type;
 }
+/*!
+    Returns compression type of texture.
+    For more details please see the Texture::CompressionType enum.
+*/
+int Texture::compress() const {
+    return m_compress;
+}
+/*!
+    Sets compression \a type of texture.
+    The surfaces must contain data encoded in this format.
+    For more details please see the Texture::CompressionType enum.
+*/
+void Texture::setCompress(int type) {
+    m_compress = type;
+}
+/*!
+    Returns true if the MIP levels of the texture are managed by the TextureStreamer; otherwise returns false.
+*/
+bool Texture::isStreaming() const {
+    return m_streaming;
+}
+/*!
+    Enables or disables the \a streaming of the MIP levels for the texture.
+    The streamed textures keep on GPU only the MIP levels required by the visible objects within the memory budget.
+*/
+void Texture::setStreaming(bool streaming) {
+    if(m_streaming != streaming) {
+        m_streaming = streaming;
+        if(m_streaming) {
+            TextureStreamer::addTexture(this);
+        } else {
+            TextureStreamer::removeTexture(this);
+            setResidentMip(0);
+        }
+    }
+}
+/*!
+    Returns the first MIP level which is uploaded to GPU.
+    The levels before it are kept on CPU side only.
+*/
+int Texture::residentMip() const {
+    return m_residentMip;
+}
+/*!
+    Sets the first \a mip level which must be uploaded to GPU.
+    The texture will be reuploaded in case of the level is changed.
+    The released levels are read from the bundle first, the current level is kept in case of they can't be restored.
+*/
+void Texture::setResidentMip(int mip) {
+    mip = CLAMP(mip, 0, mipCount() - 1);
+    if(mip < m_residentMip && !restoreLevels(mip)) {
+        return;
+    }
+    if(m_residentMip != mip) {
+        m_residentMip = mip;
+        switchState(ToBeUpdated);
+    }
+}
+/*!
+    \internal
+    Releases the CPU copy of the MIP levels before the \a mip to save memory.
+    The levels are kept only for the textures loaded from the bundle, which can be restored with restoreLevels().
+*/
+void Texture::releaseLevels(int32_t mip) {
+    ResourceSystem *system = Engine::resourceSystem();
+    if(system == nullptr || system->reference(this).empty()) {
+        return;
+    }
+
+    for(auto &side : m_sides) {
+        for(int32_t i = 0; i < MIN(mip, static_cast<int32_t>(side.size())); i++) {
+            ByteArray().swap(side[i]);
+        }
+    }
+}
+/*!
+    \internal
+    Reads the released MIP levels starting from the \a mip back from the bundle.
+    Returns true if all of the levels are available; otherwise returns false.
+*/
+bool Texture::restoreLevels(int32_t mip) {
+    bool missing = false;
+    for(auto &side : m_sides) {
+        for(int32_t i = MAX(mip, 0); i < static_cast<int32_t>(side.size()); i++) {
+            missing |= side[i].empty();
+        }
+    }
+    if(!missing) {
+        return true;
+    }
+
+    ResourceSystem *system = Engine::resourceSystem();
+    if(system == nullptr) {
+        return false;
+    }
+
+    VariantMap data = system->readUserData(this);
+    auto it = data.find(gData);
+    if(it == data.end()) {
+        return false;
+    }
+
+    const VariantList &surfaces = (*it).second.value<VariantList>();
+    auto side = m_sides.begin();
+    for(auto &s : surfaces) {
+        if(side == m_sides.end()) {
+            break;
+        }
+
+        int32_t w = m_width;
+        int32_t h = m_height;
+        int32_t level = 0;
+        for(auto &l : s.value<VariantList>()) {
+            if(level >= static_cast<int32_t>(side->size())) {
+                break;
+            }
+            if(level >= mip && (*side)[level].empty()) {
+                ByteArray bits = l.toByteArray();
+                uint32_t length = size(w, h);
+                if(bits.size() < length) {
+                    return false;
+                }
+                (*side)[level].assign(bits.begin(), bits.begin() + length);
+            }
+            w = MAX(w / 2, 1);
+            h = MAX(h / 2, 1);
+            level++;
+        }
+        ++side;
+    }
+    return true;
+}
 /*!
     Returns the type of warp policy.
     For more details please see the Texture::WrapType enum.
@@ -367,6 +527,7 @@ bool Texture::isUnloadable() {
 */
 void Texture::clear() {
     m_sides.clear();
+    m_residentMip = 0;
 }
 /*!
     Returns the maximum texure size.
@@ -405,7 +566,7 @@ int32_t Texture::size(int32_t width, int32_t height) const {
     \internal
 */
 inline int32_t Texture::sizeDXTc(int32_t width, int32_t height) const {
-    return ((width + 3) / 4) * ((height + 3) / 4) * (m_compress == DXT1 ? 8 : 16);
+    return ((width + 3) / 4) * ((height + 3) / 4) * ((m_compress == DXT1 || m_compress == BC4 || m_compress == ETC2) ? 8 : 16);
 }
 /*!
     \internal
@@ -2,37 +2,17 @@
 
 #include "material.h"
 #include "mesh.h"
+#include "computeshader.h"
+#include "computebuffer.h"
 
-#include <array>
+#include "utils/particlecompute.h"
 
 namespace {
     const char *gEmitters("Emitters");
-}
 
-enum Stages {
-    State,
-    Spawn,
-    Update,
-    Render
-};
-
-enum Operation {
-    Mov = 0,
-    Add,
-    Sub,
-    Mul,
-    Div
-};
-
-enum Space {
-    System,
-    Emitter,
-    Particle,
-    Renderable,
-    Local,
-    Constant,
-    Random
-};
+    const char *gShader("Shader");
+    const char *gBuffers("Buffers");
+}
 
 /*!
     \class VisualEffect
@@ -45,6 +25,8 @@ enum Space {
 VisualEffect::VisualEffect() :
         m_mesh(nullptr),
         m_material(nullptr),
+        m_computeShader(nullptr),
+        m_constantBuffer(nullptr),
         m_spawnRate(1.0f),
         m_capacity(1),
         m_particleStride(1), // Store an age at least
@@ -55,18 +37,57 @@ VisualEffect::VisualEffect() :
 
 }
 
+/*!
+    Simulates the particles of one emitter for the current frame.
+    The \a emitter buffer contains actual emitter state, the \a particles buffer contains the particle attributes and the \a render buffer receives the renderables data.
+    The new particles are spawned into the free lanes, then all of the live particles are updated and the renderables are filled for the survived ones.
+*/
 void VisualEffect::update(std::vector<float> &emitter, std::vector<float> &particles, std::vector<float> &render) {
-    if(!m_spawnOperations.empty()) {
-        apply(m_spawnOperations, emitter, particles, render, Spawn);
+    PROFILE_FUNCTION();
+
+    size_t size = ParticleProgram::bufferSize(m_particleStride, m_capacity);
+    if(particles.size() != size) {
+        particles.assign(size, 0.0f);
+        emitter[AliveParticles] = 0.0f;
     }
 
-    if(!m_updateOperations.empty()) {
-        apply(m_updateOperations, emitter, particles, render, Update);
+    ParticleProgram::Context context;
+    context.emitter = emitter.data();
+    context.particles = particles.data();
+    context.render = render.data();
+    context.capacity = m_capacity;
+    context.stride = m_particleStride;
+    context.renderStride = m_renderableStride;
+
+    simulate(m_spawnProgram, m_updateProgram, m_renderProgram, context);
+}
+/*!
+    Executes the \a spawn, \a update and \a render programs for one frame on the CPU using the buffers of the \a context.
+    This is the reference simulation, the GPU path must produce the same set of particles.
+*/
+void VisualEffect::simulate(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render, const ParticleProgram::Context &context) {
+    float *emitter = context.emitter;
+
+    int32_t alive = ParticleProgram::compact(context, CLAMP(static_cast<int32_t>(emitter[AliveParticles]), 0, context.capacity));
+
+    if(!spawn.isEmpty()) {
+        int32_t count = MIN(static_cast<int32_t>(emitter[SpawnCounter]), context.capacity - alive);
+        if(count > 0) {
+            emitter[SpawnCounter] -= count;
+
+            spawn.execute(context, alive, count);
+            alive = ParticleProgram::compact(context, alive + count);
+        }
     }
 
-    if(!m_renderOperations.empty()) {
-        apply(m_renderOperations, emitter, particles, render, Render);
+    if(!update.isEmpty()) {
+        update.execute(context, 0, alive);
+        alive = ParticleProgram::compact(context, alive);
     }
+
+    render.execute(context, 0, alive);
+
+    emitter[AliveParticles] = alive;
 }
 /*!
     Returns a mesh associated with the particle emitter.
@@ -144,16 +165,14 @@ void VisualEffect::setLocal(bool local) {
 }
 /*!
     Returns true if GPU particle simulation is enabled, false otherwise.
-
-    \note Gpu simulation is not supported yet.
+    The GPU simulation requires compute shaders support, the particles are never read back to the CPU in this case.
 */
 bool VisualEffect::gpu() const {
     return m_gpu;
 }
 /*!
     Setter for the \a gpu flag indicating GPU particle simulation.
-
-    \note Gpu simulation is not supported yet.
+    The flag takes effect on the next load of the effect.
 */
 void VisualEffect::setGpu(bool gpu) {
     m_gpu = gpu;
@@ -177,79 +196,17 @@ AABBox VisualEffect::bound() const {
     return m_aabb;
 }
 /*!
-    Modifies a \a particle attributes stored in data buffer.
-    The \a emitter buffer contains actual emitter state.
-    The \a render buffer contains actual renderables data.
+    Returns the compute shader which simulates the effect on GPU.
+    Returns nullptr if GPU simulation is disabled for the effect.
 */
-void VisualEffect::apply(std::vector<Operator> &operations, std::vector<float> &emitter, std::vector<float> &particle, std::vector<float> &render, int stage) const {
-    Vector4 local;
-
-    bool spawn = stage == Spawn;
-
-    emitter[AliveParticles] = 0;
-    for(int i = 0; i < m_capacity; i++) {
-        float *p = &particle[i * m_particleStride];
-        float *r = &render[static_cast<int32_t>(emitter[AliveParticles]) * m_renderableStride];
-
-        if((*p > 0) != spawn) { // check alive (for spawn case)
-            emitter[AliveParticles]++;
-
-            if(spawn) {
-                if(emitter[SpawnCounter] < 1.0f) {
-                    break;
-                }
-                emitter[SpawnCounter] -= 1.0f;
-            }
-
-            for(auto &it : operations) {
-                float *ret = nullptr;
-                switch(it.resultSpace) {
-                    case Space::Emitter: ret = &emitter[it.resultOffset]; break;
-                    case Space::Particle: ret = &p[it.resultOffset]; break;
-                    case Space::Renderable: ret = &r[it.resultOffset]; break;
-                    case Space::Local: ret = local.v; break;
-                    default: break;
-                }
-
-                std::array<const float *, 2> arg = {ret, ret};
-                std::array<bool, 2> sgl = {false, false};
-
-                for(int b = 0; b < 2; b++) {
-                    Argument &argument = it.arguments[b];
-
-                    if(argument.size == 1) {
-                        sgl[b] = true;
-                    }
-
-                    switch(argument.space) {
-                        case Space::Emitter: arg[b] = &emitter[argument.offset]; break;
-                        case Space::Particle: arg[b] = &p[argument.offset]; break;
-                        case Space::Local: arg[b] = local.v; break;
-                        case Space::Constant: arg[b] = it.constData.data(); break;
-                        case Space::Random: arg[b] = &it.constData[i * it.resultSize]; break;
-                        default: break;
-                    }
-                }
-
-                for(int c = 0; c < it.resultSize; c++) {
-                    float result = 0.0f;
-                    float a0 = arg[0][sgl[0] ? 0 : c];
-                    float a1 = arg[1][sgl[1] ? 0 : c];
-
-                    switch(it.op) {
-                        case Mov: result = a0; break;
-                        case Add: result = a0 + a1; break;
-                        case Sub: result = a0 - a1; break;
-                        case Mul: result = a0 * a1; break;
-                        case Div: result = a0 / a1; break;
-                        default: break;
-                    }
-
-                    ret[c] = result;
-                }
-            }
-        }
-    }
+ComputeShader *VisualEffect::computeShader() const {
+    return m_computeShader;
+}
+/*!
+    Returns a buffer with the constants of the compute shader.
+*/
+ComputeBuffer *VisualEffect::constantBuffer() const {
+    return m_constantBuffer;
 }
 /*!
     \internal
@@ -283,83 +240,124 @@ void VisualEffect::loadUserData(const VariantMap &data) {
             m_particleStride = (*it).toInt();
             it++;
 
-            loadOperations((*it).value<VariantList>(), m_spawnOperations);
+            loadOperations((*it).value<VariantList>(), m_spawnProgram);
             it++;
-            loadOperations((*it).value<VariantList>(), m_updateOperations);
+            loadOperations((*it).value<VariantList>(), m_updateProgram);
             it++;
-            loadOperations((*it).value<VariantList>(), m_renderOperations);
+            loadOperations((*it).value<VariantList>(), m_renderProgram);
         }
     }
+
+    buildComputeShader();
 }
 /*!
     \internal
+    Compiles the operations \a list into the \a program.
 */
-void VisualEffect::loadOperations(const VariantList &list, std::vector<Operator> &operations) {
-    operations.clear();
+void VisualEffect::loadOperations(const VariantList &list, ParticleProgram &program) {
+    program.clear();
 
     for(auto it : list) {
         VariantList fields = it.value<VariantList>();
 
-        Operator op;
+        ParticleProgram::Instruction instruction;
         auto field = fields.begin();
-        op.op = static_cast<Operation>((*field).toInt());
+        instruction.op = (*field).toInt();
         field++;
-        op.resultSpace = (*field).toInt();
+        instruction.result.space = (*field).toInt();
         field++;
-        op.resultOffset = (*field).toInt();
+        instruction.result.offset = (*field).toInt();
         field++;
-        op.resultSize = (*field).toInt();
+        instruction.result.size = (*field).toInt();
+        instruction.size = instruction.result.size;
         field++;
 
+        int32_t index = 0;
         for(Variant arg : (*field).value<VariantList>()) {
             VariantList argFields = arg.value<VariantList>();
+            if(index > 1) {
+                break;
+            }
+            ParticleProgram::Register &argument = instruction.arguments[index];
+            index++;
 
             auto argField = argFields.begin();
 
-            Argument argument;
-
             argument.space = (*argField).toInt();
             argField++;
             argument.size = (*argField).toInt();
             argField++;
-            argument.offset = -1;
-            switch(argument.space) {
-                case Constant: {
-                    op.constData.resize(op.resultSize);
 
-                    for(int i = 0; i < op.resultSize; i++) {
-                        op.constData[i] = (*argField).toFloat();
+            int32_t size = MIN(argument.size, 4);
+            switch(argument.space) {
+                case ParticleProgram::Constant: {
+                    Vector4 value;
+                    for(int i = 0; i < size; i++) {
+                        value[i] = (*argField).toFloat();
                         argField++;
                     }
+
+                    argument.offset = program.addConstant(value);
                 } break;
-                case Random: {
+                case ParticleProgram::Random: {
                     Vector4 min;
-                    for(int i = 0; i < op.resultSize; i++) {
+                    for(int i = 0; i < size; i++) {
                         min[i] = (*argField).toFloat();
                         argField++;
                     }
 
                     Vector4 max;
-                    for(int i = 0; i < op.resultSize; i++) {
+                    for(int i = 0; i < size; i++) {
                         max[i] = (*argField).toFloat();
                         argField++;
                     }
 
-                    op.constData.resize(m_capacity * op.resultSize);
-                    for(int p = 0; p < m_capacity; p++) {
-                        for(int i = 0; i < op.resultSize; i++) {
-                            op.constData[p * op.resultSize + i] = RANGE(min[i], max[i]);
-                        }
-                    }
+                    argument.offset = program.addRandom(min, max, size, m_capacity);
                 } break;
                 default: {
                     argument.offset = (*argField).toInt();
                 } break;
             }
-
-            op.arguments.push_back(argument);
         }
 
-        operations.push_back(op);
+        program.addInstruction(instruction);
+    }
+}
+/*!
+    \internal
+    Generates the compute shader from the particle programs for the GPU simulation.
+*/
+void VisualEffect::buildComputeShader() {
+    if(!m_gpu) {
+        return;
+    }
+
+    ParticleProgram::Context layout;
+    layout.capacity = m_capacity;
+    layout.stride = m_particleStride;
+    layout.renderStride = m_renderableStride;
+
+    if(m_computeShader == nullptr) {
+        m_computeShader = Engine::objectCreate<ComputeShader>();
+        m_computeShader->incRef();
     }
+
+    VariantList buffers;
+    buffers.push_back(VariantList({"", ParticleCompute::ParticlesBinding, "Particles", 0}));
+    buffers.push_back(VariantList({"", ParticleCompute::RenderBinding, "Renderables", 0}));
+    buffers.push_back(VariantList({"", ParticleCompute::StateBinding, "Emitter", 0}));
+    buffers.push_back(VariantList({"", ParticleCompute::ConstantsBinding, "Constants", 0}));
+
+    VariantMap data;
+    data[gShader] = ParticleCompute::source(m_spawnProgram, m_updateProgram, m_renderProgram, layout);
+    data[gBuffers] = buffers;
+    m_computeShader->loadUserData(data);
+
+    if(m_constantBuffer == nullptr) {
+        m_constantBuffer = Engine::objectCreate<ComputeBuffer>();
+        m_constantBuffer->incRef();
+    }
+
+    std::vector<float> constants = ParticleCompute::constants(m_spawnProgram, m_updateProgram, m_renderProgram);
+    m_constantBuffer->setData(ByteArray(reinterpret_cast<uint8_t *>(constants.data()), reinterpret_cast<uint8_t *>(constants.data() + constants.size())));
 }
@@ -29,10 +29,16 @@
 #include "pipelinetasks/shadowmap.h"
 #include "pipelinetasks/translucent.h"
 
+#include "utils/texturestreamer.h"
+
 #include "pipelinecontext.h"
 #include "commandbuffer.h"
 #include "pipelinecontext.h"
 
+namespace {
+    const char *gTextureBudget(".textureBudget");
+};
+
 int32_t RenderSystem::m_registered = 0;
 
 std::list<BaseLight *> RenderSystem::m_lightComponents;
@@ -116,6 +122,9 @@ int RenderSystem::threadPolicy() const {
 
 bool RenderSystem::init() {
     m_pipelineContext = Engine::objectCreate<PipelineContext>("PipelineContext");
+
+    // The budget for the streamed textures in megabytes, the zero budget disables streaming
+    TextureStreamer::setBudget(static_cast<uint64_t>(MAX(Engine::value(gTextureBudget, 0).toInt(), 0)) << 20);
     return true;
 }
 
@@ -130,6 +139,8 @@ void RenderSystem::update(World *world) {
         m_pipelineContext->setWorld(world);
         m_pipelineContext->draw(camera);
     }
+
+    TextureStreamer::update();
 }
 
 void RenderSystem::composeComponent(Component *component) const {
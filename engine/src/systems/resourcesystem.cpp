@@ -5,6 +5,12 @@
 #include <log.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <threadpool.h>
 
 #include "file.h"
 
@@ -34,7 +40,83 @@
 #include "resources/tileset.h"
 #include "resources/tilemap.h"
 
-ResourceSystem::ResourceSystem() {
+namespace {
+    const uint32_t gLoaderThreads = 2;
+    const float gFinalizationBudget = 4.0f; // milliseconds
+};
+
+class LoadRequest : public Object {
+public:
+    LoadRequest(Resource *resource, const std::string &uuid, int32_t priority, uint32_t order) :
+            m_resource(resource),
+            m_uuid(uuid),
+            m_priority(priority),
+            m_order(order),
+            m_dispatched(false),
+            m_done(false),
+            m_canceled(false) {
+
+    }
+
+    void processEvents() override {
+        PROFILE_FUNCTION();
+
+        if(!m_canceled) {
+            m_data = ResourceSystem::readData(m_uuid);
+        }
+
+        std::unique_lock<std::mutex> locker(m_doneMutex);
+        m_done = true;
+        m_doneCondition.notify_all();
+    }
+
+    void cancel() {
+        m_canceled = true;
+        if(m_dispatched) {
+            // The loader thread still owns the request
+            wait();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> locker(m_doneMutex);
+        m_doneCondition.wait(locker, [this]() { return m_done.load(); });
+    }
+
+    bool operator<(const LoadRequest &right) const {
+        if(m_priority == right.m_priority) {
+            return m_order < right.m_order;
+        }
+        return m_priority > right.m_priority;
+    }
+
+public:
+    Variant m_data;
+
+    Resource *m_resource;
+
+    std::string m_uuid;
+
+    int32_t m_priority;
+
+    uint32_t m_order;
+
+    bool m_dispatched;
+
+    std::atomic<bool> m_done;
+
+    std::atomic<bool> m_canceled;
+
+    std::mutex m_doneMutex;
+
+    std::condition_variable m_doneCondition;
+
+};
+
+ResourceSystem::ResourceSystem() :
+        m_loaderPool(nullptr),
+        m_requestsOrder(0),
+        m_finalizationBudget(gFinalizationBudget) {
     setName("ResourceSystem");
 
     // The order is critical for the import
@@ -71,6 +153,22 @@ ResourceSystem::ResourceSystem() {
     ControlScheme::registerClassFactory(this);
 }
 
+ResourceSystem::~ResourceSystem() {
+    for(auto &it : m_requests) {
+        it.second->m_canceled = true;
+    }
+
+    if(m_loaderPool) {
+        m_loaderPool->waitForDone();
+        delete m_loaderPool;
+    }
+
+    for(auto &it : m_requests) {
+        delete it.second;
+    }
+    m_requests.clear();
+}
+
 bool ResourceSystem::init() {
     return true;
 }
@@ -78,6 +176,11 @@ bool ResourceSystem::init() {
 void ResourceSystem::update(World *) {
     PROFILE_FUNCTION();
 
+    if(!m_requests.empty()) {
+        finalizeRequests();
+        dispatchRequests();
+    }
+
     for(auto it = m_referenceCache.begin(); it != m_referenceCache.end();) {
         processState(it->first);
         ++it;
@@ -116,30 +219,112 @@ Resource *ResourceSystem::loadResource(const std::string &path) {
         std::string uuid = path;
         Resource *object = resource(uuid);
         if(object) {
+            auto it = m_requests.find(object);
+            if(it != m_requests.end()) {
+                // Synchronous request completes the asynchronous one immediately
+                finishRequest(it->second);
+            }
             return object;
         }
 
-        File *file = Engine::file();
-        _FILE *fp = file->fopen(uuid.c_str(), "r");
-        if(fp) {
-            ByteArray data;
-            size_t size = file->fsize(fp);
-            data.resize(size);
-            file->fread(&data[0], data.size(), 1, fp);
-            file->fclose(fp);
-
-            Variant var = Bson::load(data);
-            if(!var.isValid()) {
-                var = Json::load(std::string(data.begin(), data.end()));
-            }
-            if(var.isValid()) {
-                return static_cast<Resource *>(Engine::toObject(var, nullptr, uuid));
-            }
+        Variant var = readData(uuid);
+        if(var.isValid()) {
+            return static_cast<Resource *>(Engine::toObject(var, nullptr, uuid));
         }
-
     }
     return nullptr;
 }
+/*!
+    Starts asynchronous loading of the resource located along the \a path.
+    Reading and parsing of the resource data are performed on the loader threads, the resource is filled on the main thread during the update().
+    Requests with a higher \a priority are processed first.
+
+    Returns the resource instance in the Resource::Loading state immediately.
+    Use Resource::subscribe() or Resource::state() to know when the resource becomes ready.
+    \note Resources which are not listed in the bundle index are loaded synchronously.
+*/
+Resource *ResourceSystem::loadResourceAsync(const std::string &path, int32_t priority) {
+    PROFILE_FUNCTION();
+
+    if(path.empty()) {
+        return nullptr;
+    }
+
+    std::string uuid = path;
+    Resource *object = resource(uuid);
+    if(object) {
+        setLoadingPriority(object, priority);
+        return object;
+    }
+
+    std::string type;
+    auto index = m_indexMap.find(path);
+    if(index != m_indexMap.end()) {
+        type = index->second.first;
+    }
+
+    if(type.empty()) {
+        return loadResource(path);
+    }
+
+    // The instance is registered in cache immediately to be shared between all requests
+    object = dynamic_cast<Resource *>(Engine::objectCreate(type, uuid));
+    if(object == nullptr) {
+        return loadResource(path);
+    }
+    object->setState(Resource::Loading);
+
+    m_requests[object] = new LoadRequest(object, uuid, priority, m_requestsOrder++);
+
+    return object;
+}
+/*!
+    Returns true if the \a resource is loading asynchronously; otherwise returns false.
+*/
+bool ResourceSystem::isLoading(Resource *resource) const {
+    return m_requests.find(resource) != m_requests.end();
+}
+/*!
+    Changes the loading \a priority of the \a resource requested with loadResourceAsync().
+    The priority affects only requests which are not started yet.
+*/
+void ResourceSystem::setLoadingPriority(Resource *resource, int32_t priority) {
+    auto it = m_requests.find(resource);
+    if(it != m_requests.end()) {
+        it->second->m_priority = priority;
+    }
+}
+/*!
+    Cancels the asynchronous loading of the \a resource.
+    The resource will be unloaded and must not be used anymore.
+*/
+void ResourceSystem::cancelLoading(Resource *resource) {
+    PROFILE_FUNCTION();
+
+    auto it = m_requests.find(resource);
+    if(it != m_requests.end()) {
+        LoadRequest *request = it->second;
+        m_requests.erase(it);
+
+        request->cancel();
+        delete request;
+
+        unloadResource(resource, true);
+    }
+}
+/*!
+    Returns the time in milliseconds which can be spent on the main thread to finalize loaded resources during one update.
+*/
+float ResourceSystem::finalizationBudget() const {
+    return m_finalizationBudget;
+}
+/*!
+    Sets the time in \a milliseconds which can be spent on the main thread to finalize loaded resources during one update.
+    At least one resource is finalized per update regardless of the budget.
+*/
+void ResourceSystem::setFinalizationBudget(float milliseconds) {
+    m_finalizationBudget = milliseconds;
+}
 
 void ResourceSystem::unloadResource(Resource *resource, bool force) {
     PROFILE_FUNCTION();
@@ -182,6 +367,27 @@ std::string ResourceSystem::reference(Resource *resource) {
     return std::string();
 }
 
+/*!
+    Reads the user data of the loaded \a resource from the bundle again.
+    Used by the resources which release a part of their data from memory and restore it on demand.
+    Returns an empty map in case of the \a resource was not loaded from the bundle.
+*/
+VariantMap ResourceSystem::readUserData(Resource *resource) {
+    PROFILE_FUNCTION();
+
+    std::string uuid = reference(resource);
+    if(!uuid.empty()) {
+        VariantList objects = readData(uuid).toList();
+        if(!objects.empty()) {
+            VariantList fields = objects.front().toList();
+            if(!fields.empty()) {
+                return fields.back().toMap();
+            }
+        }
+    }
+    return VariantMap();
+}
+
 ResourceSystem::DictionaryMap &ResourceSystem::indices() const {
     return m_indexMap;
 }
@@ -197,6 +403,13 @@ void ResourceSystem::deleteFromCahe(Resource *resource) {
         m_referenceCache.erase(ref);
     }
 
+    auto request = m_requests.find(resource);
+    if(request != m_requests.end()) {
+        request->second->cancel();
+        delete request->second;
+        m_requests.erase(request);
+    }
+
     for(auto it : m_deleteList) {
         if(it == resource) {
             m_deleteList.remove(it);
@@ -209,61 +422,15 @@ void ResourceSystem::processState(Resource *resource) {
     if(resource) {
         switch(resource->state()) {
             case Resource::Loading: {
+                if(m_requests.find(resource) != m_requests.end()) {
+                    break;
+                }
+
                 std::string uuid = reference(resource);
                 if(!uuid.empty()) {
-                    File *file = Engine::file();
-                    _FILE *fp = file->fopen(uuid.c_str(), "r");
-                    if(fp) {
-                        ByteArray data;
-                        data.resize(file->fsize(fp));
-                        file->fread(&data[0], data.size(), 1, fp);
-                        file->fclose(fp);
-
-                        Variant var = Bson::load(data);
-                        if(!var.isValid()) {
-                            var = Json::load(std::string(data.begin(), data.end()));
-                        }
-
-                        ObjectList deleteObjects;
-                        enumObjects(resource, deleteObjects);
-
-                        VariantList objects = var.toList();
-                        auto delIt = deleteObjects.begin();
-                        bool first = true;
-                        for(auto &obj : objects) {
-                            VariantList fields = obj.toList();
-                            auto it = std::next(fields.begin(), 1);
-                            Object *object = resource;
-                            if(!first) {
-                                object = Engine::findObject(it->toInt(), resource);
-                            } else {
-                                first = false;
-                            }
-
-                            if(object) {
-                                it = std::next(fields.begin(), 4);
-                                VariantMap &properties = *(reinterpret_cast<VariantMap *>((*it).data()));
-                                for(const auto &prop : properties) {
-                                    Variant v = prop.second;
-                                    if(v.type() < MetaType::USERTYPE) {
-                                        object->setProperty(prop.first.c_str(), v);
-                                    }
-                                }
-
-                                object->loadUserData(fields.back().toMap());
-
-                                delIt = deleteObjects.erase(delIt);
-                            } else {
-                                VariantList list;
-                                list.push_back(obj);
-                                Engine::toObject(list, resource, uuid);
-                            }
-                        }
-
-                        deleteObjects.reverse();
-                        for(auto toDel : deleteObjects) {
-                            delete toDel;
-                        }
+                    Variant var = readData(uuid);
+                    if(var.isValid()) {
+                        applyData(resource, uuid, var);
 
                         resource->switchState(Resource::ToBeUpdated);
                     } else {
@@ -315,3 +482,182 @@ Object *ResourceSystem::instantiateObject(const MetaObject *meta, const std::str
 
     return result;
 }
+
+void ResourceSystem::dispatchRequests() {
+    PROFILE_FUNCTION();
+
+    if(m_loaderPool == nullptr) {
+        m_loaderPool = new ThreadPool;
+        m_loaderPool->setMaxThreads(gLoaderThreads);
+    }
+
+    uint32_t inFlight = 0;
+    std::vector<LoadRequest *> queue;
+    for(auto &it : m_requests) {
+        LoadRequest *request = it.second;
+        if(request->m_dispatched) {
+            if(!request->m_done) {
+                inFlight++;
+            }
+        } else {
+            queue.push_back(request);
+        }
+    }
+
+    // Keep the loader queue short to let priority changes take effect
+    if(inFlight < gLoaderThreads && !queue.empty()) {
+        std::sort(queue.begin(), queue.end(), [](const LoadRequest *left, const LoadRequest *right) { return *left < *right; });
+
+        for(auto request : queue) {
+            if(inFlight >= gLoaderThreads) {
+                break;
+            }
+            request->m_dispatched = true;
+            m_loaderPool->start(*request);
+            inFlight++;
+        }
+    }
+}
+
+void ResourceSystem::finalizeRequests() {
+    PROFILE_FUNCTION();
+
+    std::vector<LoadRequest *> ready;
+    for(auto &it : m_requests) {
+        LoadRequest *request = it.second;
+        if(request->m_dispatched && request->m_done) {
+            ready.push_back(request);
+        }
+    }
+
+    std::sort(ready.begin(), ready.end(), [](const LoadRequest *left, const LoadRequest *right) { return *left < *right; });
+
+    auto start = std::chrono::steady_clock::now();
+    for(auto request : ready) {
+        finishRequest(request);
+
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if(elapsed.count() >= m_finalizationBudget) {
+            break;
+        }
+    }
+}
+
+void ResourceSystem::finishRequest(LoadRequest *request) {
+    PROFILE_FUNCTION();
+
+    if(!request->m_dispatched) {
+        request->m_dispatched = true;
+        request->processEvents();
+    }
+
+    request->wait();
+
+    m_requests.erase(request->m_resource);
+
+    Resource *resource = request->m_resource;
+    if(request->m_data.isValid()) {
+        restoreData(resource, request->m_data);
+
+        resource->switchState(Resource::ToBeUpdated);
+    } else {
+        Log(Log::ERR) << "Unable to load resource: " << request->m_uuid.c_str();
+        resource->setState(Resource::Invalid);
+    }
+
+    delete request;
+}
+
+/*!
+    \internal
+    Deserializes the \a data of a resource requested with loadResourceAsync() into the pre-created \a resource instance.
+    The root object of the data is matched by its UUID, so the whole hierarchy, links and dynamic properties are restored
+    in the same way as loadResource() does, but without a new root instance.
+*/
+void ResourceSystem::restoreData(Resource *resource, const Variant &data) {
+    PROFILE_FUNCTION();
+
+    VariantList objects = data.toList();
+    if(!objects.empty()) {
+        VariantList fields = objects.front().toList();
+        if(fields.size() >= 2) {
+            Engine::replaceUUID(resource, static_cast<uint32_t>(std::next(fields.begin(), 1)->toInt()));
+        }
+    }
+
+    Engine::toObject(data, resource);
+}
+/*!
+    \internal
+    Updates the already loaded \a resource with the reloaded \a data.
+    Existing objects are matched by their UUIDs and keep their identity, the new ones are created and the missing ones are deleted.
+*/
+void ResourceSystem::applyData(Resource *resource, const std::string &uuid, const Variant &data) {
+    PROFILE_FUNCTION();
+
+    ObjectList deleteObjects;
+    enumObjects(resource, deleteObjects);
+
+    VariantList objects = data.toList();
+    auto delIt = deleteObjects.begin();
+    bool first = true;
+    for(auto &obj : objects) {
+        VariantList fields = obj.toList();
+        auto it = std::next(fields.begin(), 1);
+        Object *object = resource;
+        if(!first) {
+            object = Engine::findObject(it->toInt(), resource);
+        } else {
+            first = false;
+        }
+
+        if(object) {
+            it = std::next(fields.begin(), 4);
+            VariantMap &properties = *(reinterpret_cast<VariantMap *>((*it).data()));
+            for(const auto &prop : properties) {
+                Variant v = prop.second;
+                if(v.type() < MetaType::USERTYPE) {
+                    object->setProperty(prop.first.c_str(), v);
+                }
+            }
+
+            object->loadUserData(fields.back().toMap());
+
+            delIt = deleteObjects.erase(delIt);
+        } else {
+            VariantList list;
+            list.push_back(obj);
+            Engine::toObject(list, resource, uuid);
+        }
+    }
+
+    deleteObjects.reverse();
+    for(auto toDel : deleteObjects) {
+        delete toDel;
+    }
+}
+/*!
+    \internal
+    Reads and parses the resource data with a given \a uuid.
+    This method is thread safe.
+*/
+Variant ResourceSystem::readData(const std::string &uuid) {
+    PROFILE_FUNCTION();
+
+    Variant result;
+
+    File *file = Engine::file();
+    _FILE *fp = file->fopen(uuid.c_str(), "r");
+    if(fp) {
+        ByteArray data;
+        data.resize(file->fsize(fp));
+        file->fread(&data[0], data.size(), 1, fp);
+        file->fclose(fp);
+
+        result = Bson::load(data);
+        if(!result.isValid()) {
+            result = Json::load(std::string(data.begin(), data.end()));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,457 @@
+#include "utils/assetpack.h"
+
+#include "log.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+    const char gMagic[] = {'T', 'P', 'A', 'K'};
+    const uint32_t gVersion = 1;
+
+    const uint64_t gAlignment = 4096;
+    const uint64_t gStreamingSize = 1024 * 1024; // Large entries are stored as is to be paged in on demand
+    const float gCompressionRatio = 0.9f;
+
+    uint64_t align(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+};
+
+/*!
+    \class AssetPack
+    \brief Read-only archive with the game resources mapped to the memory.
+    \inmodule Engine
+
+    The pack contains a table of contents sorted by the hash of the entry names and a bucket directory indexed by the top bits of the hash.
+    So find() takes constant time in average and doesn't require any preprocessing after open().
+
+    Each entry starts at 4K aligned offset and can be stored as is or compressed with Deflate.
+    The whole file is memory-mapped, stored entries are accessible directly with data() and the operating system pages them in only when touched.
+
+    Packs are created with AssetPackWriter and mounted by the File module when passed to File::fsearchPathAdd().
+*/
+
+AssetPack::AssetPack() :
+        m_header(nullptr),
+        m_buckets(nullptr),
+        m_entries(nullptr),
+        m_names(nullptr),
+        m_data(nullptr),
+        m_size(0),
+        m_handle(nullptr) {
+
+}
+
+AssetPack::~AssetPack() {
+    close();
+}
+/*!
+    Maps the pack located along the \a path to the memory.
+    Returns true if succeeded; returns false if file doesn't exist or isn't a valid pack.
+*/
+bool AssetPack::open(const std::string &path) {
+    PROFILE_FUNCTION();
+
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(Header))) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if(mapping == nullptr) {
+        return false;
+    }
+
+    void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(data == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_handle = mapping;
+    m_size = size.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(file, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+        ::close(file);
+        return false;
+    }
+
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if(data == MAP_FAILED) {
+        return false;
+    }
+
+    m_size = info.st_size;
+#endif
+    m_data = static_cast<uint8_t *>(data);
+
+    const Header *header = reinterpret_cast<const Header *>(m_data);
+    if(memcmp(header->magic, gMagic, sizeof(gMagic)) != 0 || header->version != gVersion) {
+        close();
+        return false;
+    }
+
+    if(!validate(*header)) {
+        aError() << "[ AssetPack ] Corrupted pack" << path;
+        close();
+        return false;
+    }
+
+    m_header = header;
+    m_buckets = reinterpret_cast<const uint32_t *>(m_data + header->tableOffset);
+    m_entries = reinterpret_cast<const Entry *>(m_data + entriesOffset(*header));
+    m_names = reinterpret_cast<const char *>(m_data + header->namesOffset);
+
+    return true;
+}
+/*!
+    \internal
+    Returns the offset of the entries which follow the buckets table described by the \a header.
+*/
+uint64_t AssetPack::entriesOffset(const Header &header) {
+    uint64_t buckets = (1ULL << header.bucketBits) + 1;
+    return align(header.tableOffset + buckets * sizeof(uint32_t), sizeof(uint64_t));
+}
+/*!
+    \internal
+    Checks that all tables described by the \a header and all references of the entries are inside of the mapped data.
+    Offsets are compared with the remaining size to never overflow.
+*/
+bool AssetPack::validate(const Header &header) const {
+    if(header.bucketBits > 31 || header.tableOffset > m_size) {
+        return false;
+    }
+
+    uint64_t buckets = (1ULL << header.bucketBits) + 1;
+    if(buckets * sizeof(uint32_t) > m_size - header.tableOffset) {
+        return false;
+    }
+
+    uint64_t entries = entriesOffset(header);
+    if(entries > m_size || header.count > (m_size - entries) / sizeof(Entry)) {
+        return false;
+    }
+
+    if(header.namesOffset > m_size || header.namesSize > m_size - header.namesOffset) {
+        return false;
+    }
+
+    // Buckets are the ranges of the entries, so they must grow and never exceed the number of entries
+    const uint32_t *table = reinterpret_cast<const uint32_t *>(m_data + header.tableOffset);
+    for(uint64_t i = 0; i < buckets; i++) {
+        if(table[i] > header.count || (i > 0 && table[i] < table[i - 1])) {
+            return false;
+        }
+    }
+
+    const Entry *list = reinterpret_cast<const Entry *>(m_data + entries);
+    for(uint32_t i = 0; i < header.count; i++) {
+        const Entry &entry = list[i];
+        if(entry.name > header.namesSize || entry.nameLength > header.namesSize - entry.name ||
+           entry.offset > m_size || entry.size > m_size - entry.offset) {
+            return false;
+        }
+    }
+
+    return true;
+}
+/*!
+    Unmaps the pack from the memory.
+    All pointers returned by data() become invalid.
+*/
+void AssetPack::close() {
+    if(m_data) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(static_cast<HANDLE>(m_handle));
+#else
+        munmap(m_data, m_size);
+#endif
+    }
+
+    m_header = nullptr;
+    m_buckets = nullptr;
+    m_entries = nullptr;
+    m_names = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_handle = nullptr;
+}
+/*!
+    Returns true if the pack is mapped; otherwise returns false.
+*/
+bool AssetPack::isOpen() const {
+    return m_header != nullptr;
+}
+/*!
+    Returns the number of entries in the pack.
+*/
+uint32_t AssetPack::count() const {
+    return m_header ? m_header->count : 0;
+}
+/*!
+    Returns the entry with a given \a index or nullptr if index is out of range.
+    Entries are sorted by the name hash.
+*/
+const AssetPack::Entry *AssetPack::entry(uint32_t index) const {
+    if(index < count()) {
+        return &m_entries[index];
+    }
+    return nullptr;
+}
+/*!
+    Returns the entry with a given \a name or nullptr if the pack doesn't contain it.
+*/
+const AssetPack::Entry *AssetPack::find(const std::string &name) const {
+    if(m_header == nullptr) {
+        return nullptr;
+    }
+
+    uint64_t key = hash(name);
+    uint32_t index = bucket(key, m_header->bucketBits);
+
+    for(uint32_t i = m_buckets[index]; i < m_buckets[index + 1]; i++) {
+        const Entry &entry = m_entries[i];
+        if(entry.hash == key && entry.nameLength == name.size() &&
+           memcmp(m_names + entry.name, name.data(), name.size()) == 0) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+/*!
+    Returns the name of the \a entry.
+*/
+std::string AssetPack::name(const Entry &entry) const {
+    return std::string(m_names + entry.name, entry.nameLength);
+}
+/*!
+    Returns a pointer to the raw data of the \a entry inside of the mapped pack.
+    For Stored entries it's the content of the file itself, so it can be used without any copying.
+*/
+const uint8_t *AssetPack::data(const Entry &entry) const {
+    if(entry.offset + entry.size > m_size) {
+        return nullptr;
+    }
+    return m_data + entry.offset;
+}
+/*!
+    Decompresses the content of the \a entry to the \a buffer.
+    The \a buffer must be at least Entry::originalSize bytes long.
+    Returns true if succeeded; otherwise returns false.
+*/
+bool AssetPack::extract(const Entry &entry, uint8_t *buffer) const {
+    PROFILE_FUNCTION();
+
+    const uint8_t *source = data(entry);
+    if(source == nullptr) {
+        return false;
+    }
+
+    switch(entry.compression) {
+        case Stored: {
+            memcpy(buffer, source, entry.originalSize);
+            return true;
+        }
+        case Deflate: {
+            uLongf size = entry.originalSize;
+            return uncompress(buffer, &size, source, entry.size) == Z_OK && size == entry.originalSize;
+        }
+        default: break;
+    }
+    return false;
+}
+/*!
+    Returns the 64-bit FNV-1a hash of the entry \a name.
+*/
+uint64_t AssetPack::hash(const std::string &name) {
+    uint64_t result = 14695981039346656037ULL;
+    for(auto it : name) {
+        result ^= static_cast<uint8_t>(it);
+        result *= 1099511628211ULL;
+    }
+    return result;
+}
+/*!
+    Returns the bucket index for the \a hash in the directory with 2^\a bits buckets.
+*/
+uint32_t AssetPack::bucket(uint64_t hash, uint32_t bits) {
+    return (bits == 0) ? 0 : static_cast<uint32_t>(hash >> (64 - bits));
+}
+
+/*!
+    \class AssetPackWriter
+    \brief Creates AssetPack archives.
+    \inmodule Engine
+
+    By default the writer compresses small entries with Deflate when it saves enough space.
+    Entries larger than 1 MB are stored as is to be paged in lazily from the mapped pack.
+*/
+
+/*!
+    Adds a file with a given \a name and content \a data to the pack.
+    The \a compression can be one of AssetPack::Compression or Auto to let the writer decide.
+    The file with the same name will be replaced.
+*/
+void AssetPackWriter::addFile(const std::string &name, const ByteArray &data, int32_t compression) {
+    PROFILE_FUNCTION();
+
+    Item item;
+    item.name = name;
+    item.originalSize = data.size();
+    item.compression = AssetPack::Stored;
+
+    if(compression == AssetPack::Deflate || (compression == Auto && !data.empty() && data.size() < gStreamingSize)) {
+        uLongf size = compressBound(data.size());
+        item.data.resize(size);
+        if(compress2(item.data.data(), &size, data.data(), data.size(), Z_BEST_COMPRESSION) == Z_OK &&
+           (compression == AssetPack::Deflate || size < data.size() * gCompressionRatio)) {
+            item.data.resize(size);
+            item.compression = AssetPack::Deflate;
+        }
+    }
+
+    if(item.compression == AssetPack::Stored) {
+        item.data = data;
+    }
+
+    auto it = m_indices.find(name);
+    if(it != m_indices.end()) {
+        m_items[it->second] = std::move(item);
+        return;
+    }
+    m_indices[name] = m_items.size();
+    m_items.push_back(std::move(item));
+}
+/*!
+    Writes the pack to the file located along the \a path.
+    Returns true if succeeded; otherwise returns false.
+*/
+bool AssetPackWriter::save(const std::string &path) const {
+    PROFILE_FUNCTION();
+
+    FILE *fp = fopen(path.c_str(), "wb");
+    if(fp == nullptr) {
+        aError() << "[ AssetPack ] Can't create pack" << path;
+        return false;
+    }
+
+    uint32_t count = m_items.size();
+    uint32_t bits = 0;
+    while((1U << bits) < count) {
+        bits++;
+    }
+
+    std::vector<AssetPack::Entry> entries(count);
+    std::string names;
+
+    ByteArray padding(gAlignment, 0);
+
+    bool result = true;
+    uint64_t offset = gAlignment; // The first page is reserved for the header
+    fseek(fp, offset, SEEK_SET);
+    for(uint32_t i = 0; i < count; i++) {
+        const Item &item = m_items[i];
+
+        AssetPack::Entry &entry = entries[i];
+        entry.hash = AssetPack::hash(item.name);
+        entry.offset = offset;
+        entry.size = item.data.size();
+        entry.originalSize = item.originalSize;
+        entry.name = names.size();
+        entry.nameLength = item.name.size();
+        entry.compression = item.compression;
+        entry.reserved = 0;
+
+        names += item.name;
+
+        if(!item.data.empty()) {
+            result &= (fwrite(item.data.data(), item.data.size(), 1, fp) == 1);
+        }
+        uint64_t next = align(offset + item.data.size(), gAlignment);
+        if(next > offset + item.data.size()) {
+            result &= (fwrite(padding.data(), next - offset - item.data.size(), 1, fp) == 1);
+        }
+        offset = next;
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const AssetPack::Entry &left, const AssetPack::Entry &right) {
+        return left.hash < right.hash;
+    });
+
+    std::vector<uint32_t> buckets((1ULL << bits) + 1, 0);
+    for(auto &it : entries) {
+        buckets[AssetPack::bucket(it.hash, bits) + 1]++;
+    }
+    for(uint32_t i = 1; i < buckets.size(); i++) {
+        buckets[i] += buckets[i - 1];
+    }
+
+    AssetPack::Header header;
+    memcpy(header.magic, gMagic, sizeof(gMagic));
+    header.version = gVersion;
+    header.count = count;
+    header.bucketBits = bits;
+    header.tableOffset = offset;
+    uint64_t bucketsSize = buckets.size() * sizeof(uint32_t);
+    uint64_t entriesOffset = align(offset + bucketsSize, sizeof(uint64_t));
+    header.namesOffset = entriesOffset + entries.size() * sizeof(AssetPack::Entry);
+    header.namesSize = names.size();
+
+    result &= (fwrite(buckets.data(), bucketsSize, 1, fp) == 1);
+    if(entriesOffset > offset + bucketsSize) {
+        result &= (fwrite(padding.data(), entriesOffset - offset - bucketsSize, 1, fp) == 1);
+    }
+    if(!entries.empty()) {
+        result &= (fwrite(entries.data(), entries.size() * sizeof(AssetPack::Entry), 1, fp) == 1);
+    }
+    if(!names.empty()) {
+        result &= (fwrite(names.data(), names.size(), 1, fp) == 1);
+    }
+
+    fseek(fp, 0, SEEK_SET);
+    result &= (fwrite(&header, sizeof(header), 1, fp) == 1);
+
+    fclose(fp);
+
+    if(!result) {
+        aError() << "[ AssetPack ] Can't write pack" << path;
+    }
+    return result;
+}
+/*!
+    Returns the number of files added to the pack.
+*/
+uint32_t AssetPackWriter::count() const {
+    return m_items.size();
+}
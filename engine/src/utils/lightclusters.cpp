@@ -0,0 +1,299 @@
+#include "utils/lightclusters.h"
+
+#include <cmath>
+
+namespace {
+    const float gMinNearPlane = 0.01f;
+    const float gEpsilon = 0.0001f;
+};
+
+/*!
+    \class LightClusters
+    \brief Assigns lights to the clusters of a view frustum.
+    \inmodule Engine
+
+    The view frustum is divided to a 3D grid of froxels: sizeX() by sizeY() screen tiles and sizeZ() depth slices distributed exponentially between near and far planes.
+    Each light is represented by a bounding sphere and after build() every cluster contains a range of indices of the lights which affect it.
+    The result can be uploaded to the GPU to shade all lights in a single pass with a fixed cost per pixel.
+
+    The binning works on the CPU and doesn't depend on any graphics API.
+*/
+
+LightClusters::LightClusters() :
+        m_sizeX(16),
+        m_sizeY(9),
+        m_sizeZ(24),
+        m_tanX(1.0f),
+        m_tanY(1.0f),
+        m_near(0.1f),
+        m_far(1000.0f),
+        m_logScale(0.0f),
+        m_ortho(false) {
+
+    updateBounds();
+}
+/*!
+    Sets the cluster grid dimensions to \a x tiles horizontally, \a y tiles vertically and \a z depth slices.
+*/
+void LightClusters::setGridSize(uint32_t x, uint32_t y, uint32_t z) {
+    m_sizeX = MAX(x, 1U);
+    m_sizeY = MAX(y, 1U);
+    m_sizeZ = MAX(z, 1U);
+
+    updateBounds();
+}
+/*!
+    Returns the number of tiles along the screen X axis.
+*/
+uint32_t LightClusters::sizeX() const {
+    return m_sizeX;
+}
+/*!
+    Returns the number of tiles along the screen Y axis.
+*/
+uint32_t LightClusters::sizeY() const {
+    return m_sizeY;
+}
+/*!
+    Returns the number of depth slices.
+*/
+uint32_t LightClusters::sizeZ() const {
+    return m_sizeZ;
+}
+/*!
+    Sets up a perspective frustum with vertical field-of-view \a fov in degrees, aspect \a ratio and clipping planes \a nearPlane and \a farPlane.
+*/
+void LightClusters::setPerspective(float fov, float ratio, float nearPlane, float farPlane) {
+    m_tanY = tan(DEG2RAD * fov * 0.5f);
+    m_tanX = m_tanY * ratio;
+    m_near = MAX(nearPlane, gMinNearPlane);
+    m_far = MAX(farPlane, m_near + gMinNearPlane);
+    m_ortho = false;
+
+    updateBounds();
+}
+/*!
+    Sets up an orthographic frustum with vertical \a size, aspect \a ratio and clipping planes \a nearPlane and \a farPlane.
+*/
+void LightClusters::setOrthographic(float size, float ratio, float nearPlane, float farPlane) {
+    m_tanY = size * 0.5f;
+    m_tanX = m_tanY * ratio;
+    m_near = MAX(nearPlane, gMinNearPlane);
+    m_far = MAX(farPlane, m_near + gMinNearPlane);
+    m_ortho = true;
+
+    updateBounds();
+}
+/*!
+    Returns the distance to the near plane used for the depth slicing.
+*/
+float LightClusters::nearPlane() const {
+    return m_near;
+}
+/*!
+    Returns the distance to the far plane used for the depth slicing.
+*/
+float LightClusters::farPlane() const {
+    return m_far;
+}
+/*!
+    Assigns the \a lights to the clusters.
+    Each light is a bounding sphere in world space: xyz components contain the position and w component contains the radius.
+    The \a view matrix transforms world space to the view space of the camera looking along the negative Z axis.
+*/
+void LightClusters::build(const Matrix4 &view, const std::vector<Vector4> &lights) {
+    PROFILE_FUNCTION();
+
+    m_pairs.clear();
+
+    for(uint32_t l = 0; l < lights.size(); l++) {
+        const Vector4 &light = lights[l];
+        Vector3 center(view * Vector3(light.x, light.y, light.z));
+        float radius = light.w;
+        float depth = -center.z;
+
+        if(depth + radius < m_near || depth - radius > m_far) {
+            continue;
+        }
+
+        float front = MAX(depth - radius, m_near);
+        float back = MIN(depth + radius, m_far);
+
+        int32_t z0 = slice(front);
+        int32_t z1 = slice(back);
+        // Compensate rounding errors of the logarithmic slicing
+        if(z0 > 0 && sliceDepth(z0) > front) {
+            z0--;
+        }
+        if(z1 < static_cast<int32_t>(m_sizeZ) - 1 && sliceDepth(z1 + 1) < back) {
+            z1++;
+        }
+
+        for(int32_t z = z0; z <= z1; z++) {
+            float d0 = MAX(sliceDepth(z), front);
+            float d1 = MIN(sliceDepth(z + 1), back);
+            if(d0 > d1) {
+                continue;
+            }
+
+            // Conservative screen space rectangle of the sphere part inside the slice
+            float minX, maxX, minY, maxY;
+            if(m_ortho) {
+                minX = (center.x - radius) / m_tanX;
+                maxX = (center.x + radius) / m_tanX;
+                minY = (center.y - radius) / m_tanY;
+                maxY = (center.y + radius) / m_tanY;
+            } else {
+                minX = MIN((center.x - radius) / (d0 * m_tanX), (center.x - radius) / (d1 * m_tanX));
+                maxX = MAX((center.x + radius) / (d0 * m_tanX), (center.x + radius) / (d1 * m_tanX));
+                minY = MIN((center.y - radius) / (d0 * m_tanY), (center.y - radius) / (d1 * m_tanY));
+                maxY = MAX((center.y + radius) / (d0 * m_tanY), (center.y + radius) / (d1 * m_tanY));
+            }
+
+            minX -= gEpsilon;
+            minY -= gEpsilon;
+            maxX += gEpsilon;
+            maxY += gEpsilon;
+
+            if(maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f) {
+                continue;
+            }
+
+            int32_t x0 = CLAMP(static_cast<int32_t>(floor((minX * 0.5f + 0.5f) * m_sizeX)), 0, static_cast<int32_t>(m_sizeX) - 1);
+            int32_t x1 = CLAMP(static_cast<int32_t>(floor((maxX * 0.5f + 0.5f) * m_sizeX)), 0, static_cast<int32_t>(m_sizeX) - 1);
+            int32_t y0 = CLAMP(static_cast<int32_t>(floor((minY * 0.5f + 0.5f) * m_sizeY)), 0, static_cast<int32_t>(m_sizeY) - 1);
+            int32_t y1 = CLAMP(static_cast<int32_t>(floor((maxY * 0.5f + 0.5f) * m_sizeY)), 0, static_cast<int32_t>(m_sizeY) - 1);
+
+            for(int32_t y = y0; y <= y1; y++) {
+                for(int32_t x = x0; x <= x1; x++) {
+                    uint32_t index = clusterIndex(x, y, z);
+
+                    const Vector3 &min = m_bounds[index * 2];
+                    const Vector3 &max = m_bounds[index * 2 + 1];
+
+                    float distance = 0.0f;
+                    for(int i = 0; i < 3; i++) {
+                        if(center[i] < min[i]) {
+                            float s = center[i] - min[i];
+                            distance += s * s;
+                        } else if(center[i] > max[i]) {
+                            float s = center[i] - max[i];
+                            distance += s * s;
+                        }
+                    }
+
+                    if(distance <= radius * radius) {
+                        m_pairs.push_back(std::make_pair(index, l));
+                    }
+                }
+            }
+        }
+    }
+
+    // Counting sort keeps the lights of each cluster in the input order
+    for(auto &it : m_clusters) {
+        it.offset = 0;
+        it.count = 0;
+    }
+    for(auto &it : m_pairs) {
+        m_clusters[it.first].count++;
+    }
+
+    uint32_t offset = 0;
+    for(auto &it : m_clusters) {
+        it.offset = offset;
+        offset += it.count;
+        it.count = 0;
+    }
+
+    m_indices.resize(m_pairs.size());
+    for(auto &it : m_pairs) {
+        Cluster &cluster = m_clusters[it.first];
+        m_indices[cluster.offset + cluster.count] = it.second;
+        cluster.count++;
+    }
+}
+/*!
+    Returns the index of the depth slice which contains a view space \a depth or -1 if the depth is outside of the clipping planes.
+*/
+int32_t LightClusters::slice(float depth) const {
+    if(depth < m_near || depth > m_far) {
+        return -1;
+    }
+    int32_t result = static_cast<int32_t>(floor(log(depth / m_near) * m_logScale));
+    return MIN(result, static_cast<int32_t>(m_sizeZ) - 1);
+}
+/*!
+    Returns the linear index of the cluster with tile coordinates \a x, \a y and slice \a z.
+*/
+uint32_t LightClusters::clusterIndex(uint32_t x, uint32_t y, uint32_t z) const {
+    return (z * m_sizeY + y) * m_sizeX + x;
+}
+/*!
+    Returns the view space bounding box of the cluster with tile coordinates \a x, \a y and slice \a z.
+*/
+AABBox LightClusters::clusterBound(uint32_t x, uint32_t y, uint32_t z) const {
+    uint32_t index = clusterIndex(x, y, z);
+
+    AABBox result;
+    result.setBox(m_bounds[index * 2], m_bounds[index * 2 + 1]);
+    return result;
+}
+/*!
+    Returns the list of clusters, each cluster refers to a range in indices().
+*/
+const std::vector<LightClusters::Cluster> &LightClusters::clusters() const {
+    return m_clusters;
+}
+/*!
+    Returns the flat list of light indices referenced by clusters().
+*/
+const std::vector<uint32_t> &LightClusters::indices() const {
+    return m_indices;
+}
+/*!
+    \internal
+    Recalculates view space bounding boxes of all clusters.
+*/
+void LightClusters::updateBounds() {
+    m_logScale = m_sizeZ / log(m_far / m_near);
+
+    m_clusters.resize(m_sizeX * m_sizeY * m_sizeZ);
+    m_bounds.resize(m_clusters.size() * 2);
+
+    for(uint32_t z = 0; z < m_sizeZ; z++) {
+        float d0 = sliceDepth(z);
+        float d1 = sliceDepth(z + 1);
+
+        for(uint32_t y = 0; y < m_sizeY; y++) {
+            float y0 = (static_cast<float>(y) / m_sizeY) * 2.0f - 1.0f;
+            float y1 = (static_cast<float>(y + 1) / m_sizeY) * 2.0f - 1.0f;
+
+            for(uint32_t x = 0; x < m_sizeX; x++) {
+                float x0 = (static_cast<float>(x) / m_sizeX) * 2.0f - 1.0f;
+                float x1 = (static_cast<float>(x + 1) / m_sizeX) * 2.0f - 1.0f;
+
+                Vector3 min, max;
+                if(m_ortho) {
+                    min = Vector3(x0 * m_tanX, y0 * m_tanY, -d1);
+                    max = Vector3(x1 * m_tanX, y1 * m_tanY, -d0);
+                } else {
+                    // The tile edges diverge with the distance so the box must enclose both slice planes
+                    min = Vector3(MIN(x0 * d0, x0 * d1) * m_tanX, MIN(y0 * d0, y0 * d1) * m_tanY, -d1);
+                    max = Vector3(MAX(x1 * d0, x1 * d1) * m_tanX, MAX(y1 * d0, y1 * d1) * m_tanY, -d0);
+                }
+
+                uint32_t index = clusterIndex(x, y, z);
+                m_bounds[index * 2] = min;
+                m_bounds[index * 2 + 1] = max;
+            }
+        }
+    }
+}
+/*!
+    \internal
+    Returns the view space depth of the near border of the slice \a z.
+*/
+float LightClusters::sliceDepth(uint32_t z) const {
+    return m_near * pow(m_far / m_near, static_cast<float>(z) / m_sizeZ);
+}
@@ -0,0 +1,723 @@
+#include "utils/meshoptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+namespace {
+    const uint32_t gCacheSize = 32;
+    const uint32_t gSimulatedCacheSize = 16;
+
+    const float gCacheDecayPower = 1.5f;
+    const float gLastTriangleScore = 0.75f;
+    const float gValenceBoostScale = 2.0f;
+    const float gValenceBoostPower = 0.5f;
+
+    const uint32_t gInvalid = UINT32_MAX;
+
+    // Half floats keep at least 1/1024 precision in this range
+    const float gQuantizedUvRange = 2.0f;
+
+    struct Quadric {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a03 = 0.0;
+        double a11 = 0.0, a12 = 0.0, a13 = 0.0;
+        double a22 = 0.0, a23 = 0.0;
+        double a33 = 0.0;
+
+        void addPlane(const Vector3 &n, float d) {
+            a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z; a03 += n.x * d;
+            a11 += n.y * n.y; a12 += n.y * n.z; a13 += n.y * d;
+            a22 += n.z * n.z; a23 += n.z * d;
+            a33 += d * d;
+        }
+
+        void add(const Quadric &q) {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+        }
+
+        double error(const Vector3 &v) const {
+            double x = v.x, y = v.y, z = v.z;
+            double result = a00 * x * x + 2.0 * (a01 * x * y + a02 * x * z + a03 * x) +
+                            a11 * y * y + 2.0 * (a12 * y * z + a13 * y) +
+                            a22 * z * z + 2.0 * a23 * z +
+                            a33;
+            return MAX(result, 0.0);
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+};
+
+static float vertexScore(int32_t position, uint32_t triangles) {
+    if(triangles == 0) {
+        return -1.0f;
+    }
+
+    float result = 0.0f;
+    if(position >= 0) {
+        if(position < 3) {
+            result = gLastTriangleScore;
+        } else {
+            float scale = 1.0f / (gCacheSize - 3);
+            result = powf(1.0f - (position - 3) * scale, gCacheDecayPower);
+        }
+    }
+
+    return result + gValenceBoostScale * powf(static_cast<float>(triangles), -gValenceBoostPower);
+}
+
+template<typename T>
+static void remapVector(std::vector<T> &data, const std::vector<uint32_t> &remap, uint32_t count) {
+    if(data.empty()) {
+        return;
+    }
+    data.resize(remap.size());
+
+    std::vector<T> result(count);
+    for(uint32_t i = 0; i < remap.size(); i++) {
+        if(remap[i] != gInvalid) {
+            result[remap[i]] = data[i];
+        }
+    }
+    data.swap(result);
+}
+
+/*!
+    \class MeshOptimizer
+    \brief Import time optimizations of the Mesh geometry.
+    \inmodule Engine
+
+    The triangles are reordered to reuse the post-transform vertex cache of the GPU and to reduce overdraw.
+    Then the vertices are reordered in the order of the first use to improve memory locality of the vertex fetch.
+    The class also provides conversions to the compact vertex formats used by quantized meshes.
+*/
+
+/*!
+    Optimizes all sub meshes of the \a mesh for the vertex cache and overdraw, then reorders the vertices for the vertex fetch.
+    The rendering result remains the same.
+*/
+void MeshOptimizer::optimize(Mesh &mesh) {
+    PROFILE_FUNCTION();
+
+    IndexVector &indices = mesh.indices();
+    const Vector3Vector &vertices = mesh.vertices();
+    if(indices.empty() || vertices.empty()) {
+        return;
+    }
+
+    for(int sub = 0; sub < mesh.subMeshCount(); sub++) {
+        uint32_t start = mesh.indexStart(sub);
+        uint32_t count = mesh.indexCount(sub);
+
+        optimizeVertexCache(&indices[start], count, vertices.size());
+        optimizeOverdraw(&indices[start], count, vertices.data(), vertices.size());
+    }
+
+    optimizeVertexFetch(mesh);
+}
+/*!
+    Reorders the triangles of the \a indices list with \a count elements for the post-transform vertex cache.
+    The \a vertexCount is the number of vertices referenced by indices.
+    Uses the linear-speed vertex cache optimisation algorithm by Tom Forsyth.
+*/
+void MeshOptimizer::optimizeVertexCache(uint32_t *indices, uint32_t count, uint32_t vertexCount) {
+    PROFILE_FUNCTION();
+
+    uint32_t triangles = count / 3;
+    if(triangles < 2) {
+        return;
+    }
+
+    // Adjacency of vertices to triangles
+    std::vector<uint32_t> active(vertexCount, 0);
+    for(uint32_t i = 0; i < triangles * 3; i++) {
+        active[indices[i]]++;
+    }
+
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for(uint32_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + active[v];
+    }
+
+    std::vector<uint32_t> adjacency(triangles * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for(uint32_t i = 0; i < triangles * 3; i++) {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<int32_t> positions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for(uint32_t v = 0; v < vertexCount; v++) {
+        vertexScores[v] = vertexScore(-1, active[v]);
+    }
+
+    int32_t best = -1;
+    float bestScore = -1.0f;
+
+    for(uint32_t t = 0; t < triangles; t++) {
+        const uint32_t *triangle = &indices[t * 3];
+        float score = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+        if(score > bestScore) {
+            bestScore = score;
+            best = t;
+        }
+    }
+
+    std::vector<uint8_t> emitted(triangles, 0);
+    std::vector<uint32_t> result(triangles * 3);
+
+    uint32_t cache[gCacheSize + 3];
+    uint32_t cacheCount = 0;
+
+    uint32_t cursor = 0;
+    for(uint32_t out = 0; out < triangles; out++) {
+        if(best < 0) {
+            // No candidates in the cache, continue from the next not emitted triangle
+            while(emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+
+        const uint32_t *triangle = &indices[best * 3];
+        memcpy(&result[out * 3], triangle, sizeof(uint32_t) * 3);
+        emitted[best] = 1;
+
+        uint32_t next[gCacheSize + 3];
+        uint32_t nextCount = 0;
+
+        for(uint32_t k = 0; k < 3; k++) {
+            uint32_t v = triangle[k];
+
+            // Remove the triangle from the list of active triangles of the vertex
+            uint32_t *list = &adjacency[offsets[v]];
+            for(uint32_t i = 0; i < active[v]; i++) {
+                if(list[i] == static_cast<uint32_t>(best)) {
+                    std::swap(list[i], list[active[v] - 1]);
+                    active[v]--;
+                    break;
+                }
+            }
+
+            if(std::find(next, next + nextCount, v) == next + nextCount) {
+                next[nextCount++] = v;
+            }
+        }
+
+        for(uint32_t i = 0; i < cacheCount; i++) {
+            uint32_t v = cache[i];
+            if(v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                next[nextCount++] = v;
+            }
+        }
+
+        cacheCount = MIN(nextCount, gCacheSize);
+        for(uint32_t i = 0; i < nextCount; i++) {
+            uint32_t v = next[i];
+            positions[v] = (i < gCacheSize) ? static_cast<int32_t>(i) : -1;
+            vertexScores[v] = vertexScore(positions[v], active[v]);
+            if(i < gCacheSize) {
+                cache[i] = v;
+            }
+        }
+
+        // Only the triangles which touch the updated vertices can change the score
+        best = -1;
+        bestScore = -1.0f;
+        for(uint32_t i = 0; i < nextCount; i++) {
+            uint32_t v = next[i];
+            const uint32_t *list = &adjacency[offsets[v]];
+            for(uint32_t j = 0; j < active[v]; j++) {
+                uint32_t t = list[j];
+                const uint32_t *candidate = &indices[t * 3];
+                float score = vertexScores[candidate[0]] + vertexScores[candidate[1]] + vertexScores[candidate[2]];
+                if(score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+
+    memcpy(indices, result.data(), sizeof(uint32_t) * result.size());
+}
+/*!
+    Reorders the clusters of triangles in the \a indices list with \a count elements to reduce overdraw.
+    The clusters are split at the places where the vertex cache is restarted, so the cache efficiency is kept.
+    The clusters which face outward of the mesh center are drawn first, they have more chances to occlude the rest.
+    The \a vertices array with \a vertexCount elements contains the vertex positions.
+*/
+void MeshOptimizer::optimizeOverdraw(uint32_t *indices, uint32_t count, const Vector3 *vertices, uint32_t vertexCount) {
+    PROFILE_FUNCTION();
+
+    uint32_t triangles = count / 3;
+    if(triangles < 2) {
+        return;
+    }
+
+    std::vector<uint32_t> clusters;
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = gSimulatedCacheSize + 1;
+    for(uint32_t t = 0; t < triangles; t++) {
+        uint32_t misses = 0;
+        for(uint32_t k = 0; k < 3; k++) {
+            uint32_t v = indices[t * 3 + k];
+            if(time - timestamps[v] > gSimulatedCacheSize) {
+                timestamps[v] = time++;
+                misses++;
+            }
+        }
+        if(t == 0 || misses == 3) {
+            clusters.push_back(t);
+        }
+    }
+    if(clusters.size() < 2) {
+        return;
+    }
+    clusters.push_back(triangles);
+
+    uint32_t clusterCount = clusters.size() - 1;
+
+    std::vector<Vector3> centers(clusterCount);
+    std::vector<Vector3> normals(clusterCount);
+
+    Vector3 meshCenter;
+    float meshArea = 0.0f;
+    for(uint32_t c = 0; c < clusterCount; c++) {
+        Vector3 center;
+        Vector3 normal;
+        float area = 0.0f;
+        for(uint32_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const Vector3 &a = vertices[indices[t * 3]];
+            const Vector3 &b = vertices[indices[t * 3 + 1]];
+            const Vector3 &d = vertices[indices[t * 3 + 2]];
+
+            Vector3 n = (b - a).cross(d - a);
+            float s = n.length();
+
+            center += (a + b + d) * (s / 3.0f);
+            normal += n;
+            area += s;
+        }
+
+        meshCenter += center;
+        meshArea += area;
+
+        centers[c] = (area > 0.0f) ? center * (1.0f / area) : center;
+        normal.normalize();
+        normals[c] = normal;
+    }
+    if(meshArea > 0.0f) {
+        meshCenter = meshCenter * (1.0f / meshArea);
+    }
+
+    std::vector<float> keys(clusterCount);
+    std::vector<uint32_t> order(clusterCount);
+    for(uint32_t c = 0; c < clusterCount; c++) {
+        keys[c] = (centers[c] - meshCenter).dot(normals[c]);
+        order[c] = c;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t left, uint32_t right) {
+        return keys[left] > keys[right];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(triangles * 3);
+    for(uint32_t c : order) {
+        result.insert(result.end(), &indices[clusters[c] * 3], &indices[clusters[c + 1] * 3]);
+    }
+
+    memcpy(indices, result.data(), sizeof(uint32_t) * result.size());
+}
+/*!
+    Reorders the vertices of the \a mesh in the order of the first use by indices and updates the indices.
+    The vertices which are not referenced by any index are removed.
+*/
+void MeshOptimizer::optimizeVertexFetch(Mesh &mesh) {
+    PROFILE_FUNCTION();
+
+    IndexVector &indices = mesh.indices();
+    uint32_t vertexCount = mesh.vertices().size();
+
+    std::vector<uint32_t> remap(vertexCount, gInvalid);
+    uint32_t next = 0;
+    for(auto &it : indices) {
+        if(remap[it] == gInvalid) {
+            remap[it] = next++;
+        }
+        it = remap[it];
+    }
+
+    remapVector(mesh.vertices(), remap, next);
+    remapVector(mesh.normals(), remap, next);
+    remapVector(mesh.tangents(), remap, next);
+    remapVector(mesh.colors(), remap, next);
+    remapVector(mesh.uv0(), remap, next);
+    remapVector(mesh.uv1(), remap, next);
+    remapVector(mesh.weights(), remap, next);
+    remapVector(mesh.bones(), remap, next);
+}
+/*!
+    Generates up to \a count levels of detail for the \a mesh, each one has about \a ratio triangles of the previous one.
+    The \a error limits the geometric deviation of the first level relative to the mesh size, it's doubled for every next level.
+    The levels reuse the vertices of the mesh, so only the indices are added.
+    The generation stops when the simplification can't reduce the triangle count noticeably.
+*/
+void MeshOptimizer::generateLods(Mesh &mesh, uint32_t count, float ratio, float error) {
+    PROFILE_FUNCTION();
+
+    mesh.clearLods();
+
+    const IndexVector &indices = mesh.indices();
+    const Vector3Vector &vertices = mesh.vertices();
+    if(indices.empty() || vertices.empty()) {
+        return;
+    }
+
+    uint32_t subs = mesh.subMeshCount();
+
+    std::vector<IndexVector> previous(subs);
+    for(uint32_t s = 0; s < subs; s++) {
+        auto begin = indices.begin() + mesh.indexStart(s);
+        previous[s].assign(begin, begin + mesh.indexCount(s));
+    }
+
+    float screenSize = 1.0f;
+    for(uint32_t lod = 1; lod <= count; lod++) {
+        screenSize *= ratio;
+
+        IndexVector lodIndices;
+        IndexVector lodOffsets;
+        uint32_t previousCount = 0;
+        for(uint32_t s = 0; s < subs; s++) {
+            IndexVector &sub = previous[s];
+            previousCount += sub.size();
+
+            uint32_t target = static_cast<uint32_t>(sub.size() / 3 * ratio) * 3;
+            sub = simplify(sub.data(), sub.size(), vertices.data(), vertices.size(), target, error);
+            optimizeVertexCache(sub.data(), sub.size(), vertices.size());
+
+            lodOffsets.push_back(lodIndices.size());
+            lodIndices.insert(lodIndices.end(), sub.begin(), sub.end());
+        }
+
+        if(lodIndices.size() > previousCount * 0.9f) {
+            break;
+        }
+
+        mesh.addLod(lodIndices, lodOffsets, screenSize);
+
+        error *= 2.0f;
+    }
+}
+/*!
+    Simplifies the triangles of the \a indices list with \a count elements and returns the new indices.
+    The \a vertices array with \a vertexCount elements contains the vertex positions.
+    The edges are collapsed in order of the quadric error until the number of indices reaches \a targetCount
+    or the next collapse exceeds the \a targetError relative to the mesh size.
+    The vertices are never moved, so the result can reuse the original vertex buffer.
+    Borders and attribute seams (vertices with the same position) are locked to keep the appearance.
+*/
+IndexVector MeshOptimizer::simplify(const uint32_t *indices, uint32_t count, const Vector3 *vertices, uint32_t vertexCount, uint32_t targetCount, float targetError) {
+    PROFILE_FUNCTION();
+
+    IndexVector result(indices, indices + (count / 3) * 3);
+    if(result.size() <= targetCount) {
+        return result;
+    }
+
+    // Vertices with the same position are the seams between attributes
+    std::vector<uint32_t> welded(vertexCount);
+    std::vector<uint32_t> siblings(vertexCount, 0);
+    {
+        std::map<std::tuple<float, float, float>, uint32_t> positions;
+        for(uint32_t v = 0; v < vertexCount; v++) {
+            auto it = positions.emplace(std::make_tuple(vertices[v].x, vertices[v].y, vertices[v].z), v).first;
+            welded[v] = it->second;
+            siblings[it->second]++;
+        }
+    }
+
+    std::vector<uint8_t> locked(vertexCount, 0);
+    {
+        std::map<uint64_t, uint32_t> edges;
+        for(uint32_t i = 0; i < result.size(); i++) {
+            uint32_t a = welded[result[i]];
+            uint32_t b = welded[result[(i % 3 == 2) ? i - 2 : i + 1]];
+            uint64_t key = (static_cast<uint64_t>(MIN(a, b)) << 32) | MAX(a, b);
+            edges[key]++;
+        }
+        for(auto &it : edges) {
+            if(it.second == 1) {
+                locked[it.first >> 32] = 1;
+                locked[it.first & 0xFFFFFFFF] = 1;
+            }
+        }
+        for(uint32_t v = 0; v < vertexCount; v++) {
+            if(siblings[welded[v]] > 1 || locked[welded[v]]) {
+                locked[v] = 1;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    Vector3 min(vertices[result[0]]);
+    Vector3 max(min);
+    for(uint32_t i = 0; i < result.size(); i += 3) {
+        const Vector3 &p0 = vertices[result[i]];
+        const Vector3 &p1 = vertices[result[i + 1]];
+        const Vector3 &p2 = vertices[result[i + 2]];
+
+        Vector3 n = (p1 - p0).cross(p2 - p0);
+        if(n.normalize() > 0.0f) {
+            float d = -n.dot(p0);
+            for(uint32_t k = 0; k < 3; k++) {
+                quadrics[result[i + k]].addPlane(n, d);
+            }
+        }
+
+        for(uint32_t k = 0; k < 3; k++) {
+            const Vector3 &p = vertices[result[i + k]];
+            for(int c = 0; c < 3; c++) {
+                min[c] = MIN(min[c], p[c]);
+                max[c] = MAX(max[c], p[c]);
+            }
+        }
+    }
+
+    Vector3 size(max - min);
+    double limit = targetError * MAX(size.x, MAX(size.y, size.z));
+    limit *= limit;
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+
+    while(result.size() > targetCount) {
+        uint32_t triangles = result.size() / 3;
+
+        // Adjacency of vertices to triangles
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for(auto it : result) {
+            offsets[it + 1]++;
+        }
+        for(uint32_t v = 0; v < vertexCount; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for(uint32_t i = 0; i < result.size(); i++) {
+                adjacency[fill[result[i]]++] = i / 3;
+            }
+        }
+
+        collapses.clear();
+        for(uint32_t i = 0; i < result.size(); i++) {
+            uint32_t a = result[i];
+            uint32_t b = result[(i % 3 == 2) ? i - 2 : i + 1];
+            if(!locked[a]) {
+                collapses.push_back({a, b, quadrics[a].error(vertices[b])});
+            }
+            if(!locked[b]) {
+                collapses.push_back({b, a, quadrics[b].error(vertices[a])});
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &left, const Collapse &right) {
+            return left.cost < right.cost;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), 0);
+
+        uint32_t removed = 0;
+        for(auto &it : collapses) {
+            if(triangles - removed <= targetCount / 3 || it.cost > limit) {
+                break;
+            }
+            if(touched[it.from] || touched[it.to]) {
+                continue;
+            }
+
+            // Reject the collapse if any of remaining triangles flips
+            bool flip = false;
+            for(uint32_t j = offsets[it.from]; j < offsets[it.from + 1] && !flip; j++) {
+                const uint32_t *triangle = &result[adjacency[j] * 3];
+                if(triangle[0] == it.to || triangle[1] == it.to || triangle[2] == it.to) {
+                    continue;
+                }
+
+                Vector3 p[3];
+                Vector3 q[3];
+                for(uint32_t k = 0; k < 3; k++) {
+                    p[k] = vertices[triangle[k]];
+                    q[k] = (triangle[k] == it.from) ? vertices[it.to] : p[k];
+                }
+                Vector3 n0 = (p[1] - p[0]).cross(p[2] - p[0]);
+                Vector3 n1 = (q[1] - q[0]).cross(q[2] - q[0]);
+                flip = (n0.dot(n1) <= 0.0f);
+            }
+            if(flip) {
+                continue;
+            }
+
+            remap[it.from] = it.to;
+            quadrics[it.to].add(quadrics[it.from]);
+
+            for(uint32_t j = offsets[it.from]; j < offsets[it.from + 1]; j++) {
+                const uint32_t *triangle = &result[adjacency[j] * 3];
+                for(uint32_t k = 0; k < 3; k++) {
+                    touched[triangle[k]] = 1;
+                }
+                if(triangle[0] == it.to || triangle[1] == it.to || triangle[2] == it.to) {
+                    removed++;
+                }
+            }
+        }
+
+        if(removed == 0) {
+            break;
+        }
+
+        uint32_t size = 0;
+        for(uint32_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = remap[result[i]];
+            uint32_t b = remap[result[i + 1]];
+            uint32_t c = remap[result[i + 2]];
+            if(a != b && b != c && a != c) {
+                result[size++] = a;
+                result[size++] = b;
+                result[size++] = c;
+            }
+        }
+        result.resize(size);
+    }
+
+    return result;
+}
+/*!
+    Returns the average number of the vertex shader invocations per triangle for the \a indices list with \a count elements.
+    The \a vertexCount is the number of vertices referenced by indices.
+    Simulates FIFO vertex cache with \a cacheSize entries, the result is between 0.5 in the best case and 3.0 in the worst case.
+*/
+float MeshOptimizer::cacheMissRatio(const uint32_t *indices, uint32_t count, uint32_t vertexCount, uint32_t cacheSize) {
+    uint32_t triangles = count / 3;
+    if(triangles == 0) {
+        return 0.0f;
+    }
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    for(uint32_t i = 0; i < triangles * 3; i++) {
+        uint32_t v = indices[i];
+        if(time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            misses++;
+        }
+    }
+
+    return static_cast<float>(misses) / triangles;
+}
+/*!
+    Returns true if the \a mesh can be quantized without a visible loss of the texture coordinates precision; otherwise returns false.
+    The uv0 coordinates are stored as half floats, so the meshes with tiled coordinates out of the [-2, 2] range must keep the full floats.
+*/
+bool MeshOptimizer::isQuantizable(Mesh &mesh) {
+    for(auto &it : mesh.uv0()) {
+        if(fabsf(it.x) > gQuantizedUvRange || fabsf(it.y) > gQuantizedUvRange) {
+            return false;
+        }
+    }
+    return true;
+}
+/*!
+    Packs the normalized \a vector to four signed normalized bytes, the fourth byte is zero.
+*/
+uint32_t MeshOptimizer::packSnorm(const Vector3 &vector) {
+    uint32_t result = 0;
+    for(int i = 0; i < 3; i++) {
+        int8_t value = static_cast<int8_t>(roundf(CLAMP(vector[i], -1.0f, 1.0f) * 127.0f));
+        result |= static_cast<uint32_t>(static_cast<uint8_t>(value)) << (i * 8);
+    }
+    return result;
+}
+/*!
+    Unpacks the vector packed with packSnorm() from the \a value.
+*/
+Vector3 MeshOptimizer::unpackSnorm(uint32_t value) {
+    Vector3 result;
+    for(int i = 0; i < 3; i++) {
+        int8_t component = static_cast<int8_t>((value >> (i * 8)) & 0xFF);
+        result[i] = MAX(component / 127.0f, -1.0f);
+    }
+    return result;
+}
+/*!
+    Converts the \a value to the IEEE 754 half precision float with rounding to the nearest even.
+*/
+uint16_t MeshOptimizer::packHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t abs = bits & 0x7FFFFFFF;
+
+    if(abs >= 0x7F800000) { // Inf or NaN
+        return sign | 0x7C00 | ((abs > 0x7F800000) ? 0x0200 : 0);
+    }
+    if(abs >= 0x477FF000) { // Overflow
+        return sign | 0x7C00;
+    }
+    if(abs < 0x38800000) { // Subnormal
+        uint32_t shift = 126 - (abs >> 23);
+        if(shift > 24) {
+            return sign;
+        }
+        uint32_t mantissa = (abs & 0x007FFFFF) | 0x00800000;
+        return sign | static_cast<uint16_t>((mantissa + (1U << (shift - 1))) >> shift);
+    }
+
+    abs -= 0x38000000;
+    return sign | static_cast<uint16_t>((abs + 0x0FFF + ((abs >> 13) & 1)) >> 13);
+}
+/*!
+    Converts the IEEE 754 half precision float \a value to the single precision float.
+*/
+float MeshOptimizer::unpackHalf(uint16_t value) {
+    uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x03FF;
+
+    if(exponent == 0) {
+        float result = mantissa * (1.0f / 16777216.0f);
+        return sign ? -result : result;
+    }
+
+    uint32_t bits;
+    if(exponent == 31) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
+}
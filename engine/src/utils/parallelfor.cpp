@@ -0,0 +1,100 @@
+#include "utils/parallelfor.h"
+
+#include <threadpool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace {
+    struct Batch {
+        Batch(const ParallelFor::Function &function, uint32_t count) :
+                function(function),
+                count(count),
+                next(0),
+                done(0) {
+
+        }
+
+        void execute() {
+            uint32_t index;
+            while((index = next.fetch_add(1)) < count) {
+                function(index);
+
+                if(done.fetch_add(1) + 1 == count) {
+                    std::unique_lock<std::mutex> locker(mutex);
+                    condition.notify_all();
+                }
+            }
+        }
+
+        const ParallelFor::Function &function;
+
+        uint32_t count;
+
+        std::atomic<uint32_t> next;
+
+        std::atomic<uint32_t> done;
+
+        std::mutex mutex;
+
+        std::condition_variable condition;
+    };
+
+    class Runner : public Object {
+    public:
+        explicit Runner(const std::shared_ptr<Batch> &batch) :
+                m_batch(batch) {
+
+        }
+
+        void processEvents() override {
+            m_batch->execute();
+
+            delete this;
+        }
+
+    private:
+        std::shared_ptr<Batch> m_batch;
+
+    };
+};
+
+/*!
+    \class ParallelFor
+    \brief Distributes the iterations of a loop over the worker threads of a ThreadPool.
+    \inmodule Engine
+
+    The calling thread takes part in the work, so the loop doesn't stall if all of the workers are busy with other tasks.
+    Only the iterations of the current loop are awaited, unlike the ThreadPool::waitForDone() which waits for all tasks of the pool.
+    This allows to share the single engine pool between the systems and to call run() from the pool worker itself.
+*/
+
+/*!
+    Calls the \a function for each index in the range [0, \a count) using the thread \a pool.
+    The iterations are processed on the calling thread in case of the \a pool is nullptr.
+    Returns when all of the iterations are finished.
+*/
+void ParallelFor::run(ThreadPool *pool, uint32_t count, const Function &function) {
+    PROFILE_FUNCTION();
+
+    uint32_t helpers = (pool && count > 1) ? MIN(uint32_t(pool->maxThreads()), count - 1) : 0;
+    if(helpers == 0) {
+        for(uint32_t i = 0; i < count; i++) {
+            function(i);
+        }
+        return;
+    }
+
+    // The runners may be dequeued after the loop is finished, so the state is shared with them
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>(function, count);
+    for(uint32_t i = 0; i < helpers; i++) {
+        pool->start(*(new Runner(batch)));
+    }
+
+    batch->execute();
+
+    std::unique_lock<std::mutex> locker(batch->mutex);
+    batch->condition.wait(locker, [&batch]() { return batch->done == batch->count; });
+}
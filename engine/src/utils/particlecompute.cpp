@@ -0,0 +1,247 @@
+#include "utils/particlecompute.h"
+
+#include <cstddef>
+#include <sstream>
+
+namespace {
+    enum Buffers {
+        Particles,
+        Render,
+        Emitter,
+        Constants,
+        Locals
+    };
+
+    enum Stages {
+        SpawnStage,
+        UpdateStage,
+        RenderStage
+    };
+
+    const char *gBufferNames[] = {"p", "r", "emitter", "k", "l"};
+};
+
+struct Location {
+    int32_t buffer;
+
+    int32_t offset;
+
+    bool lane;
+};
+
+static bool locate(const ParticleProgram::Register &reg, int32_t component, int32_t base, int32_t stage, const ParticleProgram::Context &layout, Location &location) {
+    int32_t c = (reg.size == 1) ? 0 : component;
+
+    switch(reg.space) {
+        case ParticleProgram::Emitter: location = {Emitter, reg.offset + c, false}; return true;
+        case ParticleProgram::Particle: location = {Particles, (reg.offset + c) * layout.capacity, true}; return true;
+        case ParticleProgram::Local: location = {Locals, c, false}; return true;
+        case ParticleProgram::Constant: location = {Constants, base + reg.offset + MIN(c, 3), false}; return true;
+        case ParticleProgram::Random: location = {Constants, base + reg.offset + MIN(c, 3) * layout.capacity, true}; return true;
+        case ParticleProgram::Renderable: {
+            // Only the render stage has an output slot for the renderable
+            if(stage == RenderStage) {
+                location = {Render, reg.offset + c, true};
+                return true;
+            }
+        } break;
+        default: break;
+    }
+
+    return false;
+}
+
+static bool operands(const ParticleProgram::Instruction &it, int32_t c, int32_t base, int32_t stage, const ParticleProgram::Context &layout, Location locations[3]) {
+    // The emitter attributes are shared by all invocations and can't be written by a particle
+    if(it.result.space == ParticleProgram::Emitter || !locate(it.result, c, base, stage, layout, locations[0])) {
+        return false;
+    }
+
+    for(int32_t b = 0; b < 2; b++) {
+        const ParticleProgram::Register &argument = it.arguments[b];
+        if(!locate(argument, c, base, stage, layout, locations[b + 1])) {
+            locate(it.result, (argument.size == 1) ? 0 : c, base, stage, layout, locations[b + 1]);
+        }
+    }
+
+    return true;
+}
+
+static void generate(std::stringstream &out, const ParticleProgram &program, int32_t base, int32_t stage, const ParticleProgram::Context &layout) {
+    static const char *operations[] = {"", " + ", " - ", " * ", " / "};
+
+    auto name = [](const Location &location) {
+        std::stringstream result;
+        result << gBufferNames[location.buffer] << "[" << location.offset;
+        if(location.lane) {
+            result << (location.buffer == Render ? " + o" : " + i");
+        }
+        result << "]";
+        return result.str();
+    };
+
+    for(auto &it : program.instructions()) {
+        for(int32_t c = 0; c < it.size; c++) {
+            Location locations[3];
+            if(!operands(it, c, base, stage, layout, locations)) {
+                break;
+            }
+
+            out << "        " << name(locations[0]) << " = " << name(locations[1]);
+            if(it.op > ParticleProgram::Mov && it.op <= ParticleProgram::Div) {
+                out << operations[it.op] << name(locations[2]);
+            }
+            out << ";\n";
+        }
+    }
+}
+
+static void evaluate(const ParticleProgram &program, int32_t stage, const ParticleProgram::Context &context, int32_t i, int32_t o, float *locals) {
+    float *buffers[] = {context.particles, context.render, context.emitter, const_cast<float *>(program.constants().data()), locals};
+
+    auto value = [&](const Location &location) -> float & {
+        int32_t lane = 0;
+        if(location.lane) {
+            lane = (location.buffer == Render) ? o * context.renderStride : i;
+        }
+        return buffers[location.buffer][location.offset + lane];
+    };
+
+    for(auto &it : program.instructions()) {
+        for(int32_t c = 0; c < it.size; c++) {
+            Location locations[3];
+            if(!operands(it, c, 0, stage, context, locations)) {
+                break;
+            }
+
+            float a = value(locations[1]);
+            float b = value(locations[2]);
+
+            float result = a;
+            switch(it.op) {
+                case ParticleProgram::Add: result = a + b; break;
+                case ParticleProgram::Sub: result = a - b; break;
+                case ParticleProgram::Mul: result = a * b; break;
+                case ParticleProgram::Div: result = a / b; break;
+                default: break;
+            }
+
+            value(locations[0]) = result;
+        }
+    }
+}
+
+/*!
+    \class ParticleCompute
+    \brief Translates the particle programs of the VisualEffect to a compute kernel.
+    \inmodule Engine
+
+    The GPU simulation keeps the particle attributes resident in the compute buffers with the same structure of arrays layout as the CPU path.
+    Each invocation of the kernel processes one particle slot: a dead slot is respawned while the spawn request is not exhausted,
+    then the live particle is updated and appends its renderable to the render buffer.
+    The number of the appended renderables is written directly to the indirect draw arguments, so the simulation results are never read back.
+
+    In contrast to the CPU path the particles are not moved between the slots, so the order of the renderables is not defined.
+    The emitter attributes are shared by all invocations and can't be modified by the kernel.
+
+    dispatch() executes exactly the same algorithm on the CPU; it's used to verify the GPU path against the reference CPU simulation.
+*/
+
+/*!
+    Returns GLSL source code of the compute kernel which executes \a spawn, \a update and \a render programs for the buffers with the given \a layout.
+    The constants of the programs must be provided in the buffer returned by constants().
+*/
+std::string ParticleCompute::source(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render, const ParticleProgram::Context &layout) {
+    int32_t updateBase = spawn.constants().size();
+    int32_t renderBase = updateBase + update.constants().size();
+
+    std::stringstream out;
+    out << "#version 430 core\n\n";
+    out << "layout(local_size_x = " << GroupSize << ") in;\n\n";
+    out << "layout(std430, binding = " << ParticlesBinding << ") buffer Particles { float p[]; };\n";
+    out << "layout(std430, binding = " << RenderBinding << ") buffer Renderables { float r[]; };\n";
+    out << "layout(std430, binding = " << StateBinding << ") buffer Emitter {\n";
+    out << "    float emitter[" << VisualEffect::LastAttribute << "];\n";
+    out << "    uint spawnRequest;\n";
+    out << "    uint spawned;\n";
+    out << "    uint arguments[" << LastArgument << "];\n";
+    out << "};\n";
+    out << "layout(std430, binding = " << ConstantsBinding << ") readonly buffer Constants { float k[]; };\n\n";
+
+    out << "void main() {\n";
+    out << "    uint i = gl_GlobalInvocationID.x;\n";
+    out << "    if(i >= " << layout.capacity << "u) {\n        return;\n    }\n\n";
+    out << "    float l[" << ParticleProgram::LocalRegisters << "] = float[](0.0, 0.0, 0.0, 0.0);\n\n";
+
+    out << "    if(p[i] <= 0.0) {\n";
+    if(spawn.isEmpty()) {
+        out << "        return;\n";
+    } else {
+        out << "        if(atomicAdd(spawned, 1u) >= spawnRequest) {\n            return;\n        }\n";
+        generate(out, spawn, 0, SpawnStage, layout);
+        out << "        if(p[i] <= 0.0) {\n            return;\n        }\n";
+    }
+    out << "    }\n\n";
+
+    out << "    {\n";
+    generate(out, update, updateBase, UpdateStage, layout);
+    out << "    }\n";
+    out << "    if(p[i] <= 0.0) {\n        return;\n    }\n\n";
+
+    out << "    {\n";
+    out << "        uint o = atomicAdd(arguments[" << InstanceCount << "], 1u) * " << layout.renderStride << "u;\n";
+    generate(out, render, renderBase, RenderStage, layout);
+    out << "    }\n";
+    out << "}\n";
+
+    return out.str();
+}
+/*!
+    Returns the constant pools of \a spawn, \a update and \a render programs merged in the order expected by the compute kernel.
+*/
+std::vector<float> ParticleCompute::constants(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render) {
+    std::vector<float> result(spawn.constants());
+    result.insert(result.end(), update.constants().begin(), update.constants().end());
+    result.insert(result.end(), render.constants().begin(), render.constants().end());
+    if(result.empty()) {
+        result.push_back(0.0f); // Empty storage buffers are not allowed
+    }
+    return result;
+}
+/*!
+    Executes the compute kernel algorithm for \a spawn, \a update and \a render programs on the CPU.
+    The \a context provides the particle and render buffers, the emitter attributes, spawn request and draw arguments are taken from the \a state.
+*/
+void ParticleCompute::dispatch(const ParticleProgram &spawn, const ParticleProgram &update, const ParticleProgram &render, const ParticleProgram::Context &context, State &state) {
+    ParticleProgram::Context local(context);
+    local.emitter = state.emitter;
+
+    for(int32_t i = 0; i < context.capacity; i++) {
+        float locals[ParticleProgram::LocalRegisters] = {0.0f};
+
+        float &age = context.particles[i];
+        if(age <= 0.0f) {
+            if(spawn.isEmpty() || state.spawned++ >= state.spawnRequest) {
+                continue;
+            }
+            evaluate(spawn, SpawnStage, local, i, 0, locals);
+            if(age <= 0.0f) {
+                continue;
+            }
+        }
+
+        evaluate(update, UpdateStage, local, i, 0, locals);
+        if(age <= 0.0f) {
+            continue;
+        }
+
+        int32_t o = state.arguments[InstanceCount]++;
+        evaluate(render, RenderStage, local, i, o, locals);
+    }
+}
+/*!
+    Returns the offset in bytes of the indirect draw arguments in the State buffer.
+*/
+uint32_t ParticleCompute::argumentsOffset() {
+    return offsetof(State, arguments);
+}
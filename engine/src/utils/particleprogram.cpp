@@ -0,0 +1,250 @@
+#include "utils/particleprogram.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define PARTICLE_SSE
+#endif
+
+namespace {
+    const int32_t gLanes = 8;
+};
+
+template<int op>
+static inline float calculate(float a, float b) {
+    switch(op) {
+        case ParticleProgram::Add: return a + b;
+        case ParticleProgram::Sub: return a - b;
+        case ParticleProgram::Mul: return a * b;
+        case ParticleProgram::Div: return a / b;
+        default: break;
+    }
+    return a;
+}
+
+#ifdef PARTICLE_SSE
+template<int op>
+static inline __m128 calculate(__m128 a, __m128 b) {
+    switch(op) {
+        case ParticleProgram::Add: return _mm_add_ps(a, b);
+        case ParticleProgram::Sub: return _mm_sub_ps(a, b);
+        case ParticleProgram::Mul: return _mm_mul_ps(a, b);
+        case ParticleProgram::Div: return _mm_div_ps(a, b);
+        default: break;
+    }
+    return a;
+}
+
+template<int step>
+static inline __m128 load(const float *data) {
+    return step ? _mm_loadu_ps(data) : _mm_set1_ps(*data);
+}
+#endif
+
+template<int op, int stepA, int stepB>
+static void contiguous(float *r, const float *a, const float *b, int32_t count) {
+    int32_t k = 0;
+#ifdef PARTICLE_SSE
+    for(; k + gLanes <= count; k += gLanes) {
+        __m128 low = calculate<op>(load<stepA>(a + k * stepA), load<stepB>(b + k * stepB));
+        __m128 high = calculate<op>(load<stepA>(a + (k + 4) * stepA), load<stepB>(b + (k + 4) * stepB));
+        _mm_storeu_ps(r + k, low);
+        _mm_storeu_ps(r + k + 4, high);
+    }
+#endif
+    for(; k < count; k++) {
+        r[k] = calculate<op>(a[k * stepA], b[k * stepB]);
+    }
+}
+
+template<int op>
+static void run(float *r, int32_t stepR, const float *a, int32_t stepA, const float *b, int32_t stepB, int32_t count) {
+    if(stepR == 1 && stepA <= 1 && stepB <= 1) {
+        if(stepA) {
+            stepB ? contiguous<op, 1, 1>(r, a, b, count) : contiguous<op, 1, 0>(r, a, b, count);
+        } else {
+            stepB ? contiguous<op, 0, 1>(r, a, b, count) : contiguous<op, 0, 0>(r, a, b, count);
+        }
+    } else {
+        // Renderables are interleaved and emitter results must see the previous lanes
+        for(int32_t k = 0; k < count; k++) {
+            r[k * stepR] = calculate<op>(a[k * stepA], b[k * stepB]);
+        }
+    }
+}
+
+/*!
+    \class ParticleProgram
+    \brief A compiled list of operations for one stage of the particle simulation.
+    \inmodule Engine
+
+    The particle attributes are stored as structure of arrays: each component of each attribute occupies a row of capacity floats.
+    The rows are followed by LocalRegisters temporary rows which are used as registers for the intermediate results.
+    Each instruction is executed for the whole range of particles at once and the address of each operand is resolved once per instruction.
+    The operands which are shared by all particles, like constants and emitter attributes, are broadcasted.
+
+    The live particles always occupy the first lanes of the buffer; compact() removes the dead ones after each stage.
+*/
+
+/*!
+    Removes all instructions and constants.
+*/
+void ParticleProgram::clear() {
+    m_instructions.clear();
+    m_constants.clear();
+}
+/*!
+    Returns true if the program contains no instructions.
+*/
+bool ParticleProgram::isEmpty() const {
+    return m_instructions.empty();
+}
+/*!
+    Returns a list of compiled instructions.
+*/
+const std::vector<ParticleProgram::Instruction> &ParticleProgram::instructions() const {
+    return m_instructions;
+}
+/*!
+    Returns the constant pool of the program.
+*/
+const std::vector<float> &ParticleProgram::constants() const {
+    return m_constants;
+}
+/*!
+    Adds a constant \a value to the constant pool.
+    Returns an offset of the constant in the pool.
+*/
+int32_t ParticleProgram::addConstant(const Vector4 &value) {
+    int32_t result = m_constants.size();
+    m_constants.insert(m_constants.end(), value.v, value.v + 4);
+    return result;
+}
+/*!
+    Adds a random value with \a size components in range [\a min, \a max] for each of \a capacity particles to the constant pool.
+    The values are stored row by row as the particle attributes.
+    Returns an offset of the first row in the pool.
+*/
+int32_t ParticleProgram::addRandom(const Vector4 &min, const Vector4 &max, int32_t size, int32_t capacity) {
+    int32_t result = m_constants.size();
+    m_constants.resize(result + 4 * capacity);
+    for(int32_t p = 0; p < capacity; p++) {
+        for(int32_t i = 0; i < size; i++) {
+            m_constants[result + i * capacity + p] = RANGE(min[i], max[i]);
+        }
+    }
+    return result;
+}
+/*!
+    Appends an \a instruction to the program.
+*/
+void ParticleProgram::addInstruction(const Instruction &instruction) {
+    m_instructions.push_back(instruction);
+}
+/*!
+    Executes the program for \a count particles starting from the \a first one using the buffers of the \a context.
+*/
+void ParticleProgram::execute(const Context &context, int32_t first, int32_t count) const {
+    if(count <= 0) {
+        return;
+    }
+
+    for(auto &it : m_instructions) {
+        for(int32_t c = 0; c < it.size; c++) {
+            int32_t stepR = 0;
+            float *r = address(context, it.result, c, first, stepR);
+            if(r == nullptr) {
+                break;
+            }
+
+            int32_t steps[2] = {stepR, stepR};
+            const float *args[2] = {r, r};
+            for(int32_t b = 0; b < 2; b++) {
+                const Register &argument = it.arguments[b];
+                const float *a = address(context, argument, c, first, steps[b]);
+                if(a) {
+                    args[b] = a;
+                } else if(argument.size == 1) { // The unbound operand is aliased to the result
+                    args[b] = address(context, it.result, 0, first, steps[b]);
+                }
+            }
+
+            switch(it.op) {
+                case Mov: run<Mov>(r, stepR, args[0], steps[0], args[1], steps[1], count); break;
+                case Add: run<Add>(r, stepR, args[0], steps[0], args[1], steps[1], count); break;
+                case Sub: run<Sub>(r, stepR, args[0], steps[0], args[1], steps[1], count); break;
+                case Mul: run<Mul>(r, stepR, args[0], steps[0], args[1], steps[1], count); break;
+                case Div: run<Div>(r, stepR, args[0], steps[0], args[1], steps[1], count); break;
+                default: break;
+            }
+        }
+    }
+}
+/*!
+    Moves the live particles of the \a context to the first lanes of the buffer.
+    A particle is alive while its first attribute (the age) is positive.
+    Returns the number of the live particles among the first \a count lanes.
+*/
+int32_t ParticleProgram::compact(const Context &context, int32_t count) {
+    float *age = context.particles;
+
+    int32_t k = 0;
+    while(k < count) {
+        if(age[k] > 0.0f) {
+            k++;
+        } else {
+            count--;
+            if(k != count) {
+                for(int32_t row = 0; row < context.stride; row++) {
+                    float *data = &context.particles[row * context.capacity];
+                    data[k] = data[count];
+                }
+            }
+        }
+    }
+
+    return count;
+}
+/*!
+    Returns a number of floats required to store the particle buffer with attribute \a stride for the \a capacity particles.
+*/
+int32_t ParticleProgram::bufferSize(int32_t stride, int32_t capacity) {
+    return (stride + LocalRegisters) * capacity;
+}
+/*!
+    \internal
+    Returns an address of the \a component of the register \a reg for the \a first particle and the \a step between the particles.
+    Returns nullptr for the registers without storage.
+*/
+float *ParticleProgram::address(const Context &context, const Register &reg, int32_t component, int32_t first, int32_t &step) const {
+    int32_t c = (reg.size == 1) ? 0 : component;
+
+    switch(reg.space) {
+        case Emitter: {
+            step = 0;
+            return &context.emitter[reg.offset + c];
+        }
+        case Particle: {
+            step = 1;
+            return &context.particles[(reg.offset + c) * context.capacity + first];
+        }
+        case Local: {
+            step = 1;
+            return &context.particles[(context.stride + c) * context.capacity + first];
+        }
+        case Renderable: {
+            step = context.renderStride;
+            return &context.render[first * context.renderStride + reg.offset + c];
+        }
+        case Constant: {
+            step = 0;
+            return const_cast<float *>(&m_constants[reg.offset + MIN(c, 3)]);
+        }
+        case Random: {
+            step = 1;
+            return const_cast<float *>(&m_constants[reg.offset + MIN(c, 3) * context.capacity + first]);
+        }
+        default: break;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,174 @@
+#include "utils/querybatch.h"
+
+/*!
+    \class QueryBatch
+    \brief Collects the spatial queries to be executed against the colliders of the World in one call.
+    \inmodule Engine
+
+    The batch supports the closest hit and the multiple hits ray casts, the sphere casts and the sphere overlaps.
+    Each query reserves the storage for its results when it's added, so the physics system can execute the queries in parallel without any synchronization.
+    The batch can be executed immediately with World::query() or deferred with World::queryDeferred(); in the last case the results are ready after the next physics update.
+
+    The hit distance is the distance from the origin of the ray to the hit point.
+    For the overlaps the distance is the penetration depth reported by the physics system and the point is located on the surface of the found collider.
+
+    \code
+        QueryBatch batch;
+        for(auto &it : targets) {
+            batch.addRayCast(Ray(origin, it), range);
+        }
+        world->query(batch);
+        for(uint32_t i = 0; i < batch.size(); i++) {
+            if(batch.hitCount(i) > 0) {
+                Object *object = batch.hit(i).object;
+                ...
+            }
+        }
+    \endcode
+*/
+
+/*!
+    \enum QueryBatch::Type
+
+    \value RayCast \c The closest hit of the ray.
+    \value RayCastAll \c All hits of the ray sorted by distance.
+    \value SphereCast \c The closest hit of the sphere moved along the ray.
+    \value Overlap \c All colliders intersected with the sphere.
+*/
+
+/*!
+    \enum QueryBatch::State
+
+    \value Idle \c The batch was not executed since the last modification.
+    \value Pending \c The batch is waiting for the deferred execution.
+    \value Ready \c The results of the batch are available.
+*/
+
+QueryBatch::QueryBatch() :
+        m_state(Idle) {
+
+}
+/*!
+    Removes all queries and results from the batch.
+*/
+void QueryBatch::clear() {
+    m_queries.clear();
+    m_hits.clear();
+    m_state = Idle;
+}
+/*!
+    Returns the number of queries in the batch.
+*/
+uint32_t QueryBatch::size() const {
+    return m_queries.size();
+}
+/*!
+    Returns the execution state of the batch.
+    For more details please see QueryBatch::State.
+*/
+int32_t QueryBatch::state() const {
+    return m_state;
+}
+/*!
+    \internal
+    Sets the execution \a state of the batch.
+*/
+void QueryBatch::setState(int32_t state) {
+    m_state = state;
+}
+/*!
+    Returns true if the results of the batch are available; otherwise returns false.
+*/
+bool QueryBatch::isReady() const {
+    return m_state == Ready;
+}
+/*!
+    Adds a query for the closest hit of the \a ray with the max \a distance.
+    Returns the index of the query.
+*/
+uint32_t QueryBatch::addRayCast(const Ray &ray, float distance) {
+    return addQuery(RayCast, ray, 0.0f, distance, 1);
+}
+/*!
+    Adds a query for up to \a maxHits hits of the \a ray with the max \a distance.
+    Returns the index of the query.
+*/
+uint32_t QueryBatch::addRayCastAll(const Ray &ray, float distance, uint32_t maxHits) {
+    return addQuery(RayCastAll, ray, 0.0f, distance, maxHits);
+}
+/*!
+    Adds a query for the closest hit of the sphere with the \a radius moved along the \a ray to the max \a distance.
+    Returns the index of the query.
+*/
+uint32_t QueryBatch::addSphereCast(const Ray &ray, float radius, float distance) {
+    return addQuery(SphereCast, ray, radius, distance, 1);
+}
+/*!
+    Adds a query for up to \a maxHits colliders which intersect the sphere with the \a center and \a radius.
+    Returns the index of the query.
+*/
+uint32_t QueryBatch::addOverlap(const Vector3 &center, float radius, uint32_t maxHits) {
+    return addQuery(Overlap, Ray(center, Vector3()), radius, 0.0f, maxHits);
+}
+/*!
+    Returns the query with the \a index.
+*/
+const QueryBatch::Query &QueryBatch::query(uint32_t index) const {
+    return m_queries[index];
+}
+/*!
+    Returns the number of hits found by the query with the \a index.
+*/
+uint32_t QueryBatch::hitCount(uint32_t index) const {
+    return m_queries[index].count;
+}
+/*!
+    Returns the hit with the \a number found by the query with the \a index.
+*/
+const Ray::Hit &QueryBatch::hit(uint32_t index, uint32_t number) const {
+    return m_hits[m_queries[index].first + number];
+}
+/*!
+    \internal
+    Returns the storage for the results of the query with the \a index.
+    The storage can hold up to Query::capacity hits.
+*/
+Ray::Hit *QueryBatch::hits(uint32_t index) {
+    return &m_hits[m_queries[index].first];
+}
+/*!
+    \internal
+    Sets the \a count of hits found by the query with the \a index.
+*/
+void QueryBatch::setHitCount(uint32_t index, uint32_t count) {
+    Query &query = m_queries[index];
+    query.count = MIN(count, query.capacity);
+}
+/*!
+    \internal
+    Resets the results of all queries before the execution.
+*/
+void QueryBatch::resetHits() {
+    for(auto &it : m_queries) {
+        it.count = 0;
+    }
+}
+/*!
+    \internal
+*/
+uint32_t QueryBatch::addQuery(int32_t type, const Ray &ray, float radius, float distance, uint32_t capacity) {
+    Query query;
+    query.ray = ray;
+    query.distance = distance;
+    query.radius = radius;
+    query.type = type;
+    query.first = m_hits.size();
+    query.capacity = MAX(capacity, 1);
+
+    m_hits.resize(m_hits.size() + query.capacity);
+    m_queries.push_back(query);
+
+    m_state = Idle;
+
+    return m_queries.size() - 1;
+}
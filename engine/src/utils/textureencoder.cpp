@@ -0,0 +1,1197 @@
+#include "utils/textureencoder.h"
+
+#include "resources/texture.h"
+
+#include "utils/parallelfor.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <climits>
+
+namespace {
+    const int32_t gParallelPixels = 256 * 256;
+
+    const int32_t gEtcModifiers[8][4] = {
+        {  2,   8,  -2,   -8},
+        {  5,  17,  -5,  -17},
+        {  9,  29,  -9,  -29},
+        { 13,  42, -13,  -42},
+        { 18,  60, -18,  -60},
+        { 24,  80, -24,  -80},
+        { 33, 106, -33, -106},
+        { 47, 183, -47, -183}
+    };
+
+    const int32_t gEacModifiers[16][8] = {
+        {-3, -6,  -9, -15, 2, 5, 8, 14},
+        {-3, -7, -10, -13, 2, 6, 9, 12},
+        {-2, -5,  -8, -13, 1, 4, 7, 12},
+        {-2, -4,  -6, -13, 1, 3, 5, 12},
+        {-3, -6,  -8, -12, 2, 5, 7, 11},
+        {-3, -7,  -9, -11, 2, 6, 8, 10},
+        {-4, -7,  -8, -11, 3, 6, 7, 10},
+        {-3, -5,  -8, -11, 2, 4, 7, 10},
+        {-2, -6,  -8, -10, 1, 5, 7,  9},
+        {-2, -5,  -8, -10, 1, 4, 7,  9},
+        {-2, -4,  -8, -10, 1, 3, 7,  9},
+        {-2, -5,  -7, -10, 1, 4, 6,  9},
+        {-3, -4,  -7, -10, 2, 3, 6,  9},
+        {-1, -2,  -3, -10, 0, 1, 2,  9},
+        {-4, -6,  -8,  -9, 3, 5, 7,  8},
+        {-3, -5,  -7,  -9, 2, 4, 6,  8}
+    };
+
+    const int32_t gBC7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    const float gBC1Weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+    const float gKaiserAlpha = 4.0f;
+
+    const float gFilterSupport[3] = {0.5f, 1.0f, 3.0f};
+
+    struct Tap {
+        int32_t index;
+        float weight;
+    };
+};
+
+inline int32_t colorDistance(const int32_t *a, const uint8_t *b, int32_t channels) {
+    int32_t result = 0;
+    for(int32_t c = 0; c < channels; c++) {
+        int32_t d = a[c] - b[c];
+        result += d * d;
+    }
+    return result;
+}
+
+inline int32_t expand4(int32_t value) {
+    return (value << 4) | value;
+}
+
+inline int32_t expand5(int32_t value) {
+    return (value << 3) | (value >> 2);
+}
+
+void principalAxis(const float *points, int32_t dim, float *mean, float *axis) {
+    for(int32_t c = 0; c < dim; c++) {
+        mean[c] = 0.0f;
+        for(int32_t i = 0; i < 16; i++) {
+            mean[c] += points[i * dim + c];
+        }
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for(int32_t i = 0; i < 16; i++) {
+        for(int32_t a = 0; a < dim; a++) {
+            float da = points[i * dim + a] - mean[a];
+            for(int32_t b = 0; b < dim; b++) {
+                covariance[a][b] += da * (points[i * dim + b] - mean[b]);
+            }
+        }
+    }
+
+    // Power iteration starting from the row with the biggest variance
+    int32_t start = 0;
+    for(int32_t c = 1; c < dim; c++) {
+        if(covariance[c][c] > covariance[start][start]) {
+            start = c;
+        }
+    }
+    for(int32_t c = 0; c < dim; c++) {
+        axis[c] = covariance[start][c];
+    }
+
+    for(int32_t n = 0; n < 8; n++) {
+        float next[4] = {};
+        float length = 0.0f;
+        for(int32_t a = 0; a < dim; a++) {
+            for(int32_t b = 0; b < dim; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            length = MAX(length, fabsf(next[a]));
+        }
+        if(length < 1e-6f) {
+            break;
+        }
+        for(int32_t c = 0; c < dim; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float length = 0.0f;
+    for(int32_t c = 0; c < dim; c++) {
+        length += axis[c] * axis[c];
+    }
+    length = sqrtf(length);
+    for(int32_t c = 0; c < dim; c++) {
+        axis[c] = (length > 1e-6f) ? axis[c] / length : 0.0f;
+    }
+}
+
+void axisEndpoints(const float *points, int32_t dim, float *e0, float *e1) {
+    float mean[4];
+    float axis[4];
+    principalAxis(points, dim, mean, axis);
+
+    float min = 0.0f;
+    float max = 0.0f;
+    for(int32_t i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for(int32_t c = 0; c < dim; c++) {
+            t += (points[i * dim + c] - mean[c]) * axis[c];
+        }
+        min = MIN(min, t);
+        max = MAX(max, t);
+    }
+
+    for(int32_t c = 0; c < dim; c++) {
+        e0[c] = CLAMP(mean[c] + axis[c] * max, 0.0f, 255.0f);
+        e1[c] = CLAMP(mean[c] + axis[c] * min, 0.0f, 255.0f);
+    }
+}
+
+bool leastSquares(const float *points, int32_t dim, const float *weights, float *e0, float *e1) {
+    float alpha2 = 0.0f;
+    float beta2 = 0.0f;
+    float alphaBeta = 0.0f;
+    float alphaX[4] = {};
+    float betaX[4] = {};
+
+    for(int32_t i = 0; i < 16; i++) {
+        float a = weights[i];
+        float b = 1.0f - a;
+        alpha2 += a * a;
+        beta2 += b * b;
+        alphaBeta += a * b;
+        for(int32_t c = 0; c < dim; c++) {
+            alphaX[c] += a * points[i * dim + c];
+            betaX[c] += b * points[i * dim + c];
+        }
+    }
+
+    float det = alpha2 * beta2 - alphaBeta * alphaBeta;
+    if(fabsf(det) < 1e-6f) {
+        return false;
+    }
+
+    for(int32_t c = 0; c < dim; c++) {
+        e0[c] = CLAMP((alphaX[c] * beta2 - betaX[c] * alphaBeta) / det, 0.0f, 255.0f);
+        e1[c] = CLAMP((betaX[c] * alpha2 - alphaX[c] * alphaBeta) / det, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+uint16_t pack565(const float *color) {
+    int32_t r = CLAMP(int32_t(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int32_t g = CLAMP(int32_t(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int32_t b = CLAMP(int32_t(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return (r << 11) | (g << 5) | b;
+}
+
+void unpack565(uint16_t value, int32_t *color) {
+    int32_t r = (value >> 11) & 31;
+    int32_t g = (value >> 5) & 63;
+    int32_t b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void paletteBC1(uint16_t c0, uint16_t c1, bool opaque, int32_t palette[4][4]) {
+    unpack565(c0, palette[0]);
+    unpack565(c1, palette[1]);
+    for(int32_t c = 0; c < 3; c++) {
+        if(opaque || c0 > c1) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = (opaque || c0 > c1) ? 255 : 0;
+}
+
+int32_t fitBC1(const uint8_t *rgba, uint16_t &c0, uint16_t &c1, uint32_t &indices) {
+    if(c0 < c1) {
+        std::swap(c0, c1);
+    }
+
+    int32_t palette[4][4];
+    paletteBC1(c0, c1, true, palette);
+
+    // Equal endpoints select the three color mode, so only the first entry is used
+    int32_t count = (c0 == c1) ? 1 : 4;
+
+    int32_t error = 0;
+    indices = 0;
+    for(int32_t i = 0; i < 16; i++) {
+        int32_t best = 0;
+        int32_t bestError = INT_MAX;
+        for(int32_t p = 0; p < count; p++) {
+            int32_t e = colorDistance(palette[p], &rgba[i * 4], 3);
+            if(e < bestError) {
+                bestError = e;
+                best = p;
+            }
+        }
+        indices |= best << (i * 2);
+        error += bestError;
+    }
+    return error;
+}
+
+void encodeBC1(const uint8_t *rgba, uint8_t *block, int32_t quality) {
+    float points[16 * 3];
+    for(int32_t i = 0; i < 16; i++) {
+        for(int32_t c = 0; c < 3; c++) {
+            points[i * 3 + c] = rgba[i * 4 + c];
+        }
+    }
+
+    float e0[3];
+    float e1[3];
+    axisEndpoints(points, 3, e0, e1);
+
+    uint16_t c0 = pack565(e0);
+    uint16_t c1 = pack565(e1);
+    uint32_t indices;
+    int32_t error = fitBC1(rgba, c0, c1, indices);
+
+    int32_t iterations = (quality == TextureEncoder::Best) ? 4 : quality;
+    for(int32_t n = 0; n < iterations && error > 0; n++) {
+        float weights[16];
+        for(int32_t i = 0; i < 16; i++) {
+            weights[i] = gBC1Weights[(indices >> (i * 2)) & 3];
+        }
+        if(!leastSquares(points, 3, weights, e0, e1)) {
+            break;
+        }
+
+        uint16_t n0 = pack565(e0);
+        uint16_t n1 = pack565(e1);
+        uint32_t nextIndices;
+        int32_t nextError = fitBC1(rgba, n0, n1, nextIndices);
+        if(nextError >= error) {
+            break;
+        }
+        c0 = n0;
+        c1 = n1;
+        indices = nextIndices;
+        error = nextError;
+    }
+
+    block[0] = c0 & 0xff;
+    block[1] = c0 >> 8;
+    block[2] = c1 & 0xff;
+    block[3] = c1 >> 8;
+    for(int32_t i = 0; i < 4; i++) {
+        block[4 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+void decodeBC1(const uint8_t *block, uint8_t *rgba, bool opaque) {
+    uint16_t c0 = block[0] | (block[1] << 8);
+    uint16_t c1 = block[2] | (block[3] << 8);
+
+    int32_t palette[4][4];
+    paletteBC1(c0, c1, opaque, palette);
+
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+    for(int32_t i = 0; i < 16; i++) {
+        int32_t *color = palette[(indices >> (i * 2)) & 3];
+        for(int32_t c = 0; c < 4; c++) {
+            rgba[i * 4 + c] = color[c];
+        }
+    }
+}
+
+void paletteBC4(int32_t a0, int32_t a1, int32_t *palette) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if(a0 > a1) {
+        for(int32_t i = 2; i < 8; i++) {
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+    } else {
+        for(int32_t i = 2; i < 6; i++) {
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+int32_t fitBC4(const int32_t *values, int32_t a0, int32_t a1, uint64_t &indices) {
+    int32_t palette[8];
+    paletteBC4(a0, a1, palette);
+
+    int32_t error = 0;
+    indices = 0;
+    for(int32_t i = 0; i < 16; i++) {
+        int32_t best = 0;
+        int32_t bestError = INT_MAX;
+        for(int32_t p = 0; p < 8; p++) {
+            int32_t d = palette[p] - values[i];
+            if(d * d < bestError) {
+                bestError = d * d;
+                best = p;
+            }
+        }
+        indices |= uint64_t(best) << (i * 3);
+        error += bestError;
+    }
+    return error;
+}
+
+void encodeBC4(const uint8_t *rgba, uint8_t *block, int32_t channel, int32_t quality) {
+    int32_t values[16];
+    int32_t min = 255;
+    int32_t max = 0;
+    for(int32_t i = 0; i < 16; i++) {
+        values[i] = rgba[i * 4 + channel];
+        min = MIN(min, values[i]);
+        max = MAX(max, values[i]);
+    }
+
+    int32_t a0 = max;
+    int32_t a1 = min;
+    uint64_t indices;
+    int32_t error = fitBC4(values, a0, a1, indices);
+
+    if(quality != TextureEncoder::Fast && max > min) {
+        // Insetting the endpoints may reduce the quantization error of the inner values
+        int32_t range = (quality == TextureEncoder::Best) ? 4 : 1;
+        for(int32_t i0 = max; i0 >= MAX(max - range, 0) && error > 0; i0--) {
+            for(int32_t i1 = min; i1 <= min + range && i1 < i0; i1++) {
+                uint64_t next;
+                int32_t e = fitBC4(values, i0, i1, next);
+                if(e < error) {
+                    error = e;
+                    a0 = i0;
+                    a1 = i1;
+                    indices = next;
+                }
+            }
+        }
+    }
+
+    if(quality == TextureEncoder::Best && error > 0) {
+        // The six values mode has the exact 0 and 255, fit the rest of the values
+        int32_t lo = 255;
+        int32_t hi = 0;
+        for(int32_t i = 0; i < 16; i++) {
+            if(values[i] != 0 && values[i] != 255) {
+                lo = MIN(lo, values[i]);
+                hi = MAX(hi, values[i]);
+            }
+        }
+        if(lo <= hi) {
+            uint64_t next;
+            int32_t e = fitBC4(values, lo, hi, next);
+            if(e < error) {
+                error = e;
+                a0 = lo;
+                a1 = hi;
+                indices = next;
+            }
+        }
+    }
+
+    block[0] = a0;
+    block[1] = a1;
+    for(int32_t i = 0; i < 6; i++) {
+        block[2 + i] = (indices >> (i * 8)) & 0xff;
+    }
+}
+
+void decodeBC4(const uint8_t *block, uint8_t *rgba, int32_t channel) {
+    int32_t palette[8];
+    paletteBC4(block[0], block[1], palette);
+
+    uint64_t indices = 0;
+    for(int32_t i = 0; i < 6; i++) {
+        indices |= uint64_t(block[2 + i]) << (i * 8);
+    }
+    for(int32_t i = 0; i < 16; i++) {
+        rgba[i * 4 + channel] = palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+void writeBits(uint8_t *block, uint32_t &offset, uint32_t value, uint32_t count) {
+    for(uint32_t i = 0; i < count; i++, offset++) {
+        if(value & (1 << i)) {
+            block[offset >> 3] |= 1 << (offset & 7);
+        }
+    }
+}
+
+uint32_t readBits(const uint8_t *block, uint32_t &offset, uint32_t count) {
+    uint32_t result = 0;
+    for(uint32_t i = 0; i < count; i++, offset++) {
+        if(block[offset >> 3] & (1 << (offset & 7))) {
+            result |= 1 << i;
+        }
+    }
+    return result;
+}
+
+void quantizeBC7(const float *endpoint, int32_t bit, int32_t *result) {
+    for(int32_t c = 0; c < 4; c++) {
+        result[c] = CLAMP(int32_t((endpoint[c] - bit) * 0.5f + 0.5f), 0, 127);
+    }
+}
+
+int32_t quantizeBC7(const float *endpoint, int32_t *result) {
+    int32_t best = 0;
+    float bestError = FLT_MAX;
+    for(int32_t bit = 0; bit < 2; bit++) {
+        int32_t q[4];
+        quantizeBC7(endpoint, bit, q);
+        float error = 0.0f;
+        for(int32_t c = 0; c < 4; c++) {
+            float d = float((q[c] << 1) | bit) - endpoint[c];
+            error += d * d;
+        }
+        if(error < bestError) {
+            bestError = error;
+            best = bit;
+        }
+    }
+    quantizeBC7(endpoint, best, result);
+    return best;
+}
+
+int32_t fitBC7(const uint8_t *rgba, const int32_t *q0, int32_t p0, const int32_t *q1, int32_t p1, int32_t *indices) {
+    int32_t palette[16][4];
+    for(int32_t c = 0; c < 4; c++) {
+        int32_t v0 = (q0[c] << 1) | p0;
+        int32_t v1 = (q1[c] << 1) | p1;
+        for(int32_t i = 0; i < 16; i++) {
+            palette[i][c] = ((64 - gBC7Weights[i]) * v0 + gBC7Weights[i] * v1 + 32) >> 6;
+        }
+    }
+
+    int32_t error = 0;
+    for(int32_t i = 0; i < 16; i++) {
+        int32_t bestError = INT_MAX;
+        for(int32_t p = 0; p < 16; p++) {
+            int32_t e = colorDistance(palette[p], &rgba[i * 4], 4);
+            if(e < bestError) {
+                bestError = e;
+                indices[i] = p;
+            }
+        }
+        error += bestError;
+    }
+    return error;
+}
+
+void encodeBC7(const uint8_t *rgba, uint8_t *block, int32_t quality) {
+    float points[16 * 4];
+    for(int32_t i = 0; i < 64; i++) {
+        points[i] = rgba[i];
+    }
+
+    float e0[4];
+    float e1[4];
+    axisEndpoints(points, 4, e0, e1);
+
+    int32_t q0[4];
+    int32_t q1[4];
+    int32_t p0 = quantizeBC7(e0, q0);
+    int32_t p1 = quantizeBC7(e1, q1);
+    int32_t indices[16];
+    int32_t error = fitBC7(rgba, q0, p0, q1, p1, indices);
+
+    int32_t iterations = (quality == TextureEncoder::Best) ? 4 : quality;
+    for(int32_t n = 0; n < iterations && error > 0; n++) {
+        float weights[16];
+        for(int32_t i = 0; i < 16; i++) {
+            weights[i] = float(64 - gBC7Weights[indices[i]]) / 64.0f;
+        }
+        if(!leastSquares(points, 4, weights, e0, e1)) {
+            break;
+        }
+
+        bool improved = false;
+        // The best quality tries all of the shared bit combinations instead of the nearest ones
+        int32_t combinations = (quality == TextureEncoder::Best) ? 4 : 1;
+        for(int32_t b = 0; b < combinations; b++) {
+            int32_t n0[4];
+            int32_t n1[4];
+            int32_t b0;
+            int32_t b1;
+            if(combinations == 1) {
+                b0 = quantizeBC7(e0, n0);
+                b1 = quantizeBC7(e1, n1);
+            } else {
+                b0 = b & 1;
+                b1 = b >> 1;
+                quantizeBC7(e0, b0, n0);
+                quantizeBC7(e1, b1, n1);
+            }
+
+            int32_t nextIndices[16];
+            int32_t nextError = fitBC7(rgba, n0, b0, n1, b1, nextIndices);
+            if(nextError < error) {
+                error = nextError;
+                memcpy(q0, n0, sizeof(q0));
+                memcpy(q1, n1, sizeof(q1));
+                p0 = b0;
+                p1 = b1;
+                memcpy(indices, nextIndices, sizeof(indices));
+                improved = true;
+            }
+        }
+        if(!improved) {
+            break;
+        }
+    }
+
+    // The most significant bit of the first index is implicit zero
+    if(indices[0] & 8) {
+        for(int32_t c = 0; c < 4; c++) {
+            std::swap(q0[c], q1[c]);
+        }
+        std::swap(p0, p1);
+        for(int32_t i = 0; i < 16; i++) {
+            indices[i] = 15 - indices[i];
+        }
+    }
+
+    memset(block, 0, 16);
+    uint32_t offset = 0;
+    writeBits(block, offset, 1 << 6, 7);
+    for(int32_t c = 0; c < 4; c++) {
+        writeBits(block, offset, q0[c], 7);
+        writeBits(block, offset, q1[c], 7);
+    }
+    writeBits(block, offset, p0, 1);
+    writeBits(block, offset, p1, 1);
+    for(int32_t i = 0; i < 16; i++) {
+        writeBits(block, offset, indices[i], (i == 0) ? 3 : 4);
+    }
+}
+
+void decodeBC7(const uint8_t *block, uint8_t *rgba) {
+    // Only the mode 6 is supported, the rest of the modes are decoded as a transparent black
+    if((block[0] & 0x7f) != (1 << 6)) {
+        memset(rgba, 0, 64);
+        return;
+    }
+
+    uint32_t offset = 7;
+    int32_t q[2][4];
+    for(int32_t c = 0; c < 4; c++) {
+        q[0][c] = readBits(block, offset, 7);
+        q[1][c] = readBits(block, offset, 7);
+    }
+    int32_t p0 = readBits(block, offset, 1);
+    int32_t p1 = readBits(block, offset, 1);
+
+    for(int32_t i = 0; i < 16; i++) {
+        int32_t index = readBits(block, offset, (i == 0) ? 3 : 4);
+        int32_t w = gBC7Weights[index];
+        for(int32_t c = 0; c < 4; c++) {
+            int32_t v0 = (q[0][c] << 1) | p0;
+            int32_t v1 = (q[1][c] << 1) | p1;
+            rgba[i * 4 + c] = ((64 - w) * v0 + w * v1 + 32) >> 6;
+        }
+    }
+}
+
+void etcSubBlock(int32_t flip, int32_t sub, int32_t *pixels) {
+    int32_t n = 0;
+    for(int32_t y = 0; y < 4; y++) {
+        for(int32_t x = 0; x < 4; x++) {
+            int32_t second = flip ? (y >= 2) : (x >= 2);
+            if(second == sub) {
+                pixels[n++] = y * 4 + x;
+            }
+        }
+    }
+}
+
+int32_t fitETC(const uint8_t *rgba, const int32_t *pixels, const int32_t *base, int32_t limit, int32_t &table, int32_t *modifiers) {
+    int32_t best = limit;
+    for(int32_t t = 0; t < 8; t++) {
+        int32_t error = 0;
+        int32_t mods[8];
+        for(int32_t j = 0; j < 8 && error < best; j++) {
+            const uint8_t *pixel = &rgba[pixels[j] * 4];
+            int32_t bestError = INT_MAX;
+            for(int32_t m = 0; m < 4; m++) {
+                int32_t color[3];
+                for(int32_t c = 0; c < 3; c++) {
+                    color[c] = CLAMP(base[c] + gEtcModifiers[t][m], 0, 255);
+                }
+                int32_t e = colorDistance(color, pixel, 3);
+                if(e < bestError) {
+                    bestError = e;
+                    mods[j] = m;
+                }
+            }
+            error += bestError;
+        }
+        if(error < best) {
+            best = error;
+            table = t;
+            memcpy(modifiers, mods, sizeof(mods));
+        }
+    }
+    return best;
+}
+
+int32_t searchETC(const uint8_t *rgba, const int32_t *pixels, int32_t bits, const int32_t *lo, const int32_t *hi, int32_t radius,
+                  int32_t *q, int32_t &table, int32_t *modifiers) {
+    int32_t start[3] = {q[0], q[1], q[2]};
+    int32_t best = INT_MAX;
+    for(int32_t dr = -radius; dr <= radius; dr++) {
+        for(int32_t dg = -radius; dg <= radius; dg++) {
+            for(int32_t db = -radius; db <= radius; db++) {
+                int32_t candidate[3] = {start[0] + dr, start[1] + dg, start[2] + db};
+                bool valid = true;
+                int32_t base[3];
+                for(int32_t c = 0; c < 3; c++) {
+                    valid &= (candidate[c] >= lo[c] && candidate[c] <= hi[c]);
+                    base[c] = (bits == 4) ? expand4(candidate[c]) : expand5(candidate[c]);
+                }
+                if(!valid) {
+                    continue;
+                }
+
+                int32_t t;
+                int32_t mods[8];
+                int32_t error = fitETC(rgba, pixels, base, best, t, mods);
+                if(error < best) {
+                    best = error;
+                    table = t;
+                    memcpy(q, candidate, sizeof(candidate));
+                    memcpy(modifiers, mods, sizeof(mods));
+                }
+            }
+        }
+    }
+    return best;
+}
+
+void writeETC(uint8_t *block, bool differential, int32_t flip, const int32_t q[2][3], const int32_t *tables, const int32_t mods[2][8], const int32_t pixels[2][8]) {
+    for(int32_t c = 0; c < 3; c++) {
+        if(differential) {
+            block[c] = (q[0][c] << 3) | ((q[1][c] - q[0][c]) & 7);
+        } else {
+            block[c] = (q[0][c] << 4) | q[1][c];
+        }
+    }
+    block[3] = (tables[0] << 5) | (tables[1] << 2) | (differential ? 2 : 0) | flip;
+
+    uint32_t msb = 0;
+    uint32_t lsb = 0;
+    for(int32_t s = 0; s < 2; s++) {
+        for(int32_t j = 0; j < 8; j++) {
+            int32_t i = pixels[s][j];
+            int32_t k = (i % 4) * 4 + (i / 4);
+            msb |= (mods[s][j] >> 1) << k;
+            lsb |= (mods[s][j] & 1) << k;
+        }
+    }
+    block[4] = msb >> 8;
+    block[5] = msb & 0xff;
+    block[6] = lsb >> 8;
+    block[7] = lsb & 0xff;
+}
+
+void encodeETC(const uint8_t *rgba, uint8_t *block, int32_t quality) {
+    int32_t radius = (quality == TextureEncoder::Best) ? 1 : 0;
+    int32_t best = INT_MAX;
+
+    for(int32_t flip = 0; flip < 2; flip++) {
+        int32_t pixels[2][8];
+        float average[2][3] = {};
+        for(int32_t s = 0; s < 2; s++) {
+            etcSubBlock(flip, s, pixels[s]);
+            for(int32_t j = 0; j < 8; j++) {
+                for(int32_t c = 0; c < 3; c++) {
+                    average[s][c] += rgba[pixels[s][j] * 4 + c] / 8.0f;
+                }
+            }
+        }
+
+        int32_t q[2][3];
+        int32_t tables[2];
+        int32_t mods[2][8];
+
+        // Individual mode, both sub blocks have own 4 bit colors
+        {
+            const int32_t lo[3] = {0, 0, 0};
+            const int32_t hi[3] = {15, 15, 15};
+
+            int32_t error = 0;
+            for(int32_t s = 0; s < 2; s++) {
+                for(int32_t c = 0; c < 3; c++) {
+                    q[s][c] = CLAMP(int32_t(average[s][c] * 15.0f / 255.0f + 0.5f), 0, 15);
+                }
+                error += searchETC(rgba, pixels[s], 4, lo, hi, radius, q[s], tables[s], mods[s]);
+            }
+            if(error < best) {
+                best = error;
+                writeETC(block, false, flip, q, tables, mods, pixels);
+            }
+        }
+        // Differential mode, the second 5 bit color is stored as a 3 bit offset of the first one
+        {
+            const int32_t lo[3] = {0, 0, 0};
+            const int32_t hi[3] = {31, 31, 31};
+
+            for(int32_t s = 0; s < 2; s++) {
+                for(int32_t c = 0; c < 3; c++) {
+                    q[s][c] = CLAMP(int32_t(average[s][c] * 31.0f / 255.0f + 0.5f), 0, 31);
+                }
+            }
+            int32_t error = searchETC(rgba, pixels[0], 5, lo, hi, radius, q[0], tables[0], mods[0]);
+
+            int32_t lo1[3];
+            int32_t hi1[3];
+            for(int32_t c = 0; c < 3; c++) {
+                lo1[c] = MAX(q[0][c] - 4, 0);
+                hi1[c] = MIN(q[0][c] + 3, 31);
+                q[1][c] = CLAMP(q[1][c], lo1[c], hi1[c]);
+            }
+            error += searchETC(rgba, pixels[1], 5, lo1, hi1, radius, q[1], tables[1], mods[1]);
+            if(error < best) {
+                best = error;
+                writeETC(block, true, flip, q, tables, mods, pixels);
+            }
+        }
+    }
+}
+
+void decodeETC(const uint8_t *block, uint8_t *rgba) {
+    bool differential = block[3] & 2;
+    int32_t flip = block[3] & 1;
+
+    int32_t base[2][3];
+    for(int32_t c = 0; c < 3; c++) {
+        if(differential) {
+            int32_t b = block[c] >> 3;
+            int32_t d = block[c] & 7;
+            if(d >= 4) {
+                d -= 8;
+            }
+            if(b + d < 0 || b + d > 31) {
+                // The T, H and planar modes are not produced by the encoder
+                memset(rgba, 0, 64);
+                return;
+            }
+            base[0][c] = expand5(b);
+            base[1][c] = expand5(b + d);
+        } else {
+            base[0][c] = expand4(block[c] >> 4);
+            base[1][c] = expand4(block[c] & 15);
+        }
+    }
+    int32_t tables[2] = {block[3] >> 5, (block[3] >> 2) & 7};
+
+    uint32_t msb = (block[4] << 8) | block[5];
+    uint32_t lsb = (block[6] << 8) | block[7];
+    for(int32_t y = 0; y < 4; y++) {
+        for(int32_t x = 0; x < 4; x++) {
+            int32_t k = x * 4 + y;
+            int32_t s = flip ? (y >= 2) : (x >= 2);
+            int32_t m = (((msb >> k) & 1) << 1) | ((lsb >> k) & 1);
+            uint8_t *pixel = &rgba[(y * 4 + x) * 4];
+            for(int32_t c = 0; c < 3; c++) {
+                pixel[c] = CLAMP(base[s][c] + gEtcModifiers[tables[s]][m], 0, 255);
+            }
+            pixel[3] = 255;
+        }
+    }
+}
+
+int32_t fitEAC(const int32_t *values, int32_t base, int32_t multiplier, int32_t table, int32_t limit, uint64_t &indices) {
+    int32_t error = 0;
+    indices = 0;
+    for(int32_t i = 0; i < 16 && error < limit; i++) {
+        int32_t best = 0;
+        int32_t bestError = INT_MAX;
+        for(int32_t m = 0; m < 8; m++) {
+            int32_t d = CLAMP(base + gEacModifiers[table][m] * multiplier, 0, 255) - values[i];
+            if(d * d < bestError) {
+                bestError = d * d;
+                best = m;
+            }
+        }
+        int32_t k = (i % 4) * 4 + (i / 4);
+        indices |= uint64_t(best) << (45 - k * 3);
+        error += bestError;
+    }
+    return error;
+}
+
+void encodeEAC(const uint8_t *rgba, uint8_t *block, int32_t quality) {
+    int32_t values[16];
+    int32_t min = 255;
+    int32_t max = 0;
+    for(int32_t i = 0; i < 16; i++) {
+        values[i] = rgba[i * 4 + 3];
+        min = MIN(min, values[i]);
+        max = MAX(max, values[i]);
+    }
+
+    // The table 13 has a zero modifier which represents the flat blocks exactly
+    int32_t base = min;
+    int32_t multiplier = 1;
+    int32_t table = 13;
+    uint64_t indices;
+    int32_t error = fitEAC(values, base, multiplier, table, INT_MAX, indices);
+
+    int32_t multiplierRange = (quality == TextureEncoder::Fast) ? 0 : 1;
+    int32_t baseRange = (quality == TextureEncoder::Best) ? 2 : 0;
+    for(int32_t t = 0; t < 16 && error > 0; t++) {
+        int32_t lo = gEacModifiers[t][3];
+        int32_t hi = gEacModifiers[t][7];
+        int32_t m0 = CLAMP(int32_t(float(max - min) / float(hi - lo) + 0.5f), 1, 15);
+        for(int32_t m = MAX(m0 - multiplierRange, 1); m <= MIN(m0 + multiplierRange, 15); m++) {
+            int32_t b0 = int32_t(float(min + max) * 0.5f - float((hi + lo) * m) * 0.5f + 0.5f);
+            for(int32_t b = MAX(b0 - baseRange, 0); b <= MIN(b0 + baseRange, 255); b++) {
+                uint64_t next;
+                int32_t e = fitEAC(values, b, m, t, error, next);
+                if(e < error) {
+                    error = e;
+                    base = b;
+                    multiplier = m;
+                    table = t;
+                    indices = next;
+                }
+            }
+        }
+    }
+
+    block[0] = base;
+    block[1] = (multiplier << 4) | table;
+    for(int32_t i = 0; i < 6; i++) {
+        block[2 + i] = (indices >> (40 - i * 8)) & 0xff;
+    }
+}
+
+void decodeEAC(const uint8_t *block, uint8_t *rgba) {
+    int32_t base = block[0];
+    int32_t multiplier = block[1] >> 4;
+    int32_t table = block[1] & 15;
+
+    uint64_t indices = 0;
+    for(int32_t i = 0; i < 6; i++) {
+        indices = (indices << 8) | block[2 + i];
+    }
+    for(int32_t i = 0; i < 16; i++) {
+        int32_t k = (i % 4) * 4 + (i / 4);
+        int32_t m = (indices >> (45 - k * 3)) & 7;
+        rgba[i * 4 + 3] = CLAMP(base + gEacModifiers[table][m] * multiplier, 0, 255);
+    }
+}
+
+void encodeRow(const uint8_t *rgba, int32_t width, int32_t height, int32_t row, int32_t compression, int32_t quality, uint8_t *result) {
+    int32_t columns = (width + 3) / 4;
+    uint32_t size = TextureEncoder::blockSize(compression);
+
+    uint8_t pixels[64];
+    for(int32_t column = 0; column < columns; column++) {
+        // The blocks on the edges repeat the last row and column
+        for(int32_t y = 0; y < 4; y++) {
+            int32_t sy = MIN(row * 4 + y, height - 1);
+            for(int32_t x = 0; x < 4; x++) {
+                int32_t sx = MIN(column * 4 + x, width - 1);
+                memcpy(&pixels[(y * 4 + x) * 4], &rgba[(sy * width + sx) * 4], 4);
+            }
+        }
+        TextureEncoder::encodeBlock(pixels, &result[(row * columns + column) * size], compression, quality);
+    }
+}
+
+float srgbToLinear(uint8_t value) {
+    static float table[256];
+    static bool inited = [] {
+        for(int32_t i = 0; i < 256; i++) {
+            float v = i / 255.0f;
+            table[i] = (v <= 0.04045f) ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+        }
+        return true;
+    }();
+    A_UNUSED(inited);
+
+    return table[value];
+}
+
+float linearToSrgb(float value) {
+    value = CLAMP(value, 0.0f, 1.0f);
+    return (value <= 0.0031308f) ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+float besselI0(float x) {
+    float result = 1.0f;
+    float term = 1.0f;
+    for(int32_t k = 1; k < 20; k++) {
+        float f = x / (2.0f * k);
+        term *= f * f;
+        result += term;
+    }
+    return result;
+}
+
+float filterWeight(int32_t filter, float t) {
+    t = fabsf(t);
+    switch(filter) {
+        case TextureEncoder::Triangle: return MAX(1.0f - t, 0.0f);
+        case TextureEncoder::Kaiser: {
+            float support = gFilterSupport[TextureEncoder::Kaiser];
+            if(t >= support) {
+                return 0.0f;
+            }
+            float sinc = (t < 1e-6f) ? 1.0f : sinf(PI * t) / (PI * t);
+            float ratio = t / support;
+            return sinc * besselI0(gKaiserAlpha * sqrtf(1.0f - ratio * ratio)) / besselI0(gKaiserAlpha);
+        }
+        default: break;
+    }
+    return (t <= 0.5f) ? 1.0f : 0.0f;
+}
+
+std::vector<std::vector<Tap>> filterTaps(int32_t source, int32_t target, int32_t filter) {
+    std::vector<std::vector<Tap>> result(target);
+
+    float scale = float(source) / float(target);
+    float radius = gFilterSupport[filter] * scale;
+    for(int32_t d = 0; d < target; d++) {
+        float center = (d + 0.5f) * scale;
+
+        float sum = 0.0f;
+        for(int32_t s = int32_t(floorf(center - radius)); s <= int32_t(ceilf(center + radius)); s++) {
+            float w = filterWeight(filter, (s + 0.5f - center) / scale);
+            if(w != 0.0f) {
+                result[d].push_back({CLAMP(s, 0, source - 1), w});
+                sum += w;
+            }
+        }
+
+        if(sum != 0.0f) {
+            for(auto &it : result[d]) {
+                it.weight /= sum;
+            }
+        } else {
+            result[d] = {{CLAMP(int32_t(center), 0, source - 1), 1.0f}};
+        }
+    }
+    return result;
+}
+
+/*!
+    \class TextureEncoder
+    \brief Import time encoding of the block compressed Texture formats.
+    \inmodule Engine
+
+    The encoder supports BC1, BC3, BC4, BC5, BC7 and ETC2 formats of the Texture::CompressionType enum.
+    The image is split to 4x4 pixel blocks which are encoded independently, the rows of blocks are distributed across the engine thread pool.
+    The BC7 encoder uses only the mode 6 and the ETC2 encoder uses only the ETC1 compatible individual and differential modes.
+    The class also generates the gamma correct MIP levels.
+*/
+
+/*!
+    Encodes the \a rgba image with \a width and \a height dimensions to the \a compression format using the \a quality preset.
+    The image dimensions are not required to be multiple of the block size, the edge pixels are repeated to fill the blocks.
+    Returns the encoded data or an empty array for the unsupported formats.
+*/
+ByteArray TextureEncoder::encode(const uint8_t *rgba, int32_t width, int32_t height, int32_t compression, int32_t quality) {
+    PROFILE_FUNCTION();
+
+    ByteArray result;
+
+    uint32_t size = blockSize(compression);
+    if(size == 0 || width <= 0 || height <= 0) {
+        return result;
+    }
+
+    int32_t rows = (height + 3) / 4;
+    result.resize(((width + 3) / 4) * rows * size);
+
+    uint8_t *data = result.data();
+    ParallelFor::run((width * height >= gParallelPixels) ? Engine::threadPool() : nullptr, rows, [&](uint32_t row) {
+        encodeRow(rgba, width, height, row, compression, quality, data);
+    });
+
+    return result;
+}
+/*!
+    Decodes the \a data in the \a compression format to the RGBA image with \a width and \a height dimensions.
+    Returns the decoded image or an empty array for the unsupported formats.
+*/
+ByteArray TextureEncoder::decode(const uint8_t *data, int32_t width, int32_t height, int32_t compression) {
+    ByteArray result;
+
+    uint32_t size = blockSize(compression);
+    if(size == 0 || width <= 0 || height <= 0) {
+        return result;
+    }
+    result.resize(width * height * 4);
+
+    int32_t columns = (width + 3) / 4;
+    int32_t rows = (height + 3) / 4;
+
+    uint8_t pixels[64];
+    for(int32_t row = 0; row < rows; row++) {
+        for(int32_t column = 0; column < columns; column++) {
+            decodeBlock(&data[(row * columns + column) * size], pixels, compression);
+
+            for(int32_t y = 0; y < 4 && row * 4 + y < height; y++) {
+                int32_t count = MIN(4, width - column * 4);
+                memcpy(&result[((row * 4 + y) * width + column * 4) * 4], &pixels[y * 16], count * 4);
+            }
+        }
+    }
+
+    return result;
+}
+/*!
+    Returns the next MIP level of the \a rgba image with \a width and \a height dimensions.
+    The dimensions of the result are halved, but not less than one pixel.
+    The \a filter is one of the TextureEncoder::MipFilter kernels.
+    The color channels of the \a srgb images are filtered in the linear space; the alpha channel is always linear.
+*/
+ByteArray TextureEncoder::downsample(const uint8_t *rgba, int32_t width, int32_t height, int32_t filter, bool srgb) {
+    PROFILE_FUNCTION();
+
+    int32_t w = MAX(width / 2, 1);
+    int32_t h = MAX(height / 2, 1);
+    filter = CLAMP(filter, Box, Kaiser);
+
+    std::vector<float> source(width * height * 4);
+    for(size_t i = 0; i < source.size(); i++) {
+        source[i] = (srgb && (i % 4) != 3) ? srgbToLinear(rgba[i]) : rgba[i] / 255.0f;
+    }
+
+    std::vector<std::vector<Tap>> taps = filterTaps(width, w, filter);
+    std::vector<float> horizontal(w * height * 4, 0.0f);
+    for(int32_t y = 0; y < height; y++) {
+        for(int32_t x = 0; x < w; x++) {
+            float *dst = &horizontal[(y * w + x) * 4];
+            for(auto &tap : taps[x]) {
+                const float *src = &source[(y * width + tap.index) * 4];
+                for(int32_t c = 0; c < 4; c++) {
+                    dst[c] += src[c] * tap.weight;
+                }
+            }
+        }
+    }
+
+    taps = filterTaps(height, h, filter);
+    ByteArray result(w * h * 4);
+    for(int32_t y = 0; y < h; y++) {
+        for(int32_t x = 0; x < w; x++) {
+            float value[4] = {};
+            for(auto &tap : taps[y]) {
+                const float *src = &horizontal[(tap.index * w + x) * 4];
+                for(int32_t c = 0; c < 4; c++) {
+                    value[c] += src[c] * tap.weight;
+                }
+            }
+
+            uint8_t *dst = &result[(y * w + x) * 4];
+            for(int32_t c = 0; c < 4; c++) {
+                float v = (srgb && c != 3) ? linearToSrgb(value[c]) : CLAMP(value[c], 0.0f, 1.0f);
+                dst[c] = uint8_t(v * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    return result;
+}
+/*!
+    Returns the size of the 4x4 pixel block in bytes for the \a compression format or zero for the unsupported formats.
+*/
+uint32_t TextureEncoder::blockSize(int32_t compression) {
+    switch(compression) {
+        case Texture::DXT1:
+        case Texture::BC4:
+        case Texture::ETC2: return 8;
+        case Texture::DXT5:
+        case Texture::BC5:
+        case Texture::BC7:
+        case Texture::ETC2A: return 16;
+        default: break;
+    }
+    return 0;
+}
+/*!
+    Encodes the 4x4 block of \a rgba pixels to the \a block in the \a compression format using the \a quality preset.
+    The \a block must have at least TextureEncoder::blockSize() bytes.
+*/
+void TextureEncoder::encodeBlock(const uint8_t *rgba, uint8_t *block, int32_t compression, int32_t quality) {
+    switch(compression) {
+        case Texture::DXT1: {
+            encodeBC1(rgba, block, quality);
+        } break;
+        case Texture::DXT5: {
+            encodeBC4(rgba, block, 3, quality);
+            encodeBC1(rgba, &block[8], quality);
+        } break;
+        case Texture::BC4: {
+            encodeBC4(rgba, block, 0, quality);
+        } break;
+        case Texture::BC5: {
+            encodeBC4(rgba, block, 0, quality);
+            encodeBC4(rgba, &block[8], 1, quality);
+        } break;
+        case Texture::BC7: {
+            encodeBC7(rgba, block, quality);
+        } break;
+        case Texture::ETC2: {
+            encodeETC(rgba, block, quality);
+        } break;
+        case Texture::ETC2A: {
+            encodeEAC(rgba, block, quality);
+            encodeETC(rgba, &block[8], quality);
+        } break;
+        default: break;
+    }
+}
+/*!
+    Decodes the \a block in the \a compression format to the 4x4 block of \a rgba pixels.
+    Only the modes produced by the encoder are supported for the BC7 and ETC2 formats.
+*/
+void TextureEncoder::decodeBlock(const uint8_t *block, uint8_t *rgba, int32_t compression) {
+    switch(compression) {
+        case Texture::DXT1: {
+            decodeBC1(block, rgba, false);
+        } break;
+        case Texture::DXT5: {
+            decodeBC1(&block[8], rgba, true);
+            decodeBC4(block, rgba, 3);
+        } break;
+        case Texture::BC4:
+        case Texture::BC5: {
+            for(int32_t i = 0; i < 16; i++) {
+                rgba[i * 4 + 1] = 0;
+                rgba[i * 4 + 2] = 0;
+                rgba[i * 4 + 3] = 255;
+            }
+            decodeBC4(block, rgba, 0);
+            if(compression == Texture::BC5) {
+                decodeBC4(&block[8], rgba, 1);
+            }
+        } break;
+        case Texture::BC7: {
+            decodeBC7(block, rgba);
+        } break;
+        case Texture::ETC2: {
+            decodeETC(block, rgba);
+        } break;
+        case Texture::ETC2A: {
+            decodeETC(&block[8], rgba);
+            decodeEAC(block, rgba);
+        } break;
+        default: break;
+    }
+}
@@ -0,0 +1,234 @@
+#include "utils/texturestreamer.h"
+
+#include "resources/texture.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace {
+    const int32_t gTailSize = 64;
+
+    const uint32_t gMaxUpgrades = 16;
+};
+
+std::list<Texture *> TextureStreamer::m_textures;
+TextureStreamer::Statistics TextureStreamer::m_statistics;
+uint64_t TextureStreamer::m_budget = 0;
+uint32_t TextureStreamer::m_frame = 1;
+
+static uint64_t residentSize(const TextureStreamer::Residency &item, int32_t mip) {
+    uint64_t result = 0;
+    for(size_t i = MAX(mip, 0); i < item.sizes.size(); i++) {
+        result += item.sizes[i];
+    }
+    return result;
+}
+
+/*!
+    \class TextureStreamer
+    \brief Manages the GPU residency of the MIP levels for the streamed textures.
+    \inmodule Engine
+
+    The streamed textures start from the MIP tail, the smallest levels which are always resident.
+    Each frame the render pipeline requests the MIP levels required by the visible objects and the streamer moves the textures towards them.
+    The higher levels are uploaded one per frame, the evictions are applied immediately.
+    When the requested levels do not fit into the memory budget, the least recently used textures are dropped to the tail first and then the biggest levels of the visible ones are skipped.
+
+    The CPU copy of the levels which are not resident is released, such levels are read from the bundle again before the upload.
+
+    The streaming is disabled while the budget is zero; all of the textures are fully resident in this case.
+*/
+
+/*!
+    Registers a streamed \a texture.
+    \internal
+*/
+void TextureStreamer::addTexture(Texture *texture) {
+    m_textures.push_back(texture);
+}
+/*!
+    Unregisters a streamed \a texture.
+    \internal
+*/
+void TextureStreamer::removeTexture(Texture *texture) {
+    m_textures.remove(texture);
+}
+/*!
+    Requests the \a mip level of the \a texture to be resident for the current frame.
+    The lowest requested level wins in case of multiple requests.
+*/
+void TextureStreamer::requestMip(Texture *texture, int32_t mip) {
+    if(texture && texture->m_streaming) {
+        texture->m_requiredMip = MIN(texture->m_requiredMip, MAX(mip, 0));
+        texture->m_lastUse = m_frame;
+    }
+}
+/*!
+    Updates the resident MIP levels of the streamed textures according to the requests of the current frame and resets the requests.
+    The textures with changed levels are reuploaded to GPU on the next use.
+*/
+void TextureStreamer::update() {
+    PROFILE_FUNCTION();
+
+    ResidencyList list;
+    list.reserve(m_textures.size());
+
+    std::vector<Texture *> textures;
+    textures.reserve(m_textures.size());
+
+    for(auto it : m_textures) {
+        int32_t count = it->mipCount();
+        if(m_budget > 0 && !it->isRender() && !it->m_sides.empty() && count > 1) {
+            Residency item;
+            item.sizes.resize(count);
+
+            int32_t w = it->m_width;
+            int32_t h = it->m_height;
+            for(int32_t i = 0; i < count; i++) {
+                item.sizes[i] = uint64_t(it->size(w, h)) * it->sides();
+                w = MAX(w / 2, 1);
+                h = MAX(h / 2, 1);
+            }
+            item.resident = it->m_residentMip;
+            item.required = it->m_requiredMip;
+            item.tail = tailMip(it->m_width, it->m_height, count);
+            item.lastUse = it->m_lastUse;
+
+            list.push_back(item);
+            textures.push_back(it);
+        } else {
+            it->setResidentMip(0);
+        }
+        it->m_requiredMip = INT32_MAX;
+    }
+
+    m_statistics = plan(list, m_budget);
+    m_statistics.textures = m_textures.size();
+
+    for(size_t i = 0; i < list.size(); i++) {
+        textures[i]->setResidentMip(list[i].target);
+        textures[i]->releaseLevels(textures[i]->m_residentMip);
+    }
+
+    m_frame++;
+}
+/*!
+    Returns the GPU memory budget in bytes for the streamed textures.
+*/
+uint64_t TextureStreamer::budget() {
+    return m_budget;
+}
+/*!
+    Sets the GPU memory budget in \a bytes for the streamed textures.
+    The zero budget disables streaming.
+*/
+void TextureStreamer::setBudget(uint64_t bytes) {
+    m_budget = bytes;
+}
+/*!
+    Returns the residency statistics of the last update.
+*/
+const TextureStreamer::Statistics &TextureStreamer::statistics() {
+    return m_statistics;
+}
+/*!
+    Returns the first level of the MIP tail for the texture with \a width, \a height and \a mipCount levels.
+    The levels of the tail are always resident.
+*/
+int32_t TextureStreamer::tailMip(int32_t width, int32_t height, int32_t mipCount) {
+    int32_t mip = 0;
+    while(mip < mipCount - 1 && (MAX(width >> mip, 1) > gTailSize || MAX(height >> mip, 1) > gTailSize)) {
+        mip++;
+    }
+    return mip;
+}
+/*!
+    Calculates the target resident levels for the \a list of textures to fit into the memory \a budget.
+    Each item of the \a list must contain the sizes of the levels, the currently resident level, the required level and the frame of the last use.
+    The not requested textures have the required level equal to INT32_MAX, they keep their levels while the budget allows.
+    Returns the residency statistics for the calculated targets.
+*/
+TextureStreamer::Statistics TextureStreamer::plan(ResidencyList &list, uint64_t budget) {
+    Statistics result;
+    result.budget = budget;
+    result.textures = list.size();
+
+    uint64_t total = 0;
+    std::vector<int32_t> wanted(list.size());
+    std::vector<uint32_t> unused;
+    for(uint32_t i = 0; i < list.size(); i++) {
+        Residency &item = list[i];
+        item.tail = CLAMP(item.tail, 0, MAX(int32_t(item.sizes.size()) - 1, 0));
+        if(item.required != INT32_MAX) {
+            wanted[i] = CLAMP(item.required, 0, item.tail);
+            result.visible++;
+        } else {
+            wanted[i] = CLAMP(item.resident, 0, item.tail);
+            unused.push_back(i);
+        }
+        total += residentSize(item, wanted[i]);
+    }
+    result.requestedMemory = total;
+
+    if(total > budget) {
+        // The least recently used textures are dropped to the tail first
+        std::sort(unused.begin(), unused.end(), [&list](uint32_t left, uint32_t right) {
+            return list[left].lastUse < list[right].lastUse;
+        });
+        for(auto i : unused) {
+            if(total <= budget) {
+                break;
+            }
+            total -= residentSize(list[i], wanted[i]) - residentSize(list[i], list[i].tail);
+            wanted[i] = list[i].tail;
+        }
+
+        // Then the biggest levels are skipped
+        std::priority_queue<std::pair<uint64_t, uint32_t>> queue;
+        for(uint32_t i = 0; i < list.size(); i++) {
+            if(wanted[i] < list[i].tail) {
+                queue.push(std::make_pair(list[i].sizes[wanted[i]], i));
+            }
+        }
+        while(total > budget && !queue.empty()) {
+            uint32_t i = queue.top().second;
+            queue.pop();
+
+            total -= list[i].sizes[wanted[i]];
+            wanted[i]++;
+            if(wanted[i] < list[i].tail) {
+                queue.push(std::make_pair(list[i].sizes[wanted[i]], i));
+            }
+        }
+    }
+
+    // The biggest deficit is upgraded first
+    std::vector<uint32_t> order(list.size());
+    for(uint32_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&list, &wanted](uint32_t left, uint32_t right) {
+        return (list[left].resident - wanted[left]) > (list[right].resident - wanted[right]);
+    });
+
+    for(auto i : order) {
+        Residency &item = list[i];
+        int32_t resident = CLAMP(item.resident, 0, MAX(int32_t(item.sizes.size()) - 1, 0));
+        if(wanted[i] > resident) {
+            item.target = wanted[i];
+            result.evictions++;
+        } else if(wanted[i] < resident && result.upgrades < gMaxUpgrades) {
+            item.target = resident - 1;
+            result.upgrades++;
+        } else {
+            item.target = resident;
+        }
+
+        if(item.required != INT32_MAX && item.target > CLAMP(item.required, 0, item.tail)) {
+            result.partial++;
+        }
+        result.residentMemory += residentSize(item, item.target);
+    }
+
+    return result;
+}
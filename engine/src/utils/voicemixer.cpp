@@ -0,0 +1,320 @@
+#include "utils/voicemixer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #include <xmmintrin.h>
+    #define MIXER_SSE
+#endif
+
+namespace {
+    const float gSampleScale = 1.0f / 32768.0f;
+
+    const float gFractionScale = 1.0f / 4294967296.0f;
+};
+// Adds the interleaved stereo \a input scaled by the left and right \a gains to the \a output
+static void accumulate(float *output, const float *input, const float gains[2], uint32_t samples) {
+    uint32_t i = 0;
+#ifdef MIXER_SSE
+    __m128 gain = _mm_setr_ps(gains[0], gains[1], gains[0], gains[1]);
+    for(; i + 4 <= samples; i += 4) {
+        _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(_mm_loadu_ps(input + i), gain)));
+    }
+#endif
+    for(; i < samples; i++) {
+        output[i] += input[i] * gains[i & 1];
+    }
+}
+
+/*!
+    \class VoiceMixer
+    \brief Mixes a large number of audio emitters in software into a single stereo stream.
+    \inmodule Engine
+
+    Each playing emitter is a voice which is scored every mix by its priority and by its loudness at the listener position.
+    The loudness takes into account the volume of the emitter, the average level of its clip and the distance attenuation;
+    the emitters out of the maximum distance are culled, by default the distance is unlimited.
+    Only the voices with the highest scores are real voices, which means they are resampled and added to the output.
+    The rest of the voices are virtual: the playback position of them still advances with the same rate, so a voice which becomes real again continues at the right sample.
+
+    The mixer doesn't depend on the audio device, the output is an interleaved stereo buffer of the floating point samples at the frequency() rate.
+    The mixing order and the fixed point playback positions make the result fully deterministic.
+*/
+
+VoiceMixer::VoiceMixer(uint32_t frequency, uint32_t realVoices) :
+        m_right(1.0f, 0.0f, 0.0f),
+        m_frequency(frequency),
+        m_realVoices(realVoices),
+        m_nextVoice(0) {
+
+}
+/*!
+    Returns the output frequency in Hz.
+*/
+uint32_t VoiceMixer::frequency() const {
+    return m_frequency;
+}
+/*!
+    Returns the maximum number of real voices which are mixed at the same time.
+*/
+uint32_t VoiceMixer::realVoices() const {
+    return m_realVoices;
+}
+/*!
+    Starts playback of the \a emitter from the beginning of its clip and returns the handle of the new voice.
+    The clip data must stay valid while the voice is playing.
+*/
+uint32_t VoiceMixer::play(const Emitter &emitter) {
+    if(emitter.clip.data == nullptr || emitter.clip.frames == 0 || emitter.clip.frequency == 0) {
+        return 0;
+    }
+
+    m_nextVoice++;
+
+    Voice &voice = m_voices[m_nextVoice];
+    voice.emitter = emitter;
+    voice.id = m_nextVoice;
+
+    return m_nextVoice;
+}
+/*!
+    Stops the \a voice and releases it.
+*/
+void VoiceMixer::stop(uint32_t voice) {
+    m_voices.erase(voice);
+}
+/*!
+    Returns true if the \a voice is still playing.
+*/
+bool VoiceMixer::isPlaying(uint32_t voice) const {
+    return m_voices.find(voice) != m_voices.end();
+}
+/*!
+    Returns true if the \a voice was mixed to the output during the last mix.
+*/
+bool VoiceMixer::isReal(uint32_t voice) const {
+    auto it = m_voices.find(voice);
+    return it != m_voices.end() && it->second.real;
+}
+/*!
+    Returns the playback position of the \a voice in the frames of its clip.
+*/
+uint32_t VoiceMixer::position(uint32_t voice) const {
+    auto it = m_voices.find(voice);
+    if(it != m_voices.end()) {
+        return static_cast<uint32_t>(it->second.position >> 32);
+    }
+    return 0;
+}
+/*!
+    Sets the world \a position of the \a voice emitter.
+*/
+void VoiceMixer::setPosition(uint32_t voice, const Vector3 &position) {
+    auto it = m_voices.find(voice);
+    if(it != m_voices.end()) {
+        it->second.emitter.position = position;
+    }
+}
+/*!
+    Sets the \a volume of the \a voice emitter.
+*/
+void VoiceMixer::setVolume(uint32_t voice, float volume) {
+    auto it = m_voices.find(voice);
+    if(it != m_voices.end()) {
+        it->second.emitter.volume = volume;
+    }
+}
+/*!
+    Enables or disables the \a loop of the \a voice.
+*/
+void VoiceMixer::setLoop(uint32_t voice, bool loop) {
+    auto it = m_voices.find(voice);
+    if(it != m_voices.end()) {
+        it->second.emitter.loop = loop;
+    }
+}
+/*!
+    Sets the listener \a position and the \a right direction of the listener used for the panning.
+*/
+void VoiceMixer::setListener(const Vector3 &position, const Vector3 &right) {
+    m_listener = position;
+    m_right = right;
+}
+/*!
+    Mixes the next \a frames of all voices to the interleaved stereo \a output.
+    The finished voices are released after the mix.
+*/
+void VoiceMixer::mix(float *output, uint32_t frames) {
+    PROFILE_FUNCTION();
+
+    std::fill(output, output + frames * 2, 0.0f);
+
+    prioritize();
+
+    for(auto &it : m_voices) {
+        Voice &voice = it.second;
+        if(voice.real) {
+            render(voice, output, frames);
+        } else {
+            advance(voice, frames);
+        }
+    }
+
+    for(auto it = m_voices.begin(); it != m_voices.end();) {
+        if(it->second.finished) {
+            it = m_voices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+/*!
+    Returns the root mean square level of the signed 16 bit \a samples in range [0, 1].
+*/
+float VoiceMixer::loudness(const int16_t *data, uint32_t samples) {
+    if(samples == 0) {
+        return 0.0f;
+    }
+
+    double sum = 0.0;
+    for(uint32_t i = 0; i < samples; i++) {
+        double sample = data[i] * gSampleScale;
+        sum += sample * sample;
+    }
+    return static_cast<float>(sqrt(sum / samples));
+}
+/*!
+    Converts the floating point \a input samples to the signed 16 bit \a output with saturation.
+*/
+void VoiceMixer::convert(const float *input, int16_t *output, uint32_t samples) {
+    for(uint32_t i = 0; i < samples; i++) {
+        float value = CLAMP(input[i], -1.0f, 1.0f) * 32767.0f;
+        output[i] = static_cast<int16_t>(lrintf(value));
+    }
+}
+/*!
+    \internal
+    Calculates the scores and the gains of the voices and selects the real ones.
+*/
+void VoiceMixer::prioritize() {
+    m_order.clear();
+
+    for(auto &it : m_voices) {
+        Voice &voice = it.second;
+        const Emitter &emitter = voice.emitter;
+
+        Vector3 direction = emitter.position - m_listener;
+        float distance = direction.length();
+
+        float attenuation = 0.0f;
+        if(distance <= emitter.maxDistance) {
+            attenuation = emitter.minDistance / MAX(distance, emitter.minDistance);
+        }
+        float gain = attenuation * emitter.volume;
+
+        // Equal power panning
+        float pan = 0.0f;
+        if(distance > 0.0f) {
+            pan = CLAMP(direction.dot(m_right) / distance, -1.0f, 1.0f);
+        }
+        float angle = (pan + 1.0f) * PI * 0.25f;
+        voice.gains[0] = cosf(angle) * gain;
+        voice.gains[1] = sinf(angle) * gain;
+
+        voice.real = false;
+        voice.score = emitter.priority + gain * emitter.clip.loudness;
+        if(gain > 0.0f) {
+            m_order.push_back(&voice);
+        }
+    }
+
+    uint32_t count = MIN(m_realVoices, static_cast<uint32_t>(m_order.size()));
+    if(count < m_order.size()) {
+        std::nth_element(m_order.begin(), m_order.begin() + count, m_order.end(), [](const Voice *left, const Voice *right) {
+            if(left->score == right->score) {
+                return left->id < right->id;
+            }
+            return left->score > right->score;
+        });
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        m_order[i]->real = true;
+    }
+}
+/*!
+    \internal
+    Resamples the next \a frames of the \a voice and adds them to the \a output.
+*/
+void VoiceMixer::render(Voice &voice, float *output, uint32_t frames) {
+    const Clip &clip = voice.emitter.clip;
+    const uint64_t length = uint64_t(clip.frames) << 32;
+    const uint64_t delta = step(voice);
+    const uint32_t right = (clip.channels > 1) ? 1 : 0;
+
+    m_scratch.resize(frames * 2);
+    float *data = m_scratch.data();
+
+    uint64_t position = voice.position;
+    uint32_t count = frames;
+    for(uint32_t i = 0; i < frames; i++) {
+        if(position >= length) {
+            if(!voice.emitter.loop) {
+                voice.finished = true;
+                count = i;
+                break;
+            }
+            position %= length;
+        }
+
+        uint32_t index = static_cast<uint32_t>(position >> 32);
+        uint32_t next = index + 1;
+        if(next >= clip.frames) {
+            next = voice.emitter.loop ? 0 : index;
+        }
+        float fraction = static_cast<float>(position & 0xFFFFFFFF) * gFractionScale;
+
+        const int16_t *a = clip.data + index * clip.channels;
+        const int16_t *b = clip.data + next * clip.channels;
+
+        float l = a[0] + (b[0] - a[0]) * fraction;
+        float r = a[right] + (b[right] - a[right]) * fraction;
+        data[i * 2] = l * gSampleScale;
+        data[i * 2 + 1] = r * gSampleScale;
+
+        position += delta;
+    }
+    if(position >= length) {
+        if(voice.emitter.loop) {
+            position %= length;
+        } else {
+            voice.finished = true;
+        }
+    }
+    voice.position = position;
+
+    accumulate(output, data, voice.gains, count * 2);
+}
+/*!
+    \internal
+    Advances the playback position of the virtual \a voice by \a frames.
+*/
+void VoiceMixer::advance(Voice &voice, uint32_t frames) {
+    const uint64_t length = uint64_t(voice.emitter.clip.frames) << 32;
+
+    voice.position += step(voice) * frames;
+    if(voice.position >= length) {
+        if(voice.emitter.loop) {
+            voice.position %= length;
+        } else {
+            voice.finished = true;
+        }
+    }
+}
+/*!
+    \internal
+    Returns the 32.32 fixed point step of the playback position per output frame.
+*/
+uint64_t VoiceMixer::step(const Voice &voice) const {
+    return (uint64_t(voice.emitter.clip.frequency) << 32) / m_frequency;
+}
@@ -0,0 +1,123 @@
+#include "tst_common.h"
+
+#include "components/actor.h"
+#include "components/transform.h"
+
+#include "components/private/baseanimationblender.h"
+
+#include "resources/animationclip.h"
+
+class AnimatorTest : public ::testing::Test {
+public:
+    static AnimationCurve curve(const Variant &first, const Variant &second) {
+        AnimationCurve result;
+
+        AnimationCurve::KeyFrame k1;
+        k1.m_value = first;
+        k1.m_position = 0.0f;
+        k1.m_type = AnimationCurve::KeyFrame::Linear;
+        result.m_keys.push_back(k1);
+
+        AnimationCurve::KeyFrame k2;
+        k2.m_value = second;
+        k2.m_position = 1.0f;
+        k2.m_type = AnimationCurve::KeyFrame::Linear;
+        result.m_keys.push_back(k2);
+
+        return result;
+    }
+
+    // The blenders hide PropertyAnimation::setTarget() to bind the Transform channels
+    template<typename T>
+    static void play(T &animation, Object *object, const char *property, const AnimationCurve &curve, uint32_t time) {
+        animation.setTarget(object, property);
+        animation.setDuration(1000);
+        animation.setCurve(curve);
+        animation.start();
+        animation.setCurrentTime(time);
+    }
+
+};
+
+TEST_F(AnimatorTest, Direct_transform_channels) {
+    ObjectSystem system;
+    Transform::registerClassFactory(&system);
+
+    Actor direct;
+    direct.addComponent("Transform");
+    Actor reference;
+    reference.addComponent("Transform");
+
+    AnimationCurve position = curve(Vector3(0.0f, 0.0f, 0.0f), Vector3(2.0f, 4.0f, 6.0f));
+    AnimationCurve rotation = curve(Quaternion(Vector3(0.0f, 1.0f, 0.0f), 0.0f), Quaternion(Vector3(0.0f, 1.0f, 0.0f), 90.0f));
+    AnimationCurve scale = curve(Vector3(1.0f), Vector3(3.0f));
+
+    // The blenders write the Transform directly, the generic animation writes through the properties
+    BaseAnimationBlender blenders[3];
+    PropertyAnimation animations[3];
+    play(blenders[0], direct.transform(), "position", position, 250);
+    play(blenders[1], direct.transform(), "quaternion", rotation, 250);
+    play(blenders[2], direct.transform(), "scale", scale, 250);
+    play(animations[0], reference.transform(), "position", position, 250);
+    play(animations[1], reference.transform(), "quaternion", rotation, 250);
+    play(animations[2], reference.transform(), "scale", scale, 250);
+
+    ASSERT_TRUE(direct.transform()->position() == Vector3(0.5f, 1.0f, 1.5f));
+    ASSERT_TRUE(direct.transform()->position() == reference.transform()->position());
+    ASSERT_TRUE(direct.transform()->quaternion() == reference.transform()->quaternion());
+    ASSERT_TRUE(direct.transform()->scale() == reference.transform()->scale());
+    ASSERT_TRUE(direct.transform()->worldTransform() == reference.transform()->worldTransform());
+}
+
+TEST_F(AnimatorTest, Cross_fade_start) {
+    ObjectSystem system;
+    Transform::registerClassFactory(&system);
+
+    Actor actor;
+    actor.addComponent("Transform");
+
+    AnimationTrack previous;
+    previous.curve() = curve(Vector3(10.0f), Vector3(20.0f));
+
+    BaseAnimationBlender blender;
+    blender.setPreviousTrack(previous);
+    blender.setTransitionTime(0.5f);
+    play(blender, actor.transform(), "position", curve(Vector3(0.0f), Vector3(4.0f)), 0);
+
+    // The direct path mixes the channels with the same factor as the generic Variant path
+    blender.setCurrentTime(100);
+    Vector3 result = actor.transform()->position();
+    float factor = 0.1f / 0.5f;
+    EXPECT_NEAR(result.x, MIX(0.4f, 11.0f, factor), 1e-4f);
+}
+
+TEST_F(AnimatorTest, Quaternion_cross_fade) {
+    ObjectSystem system;
+    Transform::registerClassFactory(&system);
+
+    Actor actor;
+    actor.addComponent("Transform");
+
+    Quaternion from(Vector3(0.0f, 1.0f, 0.0f), 90.0f);
+    Quaternion to(Vector3(0.0f, 1.0f, 0.0f), 0.0f);
+
+    AnimationTrack previous;
+    previous.curve() = curve(from, from);
+
+    BaseAnimationBlender blender;
+    blender.setPreviousTrack(previous);
+    blender.setTransitionTime(0.5f);
+    play(blender, actor.transform(), "quaternion", curve(to, to), 0);
+    ASSERT_TRUE(blender.isTransformChannel());
+
+    // The rotation is blended with the previous clip instead of a jump to the new one
+    blender.setCurrentTime(100);
+    Quaternion expected;
+    expected.mix(to, from, 0.1f / 0.5f);
+
+    Quaternion result = actor.transform()->quaternion();
+    EXPECT_NEAR(result.x, expected.x, 1e-4f);
+    EXPECT_NEAR(result.y, expected.y, 1e-4f);
+    EXPECT_NEAR(result.z, expected.z, 1e-4f);
+    EXPECT_NEAR(result.w, expected.w, 1e-4f);
+}
@@ -0,0 +1,164 @@
+#include "tst_common.h"
+
+#include "file.h"
+#include "utils/assetpack.h"
+
+#include <cstdio>
+#include <cstring>
+
+class AssetPackTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        m_path = "tst_assetpack.pak";
+    }
+
+    void TearDown() override {
+        remove(m_path.c_str());
+    }
+
+    // Applies the \a patch to the saved pack and checks that it can't be opened anymore
+    template<typename T>
+    void expectCorrupted(T patch) {
+        FILE *fp = fopen(m_path.c_str(), "rb");
+        ASSERT_TRUE(fp != nullptr);
+        fseek(fp, 0, SEEK_END);
+        ByteArray data(ftell(fp));
+        fseek(fp, 0, SEEK_SET);
+        ASSERT_EQ(fread(data.data(), 1, data.size(), fp), data.size());
+        fclose(fp);
+
+        patch(data);
+
+        std::string path = m_path + ".bad";
+        fp = fopen(path.c_str(), "wb");
+        ASSERT_TRUE(fp != nullptr);
+        fwrite(data.data(), 1, data.size(), fp);
+        fclose(fp);
+
+        AssetPack pack;
+        EXPECT_FALSE(pack.open(path));
+        remove(path.c_str());
+    }
+
+    std::string m_path;
+
+};
+
+TEST_F(AssetPackTest, Write_and_find) {
+    ByteArray text(5000, 'a');
+    ByteArray noise(3000);
+    for(uint32_t i = 0; i < noise.size(); i++) {
+        noise[i] = (i * 2654435761U) >> 24;
+    }
+
+    AssetPackWriter writer;
+    for(uint32_t i = 0; i < 100; i++) {
+        writer.addFile("file" + std::to_string(i), ByteArray(i + 1, i));
+    }
+    writer.addFile("text", text);
+    writer.addFile("noise", noise, AssetPack::Stored);
+    writer.addFile("dir/empty", ByteArray());
+    ASSERT_TRUE(writer.save(m_path));
+
+    AssetPack pack;
+    ASSERT_TRUE(pack.open(m_path));
+    ASSERT_EQ(pack.count(), 103);
+    ASSERT_TRUE(pack.find("missing") == nullptr);
+
+    for(uint32_t i = 0; i < 100; i++) {
+        const AssetPack::Entry *entry = pack.find("file" + std::to_string(i));
+        ASSERT_TRUE(entry != nullptr);
+        ASSERT_EQ(entry->originalSize, i + 1);
+        ASSERT_EQ(entry->offset % 4096, 0);
+
+        ByteArray data(entry->originalSize);
+        ASSERT_TRUE(pack.extract(*entry, data.data()));
+        ASSERT_TRUE(data == ByteArray(i + 1, i));
+    }
+
+    const AssetPack::Entry *entry = pack.find("text");
+    ASSERT_TRUE(entry != nullptr);
+    ASSERT_EQ(entry->compression, AssetPack::Deflate);
+    ASSERT_TRUE(entry->size < text.size());
+
+    entry = pack.find("noise");
+    ASSERT_TRUE(entry != nullptr);
+    ASSERT_EQ(entry->compression, AssetPack::Stored);
+    ASSERT_EQ(memcmp(pack.data(*entry), noise.data(), noise.size()), 0);
+
+    entry = pack.find("dir/empty");
+    ASSERT_TRUE(entry != nullptr);
+    ASSERT_EQ(entry->originalSize, 0);
+}
+
+TEST_F(AssetPackTest, File_backend) {
+    ByteArray text(5000, 'b');
+
+    AssetPackWriter writer;
+    writer.addFile("text", text);
+    writer.addFile("dir/data", ByteArray(16, 1), AssetPack::Stored);
+    ASSERT_TRUE(writer.save(m_path));
+
+    File file;
+    file.fsearchPathAdd(m_path.c_str());
+
+    ASSERT_TRUE(file.exists("text"));
+    ASSERT_TRUE(file.isdir("dir"));
+
+    _FILE *fp = file.fopen("text", "r");
+    ASSERT_TRUE(fp != nullptr);
+    ASSERT_EQ(file.fsize(fp), text.size());
+
+    ByteArray data(file.fsize(fp));
+    ASSERT_EQ(file.fread(&data[0], 1000, 2, fp), 2);
+    ASSERT_EQ(file.ftell(fp), 2000);
+    ASSERT_EQ(file.fread(&data[2000], 1000, 4, fp), 3);
+    ASSERT_TRUE(data == text);
+
+    file.fseek(fp, 10);
+    ASSERT_EQ(file.ftell(fp), 10);
+    ASSERT_EQ(file.fclose(fp), 0);
+}
+
+TEST_F(AssetPackTest, Duplicates_and_corruption) {
+    AssetPackWriter writer;
+    writer.addFile("first", ByteArray(8, 1), AssetPack::Stored);
+    writer.addFile("second", ByteArray(8, 2), AssetPack::Stored);
+    writer.addFile("first", ByteArray(8, 3), AssetPack::Stored);
+    ASSERT_EQ(writer.count(), 2);
+    ASSERT_TRUE(writer.save(m_path));
+
+    {
+        AssetPack pack;
+        ASSERT_TRUE(pack.open(m_path));
+        const AssetPack::Entry *entry = pack.find("first");
+        ASSERT_TRUE(entry != nullptr);
+        ASSERT_EQ(pack.data(*entry)[0], 3);
+    }
+
+    typedef AssetPack::Header Header;
+
+    expectCorrupted([](ByteArray &data) {
+        reinterpret_cast<Header *>(data.data())->bucketBits = 64;
+    });
+    expectCorrupted([](ByteArray &data) {
+        reinterpret_cast<Header *>(data.data())->count = 0xffffffff;
+    });
+    expectCorrupted([](ByteArray &data) {
+        Header *header = reinterpret_cast<Header *>(data.data());
+        header->namesOffset = 0xffffffffffffff00ULL;
+    });
+    expectCorrupted([](ByteArray &data) {
+        Header *header = reinterpret_cast<Header *>(data.data());
+        uint32_t *buckets = reinterpret_cast<uint32_t *>(&data[header->tableOffset]);
+        buckets[1 << header->bucketBits] = header->count + 1;
+    });
+    expectCorrupted([](ByteArray &data) {
+        Header *header = reinterpret_cast<Header *>(data.data());
+        uint64_t buckets = (1ULL << header->bucketBits) + 1;
+        uint64_t offset = (header->tableOffset + buckets * sizeof(uint32_t) + 7) & ~7ULL;
+        AssetPack::Entry *entry = reinterpret_cast<AssetPack::Entry *>(&data[offset]);
+        entry->nameLength = header->namesSize;
+        entry->name = 1;
+    });
+}
@@ -0,0 +1,196 @@
+#include "tst_common.h"
+
+#include "commandbuffer.h"
+#include "commandlist.h"
+
+#include "resources/material.h"
+
+#include <thread>
+
+class NullCommandBuffer : public CommandBuffer {
+public:
+    void clearRenderTarget(bool clearColor, const Vector4 &color, bool clearDepth, float depth) override {
+        A_UNUSED(clearColor);
+        A_UNUSED(clearDepth);
+        A_UNUSED(depth);
+        m_calls.push_back("clear");
+        m_color = color;
+    }
+
+    void drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, MaterialInstance &instance) override {
+        A_UNUSED(mesh);
+        A_UNUSED(layer);
+        m_calls.push_back("draw" + std::to_string(sub));
+        m_instance = &instance;
+        m_instances = instance.instanceCount();
+        m_batchedSize = instance.batchedSize();
+    }
+
+    void setViewport(int32_t x, int32_t y, int32_t width, int32_t height) override {
+        CommandBuffer::setViewport(x, y, width, height);
+        m_calls.push_back("viewport");
+    }
+
+    void beginDebugMarker(const char *name) override {
+        m_calls.push_back(std::string("begin ") + name);
+    }
+
+    void endDebugMarker() override {
+        m_calls.push_back("end");
+    }
+
+    std::vector<std::string> m_calls;
+
+    Vector4 m_color;
+
+    MaterialInstance *m_instance = nullptr;
+
+    uint32_t m_instances = 0;
+
+    uint32_t m_batchedSize = 0;
+
+};
+
+class CommandListTest : public ::testing::Test {
+
+};
+
+TEST_F(CommandListTest, Record_and_replay) {
+    Engine system(nullptr, "");
+
+    Material material;
+    MaterialInstance instance(&material);
+
+    CommandList list;
+    ASSERT_TRUE(list.isEmpty());
+
+    list.beginDebugMarker("Pass");
+    list.clearRenderTarget(true, Vector4(1.0f, 2.0f, 3.0f, 4.0f));
+    list.setViewport(0, 0, 128, 64);
+    list.drawMesh(nullptr, 2, CommandBuffer::DEFAULT, instance);
+    list.setViewProjection(Matrix4(), Matrix4());
+    list.endDebugMarker();
+
+    ASSERT_EQ(list.count(), 6);
+
+    NullCommandBuffer buffer;
+    buffer.execute(list);
+
+    std::vector<std::string> expected = {"begin Pass", "clear", "viewport", "draw2", "end"};
+    ASSERT_TRUE(buffer.m_calls == expected);
+    ASSERT_TRUE(buffer.m_color == Vector4(1.0f, 2.0f, 3.0f, 4.0f));
+    ASSERT_TRUE(buffer.m_instance == &instance);
+    ASSERT_TRUE(buffer.viewport() == Vector2(128, 64));
+
+    list.clear();
+    ASSERT_TRUE(list.isEmpty());
+    ASSERT_EQ(list.size(), 0);
+}
+
+TEST_F(CommandListTest, Inspect_packets) {
+    CommandList list;
+    list.setGlobalValue("camera.position", Vector4(1.0f, 2.0f, 3.0f, 4.0f));
+    list.setGlobalValue("unsupported", Variant(std::string("value")));
+    list.enableScissor(1, 2, 3, 4);
+
+    ASSERT_EQ(list.count(), 2);
+
+    auto it = list.begin();
+    ASSERT_EQ(it.header().type, CommandList::SetGlobalValue);
+    ASSERT_STREQ(it.name(), "camera.position");
+    ASSERT_EQ(it.packet<CommandList::ValuePacket>().type, MetaType::VECTOR4);
+
+    ++it;
+    ASSERT_EQ(it.header().type, CommandList::EnableScissor);
+    ASSERT_EQ(it.packet<CommandList::RectPacket>().width, 3);
+
+    ++it;
+    ASSERT_FALSE(it != list.end());
+}
+
+TEST_F(CommandListTest, Parallel_recording) {
+    Engine system(nullptr, "");
+
+    Material material;
+    MaterialInstance instance(&material);
+
+    CommandList lists[2];
+
+    std::thread first([&]() {
+        for(uint32_t i = 0; i < 100; i++) {
+            lists[0].drawMesh(nullptr, 0, CommandBuffer::DEFAULT, instance);
+        }
+    });
+    std::thread second([&]() {
+        for(uint32_t i = 0; i < 100; i++) {
+            lists[1].drawMesh(nullptr, 1, CommandBuffer::TRANSLUCENT, instance);
+        }
+    });
+
+    first.join();
+    second.join();
+
+    CommandList merged;
+    merged.append(lists[0]);
+    merged.append(lists[1]);
+    ASSERT_EQ(merged.count(), 200);
+
+    NullCommandBuffer buffer;
+    buffer.execute(merged);
+
+    ASSERT_EQ(buffer.m_calls.size(), 200);
+    ASSERT_TRUE(buffer.m_calls.front() == "draw0");
+    ASSERT_TRUE(buffer.m_calls.back() == "draw1");
+}
+
+TEST_F(CommandListTest, Batched_draws) {
+    Engine system(nullptr, "");
+
+    Material material;
+    MaterialInstance first(&material);
+    MaterialInstance second(&material);
+    MaterialInstance third(&material);
+
+    second.rawUniformBuffer().resize(16);
+    third.rawUniformBuffer().resize(16);
+
+    Vector4 value(1.0f, 2.0f, 3.0f, 4.0f);
+    memcpy(third.rawUniformBuffer().data(), &value, sizeof(Vector4));
+
+    // Recording doesn't touch the instances, the batches are applied during the replay only
+    CommandList list;
+    list.drawMesh(nullptr, 0, CommandBuffer::DEFAULT, first, {&second, &third});
+    ASSERT_EQ(first.instanceCount(), 1);
+
+    // The uniform data is taken at the replay time
+    value = Vector4(5.0f, 6.0f, 7.0f, 8.0f);
+    memcpy(third.rawUniformBuffer().data(), &value, sizeof(Vector4));
+
+    NullCommandBuffer buffer;
+    buffer.execute(list);
+
+    ASSERT_EQ(buffer.m_calls.size(), 1);
+    ASSERT_EQ(buffer.m_instances, 3);
+    ASSERT_EQ(buffer.m_batchedSize, first.rawUniformBuffer().size() + 32);
+    ASSERT_EQ(first.instanceCount(), 1);
+
+    first.batch(second);
+    first.batch(third);
+
+    uint32_t size = first.batchedSize();
+    ByteArray data(size);
+    first.copyBatched(data.data(), 0, size);
+
+    Vector4 result;
+    memcpy(&result, &data[size - sizeof(Vector4)], sizeof(Vector4));
+    ASSERT_TRUE(result == Vector4(5.0f, 6.0f, 7.0f, 8.0f));
+
+    // The copy can start in the middle of the batched instances
+    memcpy(&result, &data[size - 16 - sizeof(Vector4)], sizeof(Vector4));
+    Vector4 partial;
+    first.copyBatched(reinterpret_cast<uint8_t *>(&partial), size - 16 - sizeof(Vector4), sizeof(Vector4));
+    ASSERT_TRUE(partial == result);
+
+    first.resetBatches();
+    ASSERT_EQ(first.instanceCount(), 1);
+}
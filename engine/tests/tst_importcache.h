@@ -0,0 +1,141 @@
+#include "tst_common.h"
+
+#include "editor/importcache.h"
+#include "editor/assetconverter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+
+class ImportCacheTest : public ::testing::Test {
+public:
+    static void writeFile(const QString &path, const QByteArray &data) {
+        QFile file(path);
+        if(file.open(QIODevice::WriteOnly)) {
+            file.write(data);
+            file.close();
+        }
+    }
+
+    static QByteArray readFile(const QString &path) {
+        QByteArray result;
+        QFile file(path);
+        if(file.open(QIODevice::ReadOnly)) {
+            result = file.readAll();
+            file.close();
+        }
+        return result;
+    }
+
+    static void setup(AssetConverterSettings &settings, const QString &root) {
+        settings.setSource(root + "/content/texture.png");
+        settings.setDestination("{00000000-0000-0000-0000-000000000001}");
+        settings.setAbsoluteDestination(root + "/import/" + settings.destination());
+        settings.setHash("{00000000-0000-0000-0000-0000000000ff}");
+    }
+
+};
+
+TEST_F(ImportCacheTest, Key) {
+    AssetConverterSettings settings;
+    settings.setHash("{00000000-0000-0000-0000-0000000000ff}");
+    settings.setDestination("{00000000-0000-0000-0000-000000000001}");
+
+    QString key = settings.cacheKey();
+    EXPECT_FALSE(key.isEmpty());
+    EXPECT_EQ(key, settings.cacheKey());
+
+    // The source content
+    settings.setHash("{00000000-0000-0000-0000-0000000000fe}");
+    QString source = settings.cacheKey();
+    EXPECT_NE(key, source);
+
+    // The converter version
+    settings.setVersion(settings.version() + 1);
+    QString version = settings.cacheKey();
+    EXPECT_NE(source, version);
+
+    // The destination
+    settings.setDestination("{00000000-0000-0000-0000-000000000002}");
+    EXPECT_NE(version, settings.cacheKey());
+}
+
+TEST_F(ImportCacheTest, Store_restore) {
+    QTemporaryDir root;
+    ASSERT_TRUE(root.isValid());
+    QDir().mkpath(root.path() + "/import");
+
+    ImportCache cache(root.path() + "/cache");
+
+    AssetConverterSettings settings;
+    setup(settings, root.path());
+    settings.setSubItem("sub", "{00000000-0000-0000-0000-000000000002}", 7);
+
+    writeFile(settings.absoluteDestination(), "data");
+    writeFile(root.path() + "/import/{00000000-0000-0000-0000-000000000002}", "sub");
+
+    ASSERT_TRUE(cache.store(&settings));
+
+    QDir(root.path() + "/import").removeRecursively();
+
+    // The other settings with the same key restore the artifact and the sub items
+    AssetConverterSettings restored;
+    setup(restored, root.path());
+    ASSERT_TRUE(cache.restore(&restored));
+
+    EXPECT_EQ(readFile(restored.absoluteDestination()), QByteArray("data"));
+    EXPECT_EQ(readFile(root.path() + "/import/{00000000-0000-0000-0000-000000000002}"), QByteArray("sub"));
+    EXPECT_EQ(restored.subItem("sub"), QString("{00000000-0000-0000-0000-000000000002}"));
+    EXPECT_EQ(restored.subType("sub"), 7);
+
+    // The changed source misses the cache
+    AssetConverterSettings changed;
+    setup(changed, root.path());
+    changed.setHash("{00000000-0000-0000-0000-0000000000fe}");
+    EXPECT_FALSE(cache.restore(&changed));
+
+    // The source without a hash is never cached
+    AssetConverterSettings unhashed;
+    setup(unhashed, root.path());
+    unhashed.setHash(QString());
+    EXPECT_FALSE(cache.store(&unhashed));
+    EXPECT_FALSE(cache.restore(&unhashed));
+
+    cache.clear();
+    EXPECT_FALSE(cache.restore(&restored));
+}
+
+TEST_F(ImportCacheTest, Replace) {
+    QTemporaryDir root;
+    ASSERT_TRUE(root.isValid());
+    QDir().mkpath(root.path() + "/import");
+
+    ImportCache cache(root.path() + "/cache");
+
+    AssetConverterSettings settings;
+    setup(settings, root.path());
+
+    writeFile(settings.absoluteDestination(), "old");
+    ASSERT_TRUE(cache.store(&settings));
+
+    // The existing entry is kept by the regular store
+    writeFile(settings.absoluteDestination(), "new");
+    ASSERT_TRUE(cache.store(&settings));
+    ASSERT_TRUE(cache.restore(&settings));
+    EXPECT_EQ(readFile(settings.absoluteDestination()), QByteArray("old"));
+
+    // The forced import replaces it
+    writeFile(settings.absoluteDestination(), "new");
+    ASSERT_TRUE(cache.store(&settings, true));
+
+    QDir(root.path() + "/import").removeRecursively();
+
+    AssetConverterSettings restored;
+    setup(restored, root.path());
+    ASSERT_TRUE(cache.restore(&restored));
+    EXPECT_EQ(readFile(restored.absoluteDestination()), QByteArray("new"));
+
+    // No temporary entries are left behind
+    QStringList entries = QDir(root.path() + "/cache").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    EXPECT_EQ(entries.size(), 1);
+}
@@ -0,0 +1,102 @@
+#include "tst_common.h"
+
+#include "utils/lightclusters.h"
+
+#include <set>
+
+class LightClustersTest : public ::testing::Test {
+
+};
+
+TEST_F(LightClustersTest, Single_light) {
+    LightClusters clusters;
+    clusters.setGridSize(4, 4, 8);
+    clusters.setPerspective(90.0f, 1.0f, 1.0f, 100.0f);
+
+    // Small light in the middle of the screen at the depth 10
+    std::vector<Vector4> lights = {Vector4(0.1f, 0.1f, -10.0f, 0.5f)};
+    clusters.build(Matrix4(), lights);
+
+    int32_t z = clusters.slice(10.0f);
+    ASSERT_GE(z, 0);
+
+    auto &cluster = clusters.clusters()[clusters.clusterIndex(2, 2, z)];
+    ASSERT_EQ(cluster.count, 1);
+    ASSERT_EQ(clusters.indices()[cluster.offset], 0);
+
+    // Opposite corner of the screen must be empty
+    ASSERT_EQ(clusters.clusters()[clusters.clusterIndex(0, 0, z)].count, 0);
+}
+
+TEST_F(LightClustersTest, Outside_of_frustum) {
+    LightClusters clusters;
+    clusters.setPerspective(60.0f, 1.5f, 0.1f, 50.0f);
+
+    std::vector<Vector4> lights = {Vector4(0.0f, 0.0f, 10.0f, 1.0f),    // behind the camera
+                                   Vector4(0.0f, 0.0f, -100.0f, 1.0f),  // beyond the far plane
+                                   Vector4(100.0f, 0.0f, -10.0f, 1.0f)}; // out of the side plane
+    clusters.build(Matrix4(), lights);
+
+    ASSERT_TRUE(clusters.indices().empty());
+}
+
+TEST_F(LightClustersTest, Conservative_binning) {
+    LightClusters clusters;
+    clusters.setGridSize(8, 6, 12);
+    clusters.setPerspective(75.0f, 1.5f, 0.5f, 200.0f);
+
+    Matrix4 view(Vector3(3.0f, -2.0f, 5.0f), Quaternion(Vector3(0.0f, 1.0f, 0.0f), 30.0f), Vector3(1.0f));
+    view = view.inverse();
+
+    std::vector<Vector4> lights;
+    std::vector<Vector3> centers;
+    for(int i = 0; i < 300; i++) {
+        Vector4 light(RANGE(-60.0f, 60.0f), RANGE(-20.0f, 20.0f), RANGE(-120.0f, 20.0f), RANGE(0.1f, 15.0f));
+        lights.push_back(light);
+        centers.push_back(view * Vector3(light.x, light.y, light.z));
+    }
+
+    clusters.build(view, lights);
+
+    auto &list = clusters.clusters();
+    auto &indices = clusters.indices();
+
+    // Each cluster contains only the lights which touch the cluster bounds
+    for(uint32_t z = 0; z < clusters.sizeZ(); z++) {
+        for(uint32_t y = 0; y < clusters.sizeY(); y++) {
+            for(uint32_t x = 0; x < clusters.sizeX(); x++) {
+                AABBox bound = clusters.clusterBound(x, y, z);
+
+                auto &cluster = list[clusters.clusterIndex(x, y, z)];
+                for(uint32_t i = cluster.offset; i < cluster.offset + cluster.count; i++) {
+                    uint32_t index = indices[i];
+                    ASSERT_TRUE(bound.intersect(centers[index], lights[index].w));
+                }
+            }
+        }
+    }
+
+    // Any visible point must find all lights which affect it in own cluster
+    float tanY = tan(DEG2RAD * 75.0f * 0.5f);
+    float tanX = tanY * 1.5f;
+    for(int i = 0; i < 2000; i++) {
+        float depth = RANGE(0.5f, 200.0f);
+        float u = RANGE(0.0f, 1.0f);
+        float v = RANGE(0.0f, 1.0f);
+        Vector3 point((u * 2.0f - 1.0f) * depth * tanX, (v * 2.0f - 1.0f) * depth * tanY, -depth);
+
+        int32_t z = clusters.slice(depth);
+        ASSERT_GE(z, 0);
+        uint32_t x = MIN(static_cast<uint32_t>(u * clusters.sizeX()), clusters.sizeX() - 1);
+        uint32_t y = MIN(static_cast<uint32_t>(v * clusters.sizeY()), clusters.sizeY() - 1);
+
+        auto &cluster = list[clusters.clusterIndex(x, y, z)];
+        std::set<uint32_t> result(indices.begin() + cluster.offset, indices.begin() + cluster.offset + cluster.count);
+
+        for(uint32_t l = 0; l < lights.size(); l++) {
+            if((centers[l] - point).length() < lights[l].w) {
+                ASSERT_TRUE(result.count(l) == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,158 @@
+#include "tst_common.h"
+
+#include "utils/meshoptimizer.h"
+
+#include <algorithm>
+#include <array>
+
+class MeshOptimizerTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        const uint32_t size = 32;
+        for(uint32_t y = 0; y <= size; y++) {
+            for(uint32_t x = 0; x <= size; x++) {
+                m_vertices.push_back(Vector3(x, y, 0.0f));
+            }
+        }
+        for(uint32_t y = 0; y < size; y++) {
+            for(uint32_t x = 0; x < size; x++) {
+                uint32_t i = y * (size + 1) + x;
+                m_indices.insert(m_indices.end(), {i, i + 1, i + size + 1});
+                m_indices.insert(m_indices.end(), {i + 1, i + size + 2, i + size + 1});
+            }
+        }
+
+        // Shuffle triangles to emulate a poor source order
+        uint32_t seed = 1;
+        for(uint32_t t = m_indices.size() / 3 - 1; t > 0; t--) {
+            seed = seed * 1664525U + 1013904223U;
+            uint32_t r = (seed >> 8) % (t + 1);
+            std::swap_ranges(&m_indices[t * 3], &m_indices[t * 3 + 3], &m_indices[r * 3]);
+        }
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles(const std::vector<uint32_t> &indices) {
+        std::vector<std::array<uint32_t, 3>> result;
+        for(uint32_t i = 0; i < indices.size(); i += 3) {
+            std::array<uint32_t, 3> t = {indices[i], indices[i + 1], indices[i + 2]};
+            // Rotate to the smallest index first to keep the winding
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            result.push_back(t);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<Vector3> m_vertices;
+
+    std::vector<uint32_t> m_indices;
+
+};
+
+TEST_F(MeshOptimizerTest, Vertex_cache) {
+    std::vector<uint32_t> indices = m_indices;
+
+    float before = MeshOptimizer::cacheMissRatio(indices.data(), indices.size(), m_vertices.size());
+    MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), m_vertices.size());
+    float after = MeshOptimizer::cacheMissRatio(indices.data(), indices.size(), m_vertices.size());
+
+    ASSERT_GT(before, 2.0f);
+    ASSERT_LT(after, 0.8f);
+    ASSERT_TRUE(triangles(indices) == triangles(m_indices));
+}
+
+TEST_F(MeshOptimizerTest, Overdraw) {
+    std::vector<uint32_t> indices = m_indices;
+
+    MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), m_vertices.size());
+    float cache = MeshOptimizer::cacheMissRatio(indices.data(), indices.size(), m_vertices.size());
+
+    MeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), m_vertices.data(), m_vertices.size());
+
+    ASSERT_TRUE(triangles(indices) == triangles(m_indices));
+    // Reordering of clusters mustn't break the vertex cache efficiency
+    ASSERT_LT(MeshOptimizer::cacheMissRatio(indices.data(), indices.size(), m_vertices.size()), cache * 1.1f);
+}
+
+TEST_F(MeshOptimizerTest, Quantization) {
+    for(float value : {0.0f, 1.0f, -2.5f, 0.333f, 1024.75f, 65504.0f, 0.00001f}) {
+        float result = MeshOptimizer::unpackHalf(MeshOptimizer::packHalf(value));
+        ASSERT_NEAR(result, value, fabs(value) * 0.001f + 0.0000001f);
+    }
+    ASSERT_EQ(MeshOptimizer::packHalf(1.0f), 0x3C00);
+    ASSERT_EQ(MeshOptimizer::packHalf(-2.0f), 0xC000);
+    ASSERT_EQ(MeshOptimizer::packHalf(100000.0f), 0x7C00);
+
+    Vector3 normal(0.3f, -0.5f, 0.8f);
+    normal.normalize();
+    Vector3 result = MeshOptimizer::unpackSnorm(MeshOptimizer::packSnorm(normal));
+    for(int i = 0; i < 3; i++) {
+        ASSERT_NEAR(result[i], normal[i], 1.0f / 127.0f);
+    }
+    ASSERT_TRUE(MeshOptimizer::unpackSnorm(MeshOptimizer::packSnorm(Vector3(-1.0f, 1.0f, 0.0f))) == Vector3(-1.0f, 1.0f, 0.0f));
+}
+
+TEST_F(MeshOptimizerTest, Quantizable_range) {
+    Mesh mesh;
+    mesh.setVertices({Vector3(0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f)});
+    mesh.setUv0({Vector2(0.0f), Vector2(1.0f, 0.0f), Vector2(0.0f, -1.5f)});
+    ASSERT_TRUE(MeshOptimizer::isQuantizable(mesh));
+
+    // Tiled coordinates lose too much precision in the half floats
+    mesh.setUv0({Vector2(0.0f), Vector2(16.0f, 0.0f), Vector2(0.0f, 1.0f)});
+    ASSERT_FALSE(MeshOptimizer::isQuantizable(mesh));
+}
+
+TEST_F(MeshOptimizerTest, Simplify_plane) {
+    std::vector<uint32_t> indices = m_indices;
+
+    // Interior of the flat grid can be collapsed without any error, the border is locked
+    IndexVector result = MeshOptimizer::simplify(indices.data(), indices.size(), m_vertices.data(), m_vertices.size(), indices.size() / 4, 0.001f);
+
+    ASSERT_LE(result.size(), indices.size() / 4);
+    ASSERT_EQ(result.size() % 3, 0);
+
+    float area = 0.0f;
+    for(uint32_t i = 0; i < result.size(); i += 3) {
+        ASSERT_TRUE(result[i] != result[i + 1] && result[i + 1] != result[i + 2] && result[i] != result[i + 2]);
+
+        Vector3 n = (m_vertices[result[i + 1]] - m_vertices[result[i]]).cross(m_vertices[result[i + 2]] - m_vertices[result[i]]);
+        // Winding must be kept
+        ASSERT_GT(n.z, 0.0f);
+        area += n.z * 0.5f;
+    }
+    ASSERT_NEAR(area, 32.0f * 32.0f, 0.01f);
+}
+
+TEST_F(MeshOptimizerTest, Simplify_error_limit) {
+    // Closed torus surface without borders
+    const uint32_t rings = 32;
+    const uint32_t sides = 16;
+    std::vector<Vector3> vertices;
+    for(uint32_t r = 0; r < rings; r++) {
+        float a = 2.0f * PI * r / rings;
+        for(uint32_t s = 0; s < sides; s++) {
+            float b = 2.0f * PI * s / sides;
+            float d = 2.0f + 0.5f * cos(b);
+            vertices.push_back(Vector3(d * cos(a), d * sin(a), 0.5f * sin(b)));
+        }
+    }
+    std::vector<uint32_t> indices;
+    for(uint32_t r = 0; r < rings; r++) {
+        for(uint32_t s = 0; s < sides; s++) {
+            uint32_t i0 = r * sides + s;
+            uint32_t i1 = ((r + 1) % rings) * sides + s;
+            uint32_t i2 = ((r + 1) % rings) * sides + (s + 1) % sides;
+            uint32_t i3 = r * sides + (s + 1) % sides;
+            indices.insert(indices.end(), {i0, i1, i2, i0, i2, i3});
+        }
+    }
+
+    IndexVector strict = MeshOptimizer::simplify(indices.data(), indices.size(), vertices.data(), vertices.size(), 0, 0.0001f);
+    IndexVector loose = MeshOptimizer::simplify(indices.data(), indices.size(), vertices.data(), vertices.size(), indices.size() / 4, 0.1f);
+
+    // Curved surface can't be simplified with a tiny error
+    ASSERT_EQ(strict.size(), indices.size());
+    ASSERT_LE(loose.size(), indices.size() / 4);
+    ASSERT_GT(loose.size(), 0);
+}
@@ -0,0 +1,57 @@
+#include "tst_common.h"
+
+#include "utils/parallelfor.h"
+
+#include <threadpool.h>
+
+#include <atomic>
+
+class ParallelForTest : public ::testing::Test {
+
+};
+
+TEST_F(ParallelForTest, Each_index_once) {
+    std::vector<std::atomic<uint32_t>> hits(1000);
+    for(auto &it : hits) {
+        it = 0;
+    }
+
+    ThreadPool pool;
+    pool.setMaxThreads(4);
+
+    ParallelFor::run(&pool, hits.size(), [&hits](uint32_t index) {
+        hits[index]++;
+    });
+
+    for(auto &it : hits) {
+        ASSERT_EQ(it, 1);
+    }
+
+    // Without a pool the loop is executed on the calling thread
+    ParallelFor::run(nullptr, hits.size(), [&hits](uint32_t index) {
+        hits[index]++;
+    });
+
+    for(auto &it : hits) {
+        ASSERT_EQ(it, 2);
+    }
+
+    pool.waitForDone();
+}
+
+TEST_F(ParallelForTest, Nested_on_busy_pool) {
+    ThreadPool pool;
+    pool.setMaxThreads(2);
+
+    // All workers of the pool run the outer loop, the inner loops must not wait for the pool
+    std::atomic<uint32_t> sum(0);
+    ParallelFor::run(&pool, 4, [&pool, &sum](uint32_t) {
+        ParallelFor::run(&pool, 100, [&sum](uint32_t index) {
+            sum += index;
+        });
+    });
+
+    EXPECT_EQ(sum, 4 * 4950);
+
+    pool.waitForDone();
+}
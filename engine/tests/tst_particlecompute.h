@@ -0,0 +1,179 @@
+#include "tst_common.h"
+
+#include "utils/particlecompute.h"
+
+#include <glslang/Public/ShaderLang.h>
+
+#include <algorithm>
+
+class ParticleComputeTest : public ::testing::Test {
+public:
+    static ParticleProgram::Register reg(int32_t space, int32_t offset, int32_t size) {
+        ParticleProgram::Register result;
+        result.space = space;
+        result.offset = offset;
+        result.size = size;
+        return result;
+    }
+
+    static void add(ParticleProgram &program, int32_t op, const ParticleProgram::Register &result,
+                    const ParticleProgram::Register &a, const ParticleProgram::Register &b = ParticleProgram::Register()) {
+        ParticleProgram::Instruction instruction;
+        instruction.op = op;
+        instruction.size = result.size;
+        instruction.result = result;
+        instruction.arguments[0] = a;
+        instruction.arguments[1] = b;
+        program.addInstruction(instruction);
+    }
+
+    static std::vector<std::vector<float>> renderables(const std::vector<float> &render, int32_t count, int32_t stride) {
+        std::vector<std::vector<float>> result;
+        for(int32_t i = 0; i < count; i++) {
+            result.push_back(std::vector<float>(render.begin() + i * stride, render.begin() + (i + 1) * stride));
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // age, lifetime, position.xyz
+    static void effect(ParticleProgram &spawn, ParticleProgram &update, ParticleProgram &render) {
+        int32_t lifetime = spawn.addConstant(Vector4(0.35f));
+        int32_t position = spawn.addConstant(Vector4(1.0f, 2.0f, 3.0f, 0.0f));
+        add(spawn, ParticleProgram::Mov, reg(ParticleProgram::Particle, 1, 1), reg(ParticleProgram::Constant, lifetime, 1));
+        add(spawn, ParticleProgram::Mov, reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Particle, 1, 1));
+        add(spawn, ParticleProgram::Mov, reg(ParticleProgram::Particle, 2, 3), reg(ParticleProgram::Constant, position, 3));
+
+        int32_t velocity = update.addConstant(Vector4(0.5f, -1.0f, 2.0f, 0.0f));
+        add(update, ParticleProgram::Sub, reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Emitter, VisualEffect::DeltaTime, 1));
+        add(update, ParticleProgram::Mul, reg(ParticleProgram::Local, 0, 3), reg(ParticleProgram::Constant, velocity, 3), reg(ParticleProgram::Emitter, VisualEffect::DeltaTime, 1));
+        add(update, ParticleProgram::Add, reg(ParticleProgram::Particle, 2, 3), reg(ParticleProgram::Particle, 2, 3), reg(ParticleProgram::Local, 0, 3));
+
+        add(render, ParticleProgram::Mov, reg(ParticleProgram::Renderable, 12, 3), reg(ParticleProgram::Particle, 2, 3));
+        add(render, ParticleProgram::Div, reg(ParticleProgram::Renderable, 0, 1), reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Particle, 1, 1));
+    }
+
+};
+
+TEST_F(ParticleComputeTest, Cpu_equivalence) {
+    const int32_t capacity = 70;
+    const int32_t stride = 5;
+    const int32_t renderStride = 20;
+
+    ParticleProgram spawn;
+    ParticleProgram update;
+    ParticleProgram render;
+    effect(spawn, update, render);
+
+    std::vector<float> emitter(VisualEffect::LastAttribute, 0.0f);
+    std::vector<float> particles(ParticleProgram::bufferSize(stride, capacity), 0.0f);
+    std::vector<float> renderData(capacity * renderStride, 0.0f);
+
+    ParticleProgram::Context reference;
+    reference.emitter = emitter.data();
+    reference.particles = particles.data();
+    reference.render = renderData.data();
+    reference.capacity = capacity;
+    reference.stride = stride;
+    reference.renderStride = renderStride;
+
+    std::vector<float> gpuParticles(particles);
+    std::vector<float> gpuRender(renderData);
+
+    ParticleProgram::Context gpu(reference);
+    gpu.particles = gpuParticles.data();
+    gpu.render = gpuRender.data();
+
+    ParticleCompute::State state;
+    std::fill(state.emitter, state.emitter + VisualEffect::LastAttribute, 0.0f);
+
+    for(int32_t frame = 0; frame < 12; frame++) {
+        // Variable spawn rate to have particles of different ages
+        float spawned = 5.0f + (frame % 3) * 2.5f;
+        emitter[VisualEffect::DeltaTime] = 0.1f;
+        emitter[VisualEffect::SpawnCounter] += spawned;
+
+        state.emitter[VisualEffect::DeltaTime] = 0.1f;
+        state.emitter[VisualEffect::SpawnCounter] += spawned;
+        state.spawnRequest = static_cast<uint32_t>(state.emitter[VisualEffect::SpawnCounter]);
+        state.emitter[VisualEffect::SpawnCounter] -= state.spawnRequest;
+        state.spawned = 0;
+        state.arguments[ParticleCompute::InstanceCount] = 0;
+
+        VisualEffect::simulate(spawn, update, render, reference);
+        ParticleCompute::dispatch(spawn, update, render, gpu, state);
+
+        int32_t alive = static_cast<int32_t>(emitter[VisualEffect::AliveParticles]);
+        ASSERT_GT(alive, 0);
+        ASSERT_LT(alive, capacity);
+        ASSERT_EQ(alive, static_cast<int32_t>(state.arguments[ParticleCompute::InstanceCount]));
+        ASSERT_EQ(emitter[VisualEffect::SpawnCounter], state.emitter[VisualEffect::SpawnCounter]);
+
+        ASSERT_EQ(renderables(renderData, alive, renderStride), renderables(gpuRender, alive, renderStride));
+    }
+}
+
+TEST_F(ParticleComputeTest, Kernel_source) {
+    ParticleProgram spawn;
+    ParticleProgram update;
+    ParticleProgram render;
+    effect(spawn, update, render);
+
+    ParticleProgram::Context layout;
+    layout.capacity = 128;
+    layout.stride = 5;
+    layout.renderStride = 20;
+
+    std::string source = ParticleCompute::source(spawn, update, render, layout);
+
+    EXPECT_NE(source.find("layout(local_size_x = 64) in;"), std::string::npos);
+    // Age update of the particle attributes
+    EXPECT_NE(source.find("p[0 + i] = p[0 + i] - emitter[1];"), std::string::npos);
+    // The update constants follow the spawn ones
+    EXPECT_NE(source.find("l[2] = k[10] * emitter[1];"), std::string::npos);
+    // The renderable output slot
+    EXPECT_NE(source.find("r[14 + o] = p[512 + i];"), std::string::npos);
+
+    std::vector<float> constants = ParticleCompute::constants(spawn, update, render);
+    ASSERT_EQ(constants.size(), spawn.constants().size() + update.constants().size());
+    EXPECT_EQ(constants[10], 2.0f);
+}
+
+TEST_F(ParticleComputeTest, Kernel_compiles) {
+    ParticleProgram spawn;
+    ParticleProgram update;
+    ParticleProgram render;
+    effect(spawn, update, render);
+
+    ParticleProgram::Context layout;
+    layout.capacity = 128;
+    layout.stride = 5;
+    layout.renderStride = 20;
+
+    std::string source = ParticleCompute::source(spawn, update, render, layout);
+    const char *str = source.c_str();
+
+    // The limits required by the kernel, the rest of the built-ins aren't used
+    TBuiltInResource resources = {};
+    resources.maxComputeWorkGroupCountX = 65535;
+    resources.maxComputeWorkGroupCountY = 65535;
+    resources.maxComputeWorkGroupCountZ = 65535;
+    resources.maxComputeWorkGroupSizeX = 1024;
+    resources.maxComputeWorkGroupSizeY = 1024;
+    resources.maxComputeWorkGroupSizeZ = 64;
+    resources.limits = {true, true, true, true, true, true, true, true, true};
+
+    glslang::InitializeProcess();
+    {
+        glslang::TShader shader(EShLangCompute);
+        shader.setStrings(&str, 1);
+
+        bool result = shader.parse(&resources, 430, ECoreProfile, false, false, EShMsgDefault);
+        EXPECT_TRUE(result) << shader.getInfoLog() << source;
+
+        glslang::TProgram program;
+        program.addShader(&shader);
+        EXPECT_TRUE(result && program.link(EShMsgDefault)) << program.getInfoLog();
+    }
+    glslang::FinalizeProcess();
+}
@@ -0,0 +1,152 @@
+#include "tst_common.h"
+
+#include "utils/particleprogram.h"
+
+class ParticleProgramTest : public ::testing::Test {
+public:
+    static ParticleProgram::Register reg(int32_t space, int32_t offset, int32_t size) {
+        ParticleProgram::Register result;
+        result.space = space;
+        result.offset = offset;
+        result.size = size;
+        return result;
+    }
+
+    static ParticleProgram::Instruction instruction(int32_t op, const ParticleProgram::Register &result,
+                                                    const ParticleProgram::Register &a, const ParticleProgram::Register &b = ParticleProgram::Register()) {
+        ParticleProgram::Instruction instruction;
+        instruction.op = op;
+        instruction.size = result.size;
+        instruction.result = result;
+        instruction.arguments[0] = a;
+        instruction.arguments[1] = b;
+        return instruction;
+    }
+
+    // Executes the program particle by particle with the interleaved attributes
+    static void reference(const ParticleProgram &program, std::vector<float> &emitter, std::vector<float> &particles, std::vector<float> &render,
+                          int32_t stride, int32_t renderStride, int32_t capacity, int32_t count) {
+        const std::vector<float> &constants = program.constants();
+
+        for(int32_t i = 0; i < count; i++) {
+            float local[4] = {0.0f};
+            float *p = &particles[i * stride];
+            float *r = &render[i * renderStride];
+
+            for(auto &it : program.instructions()) {
+                auto address = [&](const ParticleProgram::Register &reg, int32_t c) -> float {
+                    c = (reg.size == 1) ? 0 : c;
+                    switch(reg.space) {
+                        case ParticleProgram::Emitter: return emitter[reg.offset + c];
+                        case ParticleProgram::Particle: return p[reg.offset + c];
+                        case ParticleProgram::Local: return local[c];
+                        case ParticleProgram::Constant: return constants[reg.offset + c];
+                        case ParticleProgram::Random: return constants[reg.offset + c * capacity + i];
+                        default: break;
+                    }
+                    return 0.0f;
+                };
+
+                for(int32_t c = 0; c < it.size; c++) {
+                    float a = address(it.arguments[0], c);
+                    float b = address(it.arguments[1], c);
+
+                    float value = a;
+                    switch(it.op) {
+                        case ParticleProgram::Add: value = a + b; break;
+                        case ParticleProgram::Sub: value = a - b; break;
+                        case ParticleProgram::Mul: value = a * b; break;
+                        case ParticleProgram::Div: value = a / b; break;
+                        default: break;
+                    }
+
+                    switch(it.result.space) {
+                        case ParticleProgram::Particle: p[it.result.offset + c] = value; break;
+                        case ParticleProgram::Renderable: r[it.result.offset + c] = value; break;
+                        case ParticleProgram::Local: local[c] = value; break;
+                        default: break;
+                    }
+                }
+            }
+        }
+    }
+
+};
+
+TEST_F(ParticleProgramTest, Reference_equivalence) {
+    const int32_t capacity = 37;
+    const int32_t stride = 7; // age, lifetime, position, velocity.xy
+    const int32_t renderStride = 20;
+
+    ParticleProgram program;
+    int32_t lifetime = program.addRandom(Vector4(1.0f), Vector4(2.0f), 1, capacity);
+    int32_t position = program.addRandom(Vector4(-1.0f), Vector4(1.0f), 3, capacity);
+    int32_t scale = program.addConstant(Vector4(0.5f, 2.0f, 3.0f, 0.0f));
+    int32_t velocity = program.addConstant(Vector4(0.25f, -4.0f, 0.0f, 0.0f));
+
+    program.addInstruction(instruction(ParticleProgram::Mov, reg(ParticleProgram::Particle, 1, 1), reg(ParticleProgram::Random, lifetime, 1)));
+    program.addInstruction(instruction(ParticleProgram::Mov, reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Particle, 1, 1)));
+    program.addInstruction(instruction(ParticleProgram::Mov, reg(ParticleProgram::Particle, 2, 3), reg(ParticleProgram::Random, position, 3)));
+    program.addInstruction(instruction(ParticleProgram::Mov, reg(ParticleProgram::Particle, 5, 2), reg(ParticleProgram::Constant, velocity, 2)));
+    program.addInstruction(instruction(ParticleProgram::Sub, reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Particle, 0, 1), reg(ParticleProgram::Emitter, 1, 1)));
+    program.addInstruction(instruction(ParticleProgram::Mul, reg(ParticleProgram::Local, 0, 2), reg(ParticleProgram::Particle, 5, 2), reg(ParticleProgram::Emitter, 1, 1)));
+    program.addInstruction(instruction(ParticleProgram::Add, reg(ParticleProgram::Particle, 2, 2), reg(ParticleProgram::Particle, 2, 2), reg(ParticleProgram::Local, 0, 2)));
+    program.addInstruction(instruction(ParticleProgram::Mul, reg(ParticleProgram::Local, 0, 3), reg(ParticleProgram::Particle, 2, 3), reg(ParticleProgram::Constant, scale, 3)));
+    program.addInstruction(instruction(ParticleProgram::Div, reg(ParticleProgram::Renderable, 12, 3), reg(ParticleProgram::Local, 0, 3), reg(ParticleProgram::Particle, 1, 1)));
+    program.addInstruction(instruction(ParticleProgram::Mov, reg(ParticleProgram::Renderable, 0, 1), reg(ParticleProgram::Particle, 0, 1)));
+
+    std::vector<float> emitter = {0.0f, 1.0f / 60.0f, 0.0f, 0.0f, 0.0f};
+
+    std::vector<float> particles(ParticleProgram::bufferSize(stride, capacity), 0.0f);
+    std::vector<float> render(capacity * renderStride, 0.0f);
+
+    ParticleProgram::Context context;
+    context.emitter = emitter.data();
+    context.particles = particles.data();
+    context.render = render.data();
+    context.capacity = capacity;
+    context.stride = stride;
+    context.renderStride = renderStride;
+
+    program.execute(context, 0, capacity);
+
+    std::vector<float> expectedParticles(capacity * stride, 0.0f);
+    std::vector<float> expectedRender(capacity * renderStride, 0.0f);
+    reference(program, emitter, expectedParticles, expectedRender, stride, renderStride, capacity, capacity);
+
+    for(int32_t i = 0; i < capacity; i++) {
+        for(int32_t a = 0; a < stride; a++) {
+            ASSERT_EQ(particles[a * capacity + i], expectedParticles[i * stride + a]);
+        }
+    }
+    ASSERT_EQ(render, expectedRender);
+}
+
+TEST_F(ParticleProgramTest, Compact) {
+    const int32_t capacity = 6;
+    const int32_t stride = 2;
+
+    std::vector<float> particles = {
+        1.0f, 0.0f, 2.0f, -1.0f, 3.0f, 0.0f, // age
+        10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f // attribute
+    };
+    particles.resize(ParticleProgram::bufferSize(stride, capacity), 0.0f);
+
+    ParticleProgram::Context context;
+    context.particles = particles.data();
+    context.capacity = capacity;
+    context.stride = stride;
+
+    // The last lane is not in use
+    ASSERT_EQ(ParticleProgram::compact(context, 5), 3);
+
+    // The dead lanes are filled from the end
+    ASSERT_EQ(particles[0], 1.0f);
+    ASSERT_EQ(particles[1], 3.0f);
+    ASSERT_EQ(particles[2], 2.0f);
+    ASSERT_EQ(particles[capacity + 0], 10.0f);
+    ASSERT_EQ(particles[capacity + 1], 14.0f);
+    ASSERT_EQ(particles[capacity + 2], 12.0f);
+
+    ASSERT_EQ(ParticleProgram::compact(context, 3), 3);
+}
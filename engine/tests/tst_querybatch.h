@@ -0,0 +1,84 @@
+#include "tst_common.h"
+
+#include "components/world.h"
+
+#include "utils/querybatch.h"
+
+class QueryBatchTest : public ::testing::Test {
+public:
+    // Unit spheres along the X axis, the object pointer is the index of the sphere plus one
+    static void sphereQuery(System *, World *, QueryBatch &batch) {
+        for(uint32_t i = 0; i < batch.size(); i++) {
+            const QueryBatch::Query &query = batch.query(i);
+            Ray::Hit *hits = batch.hits(i);
+
+            uint32_t count = 0;
+            for(int32_t s = 0; s < 4 && count < query.capacity; s++) {
+                Ray ray(query.ray);
+                Ray::Hit hit;
+                if(ray.intersect(Vector3(s * 4.0f, 0.0f, 0.0f), 1.0f, &hit) && hit.distance <= query.distance) {
+                    hit.object = reinterpret_cast<Object *>(intptr_t(s + 1));
+                    hits[count++] = hit;
+                }
+            }
+            batch.setHitCount(i, count);
+        }
+    }
+
+};
+
+TEST_F(QueryBatchTest, Storage) {
+    QueryBatch batch;
+    ASSERT_EQ(batch.addRayCast(Ray(Vector3(), Vector3(1.0f, 0.0f, 0.0f)), 10.0f), 0);
+    ASSERT_EQ(batch.addRayCastAll(Ray(Vector3(), Vector3(1.0f, 0.0f, 0.0f)), 10.0f, 3), 1);
+    ASSERT_EQ(batch.addOverlap(Vector3(), 1.0f, 0), 2);
+
+    ASSERT_EQ(batch.size(), 3);
+    ASSERT_EQ(batch.state(), QueryBatch::Idle);
+
+    // Each query owns a separate range of hits
+    ASSERT_EQ(batch.query(1).first, 1);
+    ASSERT_EQ(batch.query(1).capacity, 3);
+    ASSERT_EQ(batch.query(2).first, 4);
+    ASSERT_EQ(batch.query(2).capacity, 1);
+
+    batch.setHitCount(1, 5);
+    ASSERT_EQ(batch.hitCount(1), 3);
+
+    batch.resetHits();
+    ASSERT_EQ(batch.hitCount(1), 0);
+}
+
+TEST_F(QueryBatchTest, Immediate_and_deferred) {
+    World world;
+    world.setQueryHandler(&sphereQuery, nullptr);
+
+    QueryBatch batch;
+    batch.addRayCast(Ray(Vector3(-2.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f)), 100.0f);
+    batch.addRayCastAll(Ray(Vector3(-2.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f)), 7.0f, 4);
+    batch.addRayCast(Ray(Vector3(-2.0f, 5.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f)), 100.0f);
+
+    world.query(batch);
+    ASSERT_TRUE(batch.isReady());
+
+    ASSERT_EQ(batch.hitCount(0), 1);
+    ASSERT_EQ(batch.hit(0).object, reinterpret_cast<Object *>(1));
+    ASSERT_EQ(batch.hitCount(1), 2);
+    ASSERT_EQ(batch.hit(1, 1).object, reinterpret_cast<Object *>(2));
+    ASSERT_EQ(batch.hitCount(2), 0);
+
+    // The results of the deferred batch arrive after the physics update only
+    world.queryDeferred(batch);
+    ASSERT_EQ(batch.state(), QueryBatch::Pending);
+
+    world.processDeferredQueries();
+    ASSERT_TRUE(batch.isReady());
+    ASSERT_EQ(batch.hitCount(1), 2);
+
+    QueryBatch cancelled;
+    cancelled.addRayCast(Ray(Vector3(-2.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f)), 100.0f);
+    world.queryDeferred(cancelled);
+    world.cancelQuery(cancelled);
+    world.processDeferredQueries();
+    ASSERT_EQ(cancelled.state(), QueryBatch::Idle);
+}
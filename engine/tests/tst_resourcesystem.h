@@ -0,0 +1,169 @@
+#include "tst_common.h"
+
+#include "engine.h"
+#include "file.h"
+
+#include "systems/resourcesystem.h"
+
+#include "resources/prefab.h"
+#include "resources/texture.h"
+
+#include "utils/texturestreamer.h"
+
+#include "components/actor.h"
+#include "components/transform.h"
+
+#include <bson.h>
+
+#include <thread>
+
+class ResourceSystemTest : public ::testing::Test {
+public:
+    class MemoryFile : public File {
+        struct Stream {
+            const ByteArray *data;
+
+            _size_t position;
+        };
+
+    public:
+        _FILE *fopen(const char *path, const char *mode) override {
+            auto it = m_files.find(path);
+            if(it != m_files.end()) {
+                return new Stream({&it->second, 0});
+            }
+            return nullptr;
+        }
+
+        _size_t fread(void *ptr, _size_t size, _size_t count, _FILE *stream) override {
+            Stream *s = static_cast<Stream *>(stream);
+            _size_t result = MIN(size * count, s->data->size() - s->position);
+            memcpy(ptr, s->data->data() + s->position, result);
+            s->position += result;
+            return result / size;
+        }
+
+        _size_t fsize(_FILE *stream) override {
+            return static_cast<Stream *>(stream)->data->size();
+        }
+
+        int fclose(_FILE *stream) override {
+            delete static_cast<Stream *>(stream);
+            return 0;
+        }
+
+        std::map<std::string, ByteArray> m_files;
+
+    };
+
+};
+
+TEST_F(ResourceSystemTest, Async_load_hierarchy) {
+    MemoryFile file;
+    Engine system(&file, "");
+
+    Prefab *source = Engine::objectCreate<Prefab>("");
+    Actor *root = Engine::composeActor("", "Root");
+    root->transform()->setPosition(Vector3(1.0f, 2.0f, 3.0f));
+    Actor *child = Engine::composeActor("", "Child", root);
+    child->setProperty("custom", 5);
+    source->setActor(root);
+
+    ByteArray data = Bson::save(Engine::toVariant(source));
+    uint32_t uuid = source->uuid();
+    delete source;
+
+    file.m_files["{sync}"] = data;
+    file.m_files["{async}"] = data;
+
+    ResourceSystem *resources = system.resourceSystem();
+    resources->indices()["sync.fab"] = std::make_pair("Prefab", "{sync}");
+    resources->indices()["async.fab"] = std::make_pair("Prefab", "{async}");
+
+    Prefab *sync = Engine::loadResource<Prefab>("sync.fab");
+    ASSERT_TRUE(sync != nullptr);
+
+    Prefab *async = Engine::loadResourceAsync<Prefab>("async.fab");
+    ASSERT_TRUE(async != nullptr);
+    ASSERT_TRUE(resources->isLoading(async));
+    EXPECT_EQ(async->state(), Resource::Loading);
+
+    while(resources->isLoading(async)) {
+        resources->processEvents();
+        std::this_thread::yield();
+    }
+
+    // The same instance is filled with the same hierarchy as the synchronous load produces
+    EXPECT_EQ(Engine::loadResource<Prefab>("async.fab"), async);
+    EXPECT_EQ(async->uuid(), uuid);
+    EXPECT_EQ(async->uuid(), sync->uuid());
+    EXPECT_EQ(async->getChildren().size(), 1);
+
+    ASSERT_TRUE(sync->actor() != nullptr);
+    ASSERT_TRUE(async->actor() != nullptr);
+    EXPECT_EQ(async->actor()->name(), "Root");
+    EXPECT_EQ(async->actor()->transform()->position(), Vector3(1.0f, 2.0f, 3.0f));
+
+    Actor *asyncChild = nullptr;
+    for(auto it : async->actor()->getChildren()) {
+        if(it->name() == "Child") {
+            asyncChild = dynamic_cast<Actor *>(it);
+        }
+    }
+    ASSERT_TRUE(asyncChild != nullptr);
+    EXPECT_EQ(asyncChild->property("custom").toInt(), 5);
+
+    EXPECT_EQ(Bson::save(Engine::toVariant(async->actor())), Bson::save(Engine::toVariant(sync->actor())));
+}
+
+TEST_F(ResourceSystemTest, Streamed_texture_reload) {
+    MemoryFile file;
+    Engine system(&file, "");
+
+    Texture *source = Engine::objectCreate<Texture>("");
+    source->setFormat(Texture::RGBA8);
+    source->resize(256, 256);
+
+    Texture::Surface &surface = source->surface(0);
+    surface.clear();
+    for(int32_t i = 0; i < 9; i++) {
+        int32_t size = MAX(256 >> i, 1);
+        surface.push_back(ByteArray(size * size * 4, i + 1));
+    }
+
+    file.m_files["{texture}"] = Bson::save(Engine::toVariant(source));
+    delete source;
+
+    ResourceSystem *resources = system.resourceSystem();
+    resources->indices()["texture.png"] = std::make_pair("Texture", "{texture}");
+
+    Texture *texture = Engine::loadResource<Texture>("texture.png");
+    ASSERT_TRUE(texture != nullptr);
+    ASSERT_EQ(texture->mipCount(), 9);
+
+    // The levels above the tail are released from memory when the texture is evicted
+    TextureStreamer::setBudget(1);
+    texture->setStreaming(true);
+    TextureStreamer::update();
+
+    int32_t tail = TextureStreamer::tailMip(256, 256, 9);
+    ASSERT_EQ(texture->residentMip(), tail);
+    for(int32_t i = 0; i < tail; i++) {
+        EXPECT_TRUE(texture->getPixels(i).empty());
+    }
+    EXPECT_EQ(texture->getPixels(tail).size(), 64 * 64 * 4);
+
+    // And read from the bundle again on the upgrade
+    TextureStreamer::setBudget(UINT64_MAX);
+    for(int32_t mip = tail - 1; mip >= 0; mip--) {
+        TextureStreamer::requestMip(texture, 0);
+        TextureStreamer::update();
+
+        ASSERT_EQ(texture->residentMip(), mip);
+        int32_t size = 256 >> mip;
+        EXPECT_EQ(texture->getPixels(mip), ByteArray(size * size * 4, mip + 1));
+    }
+
+    texture->setStreaming(false);
+    TextureStreamer::setBudget(0);
+}
@@ -0,0 +1,180 @@
+#include "tst_common.h"
+
+#include "file.h"
+
+#include "pipelinetasks/shadowmap.h"
+#include "pipelinecontext.h"
+
+#include "components/pointlight.h"
+
+#include "systems/rendersystem.h"
+
+class ShadowMapTest : public ::testing::Test {
+public:
+    class EmptyFile : public File {
+    public:
+        _FILE *fopen(const char *path, const char *mode) override {
+            A_UNUSED(path);
+            A_UNUSED(mode);
+            return nullptr;
+        }
+
+    };
+
+    class TestShadowMap : public ShadowMap {
+    public:
+        using ShadowMap::ShadowRequest;
+        using ShadowMap::TileState;
+        using ShadowMap::TileContent;
+        using ShadowMap::TileUpdate;
+
+        using ShadowMap::Skip;
+        using ShadowMap::Dynamic;
+        using ShadowMap::Full;
+
+        using ShadowMap::m_requests;
+        using ShadowMap::m_tileStates;
+        using ShadowMap::m_tilesPerFrame;
+        using ShadowMap::m_nextRequest;
+
+        using ShadowMap::exec;
+        using ShadowMap::tileUpdate;
+
+    };
+
+};
+
+TEST_F(ShadowMapTest, Tile_update) {
+    TestShadowMap::TileContent content;
+    content.lightHash = 1;
+    content.staticHash = 2;
+
+    // The tile which was never drawn and the tile without caching are always redrawn
+    TestShadowMap::TileState tile;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, content, true), TestShadowMap::Full);
+
+    tile.valid = true;
+    tile.content = content;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, content, false), TestShadowMap::Full);
+
+    // Nothing to do without the dynamic casters
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, content, true), TestShadowMap::Skip);
+
+    // The static depth must be cached first to draw only the dynamic casters
+    content.dynamicHash = 3;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, content, true), TestShadowMap::Full);
+
+    tile.staticCached = true;
+    tile.content = content;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, content, true), TestShadowMap::Dynamic);
+
+    // The dynamic casters which left the tile must be erased
+    content.dynamicHash = 0;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, content, true), TestShadowMap::Dynamic);
+
+    // Any change of the light or the static casters invalidates the cached depth
+    TestShadowMap::TileContent changed(content);
+    changed.lightHash = 4;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, changed, true), TestShadowMap::Full);
+
+    changed = content;
+    changed.staticHash = 5;
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, changed, true), TestShadowMap::Full);
+
+    changed = content;
+    changed.staticBound = AABBox(Vector3(1.0f), Vector3(2.0f));
+    EXPECT_EQ(TestShadowMap::tileUpdate(tile, changed, true), TestShadowMap::Full);
+}
+
+TEST_F(ShadowMapTest, Tiles_per_frame) {
+    // The pipeline context works without the embedded resources
+    EmptyFile file;
+    Engine engine(&file, "");
+    RenderSystem render;
+
+    PipelineContext context;
+
+    TestShadowMap shadows;
+    shadows.m_tilesPerFrame = 2;
+
+    std::vector<PointLight *> lights;
+    for(int32_t i = 0; i < 3; i++) {
+        PointLight *light = Engine::objectCreate<PointLight>();
+        lights.push_back(light);
+
+        TestShadowMap::ShadowRequest request;
+        request.light = light;
+        request.count = 1;
+        request.x[0] = i * 64;
+        request.y[0] = 0;
+        request.w[0] = 64;
+        request.h[0] = 64;
+        request.crop[0] = Matrix4::perspective(90.0f, 1.0f, 0.1f, 10.0f);
+
+        shadows.m_requests.push_back(request);
+    }
+
+    auto tile = [&](int32_t index) -> TestShadowMap::TileState & {
+        return shadows.m_tileStates[lights[index]->uuid()][0];
+    };
+
+    auto move = [&](float offset) {
+        for(auto &it : shadows.m_requests) {
+            Matrix4 m;
+            m.translate(Vector3(offset, 0.0f, 0.0f));
+            it.view[0] = m;
+        }
+    };
+
+    // The tiles which were never drawn are out of the budget
+    shadows.exec(context);
+    for(int32_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(tile(i).valid);
+    }
+    EXPECT_EQ(shadows.m_nextRequest, 0);
+
+    std::vector<Matrix4> matrices;
+    for(int32_t i = 0; i < 3; i++) {
+        matrices.push_back(tile(i).matrix);
+    }
+
+    // All the lights are moved, but only two tiles are redrawn
+    move(1.0f);
+    shadows.exec(context);
+    EXPECT_NE(tile(0).matrix, matrices[0]);
+    EXPECT_NE(tile(1).matrix, matrices[1]);
+    EXPECT_EQ(tile(2).matrix, matrices[2]);
+    EXPECT_EQ(shadows.m_nextRequest, 2);
+
+    // The next frame starts from the outdated light
+    shadows.exec(context);
+    EXPECT_NE(tile(2).matrix, matrices[2]);
+
+    for(int32_t i = 0; i < 3; i++) {
+        matrices[i] = tile(i).matrix;
+    }
+
+    move(2.0f);
+    shadows.exec(context);
+    EXPECT_NE(tile(2).matrix, matrices[2]);
+    EXPECT_NE(tile(0).matrix, matrices[0]);
+    EXPECT_EQ(tile(1).matrix, matrices[1]);
+    EXPECT_EQ(shadows.m_nextRequest, 1);
+
+    shadows.exec(context);
+    EXPECT_NE(tile(1).matrix, matrices[1]);
+
+    // Unchanged tiles are not redrawn
+    for(int32_t i = 0; i < 3; i++) {
+        matrices[i] = tile(i).matrix;
+    }
+    shadows.exec(context);
+    shadows.exec(context);
+    for(int32_t i = 0; i < 3; i++) {
+        EXPECT_EQ(tile(i).matrix, matrices[i]);
+    }
+
+    for(auto it : lights) {
+        delete it;
+    }
+}
@@ -0,0 +1,152 @@
+#include "tst_common.h"
+
+#include "resources/texture.h"
+#include "utils/textureencoder.h"
+
+#include <cmath>
+
+class TextureEncoderTest : public ::testing::Test {
+public:
+    void SetUp() override {
+        // Smooth gradients with a hard edged disc in the middle
+        m_image.resize(gSize * gSize * 4);
+        for(int32_t y = 0; y < gSize; y++) {
+            for(int32_t x = 0; x < gSize; x++) {
+                uint8_t *pixel = &m_image[(y * gSize + x) * 4];
+                bool disc = (x - 32) * (x - 32) + (y - 32) * (y - 32) < 256;
+                pixel[0] = disc ? 240 : x * 4;
+                pixel[1] = disc ? 32 : y * 4;
+                pixel[2] = (x + y) * 2;
+                pixel[3] = disc ? 64 : 255 - x * 2;
+            }
+        }
+    }
+
+    float error(const ByteArray &decoded, int32_t channel) const {
+        double sum = 0.0;
+        for(int32_t i = 0; i < gSize * gSize; i++) {
+            double d = double(decoded[i * 4 + channel]) - double(m_image[i * 4 + channel]);
+            sum += d * d;
+        }
+        return float(sqrt(sum / (gSize * gSize)));
+    }
+
+    ByteArray roundTrip(int32_t compression, int32_t quality = TextureEncoder::Normal) const {
+        ByteArray data = TextureEncoder::encode(m_image.data(), gSize, gSize, compression, quality);
+        EXPECT_EQ(data.size(), (gSize / 4) * (gSize / 4) * TextureEncoder::blockSize(compression));
+        return TextureEncoder::decode(data.data(), gSize, gSize, compression);
+    }
+
+    static constexpr int32_t gSize = 64;
+
+    ByteArray m_image;
+
+};
+
+TEST_F(TextureEncoderTest, Block_sizes) {
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::Uncompressed), 0);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::DXT1), 8);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::DXT5), 16);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::BC4), 8);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::BC5), 16);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::BC7), 16);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::ETC2), 8);
+    ASSERT_EQ(TextureEncoder::blockSize(Texture::ETC2A), 16);
+
+    // The partial blocks on the edges are padded
+    ByteArray data = TextureEncoder::encode(m_image.data(), 6, 5, Texture::BC7);
+    ASSERT_EQ(data.size(), 2 * 2 * 16);
+    ASSERT_EQ(TextureEncoder::decode(data.data(), 6, 5, Texture::BC7).size(), 6 * 5 * 4);
+
+    ASSERT_TRUE(TextureEncoder::encode(m_image.data(), gSize, gSize, Texture::Uncompressed).empty());
+}
+
+TEST_F(TextureEncoderTest, Round_trip_error) {
+    ByteArray bc1 = roundTrip(Texture::DXT1);
+    ByteArray bc3 = roundTrip(Texture::DXT5);
+    ByteArray bc4 = roundTrip(Texture::BC4);
+    ByteArray bc5 = roundTrip(Texture::BC5);
+    ByteArray bc7 = roundTrip(Texture::BC7);
+    ByteArray etc = roundTrip(Texture::ETC2);
+    ByteArray eac = roundTrip(Texture::ETC2A);
+
+    // The ETC1 compatible modes have a single chroma per half block, so the disc edges dominate the error
+    for(int32_t c = 0; c < 3; c++) {
+        EXPECT_LT(error(bc1, c), 4.0f);
+        EXPECT_LT(error(bc3, c), 4.0f);
+        EXPECT_LT(error(bc7, c), 4.0f);
+        EXPECT_LT(error(etc, c), 12.0f);
+        EXPECT_LT(error(eac, c), 12.0f);
+    }
+    EXPECT_LT(error(bc3, 3), 2.0f);
+    EXPECT_LT(error(bc7, 3), 4.0f);
+    EXPECT_LT(error(eac, 3), 2.0f);
+
+    EXPECT_LT(error(bc4, 0), 2.0f);
+    EXPECT_LT(error(bc5, 0), 2.0f);
+    EXPECT_LT(error(bc5, 1), 2.0f);
+}
+
+TEST_F(TextureEncoderTest, Quality_presets) {
+    // The better presets search more endpoints around the same initial guess
+    for(int32_t compression : {Texture::DXT1, Texture::BC7, Texture::ETC2}) {
+        ByteArray fast = roundTrip(compression, TextureEncoder::Fast);
+        ByteArray best = roundTrip(compression, TextureEncoder::Best);
+        float fastError = 0.0f;
+        float bestError = 0.0f;
+        for(int32_t c = 0; c < 3; c++) {
+            fastError += error(fast, c) * error(fast, c);
+            bestError += error(best, c) * error(best, c);
+        }
+        EXPECT_LE(bestError, fastError);
+    }
+}
+
+TEST_F(TextureEncoderTest, Parallel_encoding) {
+    const int32_t size = 512;
+    ByteArray image(size * size * 4);
+    for(uint32_t i = 0; i < image.size(); i++) {
+        image[i] = (i * 2654435761U) >> 24;
+    }
+
+    ByteArray data = TextureEncoder::encode(image.data(), size, size, Texture::DXT1, TextureEncoder::Fast);
+    ASSERT_EQ(data.size(), (size / 4) * (size / 4) * 8);
+
+    // The last block must match the single block encoding
+    uint8_t pixels[64];
+    for(int32_t y = 0; y < 4; y++) {
+        memcpy(&pixels[y * 16], &image[((size - 4 + y) * size + size - 4) * 4], 16);
+    }
+    uint8_t block[8];
+    TextureEncoder::encodeBlock(pixels, block, Texture::DXT1, TextureEncoder::Fast);
+    ASSERT_EQ(memcmp(block, &data[data.size() - 8], 8), 0);
+}
+
+TEST_F(TextureEncoderTest, Gamma_correct_downsample) {
+    // Checker board of black and white pixels
+    ByteArray image(4 * 2 * 4);
+    for(int32_t i = 0; i < 8; i++) {
+        uint8_t value = ((i % 4 + i / 4) % 2) ? 255 : 0;
+        memset(&image[i * 4], value, 3);
+        image[i * 4 + 3] = value;
+    }
+
+    ByteArray linear = TextureEncoder::downsample(image.data(), 4, 2, TextureEncoder::Box, false);
+    ASSERT_EQ(linear.size(), 2 * 1 * 4);
+    EXPECT_EQ(linear[0], 128);
+    EXPECT_EQ(linear[3], 128);
+
+    // The half of the linear intensity is brighter in the sRGB space, the alpha channel is always linear
+    ByteArray srgb = TextureEncoder::downsample(image.data(), 4, 2, TextureEncoder::Box, true);
+    EXPECT_NEAR(srgb[0], 188, 1);
+    EXPECT_EQ(srgb[3], 128);
+
+    for(int32_t filter : {TextureEncoder::Triangle, TextureEncoder::Kaiser}) {
+        ByteArray result = TextureEncoder::downsample(m_image.data(), gSize, gSize - 1, filter, true);
+        ASSERT_EQ(result.size(), (gSize / 2) * (gSize / 2 - 1) * 4);
+    }
+
+    ByteArray last = TextureEncoder::downsample(image.data(), 1, 1, TextureEncoder::Kaiser, true);
+    ASSERT_EQ(last.size(), 4);
+    ASSERT_EQ(memcmp(last.data(), image.data(), 4), 0);
+}
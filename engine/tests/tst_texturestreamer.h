@@ -0,0 +1,110 @@
+#include "tst_common.h"
+
+#include "utils/texturestreamer.h"
+
+class TextureStreamerTest : public ::testing::Test {
+public:
+    static TextureStreamer::Residency residency(int32_t size, int32_t resident, int32_t required, uint32_t lastUse) {
+        TextureStreamer::Residency result;
+        int32_t count = 1;
+        while((size >> (count - 1)) > 1) {
+            count++;
+        }
+        for(int32_t i = 0; i < count; i++) {
+            int32_t s = MAX(size >> i, 1);
+            result.sizes.push_back(s * s * 4);
+        }
+        result.resident = resident;
+        result.required = required;
+        result.tail = TextureStreamer::tailMip(size, size, count);
+        result.lastUse = lastUse;
+        return result;
+    }
+
+    static uint64_t memory(const TextureStreamer::Residency &item, int32_t mip) {
+        uint64_t result = 0;
+        for(size_t i = mip; i < item.sizes.size(); i++) {
+            result += item.sizes[i];
+        }
+        return result;
+    }
+
+};
+
+TEST_F(TextureStreamerTest, Tail_mip) {
+    ASSERT_EQ(TextureStreamer::tailMip(1024, 1024, 11), 4);
+    ASSERT_EQ(TextureStreamer::tailMip(1024, 64, 11), 4);
+    ASSERT_EQ(TextureStreamer::tailMip(64, 64, 7), 0);
+    // Without MIP levels the whole texture is the tail
+    ASSERT_EQ(TextureStreamer::tailMip(1024, 1024, 1), 0);
+}
+
+TEST_F(TextureStreamerTest, Upgrade_one_level_per_frame) {
+    TextureStreamer::ResidencyList list = { residency(1024, 4, 0, 1) };
+
+    for(int32_t expected = 3; expected >= 0; expected--) {
+        TextureStreamer::Statistics stats = TextureStreamer::plan(list, UINT64_MAX);
+        ASSERT_EQ(list[0].target, expected);
+        ASSERT_EQ(stats.upgrades, 1);
+        ASSERT_EQ(stats.visible, 1);
+        list[0].resident = list[0].target;
+    }
+
+    TextureStreamer::Statistics stats = TextureStreamer::plan(list, UINT64_MAX);
+    ASSERT_EQ(list[0].target, 0);
+    ASSERT_EQ(stats.upgrades, 0);
+    ASSERT_EQ(stats.partial, 0);
+    ASSERT_EQ(stats.residentMemory, memory(list[0], 0));
+
+    // The lower requirement is evicted immediately
+    list[0].required = 2;
+    stats = TextureStreamer::plan(list, UINT64_MAX);
+    ASSERT_EQ(list[0].target, 2);
+    ASSERT_EQ(stats.evictions, 1);
+}
+
+TEST_F(TextureStreamerTest, Budget_fitting) {
+    TextureStreamer::ResidencyList list = {
+        residency(1024, 0, 0, 1),
+        residency(256, 0, 0, 1)
+    };
+
+    // The biggest level is skipped first
+    uint64_t budget = memory(list[0], 1) + memory(list[1], 0);
+    TextureStreamer::Statistics stats = TextureStreamer::plan(list, budget);
+    ASSERT_EQ(list[0].target, 1);
+    ASSERT_EQ(list[1].target, 0);
+    ASSERT_EQ(stats.partial, 1);
+    ASSERT_EQ(stats.evictions, 1);
+    ASSERT_LE(stats.residentMemory, budget);
+    ASSERT_EQ(stats.requestedMemory, memory(list[0], 0) + memory(list[1], 0));
+
+    // The tail is never evicted
+    stats = TextureStreamer::plan(list, 0);
+    ASSERT_EQ(list[0].target, list[0].tail);
+    ASSERT_EQ(list[1].target, list[1].tail);
+    ASSERT_EQ(stats.residentMemory, memory(list[0], list[0].tail) + memory(list[1], list[1].tail));
+}
+
+TEST_F(TextureStreamerTest, Least_recently_used_eviction) {
+    TextureStreamer::ResidencyList list = {
+        residency(512, 0, INT32_MAX, 5),
+        residency(512, 0, INT32_MAX, 2),
+        residency(512, 0, 0, 10)
+    };
+
+    // The not requested textures keep their levels while the budget allows
+    TextureStreamer::Statistics stats = TextureStreamer::plan(list, UINT64_MAX);
+    ASSERT_EQ(list[0].target, 0);
+    ASSERT_EQ(list[1].target, 0);
+    ASSERT_EQ(stats.visible, 1);
+
+    // The oldest one is dropped to the tail first
+    uint64_t budget = memory(list[0], 0) * 2 + memory(list[1], list[1].tail);
+    stats = TextureStreamer::plan(list, budget);
+    ASSERT_EQ(list[0].target, 0);
+    ASSERT_EQ(list[1].target, list[1].tail);
+    ASSERT_EQ(list[2].target, 0);
+    ASSERT_EQ(stats.evictions, 1);
+    ASSERT_EQ(stats.partial, 0);
+}
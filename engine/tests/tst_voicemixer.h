@@ -0,0 +1,164 @@
+#include "tst_common.h"
+
+#include "utils/voicemixer.h"
+
+class VoiceMixerTest : public ::testing::Test {
+public:
+    static VoiceMixer::Emitter emitter(const std::vector<int16_t> &data, uint32_t channels, uint32_t frequency, const Vector3 &position) {
+        VoiceMixer::Emitter result;
+        result.clip.data = data.data();
+        result.clip.channels = channels;
+        result.clip.frames = data.size() / channels;
+        result.clip.frequency = frequency;
+        result.clip.loudness = VoiceMixer::loudness(data.data(), data.size());
+        result.position = position;
+        return result;
+    }
+
+};
+
+TEST_F(VoiceMixerTest, Deterministic_mix) {
+    std::vector<int16_t> noise(997);
+    uint32_t seed = 1;
+    for(auto &it : noise) {
+        seed = seed * 1664525 + 1013904223;
+        it = static_cast<int16_t>(seed >> 16);
+    }
+    std::vector<int16_t> constant(64, 16384);
+
+    std::vector<float> outputs[2];
+    for(auto &output : outputs) {
+        VoiceMixer mixer(44100, 8);
+        mixer.play(emitter(noise, 1, 32000, Vector3(-3.0f, 0.0f, 1.0f)));
+        mixer.play(emitter(noise, 1, 48000, Vector3(2.0f, 1.0f, 0.0f)));
+        VoiceMixer::Emitter loop = emitter(constant, 2, 44100, Vector3(0.0f, 0.0f, 5.0f));
+        loop.loop = true;
+        mixer.play(loop);
+
+        // Odd block size to cover the scalar tail of the accumulation
+        output.resize(333 * 2 * 4);
+        for(uint32_t block = 0; block < 4; block++) {
+            mixer.mix(&output[block * 333 * 2], 333);
+        }
+    }
+    ASSERT_EQ(outputs[0], outputs[1]);
+
+    // A centered voice at the listener position
+    VoiceMixer mixer(44100, 8);
+    mixer.play(emitter(constant, 1, 44100, Vector3()));
+
+    std::vector<float> output(17 * 2);
+    mixer.mix(output.data(), 17);
+    for(auto it : output) {
+        EXPECT_NEAR(it, 0.5f * sqrtf(0.5f), 1e-6f);
+    }
+}
+
+TEST_F(VoiceMixerTest, Virtualisation) {
+    std::vector<int16_t> data(4096, 1000);
+
+    VoiceMixer mixer(44100, 2);
+
+    uint32_t voices[4];
+    for(uint32_t i = 0; i < 4; i++) {
+        voices[i] = mixer.play(emitter(data, 1, 44100, Vector3(i + 1.0f, 0.0f, 0.0f)));
+    }
+
+    std::vector<float> output(100 * 2);
+    mixer.mix(output.data(), 100);
+
+    // The closest voices are real
+    EXPECT_TRUE(mixer.isReal(voices[0]));
+    EXPECT_TRUE(mixer.isReal(voices[1]));
+    EXPECT_FALSE(mixer.isReal(voices[2]));
+    EXPECT_FALSE(mixer.isReal(voices[3]));
+
+    // The virtual voices advance with the same rate
+    for(auto it : voices) {
+        EXPECT_EQ(mixer.position(it), 100);
+    }
+
+    // The priority overrides the distance
+    mixer.stop(voices[3]);
+    VoiceMixer::Emitter important = emitter(data, 1, 44100, Vector3(4.0f, 0.0f, 0.0f));
+    important.priority = 1;
+    voices[3] = mixer.play(important);
+
+    mixer.mix(output.data(), 100);
+    EXPECT_TRUE(mixer.isReal(voices[0]));
+    EXPECT_FALSE(mixer.isReal(voices[1]));
+    EXPECT_TRUE(mixer.isReal(voices[3]));
+    EXPECT_EQ(mixer.position(voices[1]), 200);
+}
+
+TEST_F(VoiceMixerTest, Distance_culling) {
+    std::vector<int16_t> data(4096, 1000);
+
+    VoiceMixer mixer(44100, 4);
+
+    VoiceMixer::Emitter far = emitter(data, 1, 44100, Vector3(0.0f, 0.0f, 50.0f));
+    far.maxDistance = 20.0f;
+    uint32_t voice = mixer.play(far);
+
+    std::vector<float> output(64 * 2, 1.0f);
+    mixer.mix(output.data(), 64);
+
+    EXPECT_FALSE(mixer.isReal(voice));
+    EXPECT_EQ(mixer.position(voice), 64);
+    for(auto it : output) {
+        EXPECT_EQ(it, 0.0f);
+    }
+
+    // The voice to the right of the listener
+    mixer.setPosition(voice, Vector3(10.0f, 0.0f, 0.0f));
+    mixer.mix(output.data(), 64);
+
+    EXPECT_TRUE(mixer.isReal(voice));
+    EXPECT_NEAR(output[0], 0.0f, 1e-6f);
+    EXPECT_GT(output[1], 0.0f);
+
+    // The emitter without the maximum distance is never culled
+    uint32_t distant = mixer.play(emitter(data, 1, 44100, Vector3(0.0f, 0.0f, 1000.0f)));
+    mixer.mix(output.data(), 64);
+
+    EXPECT_TRUE(mixer.isReal(distant));
+}
+
+TEST_F(VoiceMixerTest, Resampling) {
+    std::vector<int16_t> data(100);
+    for(uint32_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<int16_t>(i * 100);
+    }
+
+    VoiceMixer mixer(44100, 4);
+    uint32_t once = mixer.play(emitter(data, 1, 22050, Vector3()));
+    VoiceMixer::Emitter loop = emitter(data, 1, 22050, Vector3());
+    loop.loop = true;
+    uint32_t looped = mixer.play(loop);
+
+    std::vector<float> output(150 * 2);
+    mixer.mix(output.data(), 150);
+    EXPECT_EQ(mixer.position(once), 75);
+
+    // The half rate clip is interpolated between the source frames
+    float gain = sqrtf(0.5f) * 2.0f / 32768.0f;
+    EXPECT_NEAR(output[2], 50.0f * gain, 1e-5f);
+    EXPECT_NEAR(output[4], 100.0f * gain, 1e-5f);
+
+    mixer.mix(output.data(), 60);
+    EXPECT_FALSE(mixer.isPlaying(once));
+    EXPECT_TRUE(mixer.isPlaying(looped));
+    EXPECT_EQ(mixer.position(looped), 5);
+}
+
+TEST_F(VoiceMixerTest, Convert) {
+    float input[] = {0.0f, 0.5f, -0.5f, 2.0f, -2.0f};
+    int16_t output[5];
+    VoiceMixer::convert(input, output, 5);
+
+    EXPECT_EQ(output[0], 0);
+    EXPECT_EQ(output[1], 16384);
+    EXPECT_EQ(output[2], -16384);
+    EXPECT_EQ(output[3], 32767);
+    EXPECT_EQ(output[4], -32767);
+}
@@ -15,7 +15,9 @@
 #include <resources/resource.h>
 #include <resources/material.h>
 
-#define FORMAT_VERSION 8
+#include <editor/projectsettings.h>
+
+#define FORMAT_VERSION 10
 
 void copyData(uint8_t *dst, const uchar *src, uint32_t size, uint8_t channels) {
     if(channels == 3) {
@@ -33,11 +35,32 @@ void copyData(uint8_t *dst, const uchar *src, uint32_t size, uint8_t channels) {
     }
 }
 
+static int32_t platformCompression(int32_t compression) {
+    // The mobile GPUs don't support the BC formats, ETC2 is the closest replacement
+    QString platform = ProjectSettings::instance()->currentPlatformName();
+    if(platform == "android" || platform == "ios" || platform == "tvos") {
+        switch(compression) {
+            case Texture::DXT1:
+            case Texture::BC4:
+            case Texture::BC5: return Texture::ETC2;
+            case Texture::DXT5:
+            case Texture::BC7: return Texture::ETC2A;
+            default: break;
+        }
+    }
+    return compression;
+}
+
 TextureImportSettings::TextureImportSettings() :
         m_assetType(AssetType::Texture2D),
         m_filtering(FilteringType::None),
         m_wrap(WrapType::Repeat),
-        m_lod(false) {
+        m_mipFilter(MipFilterType::Triangle),
+        m_compression(CompressionType::Uncompressed),
+        m_quality(QualityType::Normal),
+        m_lod(false),
+        m_srgb(true),
+        m_streaming(false) {
 
     setVersion(FORMAT_VERSION);
     setType(MetaType::type<Texture *>());
@@ -88,6 +111,56 @@ void TextureImportSettings::setLod(bool lod) {
     }
 }
 
+TextureImportSettings::MipFilterType TextureImportSettings::mipFilter() const {
+    return m_mipFilter;
+}
+void TextureImportSettings::setMipFilter(MipFilterType filter) {
+    if(m_mipFilter != filter) {
+        m_mipFilter = filter;
+        emit updated();
+    }
+}
+
+bool TextureImportSettings::srgb() const {
+    return m_srgb;
+}
+void TextureImportSettings::setSrgb(bool srgb) {
+    if(m_srgb != srgb) {
+        m_srgb = srgb;
+        emit updated();
+    }
+}
+
+TextureImportSettings::CompressionType TextureImportSettings::compression() const {
+    return m_compression;
+}
+void TextureImportSettings::setCompression(CompressionType compression) {
+    if(m_compression != compression) {
+        m_compression = compression;
+        emit updated();
+    }
+}
+
+TextureImportSettings::QualityType TextureImportSettings::quality() const {
+    return m_quality;
+}
+void TextureImportSettings::setQuality(QualityType quality) {
+    if(m_quality != quality) {
+        m_quality = quality;
+        emit updated();
+    }
+}
+
+bool TextureImportSettings::streaming() const {
+    return m_streaming;
+}
+void TextureImportSettings::setStreaming(bool streaming) {
+    if(m_streaming != streaming) {
+        m_streaming = streaming;
+        emit updated();
+    }
+}
+
 std::string TextureImportSettings::findFreeElementName(const std::string &name) {
     QString newName = name.c_str();
     if(!newName.isEmpty()) {
@@ -224,101 +297,141 @@ AssetConverter::ReturnCode TextureConverter::convertFile(AssetConverterSettings
     return Success;
 }
 
-void TextureConverter::convertTexture(Texture *texture, TextureImportSettings *settings) {
+AssetConverter::ReturnCode TextureConverter::prepareFile(AssetConverterSettings *settings) {
+    TextureImportSettings *s = dynamic_cast<TextureImportSettings *>(settings);
+    if(s) {
+        prepareTexture(s);
+    }
+
+    return Success;
+}
+
+void TextureConverter::prepareTexture(TextureImportSettings *settings) const {
+    // Doesn't touch the engine objects to be able to run out of the main thread
     uint8_t channels = 4;
     QImage src(settings->source());
     QImage img = src.convertToFormat(QImage::Format_RGBA8888);
 
-    texture->clear();
-
-    texture->setFormat(Texture::RGBA8);
-    texture->setFiltering(Texture::FilteringType(settings->filtering()));
-    texture->setWrap(Texture::WrapType(settings->wrap()));
+    TextureImportSettings::Prepared &prepared = settings->m_prepared;
+    prepared.m_sides.clear();
+    prepared.m_width = img.width();
+    prepared.m_height = img.height();
 
     QList<QImage> sides;
     if(settings->assetType() == TextureImportSettings::AssetType::Cubemap) {
         QList<QPoint> positions;
         float ratio = (float)img.width() / (float)img.height();
-        texture->resize(img.width(), img.height());
         if(ratio == 6.0f / 1.0f) { // Row
-            texture->resize(img.width() / 6, img.height());
+            prepared.m_width = img.width() / 6;
             for(int i = 0; i < 6; i++) {
-                positions.push_back(QPoint(i * texture->width(), 0));
+                positions.push_back(QPoint(i * prepared.m_width, 0));
             }
         } else if(ratio == 1.0f / 6.0f) { // Column
-            texture->resize(img.width(), img.height() / 6);
+            prepared.m_height = img.height() / 6;
             for(int i = 0; i < 6; i++) {
-                positions.push_back(QPoint(0, i * texture->height()));
+                positions.push_back(QPoint(0, i * prepared.m_height));
             }
         } else if(ratio == 4.0f / 3.0f) { // Horizontal cross
-            texture->resize(img.width() / 4, img.height() / 3);
-            positions.push_back(QPoint(2 * texture->width(), 1 * texture->height()));
-            positions.push_back(QPoint(0 * texture->width(), 1 * texture->height()));
-            positions.push_back(QPoint(1 * texture->width(), 0 * texture->height()));
-            positions.push_back(QPoint(1 * texture->width(), 2 * texture->height()));
-            positions.push_back(QPoint(1 * texture->width(), 1 * texture->height()));
-            positions.push_back(QPoint(3 * texture->width(), 1 * texture->height()));
+            prepared.m_width = img.width() / 4;
+            prepared.m_height = img.height() / 3;
+            int32_t w = prepared.m_width;
+            int32_t h = prepared.m_height;
+            positions.push_back(QPoint(2 * w, 1 * h));
+            positions.push_back(QPoint(0 * w, 1 * h));
+            positions.push_back(QPoint(1 * w, 0 * h));
+            positions.push_back(QPoint(1 * w, 2 * h));
+            positions.push_back(QPoint(1 * w, 1 * h));
+            positions.push_back(QPoint(3 * w, 1 * h));
         } else if(ratio == 3.0f / 4.0f) { // Vertical cross
-            texture->resize(img.width() / 3, img.height() / 4);
-            positions.push_back(QPoint(1 * texture->width(), 1 * texture->height()));
-            positions.push_back(QPoint(1 * texture->width(), 3 * texture->height()));
-            positions.push_back(QPoint(1 * texture->width(), 0 * texture->height()));
-            positions.push_back(QPoint(1 * texture->width(), 2 * texture->height()));
-            positions.push_back(QPoint(0 * texture->width(), 1 * texture->height()));
-            positions.push_back(QPoint(2 * texture->width(), 1 * texture->height()));
+            prepared.m_width = img.width() / 3;
+            prepared.m_height = img.height() / 4;
+            int32_t w = prepared.m_width;
+            int32_t h = prepared.m_height;
+            positions.push_back(QPoint(1 * w, 1 * h));
+            positions.push_back(QPoint(1 * w, 3 * h));
+            positions.push_back(QPoint(1 * w, 0 * h));
+            positions.push_back(QPoint(1 * w, 2 * h));
+            positions.push_back(QPoint(0 * w, 1 * h));
+            positions.push_back(QPoint(2 * w, 1 * h));
         }
 
         QRect sub;
-        sub.setSize(QSize(texture->width(), texture->height()));
+        sub.setSize(QSize(prepared.m_width, prepared.m_height));
         foreach(const QPoint &it, positions) {
             sub.moveTo(it);
             sides.push_back(img.copy(sub));
         }
     } else {
-        texture->resize(img.width(), img.height());
         sides.push_back(img.mirrored());
     }
 
-    texture->clear();
+    int32_t compression = platformCompression(int32_t(settings->compression()));
+    int32_t quality = int32_t(settings->quality());
+    prepared.m_compression = compression;
+
+    auto encode = [&](const ByteArray &data, int32_t w, int32_t h) {
+        if(compression == Texture::Uncompressed) {
+            return data;
+        }
+        return TextureEncoder::encode(data.data(), w, h, compression, quality);
+    };
 
-    int i = 0;
     foreach(const QImage &it, sides) {
         Texture::Surface surface;
 
-        VariantList lods;
-
         ByteArray data;
         uint32_t size = it.width() * it.height() * channels;
         if(size) {
             data.resize(size);
             copyData(data.data(), it.constBits(), size, channels);
         }
-        surface.push_back(data);
+        surface.push_back(encode(data, it.width(), it.height()));
 
-        if(settings->lod()) {
+        if(settings->lod() && size) {
             /// \todo Specular convolution for cubemaps
-            int w = texture->width();
-            int h = texture->height();
-            QImage mip = it;
-            while(w > 1 && h > 1 ) {
+            int w = it.width();
+            int h = it.height();
+            while(w > 1 || h > 1) {
+                data = TextureEncoder::downsample(data.data(), w, h, int32_t(settings->mipFilter()), settings->srgb());
                 w = MAX(w / 2, 1);
                 h = MAX(h / 2, 1);
 
-                mip = mip.scaled(w, h, Qt::IgnoreAspectRatio);
-                size = w * h * channels;
-                if(size) {
-                    data.resize(size);
-                    copyData(&data[0], mip.constBits(), size, channels);
-                }
-                surface.push_back(data);
+                surface.push_back(encode(data, w, h));
             }
         }
-        texture->addSurface(surface);
+        prepared.m_sides.push_back(surface);
+    }
 
-        i++;
+    prepared.m_valid = true;
+}
+
+void TextureConverter::convertTexture(Texture *texture, TextureImportSettings *settings) {
+    TextureImportSettings::Prepared &prepared = settings->m_prepared;
+    if(!prepared.m_valid) {
+        prepareTexture(settings);
+    }
+
+    texture->clear();
+
+    texture->setFormat(Texture::RGBA8);
+    texture->setFiltering(Texture::FilteringType(settings->filtering()));
+    texture->setWrap(Texture::WrapType(settings->wrap()));
+    texture->setStreaming(settings->streaming());
+
+    texture->resize(prepared.m_width, prepared.m_height);
+
+    texture->clear();
+
+    texture->setCompress(prepared.m_compression);
+
+    for(auto &it : prepared.m_sides) {
+        texture->addSurface(it);
     }
 
     texture->setDirty();
+
+    // The prepared data is valid for a single conversion only
+    prepared = TextureImportSettings::Prepared();
 }
 
 void TextureConverter::convertSprite(Sprite *sprite, TextureImportSettings *settings) {
@@ -4,6 +4,8 @@
 #include <resources/texture.h>
 #include <resources/sprite.h>
 
+#include <utils/textureencoder.h>
+
 #include <editor/assetconverter.h>
 
 #include <QRect>
@@ -15,6 +17,11 @@ class TextureImportSettings : public AssetConverterSettings {
     Q_PROPERTY(WrapType Wrap READ wrap WRITE setWrap DESIGNABLE true USER true)
     Q_PROPERTY(bool MIP_maping READ lod WRITE setLod DESIGNABLE true USER true)
     Q_PROPERTY(FilteringType Filtering READ filtering WRITE setFiltering DESIGNABLE true USER true)
+    Q_PROPERTY(MipFilterType MIP_Filter READ mipFilter WRITE setMipFilter DESIGNABLE true USER true)
+    Q_PROPERTY(bool sRGB READ srgb WRITE setSrgb DESIGNABLE true USER true)
+    Q_PROPERTY(CompressionType Compression READ compression WRITE setCompression DESIGNABLE true USER true)
+    Q_PROPERTY(QualityType Quality READ quality WRITE setQuality DESIGNABLE true USER true)
+    Q_PROPERTY(bool Streaming READ streaming WRITE setStreaming DESIGNABLE true USER true)
 
 public:
     enum class AssetType {
@@ -35,9 +42,35 @@ public:
         Mirrored
     };
 
+    enum class CompressionType {
+        Uncompressed = Texture::Uncompressed,
+        BC1 = Texture::DXT1,
+        BC3 = Texture::DXT5,
+        BC4 = Texture::BC4,
+        BC5 = Texture::BC5,
+        BC7 = Texture::BC7,
+        ETC2 = Texture::ETC2,
+        ETC2A = Texture::ETC2A
+    };
+
+    enum class QualityType {
+        Fast = TextureEncoder::Fast,
+        Normal = TextureEncoder::Normal,
+        Best = TextureEncoder::Best
+    };
+
+    enum class MipFilterType {
+        Box = TextureEncoder::Box,
+        Triangle = TextureEncoder::Triangle,
+        Kaiser = TextureEncoder::Kaiser
+    };
+
     Q_ENUM(WrapType)
     Q_ENUM(FilteringType)
     Q_ENUM(AssetType)
+    Q_ENUM(CompressionType)
+    Q_ENUM(QualityType)
+    Q_ENUM(MipFilterType)
 
     struct Element {
         Vector2 m_min;
@@ -58,6 +91,18 @@ public:
     };
     typedef std::map<std::string, Element> ElementMap;
 
+    struct Prepared {
+        std::vector<Texture::Surface> m_sides;
+
+        int32_t m_width = 0;
+
+        int32_t m_height = 0;
+
+        int32_t m_compression = Texture::Uncompressed;
+
+        bool m_valid = false;
+    };
+
 public:
     TextureImportSettings();
 
@@ -73,6 +118,21 @@ public:
     bool lod() const;
     void setLod(bool lod);
 
+    MipFilterType mipFilter() const;
+    void setMipFilter(MipFilterType filter);
+
+    bool srgb() const;
+    void setSrgb(bool srgb);
+
+    CompressionType compression() const;
+    void setCompression(CompressionType compression);
+
+    QualityType quality() const;
+    void setQuality(QualityType quality);
+
+    bool streaming() const;
+    void setStreaming(bool streaming);
+
     ElementMap &elements();
     std::string setElement(const Element &element, const std::string &key = std::string());
     void removeElement(const std::string &key);
@@ -88,6 +148,8 @@ private:
 
     QString defaultIcon(QString) const override;
 
+    friend class TextureConverter;
+
 protected:
     AssetType m_assetType;
 
@@ -95,10 +157,22 @@ protected:
 
     WrapType m_wrap;
 
+    MipFilterType m_mipFilter;
+
+    CompressionType m_compression;
+
+    QualityType m_quality;
+
     ElementMap m_elements;
 
+    Prepared m_prepared;
+
     bool m_lod;
 
+    bool m_srgb;
+
+    bool m_streaming;
+
 };
 
 class TextureConverter : public AssetConverter {
@@ -107,7 +181,12 @@ public:
     void convertSprite(Sprite *sheet, TextureImportSettings *settings);
 
 private:
+    void prepareTexture(TextureImportSettings *settings) const;
+
     QStringList suffixes() const Q_DECL_OVERRIDE { return {"bmp", "dds", "jpg", "jpeg", "png", "tga", "ico", "tif"}; }
+
+    bool hasPrepareStep() const override { return true; }
+    ReturnCode prepareFile(AssetConverterSettings *settings) override;
     ReturnCode convertFile(AssetConverterSettings *settings) override;
 
     AssetConverterSettings *createSettings() override;
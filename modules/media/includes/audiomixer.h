@@ -0,0 +1,203 @@
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <amath.h>
+#include <utils/voicemixer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class AudioClip;
+
+class AudioMixer {
+public:
+    enum CommandType {
+        Play,
+        Stop,
+        Position,
+        Loop,
+        Volume,
+        Remove,
+        Listener
+    };
+
+    struct Command {
+        int32_t type = Play;
+
+        uint32_t voice = 0;
+
+        AudioClip *clip = nullptr;
+
+        Vector3 position;
+
+        Vector3 right;
+
+        int32_t priority = 0;
+
+        float volume = 1.0f;
+
+        float minDistance = 1.0f;
+
+        float maxDistance = FLT_MAX;
+
+        bool loop = false;
+    };
+
+public:
+    AudioMixer();
+    ~AudioMixer();
+
+    void start();
+    void stop();
+
+    bool isRunning() const;
+
+    void post(const Command &command);
+
+    static AudioMixer *instance();
+
+    static uint32_t createVoice();
+
+    static void removeClip(AudioClip *clip);
+
+protected:
+    enum {
+        OutputBuffers = 4
+    };
+
+    struct Voice {
+        AudioClip *clip = nullptr;
+
+        std::vector<uint8_t> data;
+
+        Vector3 position;
+
+        uint32_t source = 0;
+
+        uint32_t buffers[2] = {0, 0};
+
+        uint32_t format = 0;
+
+        uint32_t positionSamples = 0;
+
+        uint32_t mixed = 0;
+
+        int32_t priority = 0;
+
+        float volume = 1.0f;
+
+        float minDistance = 1.0f;
+
+        float maxDistance = FLT_MAX;
+
+        uint8_t current = 0;
+
+        bool loop = false;
+
+        bool cached = false;
+    };
+
+    struct ClipData {
+        AudioClip *clip = nullptr;
+
+        std::vector<uint8_t> pcm;
+
+        float loudness = 0.0f;
+
+        uint32_t users = 0;
+    };
+
+    class CommandQueue {
+    public:
+        CommandQueue();
+
+        bool push(const Command &command);
+        bool pop(Command &command);
+
+    private:
+        enum {
+            Capacity = 1024
+        };
+
+        struct Cell {
+            std::atomic<uint32_t> sequence;
+
+            Command command;
+        };
+
+        Cell m_cells[Capacity];
+
+        std::atomic<uint32_t> m_enqueue;
+
+        std::atomic<uint32_t> m_dequeue;
+    };
+
+    typedef std::list<ClipData> ClipList;
+
+    void run();
+
+    void process();
+
+    void execute(const Command &command);
+
+    void playVoice(Voice &voice);
+    void stopVoice(Voice &voice);
+    void updateVoice(Voice &voice);
+    void destroyVoice(Voice &voice);
+
+    void mixOutput();
+
+    void decodeClips(std::unique_lock<std::mutex> &lock);
+    static void decodeClip(AudioClip *clip, ClipData &data);
+
+    ClipData *acquireClip(AudioClip *clip);
+    void releaseClip(AudioClip *clip);
+    void purgeCache();
+
+    void clear(AudioClip *clip);
+
+protected:
+    CommandQueue m_commands;
+
+    std::vector<Command> m_pending;
+
+    std::unordered_map<uint32_t, Voice> m_voices;
+
+    ClipList m_cache;
+
+    std::unordered_map<AudioClip *, ClipList::iterator> m_cacheMap;
+
+    VoiceMixer m_voiceMixer;
+
+    std::vector<float> m_mixBuffer;
+
+    std::vector<int16_t> m_outputBuffer;
+
+    uint32_t m_output;
+
+    uint32_t m_outputBuffers[OutputBuffers];
+
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_decoded;
+
+    AudioClip *m_decoding;
+
+    std::atomic<bool> m_running;
+
+    uint32_t m_cacheSize;
+
+    static AudioMixer *m_instance;
+
+    static std::atomic<uint32_t> m_voiceCounter;
+
+};
+
+#endif // AUDIOMIXER_H
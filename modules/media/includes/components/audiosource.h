@@ -12,7 +12,11 @@ class MEDIA_EXPORT AudioSource : public NativeBehaviour {
     A_PROPERTIES(
         A_PROPERTYEX(AudioClip *, clip, AudioSource::clip, AudioSource::setClip, "editor=Asset"),
         A_PROPERTY(bool, autoPlay, AudioSource::autoPlay, AudioSource::setAutoPlay),
-        A_PROPERTY(bool, loop, AudioSource::loop, AudioSource::setLoop)
+        A_PROPERTY(bool, loop, AudioSource::loop, AudioSource::setLoop),
+        A_PROPERTY(int, priority, AudioSource::priority, AudioSource::setPriority),
+        A_PROPERTY(float, volume, AudioSource::volume, AudioSource::setVolume),
+        A_PROPERTY(float, minDistance, AudioSource::minDistance, AudioSource::setMinDistance),
+        A_PROPERTY(float, maxDistance, AudioSource::maxDistance, AudioSource::setMaxDistance)
     )
     A_METHODS(
         A_METHOD(void, AudioSource::play),
@@ -36,6 +40,18 @@ public:
     bool loop() const;
     void setLoop(bool loop);
 
+    int priority() const;
+    void setPriority(int priority);
+
+    float volume() const;
+    void setVolume(float volume);
+
+    float minDistance() const;
+    void setMinDistance(float distance);
+
+    float maxDistance() const;
+    void setMaxDistance(float distance);
+
 private:
     void start() override;
 
@@ -48,17 +64,17 @@ private:
 protected:
     AudioClip *m_clip;
 
-    std::vector<uint8_t> m_data;
+    Vector3 m_position;
 
-    uint32_t m_format;
+    uint32_t m_voice;
 
-    uint32_t m_buffers[2];
+    int32_t m_priority;
 
-    uint32_t m_positionSamples;
+    float m_volume;
 
-    uint32_t m_id;
+    float m_minDistance;
 
-    uint8_t m_current;
+    float m_maxDistance;
 
     bool m_loop;
 
@@ -5,6 +5,8 @@
 
 #include <AL/alc.h>
 
+#include "audiomixer.h"
+
 class MediaSystem : public System {
 public:
     MediaSystem();
@@ -20,6 +22,8 @@ protected:
     ALCdevice  *m_device;
     ALCcontext *m_context;
 
+    AudioMixer m_mixer;
+
     bool m_inited;
 };
 
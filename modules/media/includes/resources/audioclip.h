@@ -4,6 +4,8 @@
 #include <resource.h>
 #include <media.h>
 
+#include <mutex>
+
 class OggVorbis_File;
 
 class MEDIA_EXPORT AudioClip : public Resource {
@@ -11,6 +13,7 @@ class MEDIA_EXPORT AudioClip : public Resource {
 
 public:
     AudioClip();
+    AudioClip(const AudioClip &origin);
     virtual ~AudioClip();
 
     uint32_t channels() const;
@@ -42,6 +45,8 @@ private:
 
     _FILE *m_clip;
 
+    std::mutex m_mutex;
+
     uint32_t m_frequency;
 
     uint32_t m_channels;
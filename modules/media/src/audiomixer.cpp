@@ -0,0 +1,598 @@
+#include "audiomixer.h"
+
+#include <AL/al.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "resources/audioclip.h"
+
+namespace {
+    const uint32_t gStreamBufferSize = 65536;
+
+    const uint32_t gCacheLimit = 32 * 1024 * 1024;
+
+    const uint32_t gMixFrequency = 44100;
+
+    const uint32_t gMixFrames = 512;
+
+    const uint32_t gRealVoices = 32;
+
+    const std::chrono::milliseconds gPeriod(5);
+};
+
+AudioMixer *AudioMixer::m_instance = nullptr;
+std::atomic<uint32_t> AudioMixer::m_voiceCounter(0);
+
+/*!
+    \class AudioMixer
+    \brief The AudioMixer class owns all OpenAL voices and processes them on a dedicated audio thread.
+    \internal
+
+    The game code never touches the OpenAL objects directly: AudioSource components post play, stop and parameter commands to a lock-free queue
+    which is drained by the audio thread every few milliseconds.
+    All decoding happens on the audio thread as well, streamed clips are refilled there and never block the frame.
+    The clips are decoded into the cache before the commands which play them are executed and without holding the mixer lock,
+    so removing a clip from the main thread waits only for the decoding of that clip.
+
+    The decoded PCM data of non-stream clips is kept in the shared cache, so any number of sources which play the same clip decode it only once.
+    The clips which are not in use by any voice are evicted in the least recently used order when the cache exceeds its limit.
+
+    The non-stream voices don't allocate OpenAL sources, they are mixed in software by the VoiceMixer into a single stereo output stream.
+    Only the loudest and the most important of them are mixed, the rest are virtual voices which keep their playback positions.
+    Streamed clips still play on their own OpenAL sources.
+*/
+
+AudioMixer::AudioMixer() :
+        m_voiceMixer(gMixFrequency, gRealVoices),
+        m_output(0),
+        m_outputBuffers{0, 0, 0, 0},
+        m_decoding(nullptr),
+        m_running(false),
+        m_cacheSize(0) {
+
+    m_instance = this;
+}
+
+AudioMixer::~AudioMixer() {
+    stop();
+
+    if(m_instance == this) {
+        m_instance = nullptr;
+    }
+}
+/*!
+    Starts the audio thread. The OpenAL context must be current.
+*/
+void AudioMixer::start() {
+    if(!m_running) {
+        alGenSources(1, &m_output);
+        alGenBuffers(OutputBuffers, m_outputBuffers);
+        // The output is already spatialized by the voice mixer
+        alSourcei(m_output, AL_SOURCE_RELATIVE, true);
+
+        m_mixBuffer.resize(gMixFrames * 2);
+        m_outputBuffer.resize(gMixFrames * 2);
+        for(uint32_t i = 0; i < OutputBuffers; i++) {
+            std::fill(m_outputBuffer.begin(), m_outputBuffer.end(), 0);
+            alBufferData(m_outputBuffers[i], AL_FORMAT_STEREO16, m_outputBuffer.data(), m_outputBuffer.size() * sizeof(int16_t), gMixFrequency);
+        }
+        alSourceQueueBuffers(m_output, OutputBuffers, m_outputBuffers);
+        alSourcePlay(m_output);
+
+        m_running = true;
+        m_thread = std::thread(&AudioMixer::run, this);
+    }
+}
+/*!
+    Stops the audio thread and releases all voices and cached clips.
+*/
+void AudioMixer::stop() {
+    if(m_running) {
+        m_running = false;
+        m_thread.join();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        Command command;
+        while(m_commands.pop(command)) {
+            // Drop all pending commands
+        }
+        m_pending.clear();
+
+        for(auto &it : m_voices) {
+            destroyVoice(it.second);
+        }
+        m_voices.clear();
+
+        alSourceStop(m_output);
+        alSourcei(m_output, AL_BUFFER, 0);
+        alDeleteSources(1, &m_output);
+        alDeleteBuffers(OutputBuffers, m_outputBuffers);
+        m_output = 0;
+
+        m_cache.clear();
+        m_cacheMap.clear();
+        m_cacheSize = 0;
+    }
+}
+/*!
+    Returns true if the audio thread is running.
+*/
+bool AudioMixer::isRunning() const {
+    return m_running;
+}
+/*!
+    Posts the \a command to the audio thread. The function can be called from any thread.
+    The commands are dropped in case of the audio thread isn't running.
+*/
+void AudioMixer::post(const Command &command) {
+    while(m_running && !m_commands.push(command)) {
+        std::this_thread::yield();
+    }
+}
+/*!
+    Returns the active audio mixer.
+*/
+AudioMixer *AudioMixer::instance() {
+    return m_instance;
+}
+/*!
+    Returns a unique handle for the new voice.
+*/
+uint32_t AudioMixer::createVoice() {
+    return ++m_voiceCounter;
+}
+/*!
+    Stops all voices which play the \a clip and removes it from the cache.
+    Must be called before the \a clip is destroyed.
+*/
+void AudioMixer::removeClip(AudioClip *clip) {
+    if(m_instance && m_instance->m_running) {
+        m_instance->clear(clip);
+    }
+}
+/*!
+    \internal
+*/
+void AudioMixer::run() {
+    while(m_running) {
+        process();
+
+        std::this_thread::sleep_for(gPeriod);
+    }
+}
+/*!
+    \internal
+*/
+void AudioMixer::process() {
+    PROFILE_FUNCTION();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    Command command;
+    while(m_commands.pop(command)) {
+        m_pending.push_back(command);
+    }
+
+    decodeClips(lock);
+
+    for(auto &it : m_pending) {
+        execute(it);
+    }
+    m_pending.clear();
+
+    for(auto &it : m_voices) {
+        updateVoice(it.second);
+    }
+
+    mixOutput();
+
+    purgeCache();
+}
+/*!
+    \internal
+*/
+void AudioMixer::execute(const Command &command) {
+    if(command.type == Listener) {
+        m_voiceMixer.setListener(command.position, command.right);
+        return;
+    }
+
+    auto it = m_voices.find(command.voice);
+    if(it == m_voices.end()) {
+        if(command.type != Play) {
+            return;
+        }
+        it = m_voices.emplace(command.voice, Voice()).first;
+    }
+
+    Voice &voice = it->second;
+    if(command.type == Remove) {
+        destroyVoice(voice);
+        m_voices.erase(it);
+        return;
+    }
+
+    switch(command.type) {
+        case Play: {
+            stopVoice(voice);
+            voice.clip = command.clip;
+            voice.loop = command.loop;
+            voice.position = command.position;
+            voice.priority = command.priority;
+            voice.volume = command.volume;
+            voice.minDistance = command.minDistance;
+            voice.maxDistance = command.maxDistance;
+            playVoice(voice);
+        } break;
+        case Stop: {
+            stopVoice(voice);
+        } break;
+        case Position: {
+            voice.position = command.position;
+            if(voice.source) {
+                alSourcefv(voice.source, AL_POSITION, voice.position.v);
+            }
+            if(voice.mixed) {
+                m_voiceMixer.setPosition(voice.mixed, voice.position);
+            }
+        } break;
+        case Loop: {
+            voice.loop = command.loop;
+            if(voice.mixed) {
+                m_voiceMixer.setLoop(voice.mixed, voice.loop);
+            }
+        } break;
+        case Volume: {
+            voice.volume = command.volume;
+            if(voice.source) {
+                alSourcef(voice.source, AL_GAIN, voice.volume);
+            }
+            if(voice.mixed) {
+                m_voiceMixer.setVolume(voice.mixed, voice.volume);
+            }
+        } break;
+        default: break;
+    }
+}
+/*!
+    \internal
+*/
+void AudioMixer::playVoice(Voice &voice) {
+    AudioClip *clip = voice.clip;
+    if(clip == nullptr || clip->channels() == 0) {
+        return;
+    }
+
+    voice.format = (clip->channels() == 2) ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+    voice.positionSamples = 0;
+    voice.current = 0;
+
+    if(clip->isStream()) {
+        if(voice.source == 0) {
+            alGenSources(1, &voice.source);
+            alGenBuffers(2, voice.buffers);
+        }
+        alSourcefv(voice.source, AL_POSITION, voice.position.v);
+        alSourcef(voice.source, AL_GAIN, voice.volume);
+        alSourcef(voice.source, AL_REFERENCE_DISTANCE, voice.minDistance);
+        alSourcef(voice.source, AL_MAX_DISTANCE, voice.maxDistance);
+
+        // Looping of the stream is handled during the refill
+        alSourcei(voice.source, AL_LOOPING, false);
+
+        voice.data.resize(gStreamBufferSize);
+        uint32_t size = clip->readData(voice.data.data(), gStreamBufferSize, voice.positionSamples);
+        alBufferData(voice.buffers[0], voice.format, voice.data.data(), size, clip->frequency());
+        size = clip->readData(voice.data.data(), gStreamBufferSize, -1);
+        alBufferData(voice.buffers[1], voice.format, voice.data.data(), size, clip->frequency());
+
+        alSourceQueueBuffers(voice.source, 2, voice.buffers);
+        alSourcePlay(voice.source);
+    } else {
+        ClipData *data = acquireClip(clip);
+        voice.cached = true;
+
+        VoiceMixer::Emitter emitter;
+        emitter.clip.data = reinterpret_cast<const int16_t *>(data->pcm.data());
+        emitter.clip.channels = clip->channels();
+        emitter.clip.frames = data->pcm.size() / (sizeof(int16_t) * emitter.clip.channels);
+        emitter.clip.frequency = clip->frequency();
+        emitter.clip.loudness = data->loudness;
+        emitter.position = voice.position;
+        emitter.volume = voice.volume;
+        emitter.minDistance = voice.minDistance;
+        emitter.maxDistance = voice.maxDistance;
+        emitter.priority = voice.priority;
+        emitter.loop = voice.loop;
+
+        voice.mixed = m_voiceMixer.play(emitter);
+    }
+}
+/*!
+    \internal
+*/
+void AudioMixer::stopVoice(Voice &voice) {
+    if(voice.source) {
+        alSourceStop(voice.source);
+        // Detaches all attached and queued buffers
+        alSourcei(voice.source, AL_BUFFER, 0);
+    }
+    if(voice.mixed) {
+        m_voiceMixer.stop(voice.mixed);
+        voice.mixed = 0;
+    }
+    if(voice.cached) {
+        releaseClip(voice.clip);
+        voice.cached = false;
+    }
+    voice.current = 0;
+}
+/*!
+    \internal
+*/
+void AudioMixer::updateVoice(Voice &voice) {
+    if(voice.clip == nullptr) {
+        return;
+    }
+
+    if(voice.clip->isStream() && voice.source) {
+        int processed = 0;
+        alGetSourcei(voice.source, AL_BUFFERS_PROCESSED, &processed);
+
+        switch(processed) {
+            case 1: {
+                int32_t offset;
+                alGetSourcei(voice.source, AL_SAMPLE_OFFSET, &offset);
+                voice.positionSamples += offset;
+
+                alSourceUnqueueBuffers(voice.source, 1, &voice.buffers[voice.current]);
+                uint32_t size = voice.clip->readData(voice.data.data(), gStreamBufferSize, -1);
+                if(size > 0 || voice.loop) {
+                    alBufferData(voice.buffers[voice.current], voice.format, voice.data.data(), size, voice.clip->frequency());
+                    alSourceQueueBuffers(voice.source, 1, &voice.buffers[voice.current]);
+                    if(size < gStreamBufferSize && voice.loop) {
+                        voice.positionSamples = 0;
+                    }
+                } else {
+                    int queued;
+                    alGetSourcei(voice.source, AL_BUFFERS_QUEUED, &queued);
+                    if(queued == 0) {
+                        voice.positionSamples = 0;
+                    }
+                }
+                voice.current = 1 - voice.current;
+            } break;
+            case 2: { // End of clip
+                alSourceUnqueueBuffers(voice.source, 2, voice.buffers);
+                voice.current = 0;
+            } break;
+            default: break;
+        }
+    } else if(voice.cached && !m_voiceMixer.isPlaying(voice.mixed)) {
+        // Let the finished clip to be evicted from the cache
+        stopVoice(voice);
+    }
+}
+/*!
+    \internal
+*/
+void AudioMixer::destroyVoice(Voice &voice) {
+    stopVoice(voice);
+
+    if(voice.source) {
+        alDeleteSources(1, &voice.source);
+        alDeleteBuffers(2, voice.buffers);
+        voice.source = 0;
+    }
+}
+/*!
+    \internal
+    Mixes the software voices into the output buffers which have been already played and queues them back.
+*/
+void AudioMixer::mixOutput() {
+    int processed = 0;
+    alGetSourcei(m_output, AL_BUFFERS_PROCESSED, &processed);
+
+    for(int i = 0; i < processed; i++) {
+        uint32_t buffer = 0;
+        alSourceUnqueueBuffers(m_output, 1, &buffer);
+
+        m_voiceMixer.mix(m_mixBuffer.data(), gMixFrames);
+        VoiceMixer::convert(m_mixBuffer.data(), m_outputBuffer.data(), m_mixBuffer.size());
+
+        alBufferData(buffer, AL_FORMAT_STEREO16, m_outputBuffer.data(), m_outputBuffer.size() * sizeof(int16_t), gMixFrequency);
+        alSourceQueueBuffers(m_output, 1, &buffer);
+    }
+
+    if(processed > 0) {
+        int state = 0;
+        alGetSourcei(m_output, AL_SOURCE_STATE, &state);
+        if(state != AL_PLAYING) {
+            // Restart after the underrun
+            alSourcePlay(m_output);
+        }
+    }
+}
+/*!
+    \internal
+    Decodes the non-stream clips of the pending play commands which are not in the cache yet.
+    The mixer \a lock is released while a clip is decoded, the clip is protected from the removal by the decoding mark.
+*/
+void AudioMixer::decodeClips(std::unique_lock<std::mutex> &lock) {
+    for(uint32_t i = 0; i < m_pending.size(); i++) {
+        AudioClip *clip = m_pending[i].clip;
+        if(m_pending[i].type != Play || clip == nullptr || clip->isStream() || clip->channels() == 0 ||
+           m_cacheMap.find(clip) != m_cacheMap.end()) {
+            continue;
+        }
+
+        m_decoding = clip;
+        lock.unlock();
+
+        ClipData data;
+        decodeClip(clip, data);
+
+        lock.lock();
+        m_decoding = nullptr;
+
+        m_cacheSize += data.pcm.size();
+        m_cache.push_front(std::move(data));
+        m_cacheMap[clip] = m_cache.begin();
+
+        m_decoded.notify_all();
+    }
+}
+/*!
+    \internal
+    Decodes the whole \a clip into the \a data.
+*/
+void AudioMixer::decodeClip(AudioClip *clip, ClipData &data) {
+    PROFILE_BLOCK("Decode");
+
+    data.clip = clip;
+
+    uint32_t size = (clip->duration() + 0.5) * clip->channels() * clip->frequency() * 2;
+    data.pcm.resize(size);
+    data.pcm.resize(clip->readData(data.pcm.data(), size, 0));
+    data.loudness = VoiceMixer::loudness(reinterpret_cast<const int16_t *>(data.pcm.data()), data.pcm.size() / sizeof(int16_t));
+}
+/*!
+    \internal
+    Returns the cached data of the \a clip, the clip is decoded in case of it isn't in the cache yet.
+*/
+AudioMixer::ClipData *AudioMixer::acquireClip(AudioClip *clip) {
+    auto it = m_cacheMap.find(clip);
+    if(it != m_cacheMap.end()) {
+        // Move to the most recently used position
+        m_cache.splice(m_cache.begin(), m_cache, it->second);
+    } else {
+        m_cache.emplace_front();
+        decodeClip(clip, m_cache.front());
+
+        m_cacheSize += m_cache.front().pcm.size();
+        m_cacheMap[clip] = m_cache.begin();
+    }
+
+    ClipData &data = m_cache.front();
+    data.users++;
+    return &data;
+}
+/*!
+    \internal
+*/
+void AudioMixer::releaseClip(AudioClip *clip) {
+    auto it = m_cacheMap.find(clip);
+    if(it != m_cacheMap.end() && it->second->users > 0) {
+        it->second->users--;
+    }
+}
+/*!
+    \internal
+    Evicts the least recently used clips which are not in use until the cache fits to the limit.
+*/
+void AudioMixer::purgeCache() {
+    auto it = m_cache.end();
+    while(m_cacheSize > gCacheLimit && it != m_cache.begin()) {
+        --it;
+        if(it->users == 0) {
+            m_cacheSize -= it->pcm.size();
+            m_cacheMap.erase(it->clip);
+            it = m_cache.erase(it);
+        }
+    }
+}
+/*!
+    \internal
+*/
+void AudioMixer::clear(AudioClip *clip) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_decoded.wait(lock, [this, clip]() { return m_decoding != clip; });
+
+    // The pending commands may refer to the clip, they are executed by the audio thread without it
+    Command command;
+    while(m_commands.pop(command)) {
+        m_pending.push_back(command);
+    }
+    for(auto &it : m_pending) {
+        if(it.clip == clip) {
+            it.clip = nullptr;
+        }
+    }
+
+    for(auto &it : m_voices) {
+        if(it.second.clip == clip) {
+            stopVoice(it.second);
+            it.second.clip = nullptr;
+        }
+    }
+
+    auto it = m_cacheMap.find(clip);
+    if(it != m_cacheMap.end()) {
+        m_cacheSize -= it->second->pcm.size();
+        m_cache.erase(it->second);
+        m_cacheMap.erase(it);
+    }
+}
+
+AudioMixer::CommandQueue::CommandQueue() :
+        m_enqueue(0),
+        m_dequeue(0) {
+
+    for(uint32_t i = 0; i < Capacity; i++) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+/*!
+    \internal
+    Adds the \a command to the bounded multi-producer queue. Returns false in case of the queue is full.
+*/
+bool AudioMixer::CommandQueue::push(const Command &command) {
+    uint32_t position = m_enqueue.load(std::memory_order_relaxed);
+    Cell *cell;
+    while(true) {
+        cell = &m_cells[position % Capacity];
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int32_t diff = int32_t(sequence - position);
+        if(diff == 0) {
+            if(m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            return false;
+        } else {
+            position = m_enqueue.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->command = command;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+/*!
+    \internal
+    Takes the oldest \a command from the queue. Returns false in case of the queue is empty.
+*/
+bool AudioMixer::CommandQueue::pop(Command &command) {
+    uint32_t position = m_dequeue.load(std::memory_order_relaxed);
+    Cell *cell;
+    while(true) {
+        cell = &m_cells[position % Capacity];
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        int32_t diff = int32_t(sequence - (position + 1));
+        if(diff == 0) {
+            if(m_dequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            return false;
+        } else {
+            position = m_dequeue.load(std::memory_order_relaxed);
+        }
+    }
+
+    command = cell->command;
+    cell->sequence.store(position + Capacity, std::memory_order_release);
+    return true;
+}
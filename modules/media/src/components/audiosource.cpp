@@ -1,17 +1,17 @@
 #include "components/audiosource.h"
 
-#include <AL/al.h>
-
 #include <components/transform.h>
 
 #include "resources/audioclip.h"
 
+#include "audiomixer.h"
+
+#include <cfloat>
+
 namespace {
     const char *gClip = "Clip";
 }
 
-#define BUFFER_SIZE 65536
-
 /*!
     \class AudioSource
     \brief The AudioSource class represents a source of audio in a 3D space, handling playback of audio clips.
@@ -19,67 +19,47 @@ namespace {
 
     The AudioSource class provides methods to manage the playback of audio clips.
     It allows users to set audio clips, control playback, and adjust parameters like auto-play and looping.
+
+    The playback itself happens on the audio thread: the AudioSource only posts commands to the AudioMixer, so none of the functions block on decoding.
 */
 
 AudioSource::AudioSource() :
         m_clip(nullptr),
-        m_format(0),
-        m_positionSamples(0),
-        m_id(0),
-        m_current(0),
+        m_voice(AudioMixer::createVoice()),
+        m_priority(0),
+        m_volume(1.0f),
+        m_minDistance(1.0f),
+        m_maxDistance(FLT_MAX),
         m_loop(false),
         m_autoPlay(false) {
 
-    alGenSources(1, &m_id);
-
-    alGenBuffers(2, m_buffers);
 }
 
 AudioSource::~AudioSource() {
-    alSourceStop(m_id);
-
-    alDeleteBuffers(2, m_buffers);
-    alDeleteSources(1, &m_id);
+    AudioMixer *mixer = AudioMixer::instance();
+    if(mixer) {
+        AudioMixer::Command command;
+        command.type = AudioMixer::Remove;
+        command.voice = m_voice;
+        mixer->post(command);
+    }
 }
 /*!
     \internal
-    Updates the audio source, adjusting its position and handling streaming for audio clips.
+    Updates the audio source position, the position is sent to the audio thread only when changed.
 */
 void AudioSource::update() {
-    alSourcefv(m_id, AL_POSITION, transform()->worldPosition().v);
-
-    if(m_clip && m_clip->isStream()) {
-        int processed;
-        alGetSourcei(m_id, AL_BUFFERS_PROCESSED, &processed);
-
-        switch(processed) {
-            case 1: {
-                int32_t offset;
-                alGetSourcei(m_id, AL_SAMPLE_OFFSET, &offset);
-                m_positionSamples += offset;
-
-                alSourceUnqueueBuffers(m_id, 1, &m_buffers[m_current]);
-                uint32_t size = m_clip->readData(m_data.data(), BUFFER_SIZE, -1);
-                if(size > 0 || m_loop) {
-                    alBufferData(m_buffers[m_current], m_format, m_data.data(), size, m_clip->frequency());
-                    alSourceQueueBuffers(m_id, 1, &m_buffers[m_current]);
-                    if(size < BUFFER_SIZE && m_loop) {
-                        m_positionSamples = 0;
-                    }
-                } else {
-                    int queued;
-                    alGetSourcei(m_id, AL_BUFFERS_QUEUED, &queued);
-                    if(queued == 0) {
-                        m_positionSamples = 0;
-                    }
-                }
-                m_current = 1 - m_current;
-            } break;
-            case 2: { // End of clip
-                alSourceUnqueueBuffers(m_id, 2, m_buffers);
-                m_current = 0;
-            } break;
-            default: break;
+    Vector3 position = transform()->worldPosition();
+    if(position != m_position) {
+        m_position = position;
+
+        AudioMixer *mixer = AudioMixer::instance();
+        if(mixer) {
+            AudioMixer::Command command;
+            command.type = AudioMixer::Position;
+            command.voice = m_voice;
+            command.position = m_position;
+            mixer->post(command);
         }
     }
 }
@@ -96,37 +76,34 @@ void AudioSource::start() {
     Plays the audio clip in the specific position in 3D space.
 */
 void AudioSource::play() {
-    alSourcei(m_id, AL_LOOPING, m_loop);
-
-    m_positionSamples = 0;
-
-    if(m_clip) {
-        uint32_t size;
-        if(m_clip->isStream()) {
-            m_data.resize(BUFFER_SIZE);
-            size = m_clip->readData(m_data.data(), BUFFER_SIZE, m_positionSamples);
-            alBufferData(m_buffers[0], m_format, m_data.data(), size, m_clip->frequency());
-            size = m_clip->readData(m_data.data(), BUFFER_SIZE, m_positionSamples);
-            alBufferData(m_buffers[1], m_format, m_data.data(), size, m_clip->frequency());
-
-            alSourceQueueBuffers(m_id, 2, m_buffers);
-        } else {
-            size = (m_clip->duration() + 0.5) * m_clip->channels() * m_clip->frequency() * 2;
-            m_data.resize(size);
-            int32_t length = m_clip->readData(m_data.data(), size, m_positionSamples);
-
-            alBufferData(m_buffers[0], m_format, m_data.data(), length, m_clip->frequency());
-            alSourcei(m_id, AL_BUFFER, m_buffers[0]);
-        }
-
-        alSourcePlay(m_id);
+    AudioMixer *mixer = AudioMixer::instance();
+    if(mixer && m_clip) {
+        m_position = transform()->worldPosition();
+
+        AudioMixer::Command command;
+        command.type = AudioMixer::Play;
+        command.voice = m_voice;
+        command.clip = m_clip;
+        command.position = m_position;
+        command.loop = m_loop;
+        command.priority = m_priority;
+        command.volume = m_volume;
+        command.minDistance = m_minDistance;
+        command.maxDistance = m_maxDistance;
+        mixer->post(command);
     }
 }
 /*!
     Stops the audio source.
 */
 void AudioSource::stop() {
-    alSourceStop(m_id);
+    AudioMixer *mixer = AudioMixer::instance();
+    if(mixer) {
+        AudioMixer::Command command;
+        command.type = AudioMixer::Stop;
+        command.voice = m_voice;
+        mixer->post(command);
+    }
 }
 /*!
     Returns the audio clip associated with the audio source.
@@ -139,16 +116,6 @@ AudioClip *AudioSource::clip() const {
 */
 void AudioSource::setClip(AudioClip *clip) {
     m_clip = clip;
-    if(m_clip) {
-        switch(m_clip->channels()) {
-            case 2: {
-                m_format = AL_FORMAT_STEREO16;
-            } break;
-            default: {
-                m_format = AL_FORMAT_MONO16;
-            } break;
-        }
-    }
 }
 /*!
     \internal
@@ -198,4 +165,75 @@ bool AudioSource::loop() const {
 */
 void AudioSource::setLoop(bool loop) {
     m_loop = loop;
+
+    AudioMixer *mixer = AudioMixer::instance();
+    if(mixer) {
+        AudioMixer::Command command;
+        command.type = AudioMixer::Loop;
+        command.voice = m_voice;
+        command.loop = m_loop;
+        mixer->post(command);
+    }
+}
+/*!
+    Returns the playback priority of the audio source.
+*/
+int AudioSource::priority() const {
+    return m_priority;
+}
+/*!
+    Sets the playback \a priority of the audio source.
+    When there are more sources playing than the audio mixer can mix at once, the sources with the higher priority are heard first regardless of their distance.
+    The new priority is applied on the next play().
+*/
+void AudioSource::setPriority(int priority) {
+    m_priority = priority;
+}
+/*!
+    Returns the volume of the audio source.
+*/
+float AudioSource::volume() const {
+    return m_volume;
+}
+/*!
+    Sets the \a volume of the audio source, the volume is applied to the playing clip immediately.
+*/
+void AudioSource::setVolume(float volume) {
+    m_volume = volume;
+
+    AudioMixer *mixer = AudioMixer::instance();
+    if(mixer) {
+        AudioMixer::Command command;
+        command.type = AudioMixer::Volume;
+        command.voice = m_voice;
+        command.volume = m_volume;
+        mixer->post(command);
+    }
+}
+/*!
+    Returns the distance within which the audio source is heard at full volume.
+*/
+float AudioSource::minDistance() const {
+    return m_minDistance;
+}
+/*!
+    Sets the \a distance within which the audio source is heard at full volume, farther the volume fades with the distance.
+    The new distance is applied on the next play().
+*/
+void AudioSource::setMinDistance(float distance) {
+    m_minDistance = distance;
+}
+/*!
+    Returns the maximum distance of the audio source.
+*/
+float AudioSource::maxDistance() const {
+    return m_maxDistance;
+}
+/*!
+    Sets the maximum \a distance of the audio source, by default the distance is unlimited.
+    The mixed clips are not heard beyond this distance, the streamed clips stop fading there.
+    The new distance is applied on the next play().
+*/
+void AudioSource::setMaxDistance(float distance) {
+    m_maxDistance = distance;
 }
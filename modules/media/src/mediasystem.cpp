@@ -29,6 +29,8 @@ MediaSystem::MediaSystem() :
 MediaSystem::~MediaSystem() {
     PROFILE_FUNCTION();
 
+    m_mixer.stop();
+
     alcDestroyContext(m_context);
     alcCloseDevice(m_device);
 }
@@ -43,6 +45,7 @@ bool MediaSystem::init() {
             m_context = alcCreateContext(m_device, nullptr);
             if(alcGetError(m_device) == AL_NO_ERROR) {
                 alcMakeContextCurrent(m_context);
+                m_mixer.start();
                 m_inited = true;
             }
         }
@@ -67,6 +70,13 @@ void MediaSystem::update(World *world) {
 
         alListenerfv(AL_ORIENTATION, orientation);
 
+        // The software mixed voices are spatialized on the audio thread
+        AudioMixer::Command command;
+        command.type = AudioMixer::Listener;
+        command.position = t->worldPosition();
+        command.right = rot * Vector3(1.0f, 0.0f, 0.0f);
+        m_mixer.post(command);
+
         if(Engine::isGameMode()) {
             for(auto it : m_objectList) {
                 NativeBehaviour *comp = dynamic_cast<NativeBehaviour *>(it);
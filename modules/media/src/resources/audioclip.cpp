@@ -2,6 +2,8 @@
 
 #include <vorbis/vorbisfile.h>
 
+#include "audiomixer.h"
+
 namespace  {
     const char *gHeader("Header");
 }
@@ -25,7 +27,25 @@ AudioClip::AudioClip() :
 
 }
 
+AudioClip::AudioClip(const AudioClip &origin) :
+        Resource(origin),
+        m_path(origin.m_path),
+        m_vorbisFile(new OggVorbis_File()),
+        m_clip(nullptr),
+        m_frequency(0),
+        m_channels(0),
+        m_duration(0),
+        m_stream(origin.m_stream),
+        m_sizeFlag(false) {
+    // The copy decodes the same file with its own decoder
+    if(!m_path.empty()) {
+        loadAudioData();
+    }
+}
+
 AudioClip::~AudioClip() {
+    AudioMixer::removeClip(this);
+
     if(m_clip) {
         Engine::file()->fclose(m_clip);
     }
@@ -54,6 +74,9 @@ uint32_t AudioClip::frequency() const {
     This is an internal function and must not be called manually.
 */
 uint32_t AudioClip::readData(uint8_t *out, uint32_t size, int32_t offset) {
+    // The clip is decoded on the audio thread while it can be reloaded on the main one
+    std::unique_lock<std::mutex> lock(m_mutex);
+
     if(offset != -1) {
         ov_raw_seek(m_vorbisFile, offset);
     }
@@ -138,7 +161,9 @@ int AudioClip::close(void *datasource) {
     AudioClip *object = static_cast<AudioClip *>(datasource);
 
     if(object->m_clip) {
-        return Engine::file()->fclose(object->m_clip);
+        int result = Engine::file()->fclose(object->m_clip);
+        object->m_clip = nullptr;
+        return result;
     }
     return 0;
 }
@@ -171,6 +196,17 @@ void AudioClip::loadUserData(const VariantMap &data) {
         i++;
         m_stream = (*i).toBool();
 
+        // Stops the voices which play the clip and drops its decoded data
+        AudioMixer::removeClip(this);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        unloadAudioData();
+        if(m_clip) {
+            Engine::file()->fclose(m_clip);
+            m_clip = nullptr;
+        }
+
         loadAudioData();
     }
 }
@@ -0,0 +1,235 @@
+#include "tst_common.h"
+
+#include "audiomixer.h"
+
+#include "resources/audioclip.h"
+
+#include <thread>
+
+class AudioMixerTest : public ::testing::Test {
+public:
+    class TestMixer : public AudioMixer {
+    public:
+        using AudioMixer::CommandQueue;
+        using AudioMixer::acquireClip;
+        using AudioMixer::releaseClip;
+        using AudioMixer::purgeCache;
+        using AudioMixer::clear;
+        using AudioMixer::process;
+        using AudioMixer::m_commands;
+        using AudioMixer::m_pending;
+        using AudioMixer::m_mutex;
+        using AudioMixer::m_decoded;
+        using AudioMixer::m_decoding;
+        using AudioMixer::m_voices;
+        using AudioMixer::m_cacheMap;
+        using AudioMixer::m_cacheSize;
+
+        // Puts the decoded data of the \a clip to the cache as the most recently used one
+        void insert(AudioClip *clip, uint32_t size) {
+            m_cache.emplace_front();
+            m_cache.front().clip = clip;
+            m_cache.front().pcm.resize(size);
+
+            m_cacheSize += size;
+            m_cacheMap[clip] = m_cache.begin();
+        }
+
+        bool isCached(AudioClip *clip) const {
+            return m_cacheMap.find(clip) != m_cacheMap.end();
+        }
+
+    };
+
+};
+
+TEST_F(AudioMixerTest, Command_queue) {
+    TestMixer::CommandQueue queue;
+
+    AudioMixer::Command command;
+    EXPECT_FALSE(queue.pop(command));
+
+    // The commands are taken in the order of posting until the queue is full
+    uint32_t count = 0;
+    command.type = AudioMixer::Position;
+    while(queue.push(command)) {
+        command.voice = ++count;
+    }
+    EXPECT_EQ(count, 1024);
+
+    for(uint32_t i = 0; i < count; i++) {
+        ASSERT_TRUE(queue.pop(command));
+        EXPECT_EQ(command.voice, i);
+    }
+    EXPECT_FALSE(queue.pop(command));
+
+    // Several producers post at the same time while the consumer drains the queue
+    const uint32_t producers = 4;
+    const uint32_t commands = 10000;
+
+    std::vector<std::thread> threads;
+    for(uint32_t p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, p]() {
+            AudioMixer::Command command;
+            command.priority = p;
+            for(uint32_t i = 0; i < commands; i++) {
+                command.voice = i;
+                while(!queue.push(command)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // The commands of each producer keep their order
+    std::vector<uint32_t> next(producers, 0);
+    uint32_t received = 0;
+    while(received < producers * commands) {
+        if(queue.pop(command)) {
+            ASSERT_LT(uint32_t(command.priority), producers);
+            EXPECT_EQ(command.voice, next[command.priority]);
+            next[command.priority]++;
+            received++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    for(auto &it : threads) {
+        it.join();
+    }
+
+    EXPECT_FALSE(queue.pop(command));
+    for(auto it : next) {
+        EXPECT_EQ(it, commands);
+    }
+}
+
+TEST_F(AudioMixerTest, Cache_eviction) {
+    Engine engine(nullptr, "");
+    TestMixer mixer;
+
+    AudioClip a, b, c, d;
+
+    // Three clips exceed the cache limit
+    const uint32_t size = 12 * 1024 * 1024;
+    mixer.insert(&a, size);
+    mixer.insert(&b, size);
+    mixer.insert(&c, size);
+
+    // The used clip becomes the most recently used one, so the least recently used is the second one
+    mixer.acquireClip(&a);
+    mixer.releaseClip(&a);
+
+    mixer.purgeCache();
+    EXPECT_TRUE(mixer.isCached(&a));
+    EXPECT_FALSE(mixer.isCached(&b));
+    EXPECT_TRUE(mixer.isCached(&c));
+    EXPECT_EQ(mixer.m_cacheSize, size * 2);
+
+    // The clips in use are never evicted
+    mixer.insert(&d, size);
+    mixer.acquireClip(&c);
+    mixer.acquireClip(&a);
+    mixer.acquireClip(&d);
+
+    mixer.purgeCache();
+    EXPECT_TRUE(mixer.isCached(&a));
+    EXPECT_TRUE(mixer.isCached(&c));
+    EXPECT_TRUE(mixer.isCached(&d));
+    EXPECT_EQ(mixer.m_cacheSize, size * 3);
+
+    // The released clip is evicted first even if it was used after the others
+    mixer.releaseClip(&d);
+
+    mixer.purgeCache();
+    EXPECT_TRUE(mixer.isCached(&a));
+    EXPECT_TRUE(mixer.isCached(&c));
+    EXPECT_FALSE(mixer.isCached(&d));
+    EXPECT_EQ(mixer.m_cacheSize, size * 2);
+
+    // Below the limit nothing is evicted
+    mixer.releaseClip(&a);
+    mixer.releaseClip(&c);
+
+    mixer.purgeCache();
+    EXPECT_TRUE(mixer.isCached(&a));
+    EXPECT_TRUE(mixer.isCached(&c));
+}
+
+TEST_F(AudioMixerTest, Clear_clip) {
+    Engine engine(nullptr, "");
+    TestMixer mixer;
+
+    AudioClip clip;
+    AudioClip other;
+
+    mixer.insert(&clip, 16);
+    mixer.insert(&other, 32);
+
+    // The pending commands are kept for the audio thread without the removed clip
+    AudioMixer::Command command;
+    command.type = AudioMixer::Play;
+    command.clip = &clip;
+    command.voice = 1;
+    ASSERT_TRUE(mixer.m_commands.push(command));
+
+    command.clip = &other;
+    command.voice = 2;
+    ASSERT_TRUE(mixer.m_commands.push(command));
+
+    mixer.clear(&clip);
+
+    EXPECT_FALSE(mixer.m_commands.pop(command));
+
+    ASSERT_EQ(mixer.m_pending.size(), 2);
+    EXPECT_EQ(mixer.m_pending[0].clip, nullptr);
+    EXPECT_EQ(mixer.m_pending[1].clip, &other);
+
+    mixer.process();
+    EXPECT_TRUE(mixer.m_pending.empty());
+
+    ASSERT_EQ(mixer.m_voices.size(), 2);
+    EXPECT_EQ(mixer.m_voices[1].clip, nullptr);
+    EXPECT_EQ(mixer.m_voices[2].clip, &other);
+
+    EXPECT_FALSE(mixer.isCached(&clip));
+    EXPECT_TRUE(mixer.isCached(&other));
+    EXPECT_EQ(mixer.m_cacheSize, 32);
+}
+
+TEST_F(AudioMixerTest, Clear_decoding_clip) {
+    Engine engine(nullptr, "");
+    TestMixer mixer;
+
+    AudioClip clip;
+    AudioClip other;
+
+    // The audio thread decodes the clip without the mixer lock
+    mixer.m_decoding = &clip;
+
+    // The other clips are removed without waiting
+    mixer.clear(&other);
+
+    std::atomic<bool> cleared(false);
+    std::thread thread([&mixer, &clip, &cleared]() {
+        mixer.clear(&clip);
+        cleared = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(cleared);
+
+    // The decoded clip is put to the cache and removed right after
+    {
+        std::unique_lock<std::mutex> lock(mixer.m_mutex);
+        mixer.m_decoding = nullptr;
+        mixer.insert(&clip, 16);
+        mixer.m_decoded.notify_all();
+    }
+
+    thread.join();
+    EXPECT_TRUE(cleared);
+    EXPECT_FALSE(mixer.isCached(&clip));
+    EXPECT_EQ(mixer.m_cacheSize, 0);
+}
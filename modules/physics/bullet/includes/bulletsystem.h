@@ -3,15 +3,22 @@
 
 #include <system.h>
 
+#include "contactcache.h"
+
 class Engine;
 class Collider;
 class Joint;
+class RigidBody;
+class VolumeCollider;
+class QueryBatch;
 
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 class btBroadphaseInterface;
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
+class btConstraintSolverPoolMt;
 class btDynamicsWorld;
+class btITaskScheduler;
 
 class BulletSystem : public System {
 public:
@@ -29,8 +36,14 @@ private:
 
     void removeObject(Object *object) override;
 
+    btDynamicsWorld *createWorld();
+
+    void writeTransforms();
+
     static bool rayCast(System *system, World *world, const Ray &ray, float distance, Ray::Hit *hit);
 
+    static void query(System *system, World *world, QueryBatch &batch);
+
 protected:
     std::unordered_map<uint32_t, btDynamicsWorld *> m_worlds;
 
@@ -38,13 +51,27 @@ protected:
 
     std::list<Joint *> m_jointList;
 
+    std::vector<RigidBody *> m_awakeBodies;
+
+    std::vector<VolumeCollider *> m_triggers;
+
+    ContactCache m_contacts;
+
     btDefaultCollisionConfiguration *m_collisionConfiguration;
 
     btCollisionDispatcher *m_dispatcher;
 
     btBroadphaseInterface *m_overlappingPairCache;
 
-    btSequentialImpulseConstraintSolver *m_solver;
+    btConstraintSolver *m_solver;
+
+    btConstraintSolverPoolMt *m_solverPool;
+
+    btITaskScheduler *m_scheduler;
+
+    float m_fixedStep;
+
+    int32_t m_maxSubSteps;
 
 };
 
@@ -43,12 +43,6 @@ protected:
     btDynamicsWorld *bulletWorld() const;
     void setBulletWorld(btDynamicsWorld *world);
 
-    void dirtyContacts();
-
-    void cleanContacts();
-
-    void setContact(Collider *collider);
-
     void destroyShape();
 
     void destroyCollider();
@@ -59,10 +53,7 @@ protected:
     friend class RigidBody;
     friend class Joint;
     friend class BulletSystem;
-
-    typedef std::unordered_map<uint32_t, bool> CollisionMap;
-
-    CollisionMap m_collisions;
+    friend class ContactCache;
 
     btCollisionShape *m_collisionShape;
 
@@ -72,6 +63,8 @@ protected:
 
     RigidBody *m_rigidBody;
 
+    bool m_stayListener;
+
 };
 typedef Collider* ColliderPtr;
 
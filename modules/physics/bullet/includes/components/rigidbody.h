@@ -50,9 +50,14 @@ protected:
 
     void updateCollider(bool updated);
 
+    void writeTransform();
+
     PhysicMaterial *material() const;
 
 protected:
+    friend class BulletSystem;
+    friend class MotionState;
+
     std::list<VolumeCollider *> m_colliders;
     std::list<Joint *> m_joints;
 
@@ -63,6 +68,8 @@ protected:
     int32_t m_lockPosition;
     int32_t m_lockRotation;
 
+    uint32_t m_kinematicHash;
+
     bool m_kinematic;
 
 };
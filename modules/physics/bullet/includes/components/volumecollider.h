@@ -36,8 +36,6 @@ public:
 protected:
     void createCollider() override;
 
-    void update() override;
-
 private:
     void loadUserData(const VariantMap &data) override;
     VariantMap saveUserData() const override;
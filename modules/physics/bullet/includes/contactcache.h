@@ -0,0 +1,52 @@
+#ifndef CONTACTCACHE_H
+#define CONTACTCACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Collider;
+
+class ContactCache {
+    struct Pair {
+        Collider *a;
+
+        Collider *b;
+
+        uint32_t frame;
+
+        bool mutual;
+    };
+
+public:
+    ContactCache();
+
+    void begin();
+
+    void addContact(Collider *a, Collider *b, bool mutual);
+
+    void end();
+
+    void removeCollider(Collider *collider);
+
+    uint32_t size() const;
+
+    static bool isReceiving(const Collider *collider, const char *signal);
+
+private:
+    static void notify(const char *signal, Collider *receiver, bool activate);
+
+private:
+    std::unordered_map<uint64_t, Pair> m_pairs;
+
+    std::vector<uint64_t> m_entered;
+
+    std::vector<uint64_t> m_stayed;
+
+    std::vector<Pair> m_exited;
+
+    uint32_t m_frame;
+
+};
+
+#endif // CONTACTCACHE_H
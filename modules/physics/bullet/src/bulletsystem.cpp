@@ -6,10 +6,18 @@
 
 #include <btBulletDynamicsCommon.h>
 #include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <LinearMath/btThreads.h>
+
+#include <algorithm>
+#include <atomic>
 
 #include <log.h>
 #include <timer.h>
+#include <threadpool.h>
 
 #include <components/world.h>
 #include <components/actor.h>
@@ -17,6 +25,9 @@
 
 #include <systems/resourcesystem.h>
 
+#include <utils/querybatch.h>
+#include <utils/parallelfor.h>
+
 #include "components/rigidbody.h"
 #include "components/collider.h"
 #include "components/boxcollider.h"
@@ -34,15 +45,286 @@
 
 #include "bulletdebug.h"
 
+namespace {
+    const char *gFixedStep(".physicsFixedStep");
+    const char *gMaxSubSteps(".physicsMaxSubSteps");
+
+    const uint32_t gMaxWorkers = 16;
+
+    const int gQueryGrain = 16;
+};
+
+static inline btVector3 toBullet(const Vector3 &v) {
+    return btVector3(v.x, v.y, v.z);
+}
+
+static inline Vector3 toVector(const btVector3 &v) {
+    return Vector3(v.x(), v.y(), v.z());
+}
+
+class OverlapCallback : public btCollisionWorld::ContactResultCallback {
+public:
+    OverlapCallback(const btCollisionObject *self, Ray::Hit *hits, uint32_t capacity) :
+            m_self(self),
+            m_hits(hits),
+            m_capacity(capacity),
+            m_count(0) {
+
+    }
+
+    btScalar addSingleResult(btManifoldPoint &point, const btCollisionObjectWrapper *wrap0, int, int, const btCollisionObjectWrapper *wrap1, int, int) override {
+        bool swapped = (wrap0->getCollisionObject() != m_self);
+        const btCollisionObject *other = swapped ? wrap0->getCollisionObject() : wrap1->getCollisionObject();
+        Object *object = reinterpret_cast<Object *>(other->getUserPointer());
+
+        for(uint32_t i = 0; i < m_count; i++) {
+            if(m_hits[i].object == object) {
+                return 0.0f;
+            }
+        }
+
+        if(m_count < m_capacity) {
+            Ray::Hit &hit = m_hits[m_count++];
+            hit.object = object;
+            hit.point = toVector(swapped ? point.getPositionWorldOnA() : point.getPositionWorldOnB());
+            hit.normal = toVector(swapped ? -point.m_normalWorldOnB : point.m_normalWorldOnB);
+            hit.distance = -point.getDistance();
+        }
+        return 0.0f;
+    }
+
+    uint32_t count() const {
+        return m_count;
+    }
+
+private:
+    const btCollisionObject *m_self;
+
+    Ray::Hit *m_hits;
+
+    uint32_t m_capacity;
+
+    uint32_t m_count;
+
+};
+
+static void executeQuery(btCollisionWorld *world, QueryBatch &batch, uint32_t index) {
+    const QueryBatch::Query &query = batch.query(index);
+    Ray::Hit *hits = batch.hits(index);
+
+    btVector3 from(toBullet(query.ray.pos));
+    btVector3 to(toBullet(query.ray.pos + query.ray.dir * query.distance));
+
+    switch(query.type) {
+        case QueryBatch::RayCast: {
+            btCollisionWorld::ClosestRayResultCallback callback(from, to);
+            callback.m_flags |= btTriangleRaycastCallback::kF_FilterBackfaces;
+
+            world->rayTest(from, to, callback);
+            if(callback.hasHit()) {
+                hits[0].object = reinterpret_cast<Object *>(callback.m_collisionObject->getUserPointer());
+                hits[0].distance = callback.m_closestHitFraction * query.distance;
+                hits[0].normal = toVector(callback.m_hitNormalWorld);
+                hits[0].point = toVector(callback.m_hitPointWorld);
+                batch.setHitCount(index, 1);
+            }
+        } break;
+        case QueryBatch::RayCastAll: {
+            btCollisionWorld::AllHitsRayResultCallback callback(from, to);
+            callback.m_flags |= btTriangleRaycastCallback::kF_FilterBackfaces;
+
+            world->rayTest(from, to, callback);
+
+            int size = callback.m_collisionObjects.size();
+            std::vector<int> order(size);
+            for(int i = 0; i < size; i++) {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&callback](int a, int b) {
+                return callback.m_hitFractions[a] < callback.m_hitFractions[b];
+            });
+
+            uint32_t count = MIN((uint32_t)size, query.capacity);
+            for(uint32_t i = 0; i < count; i++) {
+                int h = order[i];
+                hits[i].object = reinterpret_cast<Object *>(callback.m_collisionObjects[h]->getUserPointer());
+                hits[i].distance = callback.m_hitFractions[h] * query.distance;
+                hits[i].normal = toVector(callback.m_hitNormalWorld[h]);
+                hits[i].point = toVector(callback.m_hitPointWorld[h]);
+            }
+            batch.setHitCount(index, count);
+        } break;
+        case QueryBatch::SphereCast: {
+            btSphereShape sphere(query.radius);
+
+            btTransform start(btQuaternion::getIdentity(), from);
+            btTransform end(btQuaternion::getIdentity(), to);
+
+            btCollisionWorld::ClosestConvexResultCallback callback(from, to);
+            world->convexSweepTest(&sphere, start, end, callback);
+            if(callback.hasHit()) {
+                hits[0].object = reinterpret_cast<Object *>(callback.m_hitCollisionObject->getUserPointer());
+                hits[0].distance = callback.m_closestHitFraction * query.distance;
+                hits[0].normal = toVector(callback.m_hitNormalWorld);
+                hits[0].point = toVector(callback.m_hitPointWorld);
+                batch.setHitCount(index, 1);
+            }
+        } break;
+        case QueryBatch::Overlap: {
+            btSphereShape sphere(query.radius);
+
+            btCollisionObject object;
+            object.setCollisionShape(&sphere);
+            object.setWorldTransform(btTransform(btQuaternion::getIdentity(), from));
+
+            OverlapCallback callback(&object, hits, query.capacity);
+            world->contactTest(&object, callback);
+            batch.setHitCount(index, callback.count());
+        } break;
+        default: break;
+    }
+}
+
+class QueryBody : public btIParallelForBody {
+public:
+    QueryBody(btCollisionWorld *world, QueryBatch &batch, bool overlaps) :
+            m_world(world),
+            m_batch(batch),
+            m_overlaps(overlaps) {
+
+    }
+
+    void forLoop(int begin, int end) const override {
+        for(int i = begin; i < end; i++) {
+            if(m_overlaps || m_batch.query(i).type != QueryBatch::Overlap) {
+                executeQuery(m_world, m_batch, i);
+            }
+        }
+    }
+
+private:
+    btCollisionWorld *m_world;
+
+    QueryBatch &m_batch;
+
+    bool m_overlaps;
+
+};
+
+class TaskScheduler : public btITaskScheduler {
+public:
+    explicit TaskScheduler(uint32_t threads) :
+            btITaskScheduler("ThreadPool"),
+            m_threads(threads),
+            m_running(false) {
+
+    }
+
+    int getMaxNumThreads() const override {
+        return gMaxWorkers;
+    }
+
+    int getNumThreads() const override {
+        return m_threads;
+    }
+
+    void setNumThreads(int numThreads) override {
+        m_threads = CLAMP(numThreads, 1, (int)gMaxWorkers);
+    }
+
+    void parallelFor(int begin, int end, int grain, const btIParallelForBody &body) override {
+        PROFILE_FUNCTION();
+
+        grain = MAX(grain, 1);
+        int chunks = (end - begin + grain - 1) / grain;
+        // The nested loops are executed on the calling worker
+        if(chunks <= 1 || m_running.exchange(true)) {
+            body.forLoop(begin, end);
+            return;
+        }
+
+        ParallelFor::run(Engine::threadPool(), chunks, [&](uint32_t index) {
+            int first = begin + index * grain;
+            body.forLoop(first, MIN(first + grain, end));
+        });
+
+        m_running = false;
+    }
+
+    btScalar parallelSum(int begin, int end, int grain, const btIParallelSumBody &body) override {
+        PROFILE_FUNCTION();
+
+        grain = MAX(grain, 1);
+        int chunks = (end - begin + grain - 1) / grain;
+        if(chunks <= 1 || m_running.exchange(true)) {
+            return body.sumLoop(begin, end);
+        }
+
+        std::vector<btScalar> sums(chunks, 0.0f);
+        ParallelFor::run(Engine::threadPool(), chunks, [&](uint32_t index) {
+            int first = begin + index * grain;
+            sums[index] = body.sumLoop(first, MIN(first + grain, end));
+        });
+
+        m_running = false;
+
+        btScalar result = 0.0f;
+        for(auto it : sums) {
+            result += it;
+        }
+        return result;
+    }
+
+private:
+    int m_threads;
+
+    std::atomic<bool> m_running;
+
+};
+
+/*!
+    \class BulletSystem
+    \brief Integrates the Bullet physics library to the engine.
+    \inmodule Bullet
+
+    The physics worlds are stepped with a fixed time step, Bullet accumulates the frame time and interpolates the transforms of the bodies between the substeps.
+    The time step and the max number of substeps per frame can be changed with the ".physicsFixedStep" and ".physicsMaxSubSteps" settings.
+
+    In case of the multithreaded build of Bullet the worlds are simulated with btDiscreteDynamicsWorldMt: the narrowphase, the islands and the large island solver
+    are processed in parallel jobs on the engine thread pool.
+    The simulated transforms are written back to the Transform components in one pass after the step, only for the bodies which are awake.
+*/
+
 BulletSystem::BulletSystem(Engine *engine) :
         System(),
         m_collisionConfiguration(new btDefaultCollisionConfiguration),
-        m_dispatcher(new btCollisionDispatcher(m_collisionConfiguration)),
+        m_dispatcher(nullptr),
         m_overlappingPairCache(new btDbvtBroadphase),
-        m_solver(new btSequentialImpulseConstraintSolver) {
+        m_solver(nullptr),
+        m_solverPool(nullptr),
+        m_scheduler(nullptr),
+        m_fixedStep(MAX(Engine::value(gFixedStep, 1.0f / 60.0f).toFloat(), 0.001f)),
+        m_maxSubSteps(MAX(Engine::value(gMaxSubSteps, 4).toInt(), 1)) {
 
     PROFILE_FUNCTION();
 
+#if BT_THREADSAFE
+    // The hardware concurrency may be unknown, so the count is clamped before leaving a core for the main thread
+    uint32_t threads = MIN(MAX(ThreadPool::optimalThreadCount(), 1U) - 1, gMaxWorkers);
+    if(threads > 1) {
+        m_scheduler = new TaskScheduler(threads);
+        btSetTaskScheduler(m_scheduler);
+
+        m_dispatcher = new btCollisionDispatcherMt(m_collisionConfiguration);
+        m_solverPool = new btConstraintSolverPoolMt(threads);
+        m_solver = new btSequentialImpulseConstraintSolverMt;
+    }
+#endif
+    if(m_scheduler == nullptr) {
+        m_dispatcher = new btCollisionDispatcher(m_collisionConfiguration);
+        m_solver = new btSequentialImpulseConstraintSolver;
+    }
+
     Collider::registerClassFactory(this);
 
     RigidBody::registerClassFactory(this);
@@ -93,10 +375,16 @@ BulletSystem::~BulletSystem() {
     }
 
     delete m_solver;
+    delete m_solverPool;
     delete m_overlappingPairCache;
     delete m_dispatcher;
     delete m_collisionConfiguration;
 
+    if(m_scheduler) {
+        btSetTaskScheduler(btGetSequentialTaskScheduler());
+        delete m_scheduler;
+    }
+
     Collider::unregisterClassFactory(this);
 
     RigidBody::unregisterClassFactory(this);
@@ -124,45 +412,57 @@ void BulletSystem::update(World *world) {
         btDynamicsWorld *dynamicWorld = nullptr;
         auto it = m_worlds.find(world->uuid());
         if(it == m_worlds.end()) {
-            dynamicWorld = new btDiscreteDynamicsWorld(m_dispatcher, m_overlappingPairCache, m_solver, m_collisionConfiguration);
-#ifdef SHARED_DEFINE
-            BulletDebug *dbg = new BulletDebug;
-            dbg->setDebugMode(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawConstraints | btIDebugDraw::DBG_DrawConstraintLimits);
-            dynamicWorld->setDebugDrawer(dbg);
-#endif
+            dynamicWorld = createWorld();
             m_worlds[world->uuid()] = dynamicWorld;
             world->setRayCastHandler(&rayCast, this);
+            world->setQueryHandler(&query, this);
         } else {
             dynamicWorld = it->second;
         }
 
+        m_contacts.begin();
+
         for(auto &it : m_colliderList) {
-            it->dirtyContacts();
+            if(it->m_world == nullptr && it->world() == world) {
+                it->setBulletWorld(dynamicWorld);
+            }
+
+            it->update();
+
+            it->m_stayListener = ContactCache::isReceiving(it, _SIGNAL(stay()));
+
+            VolumeCollider *volume = dynamic_cast<VolumeCollider *>(it);
+            if(volume && volume->trigger() && it->m_world == dynamicWorld) {
+                m_triggers.push_back(volume);
+            }
         }
 
         for(int i = 0; i < m_dispatcher->getNumManifolds(); i++) {
             btPersistentManifold *contact = m_dispatcher->getManifoldByIndexInternal(i);
+            if(contact->getNumContacts() == 0) {
+                continue;
+            }
 
             const btCollisionObject *a = static_cast<const btCollisionObject*>(contact->getBody0());
             const btCollisionObject *b = static_cast<const btCollisionObject*>(contact->getBody1());
 
-            Collider *colliderA = reinterpret_cast<Collider *>(a->getUserPointer());
-            Collider *colliderB = reinterpret_cast<Collider *>(b->getUserPointer());
-
-            if(colliderA && colliderB) {
-                colliderA->setContact(colliderB);
-                colliderB->setContact(colliderA);
-            }
+            m_contacts.addContact(reinterpret_cast<Collider *>(a->getUserPointer()),
+                                  reinterpret_cast<Collider *>(b->getUserPointer()), true);
         }
 
-        for(auto &it : m_colliderList) {
-            if(it->m_world == nullptr && it->world() == world) {
-                it->setBulletWorld(dynamicWorld);
+        // Only the triggers are notified about the objects inside of them
+        for(auto &it : m_triggers) {
+            btGhostObject *ghost = btGhostObject::upcast(it->m_collisionObject);
+            if(ghost) {
+                btAlignedObjectArray<btCollisionObject *> &pairs = ghost->getOverlappingPairs();
+                for(int32_t i = 0; i < pairs.size(); i++) {
+                    m_contacts.addContact(it, reinterpret_cast<Collider *>(pairs[i]->getUserPointer()), false);
+                }
             }
-
-            it->update();
-            it->cleanContacts();
         }
+        m_triggers.clear();
+
+        m_contacts.end();
 
         for(auto &it : m_jointList) {
             if(it->m_world == nullptr && it->world() == world) {
@@ -170,9 +470,52 @@ void BulletSystem::update(World *world) {
             }
         }
 
-        dynamicWorld->stepSimulation(Timer::deltaTime(), 4);
+        dynamicWorld->stepSimulation(Timer::deltaTime(), m_maxSubSteps, m_fixedStep);
+
+        writeTransforms();
+
+        // The deferred queries see the state of the world after the step
+        world->processDeferredQueries();
     }
 }
+/*!
+    \internal
+    Creates a new dynamics world, the multithreaded one in case of the task scheduler is available.
+*/
+btDynamicsWorld *BulletSystem::createWorld() {
+    btDiscreteDynamicsWorld *result = nullptr;
+#if BT_THREADSAFE
+    if(m_scheduler) {
+        result = new btDiscreteDynamicsWorldMt(m_dispatcher, m_overlappingPairCache, m_solverPool, m_solver, m_collisionConfiguration);
+    }
+#endif
+    if(result == nullptr) {
+        result = new btDiscreteDynamicsWorld(m_dispatcher, m_overlappingPairCache, m_solver, m_collisionConfiguration);
+    }
+    // Only the awake bodies must be synchronized, they are collected by the motion states during the step
+    result->setSynchronizeAllMotionStates(false);
+    result->setWorldUserInfo(&m_awakeBodies);
+
+#ifdef SHARED_DEFINE
+    BulletDebug *dbg = new BulletDebug;
+    dbg->setDebugMode(btIDebugDraw::DBG_DrawWireframe | btIDebugDraw::DBG_DrawConstraints | btIDebugDraw::DBG_DrawConstraintLimits);
+    result->setDebugDrawer(dbg);
+#endif
+
+    return result;
+}
+/*!
+    \internal
+    Writes the interpolated transforms of the awake rigid bodies back to their Transform components.
+*/
+void BulletSystem::writeTransforms() {
+    PROFILE_FUNCTION();
+
+    for(auto it : m_awakeBodies) {
+        it->writeTransform();
+    }
+    m_awakeBodies.clear();
+}
 
 int BulletSystem::threadPolicy() const {
     return Pool;
@@ -193,6 +536,8 @@ void BulletSystem::addObject(Object *object) {
 }
 
 void BulletSystem::removeObject(Object *object) {
+    m_contacts.removeCollider(static_cast<Collider *>(object));
+
     m_colliderList.remove(static_cast<Collider *>(object));
     m_jointList.remove(static_cast<Joint *>(object));
 
@@ -231,3 +576,33 @@ bool BulletSystem::rayCast(System *system, World *world, const Ray &ray, float d
     }
     return false;
 }
+/*!
+    \internal
+    Executes the queries of the \a batch in the dynamics world of the \a world.
+    The queries are processed in parallel on the thread pool of the \a system in case of the task scheduler is available.
+    The overlaps are tested on the calling thread afterwards, because the contact test allocates the manifolds of the dispatcher
+    which is thread safe only during the simulation step.
+*/
+void BulletSystem::query(System *system, World *world, QueryBatch &batch) {
+    PROFILE_FUNCTION();
+
+    BulletSystem *bullet = static_cast<BulletSystem *>(system);
+    auto it = bullet->m_worlds.find(world->uuid());
+    if(it != bullet->m_worlds.end()) {
+        it->second->updateAabbs();
+
+#if BT_THREADSAFE
+        if(bullet->m_scheduler) {
+            btParallelFor(0, batch.size(), gQueryGrain, QueryBody(it->second, batch, false));
+
+            for(uint32_t i = 0; i < batch.size(); i++) {
+                if(batch.query(i).type == QueryBatch::Overlap) {
+                    executeQuery(it->second, batch, i);
+                }
+            }
+            return;
+        }
+#endif
+        QueryBody(it->second, batch, true).forLoop(0, batch.size());
+    }
+}
@@ -20,7 +20,8 @@ Collider::Collider() :
         m_collisionShape(nullptr),
         m_collisionObject(nullptr),
         m_world(nullptr),
-        m_rigidBody(nullptr) {
+        m_rigidBody(nullptr),
+        m_stayListener(false) {
 
 }
 
@@ -126,53 +127,6 @@ void Collider::destroyCollider() {
         m_collisionObject = nullptr;
     }
 }
-/*!
-    Marks all current collision contacts as dirty, indicating that they should be checked for updates.
-*/
-void Collider::dirtyContacts() {
-    for(auto &it : m_collisions) {
-        it.second = true;
-    }
-}
-/*!
-    Cleans up stale collision contacts and emits signals for collisions that have ended.
-*/
-void Collider::cleanContacts() {
-    auto it = m_collisions.begin();
-    while(it != m_collisions.end()) {
-        if(it->second == true) {
-            emitSignal(_SIGNAL(exited()));
-            it = m_collisions.erase(it);
-            if(m_collisionObject) {
-                m_collisionObject->activate(true);
-            }
-        } else {
-            ++it;
-        }
-    }
-}
-/*!
-    Sets a new collision contact with another \a collider.
-    Emits appropriate signals based on whether the contact is new, sustained, or ended.
-*/
-void Collider::setContact(Collider *collider) {
-    if(collider == nullptr) {
-        return;
-    }
-    bool result = true;
-    for(auto &it : m_collisions) {
-        if(it.first == collider->uuid()) {
-            emitSignal(_SIGNAL(stay()));
-            it.second = false;
-            result = false;
-            break;
-        }
-    }
-    if(result) {
-        emitSignal(_SIGNAL(entered()));
-        m_collisions[collider->uuid()] = false;
-    }
-}
 /*!
     \internal
     Returns the color used for visualizing the collider in editor Gizmos.
@@ -92,7 +92,9 @@ btCollisionShape *MeshCollider::shape() {
 
         Vector3Vector &v = m_mesh->vertices();
         IndexVector &i = m_mesh->indices();
-        for(size_t index = 0; index < i.size(); index += 3) {
+        // Only the base level of detail is used for collisions
+        size_t count = (m_mesh->lodCount() > 1) ? m_mesh->indexStart(0, 1) : i.size();
+        for(size_t index = 0; index < count; index += 3) {
             Vector3 v1 = v[i[index]];
             Vector3 v2 = v[i[index + 1]];
             Vector3 v3 = v[i[index + 2]];
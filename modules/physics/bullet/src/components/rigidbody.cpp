@@ -19,7 +19,8 @@ enum Axises {
 class MotionState : public btMotionState {
 public:
     explicit MotionState(RigidBody *body) :
-        m_body(body) {
+        m_body(body),
+        m_moved(false) {
 
     }
 
@@ -32,8 +33,25 @@ public:
     }
 
     void setWorldTransform(const btTransform &worldTrans) override {
+        // Called by Bullet for the awake bodies only, the transform will be written back by BulletSystem after the step
+        m_transform = worldTrans;
+        if(!m_moved && m_body->m_world) {
+            std::vector<RigidBody *> *awake = reinterpret_cast<std::vector<RigidBody *> *>(m_body->m_world->getWorldUserInfo());
+            if(awake) {
+                awake->push_back(m_body);
+            }
+        }
+        m_moved = true;
+    }
+
+    void writeTransform() {
+        if(!m_moved) {
+            return;
+        }
+        m_moved = false;
+
         Transform *t = m_body->transform();
-        btQuaternion q = worldTrans.getRotation();
+        btQuaternion q = m_transform.getRotation();
 
         Quaternion rot;
         rot.x = q.getX();
@@ -43,7 +61,7 @@ public:
 
         t->setQuaternion(rot);
 
-        btVector3 p = worldTrans.getOrigin();
+        btVector3 p = m_transform.getOrigin();
         Vector3 position(p.x(), p.y(), p.z());
 
         Transform *parent = t->parentTransform();
@@ -55,8 +73,12 @@ public:
     }
 
 private:
+    btTransform m_transform;
+
     RigidBody *m_body;
 
+    bool m_moved;
+
 };
 
 /*!
@@ -73,6 +95,7 @@ RigidBody::RigidBody() :
         m_mass(1.0f),
         m_lockPosition(0),
         m_lockRotation(0),
+        m_kinematicHash(0),
         m_kinematic(false) {
 
     m_collisionShape = new btCompoundShape;
@@ -100,6 +123,13 @@ void RigidBody::update() {
     if(m_collisionObject && m_kinematic) {
         Transform *t = transform();
 
+        // Push the kinematic transform only when it was changed from the outside
+        uint32_t hash = t->hash();
+        if(hash == m_kinematicHash) {
+            return;
+        }
+        m_kinematicHash = hash;
+
         Quaternion q = t->worldQuaternion();
         Vector3 p = t->worldPosition();
 
@@ -107,6 +137,13 @@ void RigidBody::update() {
                                                                                       btVector3(p.x, p.y, p.z)));
     }
 }
+/*!
+    \internal
+    Writes the simulated transform of the awake rigid body to the Transform component.
+*/
+void RigidBody::writeTransform() {
+    m_state->writeTransform();
+}
 /*!
     Returns the mass of the rigid body.
 */
@@ -202,6 +239,8 @@ void RigidBody::createCollider() {
 
     body->setUserPointer(this);
 
+    m_kinematicHash = 0;
+
     if(m_kinematic) {
         body->setCollisionFlags(btCollisionObject::CF_KINEMATIC_OBJECT | btCollisionObject::CF_STATIC_OBJECT);
     }
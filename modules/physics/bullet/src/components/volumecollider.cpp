@@ -34,19 +34,6 @@ VolumeCollider::~VolumeCollider() {
         m_world->removeCollisionObject(m_collisionObject);
     }
 }
-/*!
-    \internal
-    Updates the state of the volume collider.
-    If the collider is set as a trigger, it checks for overlapping colliders and triggers appropriate callbacks.
-*/
-void VolumeCollider::update() {
-    if(m_collisionObject && m_trigger) {
-        btPairCachingGhostObject *ghost = static_cast<btPairCachingGhostObject *>(m_collisionObject);
-        for(int32_t i = 0; i < ghost->getOverlappingPairs().size(); i++) {
-            setContact(reinterpret_cast<Collider *>(ghost->getOverlappingPairs().at(i)->getUserPointer()));
-        }
-    }
-}
 /*!
     Returns true if the collider is a trigger, false otherwise.
 */
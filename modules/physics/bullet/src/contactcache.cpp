@@ -0,0 +1,172 @@
+#include "contactcache.h"
+
+#include <metaobject.h>
+
+#include <btBulletDynamicsCommon.h>
+
+#include "components/collider.h"
+
+/*!
+    \class ContactCache
+    \brief Tracks the contacts between the colliders and delivers the contact signals.
+    \internal
+
+    The cache stores one record per pair of colliders, the pair is identified by the uuids of both colliders.
+    Every frame the physics system reports the current contacts between begin() and end() calls, each report is a single hash map lookup.
+    The end() call compares the cache with the reported contacts in one pass and emits the signals grouped by type:
+    all Collider::entered() signals first, then Collider::stay() and Collider::exited() at last.
+
+    A pair can be \c mutual, in this case both colliders receive the signals; otherwise only the first collider is notified (used for the triggers).
+    The Collider::stay() signal is emitted only for the colliders which have receivers connected to it.
+*/
+
+ContactCache::ContactCache() :
+        m_frame(0) {
+
+}
+/*!
+    Starts collecting the contacts of a new frame.
+*/
+void ContactCache::begin() {
+    m_frame++;
+
+    m_entered.clear();
+    m_stayed.clear();
+    m_exited.clear();
+}
+/*!
+    Reports a contact between colliders \a a and \a b in the current frame.
+    Both colliders will be notified in case of \a mutual flag is true; otherwise only collider \a a.
+*/
+void ContactCache::addContact(Collider *a, Collider *b, bool mutual) {
+    if(a == nullptr || b == nullptr || a == b) {
+        return;
+    }
+
+    uint32_t uuidA = a->uuid();
+    uint32_t uuidB = b->uuid();
+    if(mutual && uuidA > uuidB) {
+        std::swap(a, b);
+        std::swap(uuidA, uuidB);
+    }
+    // The one-sided pairs are keyed in order of the notified collider first
+    uint64_t key = (uint64_t(uuidA) << 32) | uuidB;
+    if(!mutual && uuidA > uuidB) {
+        // The mutual contact of the same colliders already notifies both of them
+        auto it = m_pairs.find((uint64_t(uuidB) << 32) | uuidA);
+        if(it != m_pairs.end() && it->second.mutual && it->second.frame == m_frame) {
+            return;
+        }
+    }
+
+    auto it = m_pairs.find(key);
+    if(it == m_pairs.end()) {
+        m_pairs[key] = {a, b, m_frame, mutual};
+        m_entered.push_back(key);
+    } else if(it->second.frame != m_frame) {
+        it->second.frame = m_frame;
+        it->second.mutual |= mutual;
+        m_stayed.push_back(key);
+    } else {
+        it->second.mutual |= mutual;
+    }
+}
+/*!
+    Finishes the current frame: removes the pairs which were not reported and emits the contact signals.
+*/
+void ContactCache::end() {
+    auto it = m_pairs.begin();
+    while(it != m_pairs.end()) {
+        if(it->second.frame != m_frame) {
+            m_exited.push_back(it->second);
+            it = m_pairs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for(auto key : m_entered) {
+        Pair &pair = m_pairs[key];
+        notify(_SIGNAL(entered()), pair.a, false);
+        if(pair.mutual) {
+            notify(_SIGNAL(entered()), pair.b, false);
+        }
+    }
+
+    for(auto key : m_stayed) {
+        Pair &pair = m_pairs[key];
+        if(pair.a && pair.a->m_stayListener) {
+            notify(_SIGNAL(stay()), pair.a, false);
+        }
+        if(pair.mutual && pair.b && pair.b->m_stayListener) {
+            notify(_SIGNAL(stay()), pair.b, false);
+        }
+    }
+
+    for(auto &pair : m_exited) {
+        notify(_SIGNAL(exited()), pair.a, true);
+        if(pair.mutual) {
+            notify(_SIGNAL(exited()), pair.b, true);
+        }
+    }
+}
+/*!
+    Forgets the destroyed \a collider.
+    The pairs with the \a collider stay in the cache so the other colliders receive Collider::exited() signal on the next frame.
+*/
+void ContactCache::removeCollider(Collider *collider) {
+    for(auto &it : m_pairs) {
+        Pair &pair = it.second;
+        if(pair.a == collider) {
+            pair.a = nullptr;
+        }
+        if(pair.b == collider) {
+            pair.b = nullptr;
+        }
+    }
+    // The collider can be destroyed by a receiver during the signals delivery
+    for(auto &pair : m_exited) {
+        if(pair.a == collider) {
+            pair.a = nullptr;
+        }
+        if(pair.b == collider) {
+            pair.b = nullptr;
+        }
+    }
+}
+/*!
+    Returns the number of the pairs in contact.
+*/
+uint32_t ContactCache::size() const {
+    return m_pairs.size();
+}
+/*!
+    Returns true if the \a collider has receivers connected to the \a signal; otherwise returns false.
+*/
+bool ContactCache::isReceiving(const Collider *collider, const char *signal) {
+    const Object::LinkList &receivers = collider->getReceivers();
+    if(receivers.empty()) {
+        return false;
+    }
+
+    int32_t index = collider->metaObject()->indexOfSignal(&signal[1]);
+    for(auto &it : receivers) {
+        if(it.signal == index) {
+            return true;
+        }
+    }
+    return false;
+}
+/*!
+    \internal
+*/
+void ContactCache::notify(const char *signal, Collider *receiver, bool activate) {
+    if(receiver == nullptr) {
+        return;
+    }
+
+    receiver->emitSignal(signal);
+    if(activate && receiver->m_collisionObject) {
+        receiver->m_collisionObject->activate(true);
+    }
+}
@@ -0,0 +1,88 @@
+#include "tst_common.h"
+
+#include "bulletsystem.h"
+
+#include "components/world.h"
+#include "components/scene.h"
+#include "components/actor.h"
+#include "components/transform.h"
+
+#include "utils/querybatch.h"
+
+class BulletSystemTest : public ::testing::Test {
+
+};
+
+TEST_F(BulletSystemTest, Batch_queries) {
+    Engine engine(nullptr, "");
+    BulletSystem bullet(&engine);
+    System &system = bullet;
+
+    Engine::setGameMode(true);
+
+    World *world = Engine::objectCreate<World>("World");
+    Scene *scene = world->createScene("Scene");
+
+    // Unit spheres along the X axis
+    std::vector<Object *> colliders;
+    for(int32_t i = 0; i < 4; i++) {
+        Actor *actor = Engine::composeActor("SphereCollider", "Sphere", scene);
+        actor->transform()->setPosition(Vector3(i * 4.0f, 0.0f, 0.0f));
+
+        Component *collider = actor->component("SphereCollider");
+        ASSERT_TRUE(collider != nullptr);
+        collider->setProperty("radius", 1.0f);
+        colliders.push_back(collider);
+    }
+
+    // Creates the dynamics world and registers the query handler
+    system.update(world);
+
+    const Ray ray(Vector3(-2.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f));
+
+    // Enough copies to split the batch between the workers, the overlaps are interleaved with the casts
+    QueryBatch batch;
+    for(int32_t i = 0; i < 32; i++) {
+        batch.addRayCast(ray, 100.0f);
+        batch.addRayCastAll(ray, 7.0f, 4);
+        batch.addSphereCast(ray, 0.5f, 100.0f);
+        batch.addOverlap(Vector3(4.0f, 0.0f, 0.0f), 0.5f, 2);
+        batch.addOverlap(Vector3(2.0f, 0.0f, 0.0f), 0.5f, 2);
+    }
+
+    world->query(batch);
+    ASSERT_TRUE(batch.isReady());
+
+    for(uint32_t i = 0; i < batch.size(); i += 5) {
+        ASSERT_EQ(batch.hitCount(i), 1);
+        EXPECT_EQ(batch.hit(i).object, colliders[0]);
+        EXPECT_NEAR(batch.hit(i).distance, 1.0f, 0.01f);
+
+        ASSERT_EQ(batch.hitCount(i + 1), 2);
+        EXPECT_EQ(batch.hit(i + 1, 0).object, colliders[0]);
+        EXPECT_EQ(batch.hit(i + 1, 1).object, colliders[1]);
+        EXPECT_NEAR(batch.hit(i + 1, 1).distance, 5.0f, 0.01f);
+
+        ASSERT_EQ(batch.hitCount(i + 2), 1);
+        EXPECT_EQ(batch.hit(i + 2).object, colliders[0]);
+        EXPECT_NEAR(batch.hit(i + 2).distance, 0.5f, 0.01f);
+
+        ASSERT_EQ(batch.hitCount(i + 3), 1);
+        EXPECT_EQ(batch.hit(i + 3).object, colliders[1]);
+
+        ASSERT_EQ(batch.hitCount(i + 4), 0);
+    }
+
+    // The deferred batch is executed right after the simulation step
+    world->queryDeferred(batch);
+    ASSERT_EQ(batch.state(), QueryBatch::Pending);
+
+    system.update(world);
+    ASSERT_TRUE(batch.isReady());
+    EXPECT_EQ(batch.hitCount(1), 2);
+    EXPECT_EQ(batch.hitCount(3), 1);
+
+    delete world;
+
+    Engine::setGameMode(false);
+}
@@ -0,0 +1,236 @@
+#include "tst_common.h"
+
+#include "bulletsystem.h"
+#include "contactcache.h"
+
+#include "components/spherecollider.h"
+
+#include <functional>
+
+class ContactCacheTest : public ::testing::Test {
+public:
+    class TestCollider : public SphereCollider {
+    public:
+        using Collider::m_stayListener;
+
+    };
+
+    class ContactReceiver : public Object {
+        A_REGISTER(ContactReceiver, Object, Test)
+
+        A_METHODS(
+            A_SLOT(ContactReceiver::onEntered),
+            A_SLOT(ContactReceiver::onStay),
+            A_SLOT(ContactReceiver::onExited)
+        )
+
+    public:
+        void onEntered() {
+            entered++;
+            if(callback) {
+                callback();
+            }
+        }
+
+        void onStay() {
+            stay++;
+        }
+
+        void onExited() {
+            exited++;
+        }
+
+        std::function<void()> callback;
+
+        int entered = 0;
+        int stay = 0;
+        int exited = 0;
+
+    };
+
+    static TestCollider *collider(ContactReceiver &receiver) {
+        Collider *result = Engine::objectCreate<SphereCollider>();
+
+        Object::connect(result, _SIGNAL(entered()), &receiver, _SLOT(onEntered()));
+        Object::connect(result, _SIGNAL(stay()), &receiver, _SLOT(onStay()));
+        Object::connect(result, _SIGNAL(exited()), &receiver, _SLOT(onExited()));
+
+        TestCollider *test = static_cast<TestCollider *>(result);
+        test->m_stayListener = ContactCache::isReceiving(result, _SIGNAL(stay()));
+        return test;
+    }
+
+};
+
+TEST_F(ContactCacheTest, Enter_stay_exit) {
+    Engine engine(nullptr, "");
+    BulletSystem bullet(&engine);
+
+    ContactReceiver first;
+    ContactReceiver second;
+    TestCollider *a = collider(first);
+    TestCollider *b = collider(second);
+
+    ContactCache cache;
+
+    cache.begin();
+    cache.addContact(a, b, true);
+    // The repeated report of the same pair in one frame is ignored
+    cache.addContact(b, a, true);
+    cache.end();
+
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(first.entered, 1);
+    EXPECT_EQ(second.entered, 1);
+    EXPECT_EQ(first.stay, 0);
+
+    cache.begin();
+    cache.addContact(b, a, true);
+    cache.end();
+
+    EXPECT_EQ(first.entered, 1);
+    EXPECT_EQ(first.stay, 1);
+    EXPECT_EQ(second.stay, 1);
+    EXPECT_EQ(first.exited, 0);
+
+    // The pair which is not reported anymore exits
+    cache.begin();
+    cache.end();
+
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(first.exited, 1);
+    EXPECT_EQ(second.exited, 1);
+    EXPECT_EQ(first.stay, 1);
+
+    delete a;
+    delete b;
+}
+
+TEST_F(ContactCacheTest, One_sided_trigger) {
+    Engine engine(nullptr, "");
+    BulletSystem bullet(&engine);
+
+    ContactReceiver first;
+    ContactReceiver second;
+    TestCollider *a = collider(first);
+    TestCollider *b = collider(second);
+
+    // The trigger is the collider with the greater uuid, so its one-sided pair is checked against the mutual one
+    bool ordered = a->uuid() < b->uuid();
+    TestCollider *low = ordered ? a : b;
+    TestCollider *high = ordered ? b : a;
+    ContactReceiver &lowReceiver = ordered ? first : second;
+    ContactReceiver &highReceiver = ordered ? second : first;
+
+    ContactCache cache;
+
+    // Only the trigger is notified
+    cache.begin();
+    cache.addContact(high, low, false);
+    cache.end();
+
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(highReceiver.entered, 1);
+    EXPECT_EQ(lowReceiver.entered, 0);
+
+    cache.begin();
+    cache.end();
+
+    EXPECT_EQ(highReceiver.exited, 1);
+    EXPECT_EQ(lowReceiver.exited, 0);
+
+    // The mutual contact of the same colliders already notifies the trigger
+    cache.begin();
+    cache.addContact(low, high, true);
+    cache.addContact(high, low, false);
+    cache.end();
+
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(highReceiver.entered, 2);
+    EXPECT_EQ(lowReceiver.entered, 1);
+
+    delete low;
+    delete high;
+}
+
+TEST_F(ContactCacheTest, Remove_during_delivery) {
+    Engine engine(nullptr, "");
+    BulletSystem bullet(&engine);
+
+    ContactReceiver first;
+    ContactReceiver second;
+    ContactReceiver third;
+    TestCollider *a = collider(first);
+    TestCollider *b = collider(second);
+    TestCollider *c = collider(third);
+
+    ContactCache cache;
+
+    // The receiver of the first collider destroys the others in the middle of the delivery
+    first.callback = [&]() {
+        if(b && c) {
+            cache.removeCollider(b);
+            delete b;
+            b = nullptr;
+
+            cache.removeCollider(c);
+            delete c;
+            c = nullptr;
+        }
+    };
+
+    cache.begin();
+    cache.addContact(a, b, false);
+    cache.addContact(a, c, false);
+    cache.addContact(b, c, true);
+    cache.end();
+
+    EXPECT_EQ(first.entered, 2);
+    EXPECT_EQ(second.entered, 0);
+    EXPECT_EQ(third.entered, 0);
+
+    // The remaining collider exits from the pairs with the destroyed ones
+    first.callback = nullptr;
+
+    cache.begin();
+    cache.end();
+
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(first.exited, 2);
+    EXPECT_EQ(second.exited, 0);
+    EXPECT_EQ(third.exited, 0);
+
+    delete a;
+}
+
+TEST_F(ContactCacheTest, Stay_listener_filter) {
+    Engine engine(nullptr, "");
+    BulletSystem bullet(&engine);
+
+    ContactReceiver first;
+    ContactReceiver second;
+    TestCollider *a = collider(first);
+    TestCollider *b = collider(second);
+
+    Collider *silent = Engine::objectCreate<SphereCollider>();
+    EXPECT_TRUE(ContactCache::isReceiving(a, _SIGNAL(stay())));
+    EXPECT_FALSE(ContactCache::isReceiving(silent, _SIGNAL(stay())));
+    delete silent;
+
+    // The stay signal is emitted only for the colliders marked as listeners
+    b->m_stayListener = false;
+
+    ContactCache cache;
+    for(int i = 0; i < 3; i++) {
+        cache.begin();
+        cache.addContact(a, b, true);
+        cache.end();
+    }
+
+    EXPECT_EQ(first.stay, 2);
+    EXPECT_EQ(second.stay, 0);
+    EXPECT_EQ(second.entered, 1);
+
+    delete a;
+    delete b;
+}
@@ -3,6 +3,8 @@
 
 #include <commandbuffer.h>
 
+#include "ringbuffergl.h"
+
 #define VERTEX_ATRIB    0
 #define UV0_ATRIB       1
 #define COLOR_ATRIB     2
@@ -19,6 +21,7 @@ public:
     CommandBufferGL();
 
     void begin();
+    void end();
 
     void clearRenderTarget(bool clearColor = true, const Vector4 &color = Vector4(0.0f), bool clearDepth = true, float depth = 1.0f) override;
 
@@ -28,6 +31,8 @@ public:
 
     void setRenderTarget(RenderTarget *target, uint32_t level = 0) override;
 
+    void copyRenderTarget(RenderTarget *source, int32_t x, int32_t y, int32_t width, int32_t height) override;
+
     void setViewport(int32_t x, int32_t y, int32_t width, int32_t height) override;
 
     void enableScissor(int32_t x, int32_t y, int32_t width, int32_t height) override;
@@ -37,8 +42,21 @@ public:
     void beginDebugMarker(const char *name) override;
     void endDebugMarker() override;
 
+    RingBufferGL &ringBuffer();
+
+    bool uploadGlobal(uint32_t &offset);
+
     static void setObjectName(int32_t type, int32_t id, const std::string &name);
 
+private:
+    RingBufferGL m_ringBuffer;
+
+    Global m_uploadedGlobal;
+
+    uint32_t m_globalOffset;
+
+    bool m_globalUploaded;
+
 };
 
 #endif // COMMANDBUFFERGL_H
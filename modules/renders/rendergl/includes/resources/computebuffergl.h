@@ -19,6 +19,8 @@ private:
 
     uint32_t m_ssbo;
 
+    size_t m_size;
+
 };
 
 #endif // COMPUTEBUFFERGL_H
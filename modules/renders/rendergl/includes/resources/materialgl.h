@@ -22,6 +22,8 @@ public:
     bool bind(CommandBufferGL *buffer, uint32_t layer, uint32_t index, const Global &global);
 
 private:
+    const uint8_t *uploadData(uint32_t offset, uint32_t size);
+
     static void setBlendState(const Material::BlendState &state);
 
     static void setRasterState(const Material::RasterState &state);
@@ -37,6 +39,8 @@ private:
 
     Material::StencilState m_stencilState;
 
+    ByteArray m_uploadBuffer;
+
     uint32_t m_instanceBuffer;
     uint32_t m_globalBuffer;
 
@@ -70,8 +74,6 @@ public:
 
     uint32_t getProgram(uint16_t type, int32_t &global, int32_t &local);
 
-    Textures &textures() { return m_textures; }
-
 protected:
     uint32_t buildShader(uint16_t type, const std::string &src = std::string());
 
@@ -36,6 +36,9 @@ public:
     uint32_t m_triangles;
     uint32_t m_vertices;
 
+    uint32_t m_indexType;
+    uint32_t m_indexSize;
+
     std::list<VaoStruct *> m_vao;
 
 };
@@ -0,0 +1,46 @@
+#ifndef RINGBUFFERGL_H
+#define RINGBUFFERGL_H
+
+#include <cstdint>
+
+class RingBufferGL {
+public:
+    enum {
+        FramesInFlight = 3
+    };
+
+public:
+    RingBufferGL();
+    ~RingBufferGL();
+
+    void beginFrame();
+    void endFrame();
+
+    uint8_t *allocate(uint32_t size, uint32_t &offset);
+
+    uint32_t nativeHandle() const;
+
+    bool isPersistent() const;
+
+private:
+    void create(uint32_t size);
+    void destroy();
+
+private:
+    void *m_fences[FramesInFlight];
+
+    uint8_t *m_data;
+
+    uint32_t m_handle;
+
+    uint32_t m_segmentSize;
+    uint32_t m_requestedSize;
+
+    uint32_t m_alignment;
+
+    uint32_t m_segment;
+    uint32_t m_offset;
+
+};
+
+#endif // RINGBUFFERGL_H
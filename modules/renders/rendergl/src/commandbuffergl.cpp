@@ -8,11 +8,14 @@
 #include "resources/materialgl.h"
 #include "resources/rendertargetgl.h"
 #include "resources/computeshadergl.h"
+#include "resources/computebuffergl.h"
 
 #include <log.h>
 #include <timer.h>
 
-CommandBufferGL::CommandBufferGL() {
+CommandBufferGL::CommandBufferGL() :
+        m_globalOffset(0),
+        m_globalUploaded(false) {
 
     PROFILE_FUNCTION();
 }
@@ -23,6 +26,39 @@ void CommandBufferGL::begin() {
     m_global.time = Timer::time();
     m_global.deltaTime = Timer::deltaTime();
     m_global.clip = 0.1f;
+
+    m_ringBuffer.beginFrame();
+    m_globalUploaded = false;
+}
+
+void CommandBufferGL::end() {
+    PROFILE_FUNCTION();
+
+    m_ringBuffer.endFrame();
+}
+
+RingBufferGL &CommandBufferGL::ringBuffer() {
+    return m_ringBuffer;
+}
+
+bool CommandBufferGL::uploadGlobal(uint32_t &offset) {
+    if(!m_ringBuffer.isPersistent()) {
+        return false;
+    }
+
+    if(!m_globalUploaded || memcmp(&m_uploadedGlobal, &m_global, sizeof(Global)) != 0) {
+        uint8_t *data = m_ringBuffer.allocate(sizeof(Global), m_globalOffset);
+        if(data == nullptr) {
+            return false;
+        }
+
+        memcpy(data, &m_global, sizeof(Global));
+        m_uploadedGlobal = m_global;
+        m_globalUploaded = true;
+    }
+
+    offset = m_globalOffset;
+    return true;
 }
 
 void CommandBufferGL::clearRenderTarget(bool clearColor, const Vector4 &color, bool clearDepth, float depth) {
@@ -50,7 +86,7 @@ void CommandBufferGL::dispatchCompute(ComputeInstance *shader, int32_t groupsX,
         if(instance->bind(this)) {
             glDispatchCompute(groupsX, groupsY, groupsZ);
 
-            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_UNIFORM_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
         }
     }
 #endif
@@ -63,11 +99,25 @@ void CommandBufferGL::drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, Materia
         MeshGL *meshGL = static_cast<MeshGL *>(mesh);
 
         MaterialInstanceGL &instanceGL = static_cast<MaterialInstanceGL &>(instance);
-        for(uint32_t index = 0; index < instanceGL.drawsCount(); index++) {
+        ComputeBufferGL *indirect = static_cast<ComputeBufferGL *>(instance.indirectBuffer());
+        uint32_t draws = indirect ? 1 : instanceGL.drawsCount();
+        for(uint32_t index = 0; index < draws; index++) {
             if(instanceGL.bind(this, layer, index, m_global)) {
                 meshGL->bindVao(this);
 
-                if(meshGL->indices().empty()) {
+                if(indirect) {
+#ifndef THUNDER_MOBILE
+                    // The draw arguments are produced on GPU
+                    void *offset = reinterpret_cast<void *>(static_cast<uintptr_t>(instance.indirectOffset()));
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect->nativeHandle());
+                    if(meshGL->indices().empty()) {
+                        glDrawArraysIndirect((instance.material()->wireframe()) ? GL_LINE_STRIP : GL_TRIANGLE_STRIP, offset);
+                    } else {
+                        glDrawElementsIndirect((instance.material()->wireframe()) ? GL_LINES : GL_TRIANGLES, meshGL->m_indexType, offset);
+                    }
+                    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+#endif
+                } else if(meshGL->indices().empty()) {
                     int32_t glMode = (instance.material()->wireframe()) ? GL_LINE_STRIP : GL_TRIANGLE_STRIP;
                     uint32_t vert = meshGL->vertices().size();
                     glDrawArraysInstanced(glMode, 0, vert, instance.instanceCount());
@@ -75,7 +125,7 @@ void CommandBufferGL::drawMesh(Mesh *mesh, uint32_t sub, uint32_t layer, Materia
                 } else {
                     int32_t index = meshGL->indexCount(sub);
                     int32_t glMode = (instance.material()->wireframe()) ? GL_LINES : GL_TRIANGLES;
-                    glDrawElementsInstanced(glMode, index, GL_UNSIGNED_INT, reinterpret_cast<void *>(meshGL->indexStart(sub) * sizeof(int32_t)), instance.instanceCount());
+                    glDrawElementsInstanced(glMode, index, meshGL->m_indexType, reinterpret_cast<void *>(meshGL->indexStart(sub) * meshGL->m_indexSize), instance.instanceCount());
                     PROFILER_STAT(POLYGONS, (index / 3) * count);
                 }
                 PROFILER_STAT(DRAWCALLS, 1);
@@ -95,6 +145,22 @@ void CommandBufferGL::setRenderTarget(RenderTarget *target, uint32_t level) {
     }
 }
 
+void CommandBufferGL::copyRenderTarget(RenderTarget *source, int32_t x, int32_t y, int32_t width, int32_t height) {
+    PROFILE_FUNCTION();
+
+    RenderTargetGL *s = static_cast<RenderTargetGL *>(source);
+    if(s == nullptr || static_cast<int32_t>(s->nativeHandle()) == -1) {
+        return;
+    }
+
+    GLint target = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, s->nativeHandle());
+    glBlitFramebuffer(x, y, x + width, y + height, x, y, x + width, y + height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target);
+}
+
 void CommandBufferGL::setViewport(int32_t x, int32_t y, int32_t width, int32_t height) {
     CommandBuffer::setViewport(x, y, width, height);
 
@@ -95,6 +95,10 @@ bool RenderGLSystem::init() {
     }
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
     CheckGLError();
+
+    // The dispatches and the indirect draws are compiled out for the mobile targets
+    CommandBufferGL::setComputeSupported(GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_storage_buffer_object &&
+                                         (GLAD_GL_VERSION_4_0 || GLAD_GL_ARB_draw_indirect));
 #endif
     bool result = RenderSystem::init();
 
@@ -134,6 +138,8 @@ void RenderGLSystem::update(World *world) {
         }
 
         RenderSystem::update(world);
+
+        cmd->end();
     }
 }
 
@@ -5,7 +5,8 @@
 #include "agl.h"
 
 ComputeBufferGL::ComputeBufferGL() :
-        m_ssbo(0) {
+        m_ssbo(0),
+        m_size(0) {
 
 }
 
@@ -39,6 +40,16 @@ void ComputeBufferGL::updateBuffer() {
         if(!name().empty()) {
             CommandBufferGL::setObjectName(GL_BUFFER, m_ssbo, name());
         }
+
+        m_size = m_buffer.size();
+        m_bufferDirty = false;
+    } else if(m_size != m_buffer.size()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ssbo);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_buffer.size(), m_buffer.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        m_size = m_buffer.size();
+        m_bufferDirty = false;
     }
 
     if(m_bufferDirty) {
@@ -8,6 +8,7 @@
 #include "components/transform.h"
 
 #include "resources/texturegl.h"
+#include "resources/computebuffergl.h"
 
 #include <log.h>
 
@@ -351,6 +352,17 @@ MaterialInstanceGL::~MaterialInstanceGL() {
     }
 }
 
+const uint8_t *MaterialInstanceGL::uploadData(uint32_t offset, uint32_t size) {
+    if(m_batches.empty()) {
+        return &rawUniformBuffer()[offset];
+    }
+    // Buffers without the persistent mapping need the batched data in one block
+    m_uploadBuffer.resize(size);
+    copyBatched(m_uploadBuffer.data(), offset, size);
+
+    return m_uploadBuffer.data();
+}
+
 uint32_t MaterialInstanceGL::drawsCount() const {
     return (uint32_t)ceil((float)m_uniformBuffer.size() / (float)gMaxUBO);
 }
@@ -382,7 +394,10 @@ bool MaterialInstanceGL::bind(CommandBufferGL *buffer, uint32_t layer, uint32_t
 
     uint32_t materialType = material->materialType();
 
-    if(globalLocation > -1 && index == 0) {
+    uint32_t globalOffset = 0;
+    if(globalLocation > -1 && index == 0 && buffer->uploadGlobal(globalOffset)) {
+        glBindBufferRange(GL_UNIFORM_BUFFER, globalLocation, buffer->ringBuffer().nativeHandle(), globalOffset, sizeof(Global));
+    } else if(globalLocation > -1 && index == 0) {
         if(m_globalBuffer == 0) {
             glGenBuffers(1, &m_globalBuffer);
 
@@ -405,8 +420,8 @@ bool MaterialInstanceGL::bind(CommandBufferGL *buffer, uint32_t layer, uint32_t
 
     uint32_t offset = index * gMaxUBO;
 
-    ByteArray &gpuBuffer = m_batchBuffer.empty() ? rawUniformBuffer() : m_batchBuffer;
-    int gpuBufferSize = MIN(gpuBuffer.size() - offset, gMaxUBO);
+    uint32_t dataSize = batchedSize();
+    uint32_t gpuBufferSize = MIN(dataSize - offset, gMaxUBO);
 
 #ifdef THUNDER_MOBILE
     if(instanceLocation > -1) {
@@ -424,25 +439,44 @@ bool MaterialInstanceGL::bind(CommandBufferGL *buffer, uint32_t layer, uint32_t
         }
 
         glBindBuffer(GL_UNIFORM_BUFFER, m_instanceBuffer);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, gpuBufferSize, &gpuBuffer[offset]);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, gpuBufferSize, uploadData(offset, gpuBufferSize));
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
         glBindBufferBase(GL_UNIFORM_BUFFER, instanceLocation, m_instanceBuffer);
     }
 #else
-    if(m_instanceBuffer == 0) {
-        glGenBuffers(1, &m_instanceBuffer);
-    }
+    uint32_t target = (materialType == Material::Surface) ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+    uint32_t size = (materialType == Material::Surface) ? dataSize : gpuBufferSize;
+    uint32_t start = (materialType == Material::Surface) ? 0 : offset;
+
+    ComputeBuffer *instances = instanceBuffer();
+
+    uint32_t ringOffset = 0;
+    uint8_t *data = instances ? nullptr : buffer->ringBuffer().allocate(size, ringOffset);
+    if(instances) { // The instances data is produced on GPU
+        glBindBufferBase(target, instanceLocation, static_cast<ComputeBufferGL *>(instances)->nativeHandle());
+    } else if(data) {
+        // The instance and the batched instances are written straight to the mapped memory
+        copyBatched(data, start, size);
+
+        glBindBufferRange(target, instanceLocation, buffer->ringBuffer().nativeHandle(), ringOffset, size);
+    } else if(materialType == Material::Surface) {
+        if(m_instanceBuffer == 0) {
+            glGenBuffers(1, &m_instanceBuffer);
+        }
 
-    if(materialType == Material::Surface) {
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_instanceBuffer);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, gpuBuffer.size(), gpuBuffer.data(), GL_DYNAMIC_DRAW);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, dataSize, uploadData(0, dataSize), GL_DYNAMIC_DRAW);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, instanceLocation, m_instanceBuffer);
     } else {
+        if(m_instanceBuffer == 0) {
+            glGenBuffers(1, &m_instanceBuffer);
+        }
+
         glBindBuffer(GL_UNIFORM_BUFFER, m_instanceBuffer);
-        glBufferData(GL_UNIFORM_BUFFER, gpuBufferSize, &gpuBuffer[offset], GL_DYNAMIC_DRAW);
+        glBufferData(GL_UNIFORM_BUFFER, gpuBufferSize, uploadData(offset, gpuBufferSize), GL_DYNAMIC_DRAW);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
         glBindBufferBase(GL_UNIFORM_BUFFER, instanceLocation, m_instanceBuffer);
@@ -4,9 +4,22 @@
 
 #include "commandbuffergl.h"
 
+#include <utils/meshoptimizer.h>
+
+#include <cstring>
+
+static void packVectors(uint8_t *dst, const Vector3Vector &src) {
+    uint32_t *data = reinterpret_cast<uint32_t *>(dst);
+    for(size_t i = 0; i < src.size(); i++) {
+        data[i] = MeshOptimizer::packSnorm(src[i]);
+    }
+}
+
 MeshGL::MeshGL() :
         m_triangles(0),
-        m_vertices(0) {
+        m_vertices(0),
+        m_indexType(GL_UNSIGNED_INT),
+        m_indexSize(sizeof(uint32_t)) {
 
 }
 
@@ -90,6 +103,8 @@ void MeshGL::updateVao() {
     // vertices
     glBindBuffer(GL_ARRAY_BUFFER, m_vertices);
 
+    bool quantized = isQuantized();
+
     uint32_t vCount = vertices().size();
     glEnableVertexAttribArray(VERTEX_ATRIB);
     glVertexAttribPointer(VERTEX_ATRIB, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
@@ -98,8 +113,13 @@ void MeshGL::updateVao() {
     // The order is matter and must be the same with MeshGL::updateVbo attributes
     if(!uv0().empty()) {
         glEnableVertexAttribArray(UV0_ATRIB);
-        glVertexAttribPointer(UV0_ATRIB, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-        offset += sizeof(Vector2) * vCount;
+        if(quantized) {
+            glVertexAttribPointer(UV0_ATRIB, 2, GL_HALF_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+            offset += sizeof(uint16_t) * 2 * vCount;
+        } else {
+            glVertexAttribPointer(UV0_ATRIB, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+            offset += sizeof(Vector2) * vCount;
+        }
     }
     if(!colors().empty()) {
         glEnableVertexAttribArray(COLOR_ATRIB);
@@ -108,13 +128,23 @@ void MeshGL::updateVao() {
     }
     if(!normals().empty()) {
         glEnableVertexAttribArray(NORMAL_ATRIB);
-        glVertexAttribPointer(NORMAL_ATRIB, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-        offset += sizeof(Vector3) * vCount;
+        if(quantized) {
+            glVertexAttribPointer(NORMAL_ATRIB, 3, GL_BYTE, GL_TRUE, sizeof(uint32_t), reinterpret_cast<void *>(offset));
+            offset += sizeof(uint32_t) * vCount;
+        } else {
+            glVertexAttribPointer(NORMAL_ATRIB, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+            offset += sizeof(Vector3) * vCount;
+        }
     }
     if(!tangents().empty()) {
         glEnableVertexAttribArray(TANGENT_ATRIB);
-        glVertexAttribPointer(TANGENT_ATRIB, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
-        offset += sizeof(Vector3) * vCount;
+        if(quantized) {
+            glVertexAttribPointer(TANGENT_ATRIB, 3, GL_BYTE, GL_TRUE, sizeof(uint32_t), reinterpret_cast<void *>(offset));
+            offset += sizeof(uint32_t) * vCount;
+        } else {
+            glVertexAttribPointer(TANGENT_ATRIB, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void *>(offset));
+            offset += sizeof(Vector3) * vCount;
+        }
     }
     if(!bones().empty()) {
         glEnableVertexAttribArray(BONES_ATRIB);
@@ -129,6 +159,7 @@ void MeshGL::updateVao() {
 
 void MeshGL::updateVbo(CommandBufferGL *buffer) {
     bool dynamic = isDynamic();
+    bool quantized = isQuantized();
     uint32_t usage = (dynamic) ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
     uint32_t vCount = vertices().size();
 
@@ -137,7 +168,20 @@ void MeshGL::updateVbo(CommandBufferGL *buffer) {
             glGenBuffers(1, &m_triangles);
         }
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_triangles);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * indices().size(), indices().data(), usage);
+
+        // The dynamic meshes are updated too often to convert the indices on each update
+        if(vCount <= UINT16_MAX && !dynamic) {
+            m_indexType = GL_UNSIGNED_SHORT;
+            m_indexSize = sizeof(uint16_t);
+
+            std::vector<uint16_t> data(indices().begin(), indices().end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexSize * data.size(), data.data(), usage);
+        } else {
+            m_indexType = GL_UNSIGNED_INT;
+            m_indexSize = sizeof(uint32_t);
+
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexSize * indices().size(), indices().data(), usage);
+        }
     }
 
     if(!vertices().empty()) {
@@ -146,49 +190,91 @@ void MeshGL::updateVbo(CommandBufferGL *buffer) {
         }
         glBindBuffer(GL_ARRAY_BUFFER, m_vertices);
 
+        uint32_t uvSize = quantized ? sizeof(uint16_t) * 2 : sizeof(Vector2);
+        uint32_t normalSize = quantized ? sizeof(uint32_t) : sizeof(Vector3);
+
         uint32_t size = sizeof(Vector3) * vCount;
-        if(!uv0().empty()) size += sizeof(Vector2) * vCount;
+        if(!uv0().empty()) size += uvSize * vCount;
         if(!colors().empty()) size += sizeof(Vector4) * vCount;
-        if(!normals().empty()) size += sizeof(Vector3) * vCount;
-        if(!tangents().empty()) size += sizeof(Vector3) * vCount;
+        if(!normals().empty()) size += normalSize * vCount;
+        if(!tangents().empty()) size += normalSize * vCount;
         if(!weights().empty()) size += sizeof(Vector4) * vCount;
         if(!bones().empty()) size += sizeof(Vector4) * vCount;
 
-        glBufferData(GL_ARRAY_BUFFER, size, nullptr, usage);
-        size = sizeof(Vector3) * vCount;
-        size_t offset = 0;
+        if(quantized) {
+            // The compact attributes are converted to the single staging buffer to upload them at once
+            ByteArray data(size);
+            uint8_t *ptr = data.data();
 
-        glBufferSubData(GL_ARRAY_BUFFER, offset, size, vertices().data());
-        offset += size;
+            memcpy(ptr, vertices().data(), sizeof(Vector3) * vCount);
+            ptr += sizeof(Vector3) * vCount;
 
-        if(!uv0().empty()) {
-            size = sizeof(Vector2) * vCount;
-            glBufferSubData(GL_ARRAY_BUFFER, offset, size, uv0().data());
-            offset += size;
-        }
-        if(!colors().empty()) {
-            size = sizeof(Vector4) * vCount;
-            glBufferSubData(GL_ARRAY_BUFFER, offset, size, colors().data());
-            offset += size;
-        }
-        if(!normals().empty()) {
-            size = sizeof(Vector3) * vCount;
-            glBufferSubData(GL_ARRAY_BUFFER, offset, size, normals().data());
-            offset += size;
-        }
-        if(!tangents().empty()) {
+            if(!uv0().empty()) {
+                uint16_t *uv = reinterpret_cast<uint16_t *>(ptr);
+                for(uint32_t i = 0; i < vCount; i++) {
+                    uv[i * 2] = MeshOptimizer::packHalf(uv0()[i].x);
+                    uv[i * 2 + 1] = MeshOptimizer::packHalf(uv0()[i].y);
+                }
+                ptr += uvSize * vCount;
+            }
+            if(!colors().empty()) {
+                memcpy(ptr, colors().data(), sizeof(Vector4) * vCount);
+                ptr += sizeof(Vector4) * vCount;
+            }
+            if(!normals().empty()) {
+                packVectors(ptr, normals());
+                ptr += normalSize * vCount;
+            }
+            if(!tangents().empty()) {
+                packVectors(ptr, tangents());
+                ptr += normalSize * vCount;
+            }
+            if(!bones().empty()) {
+                memcpy(ptr, bones().data(), sizeof(Vector4) * vCount);
+                ptr += sizeof(Vector4) * vCount;
+            }
+            if(!weights().empty()) {
+                memcpy(ptr, weights().data(), sizeof(Vector4) * vCount);
+            }
+
+            glBufferData(GL_ARRAY_BUFFER, size, data.data(), usage);
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, usage);
             size = sizeof(Vector3) * vCount;
-            glBufferSubData(GL_ARRAY_BUFFER, offset, size, tangents().data());
-            offset += size;
-        }
-        if(!bones().empty()) {
-            size = sizeof(Vector4) * vCount;
-            glBufferSubData(GL_ARRAY_BUFFER, offset, size, bones().data());
+            size_t offset = 0;
+
+            glBufferSubData(GL_ARRAY_BUFFER, offset, size, vertices().data());
             offset += size;
-        }
-        if(!weights().empty()) {
-            size = sizeof(Vector4) * vCount;
-            glBufferSubData(GL_ARRAY_BUFFER, offset, size, weights().data());
+
+            if(!uv0().empty()) {
+                size = sizeof(Vector2) * vCount;
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, uv0().data());
+                offset += size;
+            }
+            if(!colors().empty()) {
+                size = sizeof(Vector4) * vCount;
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, colors().data());
+                offset += size;
+            }
+            if(!normals().empty()) {
+                size = sizeof(Vector3) * vCount;
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, normals().data());
+                offset += size;
+            }
+            if(!tangents().empty()) {
+                size = sizeof(Vector3) * vCount;
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, tangents().data());
+                offset += size;
+            }
+            if(!bones().empty()) {
+                size = sizeof(Vector4) * vCount;
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, bones().data());
+                offset += size;
+            }
+            if(!weights().empty()) {
+                size = sizeof(Vector4) * vCount;
+                glBufferSubData(GL_ARRAY_BUFFER, offset, size, weights().data());
+            }
         }
     }
 
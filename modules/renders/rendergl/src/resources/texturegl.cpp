@@ -5,6 +5,19 @@
 #include "agl.h"
 #include "commandbuffergl.h"
 
+#include <utils/textureencoder.h>
+
+static bool isNativeCompression(int32_t compression) {
+#ifdef THUNDER_MOBILE
+    // The BC formats aren't available on the mobile GPUs, such textures are transcoded to RGBA8 on upload
+    return compression != Texture::DXT1 && compression != Texture::DXT5 &&
+           compression != Texture::BC4 && compression != Texture::BC5 && compression != Texture::BC7;
+#else
+    A_UNUSED(compression);
+    return true;
+#endif
+}
+
 TextureGL::TextureGL() :
         m_id(0) {
 
@@ -113,6 +126,29 @@ void TextureGL::updateTexture() {
         default: break;
     }
 
+    switch(compress()) {
+    #ifndef THUNDER_MOBILE
+        case DXT1: internal = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+        case DXT5: internal = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+        case BC4: internal = GL_COMPRESSED_RED_RGTC1; break;
+        case BC5: internal = GL_COMPRESSED_RG_RGTC2; break;
+        case BC7: internal = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB; break;
+    #else
+        case DXT1:
+        case DXT5:
+        case BC4:
+        case BC5:
+        case BC7: {
+            internal = GL_RGBA8;
+            glformat = GL_RGBA;
+            type     = GL_UNSIGNED_BYTE;
+        } break;
+    #endif
+        case ETC2: internal = GL_COMPRESSED_RGB8_ETC2; break;
+        case ETC2A: internal = GL_COMPRESSED_RGBA8_ETC2_EAC; break;
+        default: break;
+    }
+
     switch(target) {
         case GL_TEXTURE_CUBE_MAP: {
             uploadTextureCubemap(target, internal, glformat, type);
@@ -121,6 +157,10 @@ void TextureGL::updateTexture() {
             uploadTexture(0, target, internal, glformat, type);
         } break;
     }
+    if(!isRender()) {
+        // The stale levels of the previous residency must not be sampled
+        glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, MAX(mipCount() - residentMip() - 1, 0));
+    }
 #ifndef THUNDER_MOBILE
     if(newObject && !name().empty()) {
         CommandBufferGL::setObjectName(GL_TEXTURE, m_id, name());
@@ -149,11 +189,24 @@ bool TextureGL::uploadTexture(uint32_t imageIndex, uint32_t target, uint32_t int
         glTexImage2D(target, 0, internal, w, h, 0, format, type, nullptr);
     } else {
         const Surface &image = surface(imageIndex);
-        if(isCompressed()) {
+        // The streamed textures skip the levels above the resident one
+        int32_t base = CLAMP(residentMip(), 0, MAX(static_cast<int32_t>(image.size()) - 1, 0));
+        if(isCompressed() && !isNativeCompression(compress())) {
+            // load all mipmaps
+            for(uint32_t i = base; i < image.size(); i++) {
+                int32_t mipWidth = MAX(w >> i, 1);
+                int32_t mipHeight = MAX(h >> i, 1);
+                ByteArray data = TextureEncoder::decode(image[i].data(), mipWidth, mipHeight, compress());
+                glTexImage2D(target, i - base, internal, mipWidth, mipHeight, 0, format, type, data.data());
+                CheckGLError();
+            }
+        } else if(isCompressed()) {
             // load all mipmaps
-            for(uint32_t i = 0; i < image.size(); i++) {
+            for(uint32_t i = base; i < image.size(); i++) {
                 const uint8_t *data = image[i].data();
-                glCompressedTexImage2D(target, i, internal, (w >> i), (h >> i), 0, size((w >> i), (h >> i)), data);
+                int32_t mipWidth = MAX(w >> i, 1);
+                int32_t mipHeight = MAX(h >> i, 1);
+                glCompressedTexImage2D(target, i - base, internal, mipWidth, mipHeight, 0, size(mipWidth, mipHeight), data);
                 CheckGLError();
             }
         } else {
@@ -166,9 +219,9 @@ bool TextureGL::uploadTexture(uint32_t imageIndex, uint32_t target, uint32_t int
             }
 
             // load all mipmaps
-            for(uint32_t i = 0; i < image.size(); i++) {
+            for(uint32_t i = base; i < image.size(); i++) {
                 const uint8_t *data = image[i].data();
-                glTexImage2D(target, i, internal, (w >> i), (h >> i), 0, format, type, data);
+                glTexImage2D(target, i - base, internal, MAX(w >> i, 1), MAX(h >> i, 1), 0, format, type, data);
                 CheckGLError();
             }
             if(alignment != -1) {
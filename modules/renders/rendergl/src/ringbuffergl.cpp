@@ -0,0 +1,153 @@
+#include "ringbuffergl.h"
+
+#include "agl.h"
+
+#include "commandbuffergl.h"
+
+#include <log.h>
+
+namespace {
+    const uint32_t gDefaultSegmentSize = 1048576;
+    const uint64_t gFenceTimeout = 1000000000;
+}
+
+RingBufferGL::RingBufferGL() :
+        m_data(nullptr),
+        m_handle(0),
+        m_segmentSize(0),
+        m_requestedSize(gDefaultSegmentSize),
+        m_alignment(256),
+        m_segment(0),
+        m_offset(0) {
+
+    for(uint32_t i = 0; i < FramesInFlight; i++) {
+        m_fences[i] = nullptr;
+    }
+}
+
+RingBufferGL::~RingBufferGL() {
+    destroy();
+}
+
+void RingBufferGL::beginFrame() {
+#ifndef THUNDER_MOBILE
+    if(!GLAD_GL_ARB_buffer_storage) {
+        return;
+    }
+
+    if(m_requestedSize > m_segmentSize) {
+        // The previous frame ran out of space, all segments must be retired before reallocation
+        destroy();
+        create(m_requestedSize);
+    }
+
+    GLsync fence = static_cast<GLsync>(m_fences[m_segment]);
+    if(fence) {
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        while(result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, gFenceTimeout);
+        }
+        glDeleteSync(fence);
+        m_fences[m_segment] = nullptr;
+    }
+#endif
+    m_offset = 0;
+}
+
+void RingBufferGL::endFrame() {
+#ifndef THUNDER_MOBILE
+    if(m_data == nullptr) {
+        return;
+    }
+
+    m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_segment = (m_segment + 1) % FramesInFlight;
+#endif
+}
+
+uint8_t *RingBufferGL::allocate(uint32_t size, uint32_t &offset) {
+    if(m_data == nullptr) {
+        return nullptr;
+    }
+
+    uint32_t aligned = (m_offset + m_alignment - 1) & ~(m_alignment - 1);
+    if(aligned + size > m_segmentSize) {
+        // Grow on the next frame and let the caller use the fallback upload path for now
+        m_requestedSize = MAX(m_requestedSize, (aligned + size) * 2);
+        return nullptr;
+    }
+
+    offset = m_segment * m_segmentSize + aligned;
+    m_offset = aligned + size;
+
+    return m_data + offset;
+}
+
+uint32_t RingBufferGL::nativeHandle() const {
+    return m_handle;
+}
+
+bool RingBufferGL::isPersistent() const {
+    return m_data != nullptr;
+}
+
+void RingBufferGL::create(uint32_t size) {
+#ifndef THUNDER_MOBILE
+    int32_t uniformAlignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    int32_t storageAlignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+
+    m_alignment = MAX(MAX(uniformAlignment, storageAlignment), 16);
+    m_segmentSize = (size + m_alignment - 1) & ~(m_alignment - 1);
+
+    uint32_t flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &m_handle);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_handle);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, m_segmentSize * FramesInFlight, nullptr, flags);
+    m_data = static_cast<uint8_t *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_segmentSize * FramesInFlight, flags));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if(m_data == nullptr) {
+        aWarning() << "[ Render::RingBufferGL ] Unable to map persistent buffer, falling back to per draw uploads.";
+        glDeleteBuffers(1, &m_handle);
+        m_handle = 0;
+        m_segmentSize = 0;
+        m_requestedSize = 0;
+        return;
+    }
+
+    CommandBufferGL::setObjectName(GL_BUFFER, m_handle, "InstanceRingBuffer");
+
+    m_requestedSize = m_segmentSize;
+    m_segment = 0;
+    m_offset = 0;
+#else
+    A_UNUSED(size);
+#endif
+}
+
+void RingBufferGL::destroy() {
+#ifndef THUNDER_MOBILE
+    for(uint32_t i = 0; i < FramesInFlight; i++) {
+        GLsync fence = static_cast<GLsync>(m_fences[i]);
+        if(fence) {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, gFenceTimeout);
+            glDeleteSync(fence);
+            m_fences[i] = nullptr;
+        }
+    }
+
+    if(m_handle > 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_handle);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        glDeleteBuffers(1, &m_handle);
+        m_handle = 0;
+    }
+#endif
+    m_data = nullptr;
+    m_segmentSize = 0;
+}
@@ -86,6 +86,8 @@ private:
 
     void recalcChilds() const;
 
+    bool isStretched() const;
+
     void recalcParent();
 
 private:
@@ -27,6 +27,8 @@ public:
     const std::list<std::string> &classes() const;
     void addClass(const std::string &name);
 
+    void invalidateStyle();
+
     Widget *parentWidget();
     std::list<Widget *> childWidgets() const;
 
@@ -75,6 +77,7 @@ private:
     friend class RectTransform;
     friend class UiLoader;
     friend class StyleSheet;
+    friend class UiSystem;
 
     std::list<std::string> m_classes;
 
@@ -82,6 +85,8 @@ private:
 
     RectTransform *m_transform;
 
+    bool m_styleDirty;
+
     static Widget *m_focusWidget;
 
 };
@@ -4,7 +4,10 @@
 #include <resource.h>
 #include <uikit.h>
 
+#include <unordered_map>
+
 class Widget;
+class Selector;
 
 class UIKIT_EXPORT StyleSheet : public Resource {
     A_REGISTER(StyleSheet, Resource, Resources)
@@ -37,10 +40,16 @@ private:
     VariantMap saveUserData() const override;
 
 private:
+    typedef std::vector<std::pair<Selector *, int>> SelectorList;
+
+    std::unordered_map<std::string, SelectorList> m_cache;
+
     std::string m_data;
 
     void *m_parser;
 
+    bool m_uncached;
+
 };
 
 #endif // STYLESHEET_H
@@ -4,6 +4,7 @@
 #include <system.h>
 
 class Widget;
+class Layout;
 
 class UiSystem : public System {
 public:
@@ -23,12 +24,28 @@ public:
 
     static std::list<Widget *> &widgets();
 
+    static void invalidateStyle(Widget *widget);
+    static void updateStyles();
+
+    static void invalidateLayout(Layout *layout);
+    static void cancelLayout(Layout *layout);
+    static void updateLayouts();
+
+    static int layoutBudget();
+    static void setLayoutBudget(int budget);
+
 private:
     void composeComponent(Component *component) const override;
 
-private:
+protected:
     static std::list<Widget *> m_uiComponents;
 
+    static std::list<Widget *> m_dirtyStyles;
+
+    static std::list<Layout *> m_dirtyLayouts;
+
+    static int m_layoutBudget;
+
 };
 
 #endif // UISYSTEM_H
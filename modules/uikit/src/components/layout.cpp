@@ -2,6 +2,8 @@
 
 #include "components/recttransform.h"
 
+#include "uisystem.h"
+
 #include <components/actor.h>
 
 /*!
@@ -12,6 +14,9 @@
     The Layout class is a base class used for managing the layout and positioning of widgets within a graphical user interface (GUI).
     It provides a structured way to organize UI elements, ensuring that they are placed efficiently and consistently on the screen.
     The Layout class is essential for developers who need to arrange multiple components (such as buttons, labels, text fields, etc.) in a clean and organized manner.
+
+    Any change of the layout only marks it as dirty, the positions of the items are recomputed later by the UiSystem.
+    Only the invalidated layouts are recomputed and the number of them per frame is limited with UiSystem::setLayoutBudget().
 */
 
 Layout::Layout() :
@@ -25,6 +30,10 @@ Layout::Layout() :
 }
 
 Layout::~Layout() {
+    if(m_dirty && m_parentLayout == nullptr) {
+        UiSystem::cancelLayout(this);
+    }
+
     for(auto it : m_items) {
         if(it->m_attachedTransform) {
             it->m_attachedTransform->m_attachedLayout = nullptr;
@@ -49,6 +58,10 @@ void Layout::addTransform(RectTransform *transform) {
 */
 void Layout::insertLayout(int index, Layout *layout) {
     if(layout) {
+        if(layout->m_dirty && layout->m_parentLayout == nullptr) {
+            // Will be updated together with this layout
+            UiSystem::cancelLayout(layout);
+        }
         layout->m_parentLayout = this;
         if(index > 0) {
             m_items.insert(std::next(m_items.begin(), index), layout);
@@ -103,30 +116,30 @@ void Layout::removeTransform(RectTransform *transform) {
     }
 }
 /*!
-    Returns the index of the specified child \a layout.
+    Returns the index of the specified child \a layout or -1 if the layout is not found.
 */
 int Layout::indexOf(const Layout *layout) const {
-    int result = -1;
+    int result = 0;
     for(auto it : m_items) {
-        ++result;
         if(it == layout) {
-            break;
+            return result;
         }
+        ++result;
     }
-    return result;
+    return -1;
 }
 /*!
-    Returns the index of the specified \a transform.
+    Returns the index of the specified \a transform or -1 if the transform is not found.
 */
 int Layout::indexOf(const RectTransform *transform) const {
-    int result = -1;
+    int result = 0;
     for(auto it : m_items) {
-        ++result;
         if(it->m_attachedTransform == transform) {
-            break;
+            return result;
         }
+        ++result;
     }
-    return result;
+    return -1;
 }
 /*!
     Returns the parent rect transform of this layout, or nullptr if this layout is not installed on any rect transform.
@@ -164,8 +177,10 @@ float Layout::spacing() const {
     Sets the \a spacing between items in the layout.
 */
 void Layout::setSpacing(float spacing) {
-    m_spacing = spacing;
-    invalidate();
+    if(m_spacing != spacing) {
+        m_spacing = spacing;
+        invalidate();
+    }
 }
 /*!
     Returns the layout direction (Vertical or Horizontal).
@@ -177,8 +192,10 @@ int Layout::direction() const {
     Sets the layout \a direction.
 */
 void Layout::setDirection(int direction) {
-    m_direction = direction;
-    invalidate();
+    if(m_direction != direction) {
+        m_direction = direction;
+        invalidate();
+    }
 }
 /*!
     Returns the size hint for the layout.
@@ -221,13 +238,23 @@ Vector2 Layout::sizeHint() {
 }
 /*!
     Marks the layout as dirty, indicating that it needs to be recomputed.
+    The parent layouts are invalidated as well, the topmost one is scheduled for the update.
 */
 void Layout::invalidate() {
-    m_dirty = true;
+    if(!m_dirty) {
+        m_dirty = true;
+
+        if(m_parentLayout) {
+            m_parentLayout->invalidate();
+        } else {
+            UiSystem::invalidateLayout(this);
+        }
+    }
 }
 /*!
     \internal
      Updates the layout. If the layout is marked as dirty, it recomputes the positions of child widgets and layouts.
+     The clean child layouts are skipped.
 */
 void Layout::update() {
     if(m_dirty) {
@@ -265,7 +292,11 @@ void Layout::update() {
                     }
                 }
             } else {
-                it->m_position = (m_direction == Vertical) ? Vector2(0.0f,-offset) : Vector2(offset, 0.0f);
+                Vector2 position((m_direction == Vertical) ? Vector2(0.0f,-offset) : Vector2(offset, 0.0f));
+                if(it->m_position != position) {
+                    it->m_position = position;
+                    it->m_dirty = true;
+                }
                 it->update();
 
                 Vector2 size(it->sizeHint());
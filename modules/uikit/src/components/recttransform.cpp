@@ -172,6 +172,10 @@ Vector4 RectTransform::padding() const {
 void RectTransform::setPadding(const Vector4 padding) {
     if(m_padding != padding) {
         m_padding = padding;
+
+        if(m_layout) {
+            m_layout->invalidate();
+        }
     }
 }
 /*!
@@ -358,7 +362,8 @@ void RectTransform::recalcChilds() const {
 
     for(auto it : m_children) {
         RectTransform *rect = dynamic_cast<RectTransform *>(it);
-        if(rect) {
+        // The size of children with fixed anchors doesn't depend on this transform
+        if(rect && rect->isStretched()) {
             rect->recalcChilds();
         }
     }
@@ -377,10 +382,17 @@ void RectTransform::recalcChilds() const {
 
     if(m_layout) {
         m_layout->invalidate();
-        m_layout->update();
     }
 }
 
+/*!
+    \internal
+    Returns true if the size of the RectTransform depends on the size of the parent.
+*/
+bool RectTransform::isStretched() const {
+    return abs(m_minAnchors.x - m_maxAnchors.x) > EPSILON || abs(m_minAnchors.y - m_maxAnchors.y) > EPSILON;
+}
+
 void RectTransform::recalcParent() {
     if(m_layout) {
         Vector2 hint(m_layout->sizeHint());
@@ -411,7 +423,6 @@ void RectTransform::recalcParent() {
 
             if(m_layout) {
                 m_layout->invalidate();
-                m_layout->update();
             }
 
             RectTransform *parentRect = dynamic_cast<RectTransform *>(m_parent);
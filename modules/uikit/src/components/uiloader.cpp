@@ -100,7 +100,11 @@ void UiLoader::fromBuffer(const std::string &buffer) {
             }
         }
 
-        applyStyle();
+        if(m_styleSheet) {
+            resolveStyleSheet(this);
+        }
+
+        invalidateStyle();
     }
 }
 /*!
@@ -145,7 +149,7 @@ void UiLoader::setStyleSheet(StyleSheet *style) {
             resolveStyleSheet(this);
         }
 
-        applyStyle();
+        invalidateStyle();
     }
 }
 /*!
@@ -154,7 +158,7 @@ void UiLoader::setStyleSheet(StyleSheet *style) {
 void UiLoader::resolveStyleSheet(Widget *widget) {
     for(auto it : widget->childWidgets()) {
         m_styleSheet->resolve(it);
-        resolveStyleSheet(widget);
+        resolveStyleSheet(it);
     }
 }
 /*!
@@ -30,11 +30,15 @@ Widget *Widget::m_focusWidget = nullptr;
 
     The Widget class serves as the base class for all user interface objects, providing basic functionality for handling updates, drawing, and interaction.
     Internal methods are marked as internal and are intended for use within the framework rather than by external code.
+
+    The style of the widget is not applied immediately: any change of style rules or classes marks the widget as dirty,
+    and the style is reapplied once before the next frame only for the dirty widgets.
 */
 
 Widget::Widget() :
         m_parent(nullptr),
-        m_transform(nullptr) {
+        m_transform(nullptr),
+        m_styleDirty(false) {
 
 }
 
@@ -69,6 +73,22 @@ const std::list<std::string> &Widget::classes() const {
 */
 void Widget::addClass(const std::string &name) {
     m_classes.push_back(name);
+
+    invalidateStyle();
+}
+/*!
+    Marks the style of this widget and all its child widgets to be reapplied before the next frame.
+*/
+void Widget::invalidateStyle() {
+    if(!m_styleDirty) {
+        m_styleDirty = true;
+        UiSystem::invalidateStyle(this);
+    }
+
+    // Descendant selectors depend on the parent widgets
+    for(auto it : childWidgets()) {
+        it->invalidateStyle();
+    }
 }
 /*!
     \internal
@@ -109,6 +129,7 @@ void Widget::boundChanged(const Vector2 &size) {
 }
 /*!
     Applies style settings assigned to widget.
+    Called by the UiSystem for the widgets with invalidated style, the child widgets are processed separately.
 */
 void Widget::applyStyle() {
     // Size
@@ -170,15 +191,17 @@ void Widget::applyStyle() {
     m_transform->setPadding(padding);
 
     // Display
-    Layout *layout = m_transform->layout();
-
     auto it = m_styleRules.find("display");
     if(it != m_styleRules.end()) {
         std::string layoutMode = it->second.second;
         if(layoutMode == "none") {
             actor()->setEnabled(false);
         } else {
-            layout = new Layout;
+            Layout *layout = m_transform->layout();
+            if(layout == nullptr) {
+                layout = new Layout;
+                m_transform->setLayout(layout);
+            }
 
             if(layoutMode == "block") {
                 layout->setDirection(Layout::Vertical);
@@ -186,16 +209,13 @@ void Widget::applyStyle() {
                 layout->setDirection(Layout::Horizontal);
             }
 
-            m_transform->setLayout(layout);
-        }
-    }
-
-    // Child widgets
-    for(auto it : childWidgets()) {
-        if(layout) {
-            layout->addTransform(it->rectTransform());
+            for(auto child : childWidgets()) {
+                RectTransform *rect = child->rectTransform();
+                if(layout->indexOf(rect) == -1) {
+                    layout->addTransform(rect);
+                }
+            }
         }
-        it->applyStyle();
     }
 }
 /*!
@@ -308,14 +328,21 @@ void Widget::setSystem(ObjectSystem *system) {
     \internal
     Applies a new stylesheet \a rules to the widget.
     A \a wieght parameter required to select rules between new one and existant.
+    The style of the widget is invalidated only if any of rule values is changed.
 */
 void Widget::addStyleRules(const std::map<std::string, std::string> &rules, uint32_t weight) {
+    bool changed = false;
     for(auto rule : rules) {
         auto it = m_styleRules.find(rule.first);
         if(it == m_styleRules.end() || it->second.first <= weight) {
+            changed |= (it == m_styleRules.end() || it->second.second != rule.second);
             m_styleRules[rule.first] = make_pair(weight, rule.second);
         }
     }
+
+    if(changed) {
+        invalidateStyle();
+    }
 }
 /*!
     \internal
@@ -51,7 +51,13 @@ void GuiLayer::exec(PipelineContext &context) {
         if(it->parentWidget() == nullptr && it->rectTransform()) {
             it->rectTransform()->setSize(buffer->viewport());
         }
+    }
+
+    // Only the invalidated widgets and layouts are processed
+    UiSystem::updateStyles();
+    UiSystem::updateLayouts();
 
+    for(auto it : m_uiComponents) {
         it->draw(*buffer);
     }
 
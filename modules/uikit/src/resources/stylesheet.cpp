@@ -14,6 +14,37 @@ namespace {
     const char *gData("Data");
 }
 
+static void styleKey(Widget *widget, std::string &key) {
+    key += widget->typeName();
+    key += '#';
+    key += widget->name();
+    for(auto &it : widget->classes()) {
+        key += '.';
+        key += it;
+    }
+
+    Widget *parent = widget->parentWidget();
+    if(parent) {
+        key += '>';
+        styleKey(parent, key);
+    }
+}
+
+static bool hasSelectorSigns(const std::string &data, const std::string &signs) {
+    // Only the selectors are checked, the rule blocks are skipped
+    int32_t depth = 0;
+    for(auto it : data) {
+        if(it == '{') {
+            depth++;
+        } else if(it == '}') {
+            depth = MAX(depth - 1, 0);
+        } else if(depth == 0 && signs.find(it) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*!
     \class StyleSheet
     \brief The StyleSheet class that appears to handle the parsing, storage, and application of CSS styles.
@@ -21,10 +52,15 @@ namespace {
 
     The StyleSheet class is responsible for handling CSS style rules, which can be applied to Widget objects.
     It includes functionality for storing, loading, saving, and resolving styles, along with utility methods to convert CSS color and length values.
+
+    The matched selectors are cached for each combination of the widget type, name, classes and the same state of its parents,
+    so widgets in the same state reuse the result of the selector matching.
+    The sheets with attribute selectors or sibling combinators are never cached, the key doesn't describe the property values and the siblings.
 */
 
 StyleSheet::StyleSheet() :
-        m_parser(new CSSParser()) {
+        m_parser(new CSSParser()),
+        m_uncached(false) {
 
 }
 
@@ -44,6 +80,10 @@ void StyleSheet::setData(const std::string &data) {
 }
 
 bool StyleSheet::addRawData(const std::string &data) {
+    m_cache.clear();
+    // Attribute selectors depend on the property values and sibling combinators depend on the previous siblings
+    m_uncached |= hasSelectorSigns(data, "[+~");
+
     return reinterpret_cast<CSSParser *>(m_parser)->parseByString(data);
 }
 /*!
@@ -67,15 +107,38 @@ VariantMap StyleSheet::saveUserData() const {
 /*!
     Resolves the styles for a given \a widget based on the parsed CSS rules.
     It iterates through the CSS selectors and applies matching rules to the widget.
+    The matching selectors are taken from the cache when a widget in the same state has been already resolved.
 */
 void StyleSheet::resolve(Widget *widget) {
     CSSParser *parser = reinterpret_cast<CSSParser *>(m_parser);
 
+    SelectorList local;
+    SelectorList *selectors = &local;
+
+    if(!m_uncached) {
+        std::string key;
+        styleKey(widget, key);
+
+        auto it = m_cache.find(key);
+        if(it != m_cache.end()) {
+            for(auto &selector : it->second) {
+                widget->addStyleRules(selector.first->ruleDataMap(), selector.second);
+            }
+            return;
+        }
+        selectors = &m_cache[key];
+    }
+
     for(auto it : parser->selectors()) {
         if(it->isMeet(widget)) {
-            widget->addStyleRules(it->ruleDataMap(), it->weight());
+            // The weight of group selectors depends on the last match
+            selectors->push_back(std::make_pair(it, it->weight()));
         }
     }
+
+    for(auto &it : *selectors) {
+        widget->addStyleRules(it.first->ruleDataMap(), it.second);
+    }
 }
 /*!
     Resolves inline styles provided as a string (e.g., from the \a style attribute in XML).
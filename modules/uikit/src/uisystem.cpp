@@ -19,10 +19,16 @@
 #include "components/toolbutton.h"
 #include "components/foldout.h"
 #include "components/uiloader.h"
+#include "components/layout.h"
 
 #include "pipelinetasks/guilayer.h"
 
+#include <algorithm>
+
 std::list<Widget *> UiSystem::m_uiComponents;
+std::list<Widget *> UiSystem::m_dirtyStyles;
+std::list<Layout *> UiSystem::m_dirtyLayouts;
+int UiSystem::m_layoutBudget = 64;
 
 UiSystem::UiSystem() :
         System() {
@@ -121,12 +127,80 @@ void UiSystem::addWidget(Widget *widget) {
 
 void UiSystem::removeWidget(Widget *widget) {
     m_uiComponents.remove(widget);
+
+    if(widget->m_styleDirty) {
+        m_dirtyStyles.remove(widget);
+    }
 }
 
 std::list<Widget *> &UiSystem::widgets() {
     return m_uiComponents;
 }
 
+void UiSystem::invalidateStyle(Widget *widget) {
+    m_dirtyStyles.push_back(widget);
+}
+
+void UiSystem::updateStyles() {
+    PROFILE_FUNCTION();
+
+    while(!m_dirtyStyles.empty()) {
+        // A child can be invalidated before its parent, so the widgets are ordered by depth to style the parents first
+        std::vector<std::pair<int, Widget *>> dirty;
+        dirty.reserve(m_dirtyStyles.size());
+        for(auto it : m_dirtyStyles) {
+            int depth = 0;
+            for(Widget *parent = it->parentWidget(); parent != nullptr; parent = parent->parentWidget()) {
+                depth++;
+            }
+            dirty.push_back(std::make_pair(depth, it));
+        }
+        m_dirtyStyles.clear();
+
+        std::stable_sort(dirty.begin(), dirty.end(), [](const std::pair<int, Widget *> &left, const std::pair<int, Widget *> &right) {
+            return left.first < right.first;
+        });
+
+        for(auto &it : dirty) {
+            Widget *widget = it.second;
+            if(widget->m_styleDirty) {
+                widget->m_styleDirty = false;
+                widget->applyStyle();
+            }
+        }
+    }
+}
+
+void UiSystem::invalidateLayout(Layout *layout) {
+    m_dirtyLayouts.push_back(layout);
+}
+
+void UiSystem::cancelLayout(Layout *layout) {
+    m_dirtyLayouts.remove(layout);
+}
+
+void UiSystem::updateLayouts() {
+    PROFILE_FUNCTION();
+
+    // Not more than the budget per frame, the rest is left for the next frames
+    int count = 0;
+    while(!m_dirtyLayouts.empty() && (m_layoutBudget <= 0 || count < m_layoutBudget)) {
+        Layout *layout = m_dirtyLayouts.front();
+        m_dirtyLayouts.pop_front();
+
+        layout->update();
+        count++;
+    }
+}
+
+int UiSystem::layoutBudget() {
+    return m_layoutBudget;
+}
+
+void UiSystem::setLayoutBudget(int budget) {
+    m_layoutBudget = budget;
+}
+
 void UiSystem::composeComponent(Component *component) const {
     component->composeComponent();
 }
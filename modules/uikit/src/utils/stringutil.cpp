@@ -146,6 +146,6 @@ std::string StringUtil::join(std::vector<std::string> &v, char separator) {
 
 std::string StringUtil::deletechar(const std::string &source, char target) {
     std::string dest = source;
-    dest.erase(std::remove(dest.begin(), dest.end(), target));
+    dest.erase(std::remove(dest.begin(), dest.end(), target), dest.end());
     return dest;
 }
@@ -0,0 +1,215 @@
+#include "tst_common.h"
+
+#include "uisystem.h"
+
+#include "components/world.h"
+#include "components/scene.h"
+#include "components/actor.h"
+
+#include "components/widget.h"
+#include "components/recttransform.h"
+#include "components/layout.h"
+
+#include "resources/stylesheet.h"
+
+class UiSystemTest : public ::testing::Test {
+public:
+    class TestSystem : public UiSystem {
+    public:
+        using UiSystem::m_dirtyStyles;
+        using UiSystem::m_dirtyLayouts;
+
+    };
+
+    class TestLayout : public Layout {
+    public:
+        using Layout::m_dirty;
+
+    };
+
+    class TestWidget : public Widget {
+    public:
+        using Widget::m_styleRules;
+
+    };
+
+};
+
+TEST_F(UiSystemTest, Layout_invalidation) {
+    TestLayout *root = new TestLayout;
+    TestLayout *child = new TestLayout;
+    TestLayout *nested = new TestLayout;
+
+    root->addLayout(child);
+    child->addLayout(nested);
+
+    // Only the topmost layout is scheduled
+    ASSERT_EQ(TestSystem::m_dirtyLayouts.size(), 1);
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.front(), root);
+    EXPECT_TRUE(root->m_dirty);
+    EXPECT_TRUE(child->m_dirty);
+
+    // The layouts are recomputed only by the system before the frame
+    UiSystem::updateLayouts();
+    EXPECT_TRUE(TestSystem::m_dirtyLayouts.empty());
+    EXPECT_FALSE(root->m_dirty);
+    EXPECT_FALSE(child->m_dirty);
+    EXPECT_FALSE(nested->m_dirty);
+
+    // Invalidation of the nested layout marks all the parents
+    nested->setSpacing(2.0f);
+    EXPECT_TRUE(nested->m_dirty);
+    EXPECT_TRUE(child->m_dirty);
+    EXPECT_TRUE(root->m_dirty);
+    ASSERT_EQ(TestSystem::m_dirtyLayouts.size(), 1);
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.front(), root);
+
+    // Repeated changes don't queue the layout again
+    nested->setDirection(Layout::Horizontal);
+    child->setSpacing(1.0f);
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.size(), 1);
+
+    UiSystem::updateLayouts();
+    EXPECT_FALSE(nested->m_dirty);
+    EXPECT_FALSE(root->m_dirty);
+
+    // The scheduled layout is updated together with the new parent
+    TestLayout *other = new TestLayout;
+    other->invalidate();
+    ASSERT_EQ(TestSystem::m_dirtyLayouts.size(), 1);
+
+    root->addLayout(other);
+    ASSERT_EQ(TestSystem::m_dirtyLayouts.size(), 1);
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.front(), root);
+
+    UiSystem::updateLayouts();
+    EXPECT_FALSE(other->m_dirty);
+
+    // The destroyed layout is removed from the schedule
+    TestLayout *removed = new TestLayout;
+    removed->invalidate();
+    delete removed;
+    EXPECT_TRUE(TestSystem::m_dirtyLayouts.empty());
+
+    delete root;
+    delete child;
+    delete nested;
+    delete other;
+}
+
+TEST_F(UiSystemTest, Layout_budget) {
+    UiSystem::setLayoutBudget(2);
+
+    std::vector<TestLayout *> layouts;
+    for(int i = 0; i < 5; i++) {
+        layouts.push_back(new TestLayout);
+        layouts.back()->invalidate();
+    }
+    ASSERT_EQ(TestSystem::m_dirtyLayouts.size(), 5);
+
+    // Not more than the budget per frame in the order of invalidation, the rest is left for the next frames
+    UiSystem::updateLayouts();
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.size(), 3);
+    EXPECT_FALSE(layouts[0]->m_dirty);
+    EXPECT_FALSE(layouts[1]->m_dirty);
+    EXPECT_TRUE(layouts[2]->m_dirty);
+
+    // The layout invalidated in between frames waits in the queue
+    layouts[0]->invalidate();
+    UiSystem::updateLayouts();
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.size(), 2);
+    EXPECT_FALSE(layouts[3]->m_dirty);
+    EXPECT_TRUE(layouts[4]->m_dirty);
+    EXPECT_TRUE(layouts[0]->m_dirty);
+
+    // Without the budget all the layouts are updated at once
+    UiSystem::setLayoutBudget(0);
+    layouts[1]->invalidate();
+    UiSystem::updateLayouts();
+    EXPECT_TRUE(TestSystem::m_dirtyLayouts.empty());
+    for(auto it : layouts) {
+        EXPECT_FALSE(it->m_dirty);
+    }
+
+    UiSystem::setLayoutBudget(64);
+
+    for(auto it : layouts) {
+        delete it;
+    }
+}
+
+TEST_F(UiSystemTest, Layout_transforms) {
+    Engine engine(nullptr, "");
+    UiSystem system;
+
+    World *world = Engine::objectCreate<World>("World");
+    Scene *scene = world->createScene("Scene");
+
+    Actor *parent = Engine::composeActor("Widget", "Parent", scene);
+    RectTransform *rect = static_cast<RectTransform *>(parent->transform());
+    ASSERT_TRUE(rect != nullptr);
+
+    Layout *layout = new Layout;
+    rect->setLayout(layout);
+
+    std::vector<RectTransform *> items;
+    for(int i = 0; i < 3; i++) {
+        Actor *actor = Engine::composeActor("Widget", "Item", parent);
+        RectTransform *item = static_cast<RectTransform *>(actor->transform());
+        item->setSize(Vector2(10.0f, 20.0f));
+        layout->addTransform(item);
+        items.push_back(item);
+    }
+
+    UiSystem::updateLayouts();
+    EXPECT_TRUE(TestSystem::m_dirtyLayouts.empty());
+    EXPECT_NEAR(items[1]->position().y - items[2]->position().y, 20.0f, 1e-4f);
+
+    // The padding change only schedules the layout, the items keep their positions until the update
+    Vector3 position(items[0]->position());
+    rect->setPadding(Vector4(5.0f, 0.0f, 0.0f, 0.0f));
+    EXPECT_EQ(TestSystem::m_dirtyLayouts.size(), 1);
+    EXPECT_EQ(items[0]->position(), position);
+
+    UiSystem::updateLayouts();
+    EXPECT_TRUE(TestSystem::m_dirtyLayouts.empty());
+    EXPECT_NEAR(items[0]->position().y, position.y - 5.0f, 1e-4f);
+
+    delete world;
+}
+
+TEST_F(UiSystemTest, Style_siblings) {
+    Engine engine(nullptr, "");
+    UiSystem system;
+
+    World *world = Engine::objectCreate<World>("World");
+    Scene *scene = world->createScene("Scene");
+
+    // The same widgets in the same parents, but only the first one follows the marked sibling
+    std::vector<TestWidget *> widgets;
+    for(int i = 0; i < 2; i++) {
+        Actor *parent = Engine::composeActor("Widget", "Parent", scene);
+
+        Widget *sibling = static_cast<Widget *>(Engine::composeActor("Widget", "Sibling", parent)->component("Widget"));
+        if(i == 0) {
+            sibling->addClass("marked");
+        }
+
+        widgets.push_back(static_cast<TestWidget *>(Engine::composeActor("Widget", "Item", parent)->component("Widget")));
+    }
+
+    StyleSheet sheet;
+    sheet.setData(".marked + Widget { width: 7px; }");
+
+    for(auto it : widgets) {
+        sheet.resolve(it);
+    }
+
+    EXPECT_EQ(widgets[0]->m_styleRules.count("width"), 1);
+    EXPECT_EQ(widgets[1]->m_styleRules.count("width"), 0);
+
+    UiSystem::updateStyles();
+    EXPECT_TRUE(TestSystem::m_dirtyStyles.empty());
+
+    delete world;
+}
@@ -0,0 +1,22 @@
+#ifndef ANGELJIT_H
+#define ANGELJIT_H
+
+#include <angelscript.h>
+
+#include <cstddef>
+#include <unordered_map>
+
+class AngelJit : public asIJITCompiler {
+public:
+    static bool isSupported();
+
+    int CompileFunction(asIScriptFunction *function, asJITFunction *output) override;
+
+    void ReleaseJITFunction(asJITFunction function) override;
+
+protected:
+    std::unordered_map<void *, size_t> m_functions;
+
+};
+
+#endif // ANGELJIT_H
@@ -3,6 +3,8 @@
 
 #include <system.h>
 
+#include <unordered_map>
+
 class asIScriptEngine;
 class asIScriptModule;
 class asIScriptContext;
@@ -16,6 +18,10 @@ class MetaObject;
 class Engine;
 
 class AngelScript;
+class AngelBehaviour;
+class AngelJit;
+
+class ThreadPool;
 
 class AngelSystem : public System {
 public:
@@ -41,8 +47,18 @@ public:
     asIScriptContext *context() const;
 
 protected:
+    typedef std::unordered_map<asIScriptFunction *, asIScriptContext *> ContextPool;
+
     bool isBehaviour(asITypeInfo *info) const;
 
+    bool execute(asIScriptObject *object, asIScriptFunction *func, ContextPool &pool);
+
+    void executeParallel(ThreadPool *threadPool);
+
+    void executeBehaviours(uint32_t first, uint32_t step, ContextPool &pool);
+
+    void releaseContexts();
+
     void unload();
 
     void bindMetaType(asIScriptEngine *engine, const MetaType::Table &table);
@@ -56,6 +72,12 @@ protected:
 
     asIScriptContext *m_context;
 
+    AngelJit *m_jit;
+
+    std::vector<ContextPool> m_contextPools;
+
+    std::vector<AngelBehaviour *> m_parallelBehaviours;
+
     AngelScript *m_script;
 
     bool m_inited;
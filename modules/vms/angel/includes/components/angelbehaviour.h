@@ -25,6 +25,8 @@ public:
     asIScriptFunction *scriptStart() const;
     asIScriptFunction *scriptUpdate() const;
 
+    bool isParallel() const;
+
     void createObject();
 
 public:
@@ -99,6 +101,8 @@ protected:
     asIScriptFunction *m_start;
     asIScriptFunction *m_update;
 
+    bool m_parallel;
+
     MetaObject *m_metaObject;
 };
 
@@ -0,0 +1,760 @@
+#include "angeljit.h"
+
+#include <global.h>
+
+#include <as_scriptfunction.h>
+#include <as_callfunc.h>
+
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+    #define NATIVE_JIT
+    #include <sys/mman.h>
+#endif
+
+namespace {
+    // General purpose and SSE registers use the same numbering in the instruction encoding
+    enum Registers {
+        Eax = 0,
+        Ecx,
+        Edx,
+        Ebx,
+        Esp,
+        Ebp,
+        Esi,
+        Edi
+    };
+
+    const int8_t gProgramPointer = offsetof(asSVMRegisters, programPointer);
+    const int8_t gStackFramePointer = offsetof(asSVMRegisters, stackFramePointer);
+    const int8_t gStackPointer = offsetof(asSVMRegisters, stackPointer);
+    const int8_t gValueRegister = offsetof(asSVMRegisters, valueRegister);
+    const int8_t gObjectType = offsetof(asSVMRegisters, objectType);
+    const int8_t gProcessSuspend = offsetof(asSVMRegisters, doProcessSuspend);
+
+    // Integer argument registers of the System V calling convention: rdi, rsi, rdx, rcx, r8 and r9
+    const uint8_t gIntArguments[] = {Edi, Esi, Edx, Ecx, 8, 9};
+    // Floating point arguments are passed in xmm0 - xmm7
+    const uint8_t gFloatArguments = 8;
+
+    // mov rax, imm64 + jmp rel32
+    const uint8_t gExitSize = 15;
+};
+
+class Assembler {
+public:
+    void emit(std::initializer_list<uint8_t> bytes) {
+        m_code.insert(m_code.end(), bytes);
+    }
+
+    void dword(uint32_t value) {
+        size_t offset = m_code.size();
+        m_code.resize(offset + sizeof(value));
+        memcpy(&m_code[offset], &value, sizeof(value));
+    }
+
+    void qword(uint64_t value) {
+        size_t offset = m_code.size();
+        m_code.resize(offset + sizeof(value));
+        memcpy(&m_code[offset], &value, sizeof(value));
+    }
+    // Operation with the script variable [rbp - variable * 4], rbp holds the stack frame pointer
+    void variable(std::initializer_list<uint8_t> opcode, uint8_t reg, short var) {
+        emit(opcode);
+        emit({uint8_t(0x85 | (reg << 3))});
+        dword(uint32_t(-4 * int32_t(var)));
+    }
+    // Operation with the field of the asSVMRegisters [rbx + offset]
+    void registers(std::initializer_list<uint8_t> opcode, uint8_t reg, int8_t offset) {
+        emit(opcode);
+        emit({uint8_t(0x43 | (reg << 3)), uint8_t(offset)});
+    }
+    // Emits the jump with unresolved target and returns the position of the displacement
+    size_t jump(std::initializer_list<uint8_t> opcode) {
+        emit(opcode);
+        dword(0);
+        return m_code.size() - sizeof(uint32_t);
+    }
+
+    void patch(size_t position, size_t target) {
+        int32_t displacement = int32_t(target) - int32_t(position + sizeof(int32_t));
+        memcpy(&m_code[position], &displacement, sizeof(displacement));
+    }
+    // Returns control to the interpreter at the instruction \a bc
+    void exit(asDWORD *bc, size_t target) {
+        emit({0x48, 0xB8});
+        qword(reinterpret_cast<uint64_t>(bc));
+        patch(jump({0xE9}), target);
+    }
+
+    // Loads the register \a reg from [rax + offset], the general purpose registers above rdi need the REX prefix
+    void argument(std::initializer_list<uint8_t> opcode, uint8_t rex, uint8_t reg, int32_t offset) {
+        if(rex || reg > Edi) {
+            emit({uint8_t(0x40 | rex | (reg > Edi ? 0x04 : 0x00))});
+        }
+        emit(opcode);
+        emit({uint8_t(0x80 | ((reg & 7) << 3))});
+        dword(uint32_t(offset));
+    }
+
+    size_t size() const {
+        return m_code.size();
+    }
+
+    const uint8_t *data() const {
+        return m_code.data();
+    }
+
+private:
+    std::vector<uint8_t> m_code;
+
+};
+
+struct Fixup {
+    size_t position;
+
+    asUINT target;
+};
+
+struct Argument {
+    enum Type {
+        Int32,
+        Int64,
+        Float,
+        Double
+    };
+
+    int32_t offset;
+
+    Type type;
+};
+
+// Pushes ecx or rcx to the script stack
+static void push(Assembler &a, bool wide) {
+    a.registers({0x48, 0x8B}, Eax, gStackPointer);
+    a.emit({0x48, 0x83, 0xE8, uint8_t(wide ? 8 : 4)}); // sub rax, size
+    if(wide) {
+        a.emit({0x48, 0x89, 0x08}); // mov [rax], rcx
+    } else {
+        a.emit({0x89, 0x08}); // mov [rax], ecx
+    }
+    a.registers({0x48, 0x89}, Eax, gStackPointer);
+}
+// Collects the arguments of the registered function which can be called directly, the offsets are in bytes from the stack pointer
+static bool nativeArguments(asCScriptFunction *function, std::vector<Argument> &ints, std::vector<Argument> &floats) {
+    asSSystemFunctionInterface *system = function->sysFuncIntf;
+    if(function->funcType != asFUNC_SYSTEM || system == nullptr) {
+        return false;
+    }
+
+    // Only the plain functions and methods, the calls which need any glue are left to the interpreter
+    switch(system->callConv) {
+        case ICC_CDECL:
+        case ICC_THISCALL:
+        case ICC_CDECL_OBJLAST:
+        case ICC_CDECL_OBJFIRST: break;
+        default: return false;
+    }
+    if(system->auxiliary || system->baseOffset || system->compositeOffset || system->isCompositeIndirect ||
+       system->hostReturnInMemory || system->takesObjByVal || system->returnAutoHandle || system->cleanArgs.GetLength() ||
+       system->hostReturnSize > 2 || function->DoesReturnOnStack()) {
+        return false;
+    }
+    for(asUINT i = 0; i < system->paramAutoHandles.GetLength(); i++) {
+        if(system->paramAutoHandles[i]) {
+            return false;
+        }
+    }
+
+    // The objects and the handles are returned through the object register
+    const asCDataType &result = function->returnType;
+    if((result.IsObject() || result.IsFuncdef()) && !result.IsReference()) {
+        return false;
+    }
+
+    bool method = (system->callConv != ICC_CDECL);
+    int32_t offset = 0;
+    if(method) {
+        if(system->callConv != ICC_CDECL_OBJLAST) {
+            ints.push_back({0, Argument::Int64});
+        }
+        offset += AS_PTR_SIZE * sizeof(asDWORD);
+    }
+
+    for(asUINT i = 0; i < function->parameterTypes.GetLength(); i++) {
+        const asCDataType &type = function->parameterTypes[i];
+        if(type.IsAnyType()) {
+            return false;
+        }
+
+        if(type.IsReference()) {
+            ints.push_back({offset, Argument::Int64});
+        } else if(type.IsFloatType()) {
+            floats.push_back({offset, Argument::Float});
+        } else if(type.IsDoubleType()) {
+            floats.push_back({offset, Argument::Double});
+        } else if(type.IsPrimitive() && !type.IsObjectHandle()) {
+            ints.push_back({offset, (type.GetSizeOnStackDWords() == 1) ? Argument::Int32 : Argument::Int64});
+        } else {
+            return false;
+        }
+        offset += type.GetSizeOnStackDWords() * sizeof(asDWORD);
+    }
+
+    if(system->callConv == ICC_CDECL_OBJLAST) {
+        ints.push_back({0, Argument::Int64});
+    }
+
+    // Nothing is passed on the native stack
+    return ints.size() <= sizeof(gIntArguments) && floats.size() <= gFloatArguments;
+}
+// Calls the registered function directly, the same way as the interpreter does it in the asBC_CALLSYS
+static bool nativeCall(Assembler &a, asIScriptEngine *engine, asDWORD *bc, size_t exit) {
+    asCScriptFunction *function = static_cast<asCScriptFunction *>(engine->GetFunctionById(asBC_INTARG(bc)));
+    if(function == nullptr) {
+        return false;
+    }
+
+    std::vector<Argument> ints;
+    std::vector<Argument> floats;
+    if(!nativeArguments(function, ints, floats)) {
+        return false;
+    }
+
+    asSSystemFunctionInterface *system = function->sysFuncIntf;
+    bool method = (system->callConv != ICC_CDECL);
+    if(method) {
+        a.registers({0x48, 0x8B}, Eax, gStackPointer);
+        a.emit({0x48, 0x83, 0x38, 0x00, 0x75, gExitSize}); // cmp qword [rax], 0; jne call
+        // Let the interpreter raise the null pointer exception
+        a.exit(bc, exit);
+    }
+
+    // The registered function may raise the script exception which needs the current position
+    a.emit({0x48, 0xB8});
+    a.qword(reinterpret_cast<uint64_t>(bc));
+    a.registers({0x48, 0x89}, Eax, gProgramPointer);
+
+    a.registers({0x48, 0x8B}, Eax, gStackPointer);
+    for(size_t i = 0; i < ints.size(); i++) {
+        bool wide = (ints[i].type == Argument::Int64);
+        a.argument({0x8B}, wide ? 0x08 : 0x00, gIntArguments[i], ints[i].offset); // mov reg, [rax + offset]
+    }
+    for(size_t i = 0; i < floats.size(); i++) {
+        bool wide = (floats[i].type == Argument::Double);
+        a.emit({uint8_t(wide ? 0xF2 : 0xF3)});
+        a.argument({0x0F, 0x10}, 0x00, uint8_t(i), floats[i].offset); // movss/movsd xmm, [rax + offset]
+    }
+
+    a.emit({0x48, 0xB8});
+    a.qword(reinterpret_cast<uint64_t>(system->func));
+    a.emit({0xFF, 0xD0}); // call rax
+
+    if(system->hostReturnSize > 0) {
+        bool wide = (system->hostReturnSize == 2);
+        if(system->hostReturnFloat) {
+            a.registers({uint8_t(wide ? 0xF2 : 0xF3), 0x0F, 0x11}, 0, gValueRegister);
+        } else if(wide) {
+            a.registers({0x48, 0x89}, Eax, gValueRegister);
+        } else {
+            a.registers({0x89}, Eax, gValueRegister);
+        }
+    }
+
+    a.emit({0x48, 0xB8});
+    a.qword(reinterpret_cast<uint64_t>(function->returnType.GetTypeInfo()));
+    a.registers({0x48, 0x89}, Eax, gObjectType);
+
+    // Pops the arguments and the object pointer
+    a.registers({0x48, 0x81}, 0, gStackPointer);
+    a.dword((system->paramSize + (method ? AS_PTR_SIZE : 0)) * sizeof(asDWORD));
+
+    // The exception or the suspension requested by the function are handled by the interpreter
+    a.registers({0x80}, 7, gProcessSuspend);
+    a.emit({0x00, 0x74, gExitSize}); // cmp byte [rbx + doProcessSuspend], 0; je next
+    a.exit(bc + 2, exit);
+
+    return true;
+}
+
+// Writes -1, 0 or 1 to the value register from the flags of the integer comparison
+static void compareResult(Assembler &a, bool isSigned) {
+    a.emit({0x0F, uint8_t(isSigned ? 0x9F : 0x97), 0xC1}); // setg/seta cl
+    a.emit({0x0F, uint8_t(isSigned ? 0x9C : 0x92), 0xC2}); // setl/setb dl
+    a.emit({0x0F, 0xB6, 0xC9, 0x0F, 0xB6, 0xD2}); // movzx ecx, cl; movzx edx, dl
+    a.emit({0x29, 0xD1}); // sub ecx, edx
+    a.registers({0x89}, Ecx, gValueRegister);
+}
+// Writes -1, 0 or 1 to the value register from the flags of ucomiss/ucomisd, the unordered values are not equal and not less
+static void floatCompareResult(Assembler &a) {
+    a.emit({0xB9, 0x01, 0x00, 0x00, 0x00, 0x7A, 19}); // mov ecx, 1; jp store
+    a.emit({0xB9, 0x00, 0x00, 0x00, 0x00, 0x74, 12}); // mov ecx, 0; je store
+    a.emit({0xB9, 0xFF, 0xFF, 0xFF, 0xFF, 0x72, 5});  // mov ecx, -1; jb store
+    a.emit({0xB9, 0x01, 0x00, 0x00, 0x00});           // mov ecx, 1
+    a.registers({0x89}, Ecx, gValueRegister);
+}
+// Loads the float \a value to xmm1
+static void floatConstant(Assembler &a, asDWORD value) {
+    a.emit({0xB8});
+    a.dword(value);
+    a.emit({0x66, 0x0F, 0x6E, 0xC8}); // movd xmm1, eax
+}
+
+static bool translate(Assembler &a, asIScriptEngine *engine, asDWORD *bc, asUINT index, asUINT size, size_t exit, std::vector<Fixup> &fixups) {
+    asEBCInstr op = asEBCInstr(*reinterpret_cast<asBYTE *>(bc));
+
+    // The second and the third operands are located in the next dword which the short instructions don't have
+    short a0 = asBC_SWORDARG0(bc);
+    short a1 = (size > 1) ? asBC_SWORDARG1(bc) : 0;
+    short a2 = (size > 1) ? asBC_SWORDARG2(bc) : 0;
+
+    switch(op) {
+        case asBC_JitEntry: break;
+        case asBC_SUSPEND: {
+            // The context wants to process the suspension or the line callback
+            a.registers({0x80}, 7, gProcessSuspend);
+            a.emit({0x00, 0x74, gExitSize}); // cmp byte [rbx + doProcessSuspend], 0; je next
+            a.exit(bc, exit);
+        } break;
+        // Branches
+        case asBC_JMP:
+        case asBC_JZ:
+        case asBC_JNZ:
+        case asBC_JS:
+        case asBC_JNS:
+        case asBC_JP:
+        case asBC_JNP:
+        case asBC_JLowZ:
+        case asBC_JLowNZ: {
+            asUINT target = index + size + asBC_INTARG(bc);
+
+            uint8_t condition = 0;
+            switch(op) {
+                case asBC_JZ: case asBC_JLowZ: condition = 0x84; break;
+                case asBC_JNZ: case asBC_JLowNZ: condition = 0x85; break;
+                case asBC_JS: condition = 0x88; break;
+                case asBC_JNS: condition = 0x89; break;
+                case asBC_JP: condition = 0x8F; break;
+                case asBC_JNP: condition = 0x8E; break;
+                default: break;
+            }
+
+            if(op == asBC_JMP) {
+                fixups.push_back({a.jump({0xE9}), target});
+            } else {
+                if(op == asBC_JLowZ || op == asBC_JLowNZ) {
+                    a.registers({0x80}, 7, gValueRegister);
+                    a.emit({0x00}); // cmp byte [rbx + valueRegister], 0
+                } else {
+                    a.registers({0x8B}, Eax, gValueRegister);
+                    a.emit({0x85, 0xC0}); // test eax, eax
+                }
+                fixups.push_back({a.jump({0x0F, condition}), target});
+            }
+        } break;
+        // Tests of the value register
+        case asBC_TZ:
+        case asBC_TNZ:
+        case asBC_TS:
+        case asBC_TNS:
+        case asBC_TP:
+        case asBC_TNP: {
+            uint8_t condition = 0;
+            switch(op) {
+                case asBC_TZ: condition = 0x94; break;
+                case asBC_TNZ: condition = 0x95; break;
+                case asBC_TS: condition = 0x98; break;
+                case asBC_TNS: condition = 0x99; break;
+                case asBC_TP: condition = 0x9F; break;
+                default: condition = 0x9E; break;
+            }
+            a.registers({0x8B}, Eax, gValueRegister);
+            a.emit({0x85, 0xC0, 0x0F, condition, 0xC0, 0x0F, 0xB6, 0xC0}); // test eax, eax; setcc al; movzx eax, al
+            // The result is stored in the lower byte and the rest of the register is cleared
+            a.registers({0x48, 0x89}, Eax, gValueRegister);
+        } break;
+        case asBC_ClrHi: {
+            a.registers({0x0F, 0xB6}, Eax, gValueRegister);
+            a.registers({0x89}, Eax, gValueRegister);
+        } break;
+        case asBC_NOT: {
+            a.variable({0x80}, 7, a0);
+            a.emit({0x00, 0x0F, 0x94, 0xC0, 0x0F, 0xB6, 0xC0}); // cmp byte [var], 0; sete al; movzx eax, al
+            a.variable({0x89}, Eax, a0);
+        } break;
+        // Comparisons
+        case asBC_CMPi:
+        case asBC_CMPu: {
+            a.variable({0x8B}, Eax, a0);
+            a.variable({0x3B}, Eax, a1);
+            compareResult(a, op == asBC_CMPi);
+        } break;
+        case asBC_CMPIi:
+        case asBC_CMPIu: {
+            a.variable({0x8B}, Eax, a0);
+            a.emit({0x3D});
+            a.dword(asBC_DWORDARG(bc));
+            compareResult(a, op == asBC_CMPIi);
+        } break;
+        case asBC_CMPf: {
+            a.variable({0xF3, 0x0F, 0x10}, 0, a0);
+            a.variable({0x0F, 0x2E}, 0, a1);
+            floatCompareResult(a);
+        } break;
+        case asBC_CMPIf: {
+            a.variable({0xF3, 0x0F, 0x10}, 0, a0);
+            floatConstant(a, asBC_DWORDARG(bc));
+            a.emit({0x0F, 0x2E, 0xC1}); // ucomiss xmm0, xmm1
+            floatCompareResult(a);
+        } break;
+        case asBC_CMPd: {
+            a.variable({0xF2, 0x0F, 0x10}, 0, a0);
+            a.variable({0x66, 0x0F, 0x2E}, 0, a1);
+            floatCompareResult(a);
+        } break;
+        // Copies
+        case asBC_SetV1:
+        case asBC_SetV2:
+        case asBC_SetV4: {
+            a.variable({0xC7}, 0, a0);
+            a.dword(asBC_DWORDARG(bc));
+        } break;
+        case asBC_SetV8: {
+            a.emit({0x48, 0xB8});
+            a.qword(asBC_QWORDARG(bc));
+            a.variable({0x48, 0x89}, Eax, a0);
+        } break;
+        case asBC_CpyVtoV4: {
+            a.variable({0x8B}, Eax, a1);
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_CpyVtoV8: {
+            a.variable({0x48, 0x8B}, Eax, a1);
+            a.variable({0x48, 0x89}, Eax, a0);
+        } break;
+        case asBC_CpyVtoR4: {
+            a.variable({0x8B}, Eax, a0);
+            a.registers({0x89}, Eax, gValueRegister);
+        } break;
+        case asBC_CpyVtoR8: {
+            a.variable({0x48, 0x8B}, Eax, a0);
+            a.registers({0x48, 0x89}, Eax, gValueRegister);
+        } break;
+        case asBC_CpyRtoV4: {
+            a.registers({0x8B}, Eax, gValueRegister);
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_CpyRtoV8: {
+            a.registers({0x48, 0x8B}, Eax, gValueRegister);
+            a.variable({0x48, 0x89}, Eax, a0);
+        } break;
+        // Access to the members of the script object
+        case asBC_LoadThisR: {
+            a.variable({0x48, 0x8B}, Eax, 0);
+            a.emit({0x48, 0x85, 0xC0, 0x75, gExitSize}); // test rax, rax; jnz next
+            // Let the interpreter raise the null pointer exception
+            a.exit(bc, exit);
+            a.emit({0x48, 0x05});
+            a.dword(uint32_t(int32_t(a0)));
+            a.registers({0x48, 0x89}, Eax, gValueRegister);
+        } break;
+        case asBC_RDR4:
+        case asBC_RDR8: {
+            bool wide = (op == asBC_RDR8);
+            a.registers({0x48, 0x8B}, Eax, gValueRegister);
+            if(wide) {
+                a.emit({0x48, 0x8B, 0x00}); // mov rax, [rax]
+                a.variable({0x48, 0x89}, Eax, a0);
+            } else {
+                a.emit({0x8B, 0x00}); // mov eax, [rax]
+                a.variable({0x89}, Eax, a0);
+            }
+        } break;
+        case asBC_WRTV4:
+        case asBC_WRTV8: {
+            bool wide = (op == asBC_WRTV8);
+            a.registers({0x48, 0x8B}, Eax, gValueRegister);
+            if(wide) {
+                a.variable({0x48, 0x8B}, Ecx, a0);
+                a.emit({0x48, 0x89, 0x08}); // mov [rax], rcx
+            } else {
+                a.variable({0x8B}, Ecx, a0);
+                a.emit({0x89, 0x08}); // mov [rax], ecx
+            }
+        } break;
+        // Integer arithmetic
+        case asBC_ADDi:
+        case asBC_SUBi:
+        case asBC_MULi:
+        case asBC_BAND:
+        case asBC_BOR:
+        case asBC_BXOR: {
+            a.variable({0x8B}, Eax, a1);
+            switch(op) {
+                case asBC_ADDi: a.variable({0x03}, Eax, a2); break;
+                case asBC_SUBi: a.variable({0x2B}, Eax, a2); break;
+                case asBC_MULi: a.variable({0x0F, 0xAF}, Eax, a2); break;
+                case asBC_BAND: a.variable({0x23}, Eax, a2); break;
+                case asBC_BOR: a.variable({0x0B}, Eax, a2); break;
+                default: a.variable({0x33}, Eax, a2); break;
+            }
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_BSLL:
+        case asBC_BSRL:
+        case asBC_BSRA: {
+            a.variable({0x8B}, Eax, a1);
+            a.variable({0x8B}, Ecx, a2);
+            a.emit({0xD3, uint8_t(op == asBC_BSLL ? 0xE0 : (op == asBC_BSRL ? 0xE8 : 0xF8))}); // shl/shr/sar eax, cl
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_ADDIi:
+        case asBC_SUBIi:
+        case asBC_MULIi: {
+            a.variable({0x8B}, Eax, a1);
+            switch(op) {
+                case asBC_ADDIi: a.emit({0x05}); break;
+                case asBC_SUBIi: a.emit({0x2D}); break;
+                default: a.emit({0x69, 0xC0}); break;
+            }
+            a.dword(asBC_INTARG(bc + 1));
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_IncVi: a.variable({0xFF}, 0, a0); break;
+        case asBC_DecVi: a.variable({0xFF}, 1, a0); break;
+        case asBC_NEGi: a.variable({0xF7}, 3, a0); break;
+        case asBC_BNOT: a.variable({0xF7}, 2, a0); break;
+        // Floating point arithmetic
+        case asBC_ADDf:
+        case asBC_SUBf:
+        case asBC_MULf:
+        case asBC_ADDd:
+        case asBC_SUBd:
+        case asBC_MULd: {
+            bool wide = (op == asBC_ADDd || op == asBC_SUBd || op == asBC_MULd);
+            uint8_t prefix = wide ? 0xF2 : 0xF3;
+            uint8_t code = 0x58;
+            if(op == asBC_SUBf || op == asBC_SUBd) {
+                code = 0x5C;
+            } else if(op == asBC_MULf || op == asBC_MULd) {
+                code = 0x59;
+            }
+            a.variable({prefix, 0x0F, 0x10}, 0, a1);
+            a.variable({prefix, 0x0F, code}, 0, a2);
+            a.variable({prefix, 0x0F, 0x11}, 0, a0);
+        } break;
+        case asBC_ADDIf:
+        case asBC_SUBIf:
+        case asBC_MULIf: {
+            uint8_t code = (op == asBC_ADDIf) ? 0x58 : ((op == asBC_SUBIf) ? 0x5C : 0x59);
+            a.variable({0xF3, 0x0F, 0x10}, 0, a1);
+            floatConstant(a, asBC_DWORDARG(bc + 1));
+            a.emit({0xF3, 0x0F, code, 0xC1});
+            a.variable({0xF3, 0x0F, 0x11}, 0, a0);
+        } break;
+        case asBC_NEGf: {
+            a.variable({0x81}, 6, a0);
+            a.dword(0x80000000); // xor the sign bit
+        } break;
+        // Conversions
+        case asBC_iTOf: {
+            a.variable({0xF3, 0x0F, 0x2A}, 0, a0);
+            a.variable({0xF3, 0x0F, 0x11}, 0, a0);
+        } break;
+        case asBC_fTOi: {
+            a.variable({0xF3, 0x0F, 0x2C}, Eax, a0);
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_iTOd: {
+            a.variable({0xF2, 0x0F, 0x2A}, 0, a1);
+            a.variable({0xF2, 0x0F, 0x11}, 0, a0);
+        } break;
+        case asBC_dTOi: {
+            a.variable({0xF2, 0x0F, 0x2C}, Eax, a1);
+            a.variable({0x89}, Eax, a0);
+        } break;
+        case asBC_fTOd: {
+            a.variable({0xF3, 0x0F, 0x5A}, 0, a1);
+            a.variable({0xF2, 0x0F, 0x11}, 0, a0);
+        } break;
+        case asBC_dTOf: {
+            a.variable({0xF2, 0x0F, 0x5A}, 0, a1);
+            a.variable({0xF3, 0x0F, 0x11}, 0, a0);
+        } break;
+        // Stack operations
+        case asBC_PshC4: {
+            a.emit({0xB9});
+            a.dword(asBC_DWORDARG(bc)); // mov ecx, imm32
+            push(a, false);
+        } break;
+        case asBC_PshC8: {
+            a.emit({0x48, 0xB9});
+            a.qword(asBC_QWORDARG(bc)); // mov rcx, imm64
+            push(a, true);
+        } break;
+        case asBC_PshV4: {
+            a.variable({0x8B}, Ecx, a0);
+            push(a, false);
+        } break;
+        case asBC_PshV8:
+        case asBC_PshVPtr: {
+            a.variable({0x48, 0x8B}, Ecx, a0);
+            push(a, true);
+        } break;
+        case asBC_PSF: {
+            a.variable({0x48, 0x8D}, Ecx, a0); // lea rcx, [var]
+            push(a, true);
+        } break;
+        case asBC_PshNull: {
+            a.emit({0x31, 0xC9}); // xor ecx, ecx
+            push(a, true);
+        } break;
+        case asBC_PshRPtr: {
+            a.registers({0x48, 0x8B}, Ecx, gValueRegister);
+            push(a, true);
+        } break;
+        case asBC_PopPtr: {
+            a.registers({0x48, 0x83}, 0, gStackPointer);
+            a.emit({uint8_t(AS_PTR_SIZE * sizeof(asDWORD))}); // add qword [rbx + stackPointer], 8
+        } break;
+        // Calls of the registered functions
+        case asBC_CALLSYS: return nativeCall(a, engine, bc, exit);
+        // Calls of the script functions, object management, division and the rest are left to the interpreter
+        default: return false;
+    }
+
+    return true;
+}
+
+/*!
+    \class AngelJit
+    \brief Translates the AngelScript bytecode to the native x86-64 code.
+    \inmodule Angel
+
+    The arithmetic, the conversions, the comparisons, the branches, the accesses to the script object members, the stack pushes
+    and the calls of the registered functions are translated. Any other instruction returns the control to the interpreter which
+    continues from the same place.
+
+    The registered functions are called directly when they use asCALL_CDECL, asCALL_THISCALL, asCALL_CDECL_OBJLAST or
+    asCALL_CDECL_OBJFIRST and take only the primitives and the references, which covers most of the Vector3 and Quaternion math.
+    The functions which return the objects by value or the handles, take the objects by value or need the argument clean up are
+    still called by the interpreter. The registered functions called directly must not throw the C++ exceptions.
+
+    The JIT can be turned off with the ".scriptJit" setting of the project.
+*/
+/*!
+    Returns true if the JIT is available on the current platform.
+*/
+bool AngelJit::isSupported() {
+#ifdef NATIVE_JIT
+    return true;
+#else
+    return false;
+#endif
+}
+
+int AngelJit::CompileFunction(asIScriptFunction *function, asJITFunction *output) {
+#ifdef NATIVE_JIT
+    asUINT length = 0;
+    asDWORD *byteCode = function->GetByteCode(&length);
+    if(byteCode == nullptr) {
+        return asERROR;
+    }
+
+    asIScriptEngine *engine = function->GetEngine();
+
+    Assembler a;
+    // void function(asSVMRegisters *rdi, asPWORD rsi), the argument of the JitEntry is the native address to resume
+    a.emit({0x53, 0x55, 0x48, 0x89, 0xFB}); // push rbx; push rbp; mov rbx, rdi
+    a.emit({0x48, 0x83, 0xEC, 0x08}); // sub rsp, 8 to keep the native stack aligned for the calls
+    a.registers({0x48, 0x8B}, Ebp, gStackFramePointer);
+    a.emit({0xFF, 0xE6}); // jmp rsi
+
+    // The stack pointer is kept up to date in the registers, only the program pointer is left to store
+    size_t exit = a.size();
+    a.registers({0x48, 0x89}, Eax, gProgramPointer);
+    a.emit({0x48, 0x83, 0xC4, 0x08}); // add rsp, 8
+    a.emit({0x5D, 0x5B, 0xC3}); // pop rbp; pop rbx; ret
+
+    std::vector<size_t> labels(length, SIZE_MAX);
+    std::vector<bool> native(length, false);
+    std::vector<asUINT> entries;
+    std::vector<Fixup> fixups;
+
+    for(asUINT i = 0; i < length;) {
+        asDWORD *bc = byteCode + i;
+        asEBCInstr op = asEBCInstr(*reinterpret_cast<asBYTE *>(bc));
+        asUINT size = asBCTypeSize[asBCInfo[op].type];
+        if(size == 0) {
+            return asERROR;
+        }
+
+        labels[i] = a.size();
+        native[i] = translate(a, engine, bc, i, size, exit, fixups);
+        if(!native[i]) {
+            a.exit(bc, exit);
+        } else if(op == asBC_JitEntry) {
+            entries.push_back(i);
+        }
+
+        i += size;
+    }
+
+    for(auto &it : fixups) {
+        if(it.target >= length || labels[it.target] == SIZE_MAX) {
+            return asERROR;
+        }
+        a.patch(it.position, labels[it.target]);
+    }
+
+    // Resume only in front of the instructions which can be executed natively
+    std::vector<asUINT> resume;
+    for(auto it : entries) {
+        asUINT next = it + asBCTypeSize[asBCInfo[asBC_JitEntry].type];
+        if(next < length && native[next] && *reinterpret_cast<asBYTE *>(byteCode + next) != asBC_JitEntry) {
+            resume.push_back(it);
+        }
+    }
+    if(resume.empty()) {
+        return asNOT_SUPPORTED;
+    }
+
+    void *memory = mmap(nullptr, a.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED) {
+        return asOUT_OF_MEMORY;
+    }
+    memcpy(memory, a.data(), a.size());
+    if(mprotect(memory, a.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, a.size());
+        return asERROR;
+    }
+
+    uint8_t *base = static_cast<uint8_t *>(memory);
+    for(auto it : resume) {
+        asBC_PTRARG(byteCode + it) = reinterpret_cast<asPWORD>(base + labels[it]);
+    }
+
+    m_functions[memory] = a.size();
+    *output = reinterpret_cast<asJITFunction>(memory);
+
+    return asSUCCESS;
+#else
+    A_UNUSED(function);
+    A_UNUSED(output);
+    return asNOT_SUPPORTED;
+#endif
+}
+
+void AngelJit::ReleaseJITFunction(asJITFunction function) {
+#ifdef NATIVE_JIT
+    auto it = m_functions.find(reinterpret_cast<void *>(function));
+    if(it != m_functions.end()) {
+        munmap(it->first, it->second);
+        m_functions.erase(it);
+    }
+#else
+    A_UNUSED(function);
+#endif
+}
@@ -23,16 +23,29 @@
 #include <components/world.h>
 #include <components/angelbehaviour.h>
 
+#include <threadpool.h>
+
+#include <utils/parallelfor.h>
+
 #include <cstring>
+#include <set>
 #include <algorithm>
 
 #include "resources/angelscript.h"
 
+#include "angeljit.h"
+
 #include "bindings/angelbindings.h"
 
 #define TEMPALTE "AngelBinary"
 #define URI "thor://Components/"
 
+namespace {
+    const char *gScriptJit(".scriptJit");
+
+    const uint32_t gParallelThreshold = 4;
+};
+
 void replace(std::string &srcStr, const std::string &findStr,
                                const std::string &replaceStr) {
     std::size_t replaceStrLen = replaceStr.length();
@@ -73,6 +86,7 @@ AngelSystem::AngelSystem(Engine *engine) :
         m_scriptEngine(nullptr),
         m_scriptModule(nullptr),
         m_context(nullptr),
+        m_jit(nullptr),
         m_script(nullptr),
         m_inited(false) {
     PROFILE_FUNCTION();
@@ -89,6 +103,8 @@ AngelSystem::~AngelSystem() {
 
     deleteAllObjects();
 
+    releaseContexts();
+
     if(m_context) {
         m_context->Release();
     }
@@ -101,13 +117,24 @@ AngelSystem::~AngelSystem() {
         m_scriptEngine->ShutDownAndRelease();
     }
 
+    delete m_jit;
+
     AngelBehaviour::unregisterClassFactory(this);
 }
 
 bool AngelSystem::init() {
     PROFILE_FUNCTION();
     if(!m_inited) {
+        // The IParallelUpdate behaviours are executed on the engine pool
+        asPrepareMultithread();
+
         m_scriptEngine = asCreateScriptEngine();
+        m_scriptEngine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true);
+        // The JIT can be turned off in the project settings to fall back to the interpreter
+        if(AngelJit::isSupported() && Engine::value(gScriptJit, true).toBool()) {
+            m_jit = new AngelJit;
+            m_scriptEngine->SetJITCompiler(m_jit);
+        }
 
         int32_t r = m_scriptEngine->SetMessageCallback(asFUNCTION(messageCallback), nullptr, asCALL_CDECL);
         if(r >= 0) {
@@ -132,26 +159,40 @@ void AngelSystem::update(World *world) {
     PROFILE_FUNCTION();
 
     if(Engine::isGameMode()) {
+        if(m_contextPools.empty()) {
+            m_contextPools.resize(1);
+        }
+        ContextPool &pool = m_contextPools.front();
+
+        m_parallelBehaviours.clear();
         for(auto it : m_objectList) {
             AngelBehaviour *component = static_cast<AngelBehaviour *>(it);
-            asIScriptObject *object = component->scriptObject();
-            if(object) {
-                if(component->isEnabled()) {
-                    Actor *actor = component->actor();
-                    if(actor) {
-                        Scene *scene = actor->scene();
-                        if(scene && scene->parent() == world) {
-                            if(!component->isStarted()) {
-                                execute(object, component->scriptStart());
-                                component->setStarted(true);
-                            }
-                            execute(object, component->scriptUpdate());
+            asIScriptObject *object = component->m_object;
+            if(object && component->isEnabled()) {
+                Actor *actor = component->actor();
+                if(actor) {
+                    Scene *scene = actor->scene();
+                    if(scene && scene->parent() == world) {
+                        // Keeps the script object alive in case the script destroys its own component
+                        object->AddRef();
+                        if(!component->isStarted()) {
+                            PROFILE_BLOCK(component->m_script.c_str());
+                            execute(object, component->m_start, pool);
+                            component->setStarted(true);
                         }
+                        if(component->m_parallel) {
+                            m_parallelBehaviours.push_back(component);
+                        } else {
+                            PROFILE_BLOCK(component->m_script.c_str());
+                            execute(object, component->m_update, pool);
+                        }
+                        object->Release();
                     }
                 }
-                object->Release();
             }
         }
+
+        executeParallel(Engine::threadPool());
     }
 }
 
@@ -186,6 +227,11 @@ void AngelSystem::reload() {
             asITypeInfo *info = m_scriptModule->GetObjectTypeByIndex(i);
             if(info && isBehaviour(info)) {
                 {
+                    // The meta type outlives the script module, so it keeps a copy of the name
+                    int length = strlen(info->GetName());
+                    char *type = new char[length + 1];
+                    memcpy(type, info->GetName(), length + 1);
+
                     MetaType::Table staticTable = {
                         expose_props_method<AngelBehaviour>::exec(),
                         expose_method<AngelBehaviour>::exec(),
@@ -198,7 +244,7 @@ void AngelSystem::reload() {
                         TypeFuncs<AngelBehaviour>::clone,
                         TypeFuncs<AngelBehaviour>::compare,
                         TypeFuncs<AngelBehaviour>::index,
-                        info->GetName(),
+                        type,
                         MetaType::BASE_OBJECT
                     };
 
@@ -265,6 +311,69 @@ void *AngelSystem::execute(asIScriptObject *object, asIScriptFunction *func) {
     return m_context->GetAddressOfReturnValue();
 }
 
+bool AngelSystem::execute(asIScriptObject *object, asIScriptFunction *func, ContextPool &pool) {
+    if(func == nullptr) {
+        return false;
+    }
+
+    asIScriptContext *context = nullptr;
+    auto it = pool.find(func);
+    if(it != pool.end()) {
+        context = it->second;
+    } else {
+        context = m_scriptEngine->CreateContext();
+        pool[func] = context;
+    }
+
+    // Preparing the context for the same function as the last time skips the function setup
+    if(context->Prepare(func) < 0) {
+        return false;
+    }
+    context->SetObject(object);
+    if(context->Execute() == asEXECUTION_EXCEPTION) {
+        int column;
+        context->GetExceptionLineNumber(&column);
+        Log(Log::ERR) << __FUNCTION__ << "Unhandled Exception:" << context->GetExceptionString() << context->GetExceptionFunction()->GetName() << "Line:" << column;
+    }
+    return true;
+}
+
+void AngelSystem::executeParallel(ThreadPool *threadPool) {
+    PROFILE_FUNCTION();
+
+    uint32_t count = m_parallelBehaviours.size();
+    uint32_t slots = (threadPool && count >= gParallelThreshold) ? MIN(uint32_t(threadPool->maxThreads()) + 1, count) : 1;
+    if(m_contextPools.size() < slots) {
+        m_contextPools.resize(slots);
+    }
+
+    // Each slot owns a separate set of contexts, the calling thread takes part in the loop
+    ParallelFor::run(threadPool, slots, [this, slots](uint32_t slot) {
+        executeBehaviours(slot, slots, m_contextPools[slot]);
+    });
+}
+
+void AngelSystem::executeBehaviours(uint32_t first, uint32_t step, ContextPool &pool) {
+    for(uint32_t i = first; i < m_parallelBehaviours.size(); i += step) {
+        AngelBehaviour *component = m_parallelBehaviours[i];
+        PROFILE_BLOCK(component->m_script.c_str());
+
+        asIScriptObject *object = component->m_object;
+        object->AddRef();
+        execute(object, component->m_update, pool);
+        object->Release();
+    }
+}
+
+void AngelSystem::releaseContexts() {
+    for(auto &pool : m_contextPools) {
+        for(auto &it : pool) {
+            it.second->Release();
+        }
+    }
+    m_contextPools.clear();
+}
+
 asIScriptModule *AngelSystem::module() const {
     PROFILE_FUNCTION();
 
@@ -289,6 +398,9 @@ bool AngelSystem::isBehaviour(asITypeInfo *info) const {
 }
 
 void AngelSystem::unload() {
+    // The prepared contexts keep references to the functions of the module
+    releaseContexts();
+
     if(m_scriptModule) {
         for(uint32_t i = 0; i < m_scriptModule->GetObjectTypeCount(); i++) {
             asITypeInfo *info = m_scriptModule->GetObjectTypeByIndex(i);
@@ -318,26 +430,32 @@ void AngelSystem::registerClasses(asIScriptEngine *engine) {
     registerInput(engine);
     registerCore(engine);
 
-    for(auto &it : MetaType::types()) {
-        if(it.first > MetaType::USERTYPE) {
-            MetaType::Table &table = it.second;
-            const char *typeName = table.name;
-            if(typeName[strlen(typeName) - 1] != '*') {
-                engine->RegisterObjectType(table.name, 0, asOBJ_REF | asOBJ_NOCOUNT);
-                std::string stream = std::string(table.name) + "@ f()";
-                engine->RegisterObjectBehaviour(table.name, asBEHAVE_FACTORY, stream.c_str(), asFUNCTION(table.static_new), asCALL_CDECL);
-                //engine->RegisterObjectBehaviour(name, asBEHAVE_ADDREF, "void f()", asMETHOD(CRef,AddRef), asCALL_THISCALL);
-                //engine->RegisterObjectBehaviour(name, asBEHAVE_RELEASE, "void f()", asMETHOD(CRef,Release), asCALL_THISCALL);
-            }
+    // The type registered several times is listed under each of its identifiers
+    MetaType::TypeMap types = MetaType::types();
+
+    std::set<std::string> names;
+    std::vector<const MetaType::Table *> tables;
+    for(auto &it : types) {
+        if(it.first > MetaType::USERTYPE && names.insert(it.second.name).second) {
+            tables.push_back(&it.second);
         }
     }
 
-    for(auto &it : MetaType::types()) {
-        if(it.first > MetaType::USERTYPE) {
-            bindMetaType(engine, it.second);
+    for(auto table : tables) {
+        const char *typeName = table->name;
+        if(typeName[strlen(typeName) - 1] != '*') {
+            engine->RegisterObjectType(table->name, 0, asOBJ_REF | asOBJ_NOCOUNT);
+            std::string stream = std::string(table->name) + "@ f()";
+            engine->RegisterObjectBehaviour(table->name, asBEHAVE_FACTORY, stream.c_str(), asFUNCTION(table->static_new), asCALL_CDECL);
+            //engine->RegisterObjectBehaviour(name, asBEHAVE_ADDREF, "void f()", asMETHOD(CRef,AddRef), asCALL_THISCALL);
+            //engine->RegisterObjectBehaviour(name, asBEHAVE_RELEASE, "void f()", asMETHOD(CRef,Release), asCALL_THISCALL);
         }
     }
 
+    for(auto table : tables) {
+        bindMetaType(engine, *table);
+    }
+
     for(auto &it : System::factories()) {
         auto factory = System::metaFactory(it.first);
         if(factory) {
@@ -346,6 +464,9 @@ void AngelSystem::registerClasses(asIScriptEngine *engine) {
     }
 
     engine->RegisterInterface("IBehaviour");
+    // Marks the behaviours which update() can be executed in parallel with the other behaviours,
+    // such update() must touch only the own state and must not create or destroy the objects
+    engine->RegisterInterface("IParallelUpdate");
     engine->RegisterObjectMethod("AngelBehaviour",
                                  "void setScriptObject(IBehaviour @)",
                                  asMETHOD(AngelBehaviour, setScriptObject),
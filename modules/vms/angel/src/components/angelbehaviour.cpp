@@ -18,6 +18,7 @@ AngelBehaviour::AngelBehaviour() :
         m_object(nullptr),
         m_start(nullptr),
         m_update(nullptr),
+        m_parallel(false),
         m_metaObject(nullptr) {
     PROFILE_FUNCTION();
 }
@@ -109,6 +110,7 @@ void AngelBehaviour::setScriptObject(asIScriptObject *object) {
             }
             m_start = info->GetMethodByDecl("void start()");
             m_update = info->GetMethodByDecl("void update()");
+            m_parallel = info->Implements(info->GetEngine()->GetTypeInfoByName("IParallelUpdate"));
 
             updateMeta();
         }
@@ -220,6 +222,10 @@ asIScriptFunction *AngelBehaviour::scriptUpdate() const {
     return m_update;
 }
 
+bool AngelBehaviour::isParallel() const {
+    return m_parallel;
+}
+
 const MetaObject *AngelBehaviour::metaObject() const {
     PROFILE_FUNCTION();
     if(m_metaObject) {
@@ -76,6 +76,8 @@ AngelBuilder::AngelBuilder(AngelSystem *system) :
         m_classModel(new AngelClassMapModel(m_scriptEngine)) {
 
     m_scriptEngine->SetMessageCallback(asFUNCTION(messageCallback), nullptr, asCALL_CDECL);
+    // Keep the resume points for the JIT compiler in the saved bytecode
+    m_scriptEngine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true);
 }
 
 AngelBuilder::~AngelBuilder() {
@@ -0,0 +1,342 @@
+#include "tst_common.h"
+
+#include "angelsystem.h"
+#include "angeljit.h"
+
+#include <angelscript.h>
+
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <iostream>
+
+class AngelJitTest : public ::testing::Test {
+public:
+    class TestJit : public AngelJit {
+    public:
+        using AngelJit::m_functions;
+
+    };
+
+    // The script sources of the module are located next to the tests
+    static std::string readSource(const std::string &name) {
+        std::string path(__FILE__);
+        path = path.substr(0, path.find_last_of("/\\")) + "/../src/converters/" + name;
+
+        std::ifstream file(path);
+        std::stringstream result;
+        result << file.rdbuf();
+        return result.str();
+    }
+
+    static asIScriptModule *build(asIScriptEngine *engine, const std::string &source) {
+        asIScriptModule *module = engine->GetModule("AngelData", asGM_ALWAYS_CREATE);
+        module->AddScriptSection("AngelData", source.c_str());
+        if(module->Build() < 0) {
+            return nullptr;
+        }
+        return module;
+    }
+
+    static asIScriptEngine *createEngine(asIJITCompiler *jit) {
+        asIScriptEngine *engine = asCreateScriptEngine();
+        engine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true);
+        if(jit) {
+            engine->SetJITCompiler(jit);
+        }
+        return engine;
+    }
+    // Executes the function \a decl with the integer argument and returns the raw value of the result
+    static uint64_t call(asIScriptModule *module, const char *decl, int32_t argument) {
+        uint64_t result = 0;
+
+        asIScriptFunction *function = module->GetFunctionByDecl(decl);
+        EXPECT_TRUE(function != nullptr);
+        if(function) {
+            asIScriptContext *context = module->GetEngine()->CreateContext();
+            context->Prepare(function);
+            context->SetArgDWord(0, argument);
+            EXPECT_EQ(context->Execute(), asEXECUTION_FINISHED);
+
+            void *address = context->GetAddressOfReturnValue();
+            if(address) {
+                memcpy(&result, address, function->GetReturnTypeId() == asTYPEID_DOUBLE ? sizeof(double) : sizeof(int32_t));
+            }
+            context->Release();
+        }
+        return result;
+    }
+
+    // Arithmetic, branches and the script object members without any calls of the registered functions
+    static std::string arithmeticSource() {
+        return
+            "int integers(int n) {\n"
+            "    int a = 1;\n"
+            "    uint b = 3;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        a = a * 3 + i - (a >> 2);\n"
+            "        a ^= (a << 1) & 0xff;\n"
+            "        a = -a | (i & 7);\n"
+            "        b = (b * 7 + uint(i)) >>> 1;\n"
+            "        b = ~b + 5;\n"
+            "    }\n"
+            "    return a + int(b & 0xffff);\n"
+            "}\n"
+            "float floats(int n) {\n"
+            "    float f = 0.5f;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        f = f * 1.5f - float(i) + 0.25f;\n"
+            "        if(f > 1000.0f || f < -1000.0f) {\n"
+            "            f = -f * 0.001f;\n"
+            "        }\n"
+            "    }\n"
+            "    return f;\n"
+            "}\n"
+            "double doubles(int n) {\n"
+            "    double d = 0.25;\n"
+            "    float f = 2.0f;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        d = d * 0.5 + double(i) - double(f);\n"
+            "        f = float(d) * 0.125f;\n"
+            "    }\n"
+            "    return d + int(d);\n"
+            "}\n"
+            "int branches(int n) {\n"
+            "    int result = 0;\n"
+            "    uint u = uint(n);\n"
+            "    for(int i = -n; i <= n; i++) {\n"
+            "        if(i < 0) {\n"
+            "            result += 1;\n"
+            "        } else if(i == 0) {\n"
+            "            result += 10;\n"
+            "        } else if(i > 5 && !(i % 2 == 0)) {\n"
+            "            result += 100;\n"
+            "        }\n"
+            "        result += (uint(i) < u) ? 1000 : 0;\n"
+            "        result += (float(i) >= 2.5f) ? 10000 : 0;\n"
+            "        result += (double(i) != 3.0) ? 0 : 100000;\n"
+            "    }\n"
+            "    int k = n;\n"
+            "    while(k > 0) {\n"
+            "        k -= 3;\n"
+            "        result--;\n"
+            "    }\n"
+            "    return result;\n"
+            "}\n"
+            "class Counter {\n"
+            "    int value = 0;\n"
+            "    float scale = 1.0f;\n"
+            "    double total = 0.0;\n"
+            "    void step(int i) {\n"
+            "        value += i * 2;\n"
+            "        scale = scale * 0.5f + float(value);\n"
+            "        total += double(scale);\n"
+            "    }\n"
+            "};\n"
+            "int members(int n) {\n"
+            "    Counter c;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        c.step(i);\n"
+            "    }\n"
+            "    return c.value + int(c.scale) + int(c.total);\n"
+            "}\n";
+    }
+    // Vector3 and Quaternion math which is mostly the calls of the registered functions and methods
+    static std::string mathSource() {
+        return
+            "float vectors(int n) {\n"
+            "    Vector3 a(1.0f, 2.0f, 3.0f);\n"
+            "    Vector3 b(0.5f, -1.0f, 0.25f);\n"
+            "    float result = 0.0f;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        a += b;\n"
+            "        a *= 0.5f;\n"
+            "        b.x = b.x + float(i & 7) * 0.01f;\n"
+            "        result += a.dot(b) + a.length() - b.sqrLength() * 0.001f;\n"
+            "        result += a.angle(b) * 0.01f + a[1];\n"
+            "    }\n"
+            "    return result + a.x + a.y + a.z;\n"
+            "}\n"
+            "float quaternions(int n) {\n"
+            "    Quaternion q;\n"
+            "    Quaternion r(Vector3(0.0f, 1.0f, 0.0f), 90.0f);\n"
+            "    float result = 0.0f;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        q.mix(q, r, 0.1f);\n"
+            "        result += q[2] + sin(float(i)) * cos(float(i));\n"
+            "        if(closeTo(result, 0.0f)) {\n"
+            "            result += 1.0f;\n"
+            "        }\n"
+            "    }\n"
+            "    return fpFromIEEE(fpToIEEE(result) & 0xffffff00);\n"
+            "}\n"
+            "int probes(int n) {\n"
+            "    int result = 0;\n"
+            "    for(int i = 0; i < n; i++) {\n"
+            "        result += probe(i);\n"
+            "    }\n"
+            "    return result;\n"
+            "}\n";
+    }
+    // Returns 1 when called directly from the native code without the interpreter
+    static int probe(int) {
+        return (asGetActiveContext()->GetSystemFunction() == nullptr) ? 1 : 0;
+    }
+
+};
+
+TEST_F(AngelJitTest, Interpreter_equivalence) {
+    const std::string source = arithmeticSource();
+
+    TestJit jit;
+    asIScriptEngine *native = createEngine(&jit);
+    asIScriptEngine *interpreter = createEngine(nullptr);
+
+    asIScriptModule *nativeModule = build(native, source);
+    asIScriptModule *interpreterModule = build(interpreter, source);
+    ASSERT_TRUE(nativeModule != nullptr);
+    ASSERT_TRUE(interpreterModule != nullptr);
+
+    if(AngelJit::isSupported()) {
+        EXPECT_FALSE(jit.m_functions.empty());
+    }
+
+    const char *functions[] = {
+        "int integers(int)",
+        "float floats(int)",
+        "double doubles(int)",
+        "int branches(int)",
+        "int members(int)"
+    };
+
+    for(auto it : functions) {
+        for(int32_t n : {0, 1, 2, 7, 31, 100}) {
+            EXPECT_EQ(call(nativeModule, it, n), call(interpreterModule, it, n)) << it << " with " << n;
+        }
+    }
+
+    native->ShutDownAndRelease();
+    interpreter->ShutDownAndRelease();
+}
+
+TEST_F(AngelJitTest, Native_calls) {
+    Engine engine(nullptr, "");
+    AngelSystem system(&engine);
+
+    TestJit jit;
+    asIScriptEngine *native = createEngine(&jit);
+    asIScriptEngine *interpreter = createEngine(nullptr);
+
+    for(auto it : {native, interpreter}) {
+        system.registerClasses(it);
+        it->RegisterGlobalFunction("int probe(int)", asFUNCTION(probe), asCALL_CDECL);
+    }
+
+    asIScriptModule *nativeModule = build(native, mathSource());
+    asIScriptModule *interpreterModule = build(interpreter, mathSource());
+    ASSERT_TRUE(nativeModule != nullptr);
+    ASSERT_TRUE(interpreterModule != nullptr);
+
+    // The registered functions and methods return the same values when called from the native code
+    for(auto it : {"float vectors(int)", "float quaternions(int)"}) {
+        for(int32_t n : {0, 1, 2, 7, 31, 100}) {
+            EXPECT_EQ(call(nativeModule, it, n), call(interpreterModule, it, n)) << it << " with " << n;
+        }
+    }
+
+    // The interpreter always marks the system function which it calls
+    EXPECT_EQ(call(interpreterModule, "int probes(int)", 10), 0);
+    if(AngelJit::isSupported()) {
+        EXPECT_EQ(call(nativeModule, "int probes(int)", 10), 10);
+    }
+
+    native->ShutDownAndRelease();
+    interpreter->ShutDownAndRelease();
+}
+
+TEST_F(AngelJitTest, Behaviour_template) {
+    Engine engine(nullptr, "");
+    AngelSystem system(&engine);
+
+    std::string source = readSource("AngelBehaviour.as");
+    const std::string name("${templateName}");
+    source.replace(source.find(name), name.size(), "Template");
+    source = readSource("Behaviour.txt") + source;
+
+    TestJit jit;
+    asIScriptEngine *engines[] = {createEngine(&jit), createEngine(nullptr)};
+
+    for(auto it : engines) {
+        system.registerClasses(it);
+
+        asIScriptModule *module = build(it, source);
+        ASSERT_TRUE(module != nullptr);
+
+        asITypeInfo *type = module->GetTypeInfoByName("Template");
+        ASSERT_TRUE(type != nullptr);
+
+        asIScriptContext *context = it->CreateContext();
+        context->Prepare(type->GetFactoryByIndex(0));
+        ASSERT_EQ(context->Execute(), asEXECUTION_FINISHED);
+
+        asIScriptObject *object = *static_cast<asIScriptObject **>(context->GetAddressOfReturnValue());
+        ASSERT_TRUE(object != nullptr);
+        object->AddRef();
+
+        // The generated behaviour is executed the same way with and without the JIT
+        for(auto decl : {"void start()", "void update()"}) {
+            context->Prepare(type->GetMethodByDecl(decl));
+            context->SetObject(object);
+            EXPECT_EQ(context->Execute(), asEXECUTION_FINISHED) << decl;
+        }
+
+        object->Release();
+        context->Release();
+    }
+
+    if(AngelJit::isSupported()) {
+        EXPECT_FALSE(jit.m_functions.empty());
+    }
+
+    for(auto it : engines) {
+        it->ShutDownAndRelease();
+    }
+}
+
+TEST_F(AngelJitTest, Benchmark) {
+    Engine engine(nullptr, "");
+    AngelSystem system(&engine);
+
+    TestJit jit;
+    asIScriptEngine *engines[] = {createEngine(&jit), createEngine(nullptr)};
+    asIScriptModule *modules[2];
+
+    const std::string source = arithmeticSource() + mathSource();
+    for(int i = 0; i < 2; i++) {
+        system.registerClasses(engines[i]);
+        engines[i]->RegisterGlobalFunction("int probe(int)", asFUNCTION(probe), asCALL_CDECL);
+
+        modules[i] = build(engines[i], source);
+        ASSERT_TRUE(modules[i] != nullptr);
+    }
+
+    // The timings are only reported, the speedup depends on the machine and the build
+    const int32_t iterations = 200000;
+    for(auto it : {"int integers(int)", "float floats(int)", "int members(int)", "float vectors(int)", "float quaternions(int)"}) {
+        double time[2];
+        uint64_t result[2];
+        for(int i = 0; i < 2; i++) {
+            auto start = std::chrono::steady_clock::now();
+            result[i] = call(modules[i], it, iterations);
+            time[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        EXPECT_EQ(result[0], result[1]) << it;
+
+        std::cout << "[          ] " << it << ": JIT " << time[0] << " ms, interpreter " << time[1] << " ms, "
+                  << time[1] / MAX(time[0], 0.001) << "x" << std::endl;
+    }
+
+    for(auto it : engines) {
+        it->ShutDownAndRelease();
+    }
+}
@@ -0,0 +1,202 @@
+#include "tst_common.h"
+
+#include "angelsystem.h"
+
+#include "components/angelbehaviour.h"
+#include "resources/angelscript.h"
+
+#include "components/world.h"
+#include "components/scene.h"
+#include "components/actor.h"
+
+#include "systems/resourcesystem.h"
+
+#include <angelscript.h>
+
+#include <threadpool.h>
+
+#include <fstream>
+#include <sstream>
+
+class AngelSystemTest : public ::testing::Test {
+public:
+    class TestSystem : public AngelSystem {
+    public:
+        explicit TestSystem(Engine *engine) :
+                AngelSystem(engine) {
+
+        }
+
+        using AngelSystem::ContextPool;
+        using AngelSystem::executeParallel;
+        using AngelSystem::m_contextPools;
+        using AngelSystem::m_parallelBehaviours;
+
+    };
+
+    class ByteStream : public asIBinaryStream {
+    public:
+        explicit ByteStream(ByteArray &data) :
+                m_data(data),
+                m_offset(0) {
+
+        }
+
+        int Write(const void *ptr, asUINT size) override {
+            const uint8_t *data = static_cast<const uint8_t *>(ptr);
+            m_data.insert(m_data.end(), data, data + size);
+            return 0;
+        }
+
+        int Read(void *ptr, asUINT size) override {
+            memcpy(ptr, &m_data[m_offset], size);
+            m_offset += size;
+            return 0;
+        }
+
+    private:
+        ByteArray &m_data;
+
+        uint32_t m_offset;
+
+    };
+
+    // The script sources of the module are located next to the tests
+    static std::string readSource(const std::string &name) {
+        std::string path(__FILE__);
+        path = path.substr(0, path.find_last_of("/\\")) + "/../src/converters/" + name;
+
+        std::ifstream file(path);
+        std::stringstream result;
+        result << file.rdbuf();
+        return result.str();
+    }
+    // Builds the \a source together with the Behaviour base class like the AngelBuilder does
+    static ByteArray build(AngelSystem &system, const std::string &source) {
+        ByteArray result;
+
+        asIScriptEngine *engine = asCreateScriptEngine();
+        engine->SetEngineProperty(asEP_INCLUDE_JIT_INSTRUCTIONS, true);
+        system.registerClasses(engine);
+
+        asIScriptModule *module = engine->GetModule("AngelBuilder", asGM_CREATE_IF_NOT_EXISTS);
+        module->AddScriptSection("AngelData", readSource("Behaviour.txt").c_str());
+        module->AddScriptSection("AngelData", source.c_str());
+        if(module->Build() >= 0) {
+            ByteStream stream(result);
+            module->SaveByteCode(&stream);
+        }
+
+        engine->ShutDownAndRelease();
+
+        return result;
+    }
+
+    static int32_t counter(Component *component) {
+        int32_t result = -1;
+
+        asIScriptObject *object = static_cast<AngelBehaviour *>(component)->scriptObject();
+        if(object) {
+            for(uint32_t i = 0; i < object->GetPropertyCount(); i++) {
+                if(strcmp(object->GetPropertyName(i), "counter") == 0) {
+                    result = *static_cast<int32_t *>(object->GetAddressOfProperty(i));
+                }
+            }
+            object->Release();
+        }
+        return result;
+    }
+
+};
+
+TEST_F(AngelSystemTest, Parallel_update) {
+    Engine engine(nullptr, "");
+    TestSystem system(&engine);
+
+    ByteArray data = build(system,
+        "class Serial : Behaviour {\n"
+        "    int counter = 0;\n"
+        "    void update() override { counter++; }\n"
+        "};\n"
+        "class Parallel : Behaviour, IParallelUpdate {\n"
+        "    int counter = 0;\n"
+        "    void update() override { counter += 2; }\n"
+        "};\n");
+    ASSERT_FALSE(data.empty());
+
+    AngelScript *script = Engine::objectCreate<AngelScript>("");
+    script->m_array = data;
+    engine.resourceSystem()->indices()["AngelBinary"] = std::make_pair("AngelScript", "AngelBinary");
+    Engine::setResource(script, "AngelBinary");
+
+    ASSERT_TRUE(system.init());
+
+    Engine::setGameMode(true);
+
+    World *world = Engine::objectCreate<World>("World");
+    Scene *scene = world->createScene("Scene");
+
+    std::vector<Component *> serial;
+    std::vector<Component *> parallel;
+    for(int32_t i = 0; i < 2; i++) {
+        serial.push_back(Engine::composeActor("Serial", "Serial", scene)->component("Serial"));
+    }
+    for(int32_t i = 0; i < 9; i++) {
+        parallel.push_back(Engine::composeActor("Parallel", "Parallel", scene)->component("Parallel"));
+    }
+    for(auto it : serial) {
+        ASSERT_TRUE(it != nullptr);
+        ASSERT_FALSE(static_cast<AngelBehaviour *>(it)->isParallel());
+    }
+    for(auto it : parallel) {
+        ASSERT_TRUE(it != nullptr);
+        ASSERT_TRUE(static_cast<AngelBehaviour *>(it)->isParallel());
+    }
+
+    // Without the engine pool the parallel behaviours are updated on the system thread after the serial ones
+    system.update(world);
+    ASSERT_EQ(system.m_parallelBehaviours.size(), parallel.size());
+    ASSERT_EQ(system.m_contextPools.size(), 1);
+
+    // One context per executed function: update() of the both classes
+    TestSystem::ContextPool contexts = system.m_contextPools.front();
+    EXPECT_EQ(contexts.size(), 2);
+
+    // The contexts are reused in the next frame
+    system.update(world);
+    EXPECT_EQ(system.m_contextPools.front(), contexts);
+
+    for(auto it : serial) {
+        EXPECT_EQ(counter(it), 2);
+    }
+    for(auto it : parallel) {
+        EXPECT_EQ(counter(it), 4);
+    }
+
+    // Each slot of the pool gets every fourth behaviour and a separate set of contexts
+    ThreadPool pool;
+    pool.setMaxThreads(3);
+
+    system.executeParallel(&pool);
+    ASSERT_EQ(system.m_contextPools.size(), 4);
+    for(uint32_t i = 1; i < 4; i++) {
+        EXPECT_EQ(system.m_contextPools[i].size(), 1);
+        for(auto &it : system.m_contextPools[i]) {
+            EXPECT_EQ(system.m_contextPools[0].count(it.first), 1);
+            EXPECT_NE(system.m_contextPools[0][it.first], it.second);
+        }
+    }
+
+    for(auto it : serial) {
+        EXPECT_EQ(counter(it), 2);
+    }
+    for(auto it : parallel) {
+        EXPECT_EQ(counter(it), 6);
+    }
+
+    pool.waitForDone();
+
+    delete world;
+
+    Engine::setGameMode(false);
+}
@@ -7,6 +7,27 @@
 #include "tst_metaobject.h"
 #include "tst_animation.h"
 #include "tst_actor.h"
+#include "tst_commandlist.h"
+#include "tst_lightclusters.h"
+#include "tst_shadowmap.h"
+#include "tst_assetpack.h"
+#include "tst_meshoptimizer.h"
+#include "tst_textureencoder.h"
+#include "tst_texturestreamer.h"
+#include "tst_animator.h"
+#include "tst_particleprogram.h"
+#include "tst_particlecompute.h"
+#include "tst_querybatch.h"
+#include "tst_voicemixer.h"
+#include "tst_parallelfor.h"
+#include "tst_resourcesystem.h"
+#include "tst_importcache.h"
+#include "tst_bulletsystem.h"
+#include "tst_contactcache.h"
+#include "tst_angelsystem.h"
+#include "tst_angeljit.h"
+#include "tst_audiomixer.h"
+#include "tst_uisystem.h"
 
 int main(int argc, char *argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
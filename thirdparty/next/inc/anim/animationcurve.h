@@ -45,11 +45,38 @@ public:
 
     typedef std::vector<KeyFrame> Keys;
 
+    AnimationCurve();
+
     Variant value(float pos) const;
+    Variant value(float pos, int32_t &cursor) const;
+
+    bool sample(float pos, float *result, int32_t &cursor) const;
 
     void frames(int32_t &b, int32_t &e, float pos);
 
+    void bake();
+    bool isBaked() const;
+
+    int32_t components() const;
+
     Keys m_keys;
+
+private:
+    int32_t interval(float pos, int32_t &cursor) const;
+
+private:
+    std::vector<float> m_positions;
+
+    std::vector<float> m_values;
+
+    std::vector<float> m_tangents;
+
+    std::vector<uint8_t> m_types;
+
+    int32_t m_valueType;
+
+    int32_t m_components;
+
 };
 
 #endif // ANIMATIONCURVE_H
@@ -42,6 +42,10 @@ public:
 
     void setCurrentTime(uint32_t posintion) override;
 
+protected:
+    Variant curveValue(float position);
+    bool curveSample(float position, float *result);
+
 private:
     AnimationCurve m_keyFrames;
 
@@ -49,6 +53,8 @@ private:
 
     int32_t m_duration;
 
+    int32_t m_cursor;
+
 };
 
 #endif // VARIANTANIMATION_H
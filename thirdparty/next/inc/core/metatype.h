@@ -308,7 +308,12 @@ inline static MetaType::Table *createTable(const char *typeName = "") {
         flags |= MetaType::BASE_OBJECT;
     }
 
-    return Table<T>::get(typeName, flags);
+    MetaType::Table *result = Table<T>::get(typeName, flags);
+    // The table is created without a name when the type is used as an argument before its registration
+    if(result->name[0] == 0) {
+        result->name = typeName;
+    }
+    return result;
 }
 
 
@@ -18,130 +18,320 @@
 
 #include "anim/animationcurve.h"
 
+#include <algorithm>
+#include <cstring>
 #include <float.h>
 
-bool AnimationCurve::KeyFrame::operator ==(const KeyFrame &left) {
-    return abs(m_position - left.m_position) <= FLT_EPSILON  && (m_value == left.m_value);
+namespace {
+    const float gStepThreshold = 0.99f;
+};
+
+static int32_t bakedComponents(int32_t type) {
+    switch(type) {
+        case MetaType::FLOAT: return 1;
+        case MetaType::VECTOR2: return 2;
+        case MetaType::VECTOR3: return 3;
+        case MetaType::VECTOR4:
+        case MetaType::QUATERNION: return 4;
+        default: break;
+    }
+    return 0;
 }
 
-Variant AnimationCurve::value(float pos) const {
-    Variant result = (m_keys.empty()) ? 0.0f : m_keys.front().m_value;
-    if(m_keys.size() >= 2) {
-        AnimationCurve::KeyFrame a;
-        AnimationCurve::KeyFrame b;
+static int32_t toComponents(const Variant &value, float *result) {
+    switch(value.type()) {
+        case MetaType::INTEGER:
+        case MetaType::FLOAT: {
+            result[0] = value.toFloat();
+            return 1;
+        }
+        case MetaType::VECTOR2: {
+            Vector2 v(value.toVector2());
+            result[0] = v.x; result[1] = v.y;
+            return 2;
+        }
+        case MetaType::VECTOR3: {
+            Vector3 v(value.toVector3());
+            result[0] = v.x; result[1] = v.y; result[2] = v.z;
+            return 3;
+        }
+        case MetaType::VECTOR4: {
+            Vector4 v(value.toVector4());
+            result[0] = v.x; result[1] = v.y; result[2] = v.z; result[3] = v.w;
+            return 4;
+        }
+        case MetaType::QUATERNION: {
+            Quaternion q(value.toQuaternion());
+            result[0] = q.x; result[1] = q.y; result[2] = q.z; result[3] = q.w;
+            return 4;
+        }
+        default: break;
+    }
+    return 0;
+}
 
-        for(auto i = m_keys.begin(); i != m_keys.end(); i++) {
-            if(pos == i->m_position) {
-                return i->m_value;
-            }
-            if(pos >= i->m_position) {
-                a = (*i);
+static Variant fromComponents(int32_t type, const float *value) {
+    switch(type) {
+        case MetaType::INTEGER:
+        case MetaType::FLOAT: return value[0];
+        case MetaType::VECTOR2: return Vector2(value[0], value[1]);
+        case MetaType::VECTOR3: return Vector3(value[0], value[1], value[2]);
+        case MetaType::VECTOR4: return Vector4(value[0], value[1], value[2], value[3]);
+        case MetaType::QUATERNION: return Quaternion(value[0], value[1], value[2], value[3]);
+        default: break;
+    }
+    return Variant();
+}
+
+static bool interpolate(int32_t type, int32_t components, int32_t keyType, const float *a, const float *b, float right, float left, float factor, float *result) {
+    switch(keyType) {
+        case AnimationCurve::KeyFrame::Linear: {
+            if(type == MetaType::QUATERNION) {
+                Quaternion q;
+                q.mix(Quaternion(a[0], a[1], a[2], a[3]), Quaternion(b[0], b[1], b[2], b[3]), factor);
+                result[0] = q.x; result[1] = q.y; result[2] = q.z; result[3] = q.w;
+            } else {
+                for(int32_t i = 0; i < components; i++) {
+                    result[i] = MIX(a[i], b[i], factor);
+                }
             }
-            if(pos <= i->m_position) {
-                b = (*i);
+            return true;
+        }
+        case AnimationCurve::KeyFrame::Cubic: {
+            if(type == MetaType::QUATERNION) {
                 break;
             }
+            for(int32_t i = 0; i < components; i++) {
+                result[i] = CMIX(a[i], right, left, b[i], factor);
+            }
+            return true;
         }
+        default: break;
+    }
+    return false;
+}
 
-        float factor = (pos - a.m_position) / (b.m_position - a.m_position);
+/*!
+    \class AnimationCurve
+    \brief The AnimationCurve class contains a sequence of key frames and interpolates the values between them.
+    \since Next 1.0
+    \inmodule Animation
 
-        switch(a.m_value.type()) {
-            case MetaType::INTEGER: {
-                switch(a.m_type) {
-                    case AnimationCurve::KeyFrame::Linear: return MIX(a.m_value.toInt(), b.m_value.toInt(), factor); break;
-                    case AnimationCurve::KeyFrame::Cubic: return CMIX(a.m_value.toInt(), a.m_rightTangent, b.m_leftTangent, b.m_value.toInt(), factor); break;
-                    default: break;
-                }
-            } break;
-            case MetaType::FLOAT: {
-                switch(a.m_type) {
-                    case AnimationCurve::KeyFrame::Linear: return MIX(a.m_value.toFloat(), b.m_value.toFloat(), factor); break;
-                    case AnimationCurve::KeyFrame::Cubic: return CMIX(a.m_value.toFloat(), a.m_rightTangent, b.m_leftTangent, b.m_value.toFloat(), factor); break;
-                    default: break;
-                }
-            } break;
-            case MetaType::VECTOR2: {
-                Vector2 av(a.m_value.toVector2());
-                Vector2 bv(b.m_value.toVector2());
-
-                switch(a.m_type) {
-                    case AnimationCurve::KeyFrame::Linear: {
-                        return Vector2(MIX(av.x, bv.x, factor), MIX(av.y, bv.y, factor));
-                    } break;
-                    case AnimationCurve::KeyFrame::Cubic: {
-                        return Vector2(CMIX(av.x, a.m_rightTangent, b.m_leftTangent, bv.x, factor),
-                                       CMIX(av.y, a.m_rightTangent, b.m_leftTangent, bv.y, factor));
-                    } break;
-                    default: break;
-                }
-            } break;
-            case MetaType::VECTOR3: {
-                Vector3 av(a.m_value.toVector3());
-                Vector3 bv(b.m_value.toVector3());
-
-                switch(a.m_type) {
-                    case AnimationCurve::KeyFrame::Linear: {
-                        return Vector3(MIX(av.x, bv.x, factor), MIX(av.y, bv.y, factor), MIX(av.z, bv.z, factor));
-                    } break;
-                    case AnimationCurve::KeyFrame::Cubic: {
-                        return Vector3(CMIX(av.x, a.m_rightTangent, b.m_leftTangent, bv.x, factor),
-                                       CMIX(av.y, a.m_rightTangent, b.m_leftTangent, bv.y, factor),
-                                       CMIX(av.z, a.m_rightTangent, b.m_leftTangent, bv.z, factor));
-                    } break;
-                    default: break;
-                }
-            } break;
-            case MetaType::VECTOR4: {
-                Vector4 av(a.m_value.toVector4());
-                Vector4 bv(b.m_value.toVector4());
-
-                switch(a.m_type) {
-                    case AnimationCurve::KeyFrame::Linear: {
-                        return Vector4(MIX(av.x, bv.x, factor), MIX(av.y, bv.y, factor), MIX(av.z, bv.z, factor), MIX(av.w, bv.w, factor));
-                    } break;
-                    case AnimationCurve::KeyFrame::Cubic: {
-                        return Vector4(CMIX(av.x, a.m_rightTangent, b.m_leftTangent, bv.x, factor),
-                                       CMIX(av.y, a.m_rightTangent, b.m_leftTangent, bv.y, factor),
-                                       CMIX(av.z, a.m_rightTangent, b.m_leftTangent, bv.z, factor),
-                                       CMIX(av.w, a.m_rightTangent, b.m_leftTangent, bv.w, factor));
-                    } break;
-                    default: break;
-                }
-            } break;
-            case MetaType::QUATERNION: {
-                Quaternion aq(a.m_value.toQuaternion());
-                Quaternion bq(b.m_value.toQuaternion());
-                switch(a.m_type) {
-                    case AnimationCurve::KeyFrame::Linear: {
-                        Quaternion q;
-                        q.mix(aq, bq, factor);
-                        return q;
-                    } break;
-                    default: break;
-                }
-            } break;
-            default: break;
+    The key frames must be sorted by position.
+    The interval of the key frames for a requested position is found using binary search.
+    The callers which evaluate the curve sequentially can pass a cursor to check the previously found interval first.
+
+    The curves of numeric values can be baked to typed contiguous arrays which avoids the Variant conversions on each evaluation.
+*/
+
+AnimationCurve::AnimationCurve() :
+        m_valueType(MetaType::INVALID),
+        m_components(0) {
+
+}
+
+bool AnimationCurve::KeyFrame::operator ==(const KeyFrame &left) {
+    return abs(m_position - left.m_position) <= FLT_EPSILON  && (m_value == left.m_value);
+}
+/*!
+    Returns the interpolated value of the curve at the normalized position \a pos.
+*/
+Variant AnimationCurve::value(float pos) const {
+    int32_t cursor = -1;
+    return value(pos, cursor);
+}
+/*!
+    Returns the interpolated value of the curve at the normalized position \a pos.
+    The \a cursor keeps the index of the last found key frame interval between the calls; it must be set to -1 before the first call.
+*/
+Variant AnimationCurve::value(float pos, int32_t &cursor) const {
+    if(m_keys.empty()) {
+        return 0.0f;
+    }
+    if(m_keys.size() < 2) {
+        return m_keys.front().m_value;
+    }
+
+    int32_t index = interval(pos, cursor);
+    const KeyFrame &a = m_keys[index];
+    const KeyFrame &b = m_keys[index + 1];
+    if(pos <= a.m_position) {
+        return a.m_value;
+    }
+    if(pos >= b.m_position) {
+        return b.m_value;
+    }
+
+    float factor = (pos - a.m_position) / (b.m_position - a.m_position);
+
+    float result[4];
+    if(isBaked()) {
+        const float *av = &m_values[index * m_components];
+        if(interpolate(m_valueType, m_components, m_types[index], av, av + m_components,
+                       m_tangents[index * 2 + 1], m_tangents[index * 2 + 2], factor, result)) {
+            return fromComponents(m_valueType, result);
+        }
+    } else {
+        float av[4];
+        float bv[4];
+        int32_t type = a.m_value.type();
+        int32_t components = toComponents(a.m_value, av);
+        if(components > 0) {
+            toComponents(b.m_value, bv);
+            if(interpolate(type, components, a.m_type, av, bv, a.m_rightTangent, b.m_leftTangent, factor, result)) {
+                return fromComponents(type, result);
+            }
         }
-        result = (factor >= 0.99f) ? b.m_value : a.m_value;
     }
-    return result;
+
+    return (factor >= gStepThreshold) ? b.m_value : a.m_value;
 }
+/*!
+    Writes the interpolated components of the baked curve at the normalized position \a pos to the \a result.
+    The \a result must have room for components() values.
+    The \a cursor keeps the index of the last found key frame interval between the calls; it must be set to -1 before the first call.
+    Returns false in case of the curve is not baked.
+*/
+bool AnimationCurve::sample(float pos, float *result, int32_t &cursor) const {
+    if(!isBaked()) {
+        return false;
+    }
+
+    if(m_positions.size() < 2) {
+        memcpy(result, m_values.data(), sizeof(float) * m_components);
+        return true;
+    }
 
+    int32_t index = interval(pos, cursor);
+    const float *a = &m_values[index * m_components];
+    const float *b = a + m_components;
+    float begin = m_positions[index];
+    float end = m_positions[index + 1];
+    if(pos <= begin) {
+        memcpy(result, a, sizeof(float) * m_components);
+    } else if(pos >= end) {
+        memcpy(result, b, sizeof(float) * m_components);
+    } else {
+        float factor = (pos - begin) / (end - begin);
+        if(!interpolate(m_valueType, m_components, m_types[index], a, b, m_tangents[index * 2 + 1], m_tangents[index * 2 + 2], factor, result)) {
+            memcpy(result, (factor >= gStepThreshold) ? b : a, sizeof(float) * m_components);
+        }
+    }
+    return true;
+}
+/*!
+    Returns the indices of the key frames around the position \a pos to \a b and \a e.
+    Both indices are equal in case of the key frame is exactly at \a pos; -1 means that there is no key frame on that side.
+*/
 void AnimationCurve::frames(int32_t &b, int32_t &e, float pos) {
     b = e = -1;
     if(m_keys.size() >= 2) {
-        for(uint32_t i = 0; i < m_keys.size(); i++) {
-            if(pos == m_keys[i].m_position) {
-                b = e = i;
+        auto it = std::lower_bound(m_keys.begin(), m_keys.end(), pos, [](const KeyFrame &key, float value) {
+            return key.m_position < value;
+        });
+        int32_t index = static_cast<int32_t>(std::distance(m_keys.begin(), it));
+        if(it != m_keys.end()) {
+            e = index;
+            if(pos == it->m_position) {
+                b = index;
                 return;
             }
-            if(pos >= m_keys[i].m_position) {
-                b = i;
-            }
-            if(pos <= m_keys[i].m_position) {
-                e = i;
-                break;
-            }
+        }
+        b = index - 1;
+    }
+}
+/*!
+    Copies the key frames to the typed contiguous arrays which are used for the evaluation.
+    Only the curves of floating-point, vector and quaternion values with the same type for all key frames can be baked.
+    The curve must be baked again after any modification of the key frames.
+*/
+void AnimationCurve::bake() {
+    m_positions.clear();
+    m_values.clear();
+    m_tangents.clear();
+    m_types.clear();
+    m_valueType = MetaType::INVALID;
+    m_components = 0;
+
+    if(m_keys.empty()) {
+        return;
+    }
+
+    int32_t type = m_keys.front().m_value.type();
+    int32_t components = bakedComponents(type);
+    if(components == 0) {
+        return;
+    }
+    for(auto &it : m_keys) {
+        if(it.m_value.type() != type) {
+            return;
+        }
+    }
+
+    m_positions.resize(m_keys.size());
+    m_values.resize(m_keys.size() * components);
+    m_tangents.resize(m_keys.size() * 2);
+    m_types.resize(m_keys.size());
+
+    for(size_t i = 0; i < m_keys.size(); i++) {
+        const KeyFrame &key = m_keys[i];
+        m_positions[i] = key.m_position;
+        toComponents(key.m_value, &m_values[i * components]);
+        m_tangents[i * 2] = key.m_leftTangent;
+        m_tangents[i * 2 + 1] = key.m_rightTangent;
+        m_types[i] = key.m_type;
+    }
+
+    m_valueType = type;
+    m_components = components;
+}
+/*!
+    Returns true in case of the curve is baked and the number of key frames was not changed after that; otherwise returns false.
+*/
+bool AnimationCurve::isBaked() const {
+    return m_components > 0 && m_positions.size() == m_keys.size();
+}
+/*!
+    Returns the number of float components of the baked curve values or 0 in case of the curve is not baked.
+*/
+int32_t AnimationCurve::components() const {
+    return isBaked() ? m_components : 0;
+}
+/*!
+    \internal
+    Returns the index of the first key frame of the interval which contains the position \a pos.
+    The interval pointed by the \a cursor and the next one are checked first, otherwise the binary search is used.
+*/
+int32_t AnimationCurve::interval(float pos, int32_t &cursor) const {
+    bool baked = isBaked();
+    auto position = [this, baked](int32_t index) {
+        return baked ? m_positions[index] : m_keys[index].m_position;
+    };
+
+    int32_t last = static_cast<int32_t>(m_keys.size()) - 2;
+    if(cursor >= 0 && cursor <= last) {
+        if(position(cursor) <= pos && pos <= position(cursor + 1)) {
+            return cursor;
+        }
+        // The sequential playback usually moves to the next interval
+        if(cursor < last && position(cursor + 1) <= pos && pos <= position(cursor + 2)) {
+            cursor++;
+            return cursor;
         }
     }
+
+    // Count of the key frames which are not after the position
+    int32_t begin = 0;
+    int32_t end = last + 2;
+    while(begin < end) {
+        int32_t middle = (begin + end) / 2;
+        if(position(middle) <= pos) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    cursor = CLAMP(begin - 1, 0, last);
+    return cursor;
 }
@@ -41,7 +41,8 @@
 */
 
 VariantAnimation::VariantAnimation() :
-        m_duration(-1) {
+        m_duration(-1),
+        m_cursor(-1) {
 
 }
 
@@ -81,9 +82,12 @@ const AnimationCurve &VariantAnimation::curve() const {
 }
 /*!
     Sets the new sequence of the key frames as \a curve.
+    The copy of the curve is baked for the faster evaluation.
 */
 void VariantAnimation::setCurve(const AnimationCurve &curve) {
     m_keyFrames = curve;
+    m_keyFrames.bake();
+    m_cursor = -1;
 }
 /*!
     \overload
@@ -98,5 +102,19 @@ void VariantAnimation::setCurrentTime(uint32_t position) {
 
     float time = (float)loopTime() / (float)m_duration;
 
-    setCurrentValue(m_keyFrames.value(time));
+    setCurrentValue(curveValue(time));
+}
+/*!
+    Returns the value of the animation curve at the normalized \a position.
+    The last found key frame interval is remembered to speed up the sequential evaluation.
+*/
+Variant VariantAnimation::curveValue(float position) {
+    return m_keyFrames.value(position, m_cursor);
+}
+/*!
+    Writes the components of the animation curve value at the normalized \a position to the \a result without the Variant conversion.
+    Returns false in case of the curve can't be baked.
+*/
+bool VariantAnimation::curveSample(float position, float *result) {
+    return m_keyFrames.sample(position, result, m_cursor);
 }
@@ -419,9 +419,12 @@ Object *ObjectSystem::toObject(const Variant &variant, Object *parent, const std
 }
 /*!
     Returns the new unique ID based on random number generator.
+    This method is thread safe.
 */
 uint32_t ObjectSystem::generateUUID() {
     PROFILE_FUNCTION();
+    static std::mutex mutex;
+    std::unique_lock<std::mutex> locker(mutex);
     return dist(mt);
 }
 /*!
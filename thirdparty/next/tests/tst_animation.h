@@ -42,3 +42,82 @@ TEST_F(AnimationTest, Property_animation) {
 
     ASSERT_TRUE(object.getVector() == Vector2(0.5, 1.0f));
 }
+
+TEST_F(AnimationTest, Curve_evaluation) {
+    AnimationCurve curve;
+    for(int i = 0; i <= 100; i++) {
+        AnimationCurve::KeyFrame key;
+        key.m_position = i / 100.0f;
+        key.m_type = (i % 2) ? AnimationCurve::KeyFrame::Cubic : AnimationCurve::KeyFrame::Linear;
+        key.m_value = Vector3(i, i * 2.0f, sinf(i * 0.1f));
+        key.m_leftTangent = 0.5f * i;
+        key.m_rightTangent = 0.5f * i + 1.0f;
+        curve.m_keys.push_back(key);
+    }
+
+    AnimationCurve baked = curve;
+    baked.bake();
+    ASSERT_TRUE(baked.isBaked());
+    ASSERT_FALSE(curve.isBaked());
+    ASSERT_EQ(baked.components(), 3);
+
+    // The baked curve and the cursor based lookup must match the plain evaluation
+    int32_t cursor = -1;
+    for(int i = -10; i <= 1010; i++) {
+        float pos = i / 1000.0f;
+        Vector3 reference = curve.value(pos).toVector3();
+        Vector3 sequential = baked.value(pos, cursor).toVector3();
+        ASSERT_TRUE(reference == sequential);
+
+        float result[3];
+        int32_t random = (i * 37) % 100;
+        ASSERT_TRUE(baked.sample(pos, result, random));
+        ASSERT_TRUE(reference == Vector3(result[0], result[1], result[2]));
+    }
+
+    ASSERT_TRUE(curve.value(-1.0f).toVector3() == Vector3(0.0f, 0.0f, 0.0f));
+    ASSERT_TRUE(curve.value(0.5f).toVector3() == curve.m_keys[50].m_value.toVector3());
+    ASSERT_TRUE(curve.value(2.0f).toVector3() == curve.m_keys.back().m_value.toVector3());
+
+    int32_t b;
+    int32_t e;
+    curve.frames(b, e, 0.505f);
+    ASSERT_EQ(b, 50);
+    ASSERT_EQ(e, 51);
+    curve.frames(b, e, 0.5f);
+    ASSERT_EQ(b, 50);
+    ASSERT_EQ(e, 50);
+
+    // Changed key frames must be baked again
+    baked.m_keys.pop_back();
+    ASSERT_FALSE(baked.isBaked());
+}
+
+TEST_F(AnimationTest, Curve_quaternion) {
+    AnimationCurve curve;
+
+    AnimationCurve::KeyFrame k1;
+    k1.m_value = Quaternion(Vector3(0.0f, 1.0f, 0.0f), 0.0f);
+    k1.m_position = 0.0f;
+    k1.m_type = AnimationCurve::KeyFrame::Linear;
+    curve.m_keys.push_back(k1);
+
+    AnimationCurve::KeyFrame k2;
+    k2.m_value = Quaternion(Vector3(0.0f, 1.0f, 0.0f), 90.0f);
+    k2.m_position = 1.0f;
+    k2.m_type = AnimationCurve::KeyFrame::Linear;
+    curve.m_keys.push_back(k2);
+
+    Quaternion reference = curve.value(0.5f).toQuaternion();
+    curve.bake();
+    ASSERT_TRUE(curve.isBaked());
+    ASSERT_TRUE(curve.value(0.5f).toQuaternion() == reference);
+    ASSERT_TRUE(reference.equal(Quaternion(Vector3(0.0f, 1.0f, 0.0f), 45.0f)));
+
+    // Strings can't be baked
+    AnimationCurve strings;
+    k1.m_value = std::string("a");
+    strings.m_keys.push_back(k1);
+    strings.bake();
+    ASSERT_FALSE(strings.isBaked());
+}
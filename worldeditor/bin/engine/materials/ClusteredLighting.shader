@@ -0,0 +1,166 @@
+<shader version="11">
+    <properties>
+        <property type="vec4" name="clusterSize"/>
+        <property type="vec4" name="clusterDepth"/>
+        <property binding="0" type="texture2d" name="normalsMap" target="true"/>
+        <property binding="1" type="texture2d" name="diffuseMap" target="true"/>
+        <property binding="2" type="texture2d" name="paramsMap" target="true"/>
+        <property binding="3" type="texture2d" name="depthMap" target="true"/>
+        <property binding="4" type="texture2d" name="clustersMap"/>
+        <property binding="5" type="texture2d" name="lightIndicesMap"/>
+        <property binding="6" type="texture2d" name="lightsMap"/>
+    </properties>
+    <vertex><![CDATA[
+#version 450 core
+
+#pragma flags
+
+#define NO_INSTANCE
+
+#include "ShaderLayout.h"
+
+layout(location = 0) in vec3 vertex;
+layout(location = 1) in vec2 uv0;
+layout(location = 2) in vec4 color;
+
+layout(location = 3) in vec3 normal;
+layout(location = 4) in vec3 tangent;
+
+layout(location = 0) out vec4 _vertex;
+
+void main(void) {
+    _vertex = vec4(vertex * 2.0, 1.0);
+    gl_Position = _vertex;
+}
+]]></vertex>
+    <fragment><![CDATA[
+#version 450 core
+
+#pragma flags
+
+#define NO_INSTANCE
+
+#include "ShaderLayout.h"
+#include "Functions.h"
+#include "BRDF.h"
+
+#define ROW_SIZE 1024
+#define LIGHT_TEXELS 4
+
+layout(binding = LOCAL) uniform Uniforms {
+    mat4 model;
+    vec4 clusterSize; // x, y, z - grid dimensions, w - lights count
+    vec4 clusterDepth; // x - near, y - far, z - slices / log(far / near)
+} uni;
+
+layout(binding = UNIFORM) uniform sampler2D normalsMap;
+layout(binding = UNIFORM + 1) uniform sampler2D diffuseMap;
+layout(binding = UNIFORM + 2) uniform sampler2D paramsMap;
+layout(binding = UNIFORM + 3) uniform sampler2D depthMap;
+layout(binding = UNIFORM + 4) uniform sampler2D clustersMap;
+layout(binding = UNIFORM + 5) uniform sampler2D lightIndicesMap;
+layout(binding = UNIFORM + 6) uniform sampler2D lightsMap;
+
+layout(location = 0) in vec4 _vertex;
+
+layout(location = 0) out vec4 rgb;
+
+vec4 fetchLight(int index, int component) {
+    int texel = index * LIGHT_TEXELS + component;
+    return texelFetch(lightsMap, ivec2(texel % ROW_SIZE, texel / ROW_SIZE), 0);
+}
+
+int fetchIndex(int index) {
+    int texel = index / 4;
+    vec4 value = texelFetch(lightIndicesMap, ivec2(texel % ROW_SIZE, texel / ROW_SIZE), 0);
+    return int(value[index % 4]);
+}
+
+void main(void) {
+    vec2 proj = ((_vertex.xyz / _vertex.w) * 0.5 + 0.5).xy;
+
+    vec4 slice0 = texture(normalsMap, proj);
+
+    // Light model LIT
+    if(slice0.w > 0.0) {
+        float depth = texture(depthMap, proj).x;
+        vec3 world = getWorld(g.cameraScreenToWorld, proj, depth);
+
+        float linear = -(g.cameraView * vec4(world, 1.0)).z;
+        if(linear >= uni.clusterDepth.x) {
+            ivec3 size = ivec3(uni.clusterSize.xyz);
+
+            int z = clamp(int(floor(log(linear / uni.clusterDepth.x) * uni.clusterDepth.z)), 0, size.z - 1);
+            ivec2 tile = clamp(ivec2(proj * uni.clusterSize.xy), ivec2(0), size.xy - 1);
+
+            vec4 cluster = texelFetch(clustersMap, ivec2(tile.y * size.x + tile.x, z), 0);
+            int offset = int(cluster.x);
+            int count = int(cluster.y);
+
+            vec4 params = texture(paramsMap, proj);
+            float rough = params.x;
+            float metal = params.z;
+            float spec  = params.w;
+
+            vec3 albedo = texture(diffuseMap, proj).xyz;
+
+            vec3 v = normalize(g.cameraPosition.xyz - world);
+            vec3 n = normalize(slice0.xyz * 2.0 - 1.0);
+            vec3 r = -reflect(v, n);
+
+            vec3 sum = vec3(0.0);
+            for(int i = 0; i < count; i++) {
+                int index = fetchIndex(offset + i);
+
+                vec4 position = fetchLight(index, 0); // w - 0 point, 1 spot
+                vec4 color = fetchLight(index, 1);
+                vec4 direction = fetchLight(index, 2);
+                vec4 light = fetchLight(index, 3); // x - brightness, y - radius/distance, w - cutoff
+
+                vec3 dir = position.xyz - world;
+                float dist = length(dir);
+                vec3 l = dir / dist;
+
+                float cosTheta = clamp(dot(l, n), 0.0, 1.0);
+                float factor = 0.0;
+
+                if(position.w > 0.5) {
+                    float spot = dot(l, direction.xyz);
+                    if(spot > light.w) {
+                        float fall = 1.0 - (1.0 - spot) / (1.0 - light.w);
+                        fall = getAttenuation(dist, light.y) * light.x * fall;
+                        factor = PI * getLambert(cosTheta, light.x) * fall;
+                    }
+                } else {
+                    factor = light.x * PI * cosTheta * getAttenuation(dist, light.w);
+
+                    float radius = light.y;
+                    if(radius > 0.0) {
+                        // Specular part of the sphere light
+                        vec3 centerToRay = dot(l, r) * r - l;
+                        vec3 closestPoint = l + centerToRay * clamp(radius / length(centerToRay), 0.0, 1.0);
+                        l = normalize(closestPoint);
+                        cosTheta = clamp(dot(l, n), 0.0, 1.0);
+                    }
+                }
+
+                if(factor > 0.0) {
+                    vec3 h = normalize(l + v);
+                    float refl = getCookTorrance(n, v, h, cosTheta, rough);
+
+                    vec3 result = albedo * (1.0 - metal) + (mix(vec3(spec), albedo, metal) * refl);
+                    sum += color.xyz * result * factor;
+                }
+            }
+
+            rgb = vec4(sum, 1.0);
+            return;
+        }
+    }
+    rgb = vec4(vec3(0.0), 1.0);
+}
+]]></fragment>
+    <pass wireFrame="false" lightModel="Unlit" type="LightFunction" twoSided="true">
+        <blend src="One" dst="One" op="Add"/>
+    </pass>
+</shader>
@@ -19,6 +19,7 @@ ImportQueue::ImportQueue(QWidget *parent) :
 
     AssetManager *manager = AssetManager::instance();
     connect(manager, &AssetManager::importStarted, this, &ImportQueue::onStarted);
+    connect(manager, &AssetManager::importProgress, this, &ImportQueue::onProgress);
     connect(manager, &AssetManager::imported, this, &ImportQueue::onProcessed);
 
     connect(manager, &AssetManager::importFinished, this, &ImportQueue::onImportFinished);
@@ -34,12 +35,15 @@ ImportQueue::~ImportQueue() {
 }
 
 void ImportQueue::onProcessed(const QString &path, const QString &type) {
-    ui->progressBar->setValue(ui->progressBar->value() + 1);
-
     QString guid = QString::fromStdString(AssetManager::instance()->pathToGuid(path.toStdString()));
     m_updateQueue[guid] = type;
 }
 
+void ImportQueue::onProgress(int processed, int total) {
+    ui->progressBar->setMaximum(total);
+    ui->progressBar->setValue(processed);
+}
+
 void ImportQueue::onStarted(int count, const QString &action) {
     show();
     ui->progressBar->setValue(0);
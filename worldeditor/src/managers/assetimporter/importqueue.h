@@ -27,6 +27,7 @@ signals:
 
 private slots:
     void onProcessed(const QString &path, const QString &type);
+    void onProgress(int processed, int total);
 
     void onStarted(int count, const QString &action);
     void onImportFinished();